@@ -0,0 +1,217 @@
+#include "AllocationCounter.h"
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local size_t count = 0;
+}
+
+#if defined(CODECS_ALLOCATION_COUNTER)
+namespace
+{
+    /**
+     * Allocate as the standard operator new does: call the new handler
+     * until the allocation succeeds, and throw if there is none.
+     */
+    void* Allocate(size_t size)
+    {
+        ++count;
+        for (;;)
+        {
+            void* p = std::malloc(size ? size : 1);
+            if (p)
+            {
+                return p;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+            {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void* AllocateNoThrow(size_t size) noexcept
+    {
+        try
+        {
+            return Allocate(size);
+        }
+        catch (...)
+        {
+            return nullptr;
+        }
+    }
+}
+
+void* operator new(size_t size)
+{
+    return Allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return Allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return AllocateNoThrow(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return AllocateNoThrow(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+#endif
+
+bool AllocationCounter::IsEnabled(void)
+{
+#if defined(CODECS_ALLOCATION_COUNTER)
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t AllocationCounter::GetCount(void)
+{
+    return count;
+}
+
+#include <vector>
+#include "BitMatrix.h"
+#include "BitView.h"
+#include "HammingCodecs.h"
+#include "LfsrDivider.h"
+#include "PackedBits.h"
+#include "PolynomialDivider.h"
+#include "DataIo.h"
+void AllocationCounter::Test(void)
+{
+    if (!IsEnabled())
+    {
+        assert(GetCount() == 0);
+        return;
+    }
+
+    // The counter sees allocations.
+    size_t before = GetCount();
+    std::vector<int>* v = new std::vector<int>(10);
+    delete v;
+    assert(GetCount() == before + 2);
+
+    // Everything below is set up first; the packed calls must not allocate.
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    auto next = [&x](void)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x;
+    };
+
+    BitMatrix matrix(100, 70);
+    for (size_t i1 = 0; i1 < 100; ++i1)
+    {
+        for (size_t i2 = 0; i2 < 70; ++i2)
+        {
+            matrix.Get(i1, i2) = (next() & 1) != 0;
+        }
+    }
+    std::vector<uint64_t> vec(2, 0);
+    vec[0] = next();
+    vec[1] = next() & 0x3F;
+    std::vector<uint64_t> product(2, 0);
+
+    HammingCodecs hc(57);
+    const size_t numBlocks = 100;
+    std::vector<uint64_t> message(PackedBits::GetNumberOfWords(numBlocks * 57), 0);
+    for (size_t i = 0; i < message.size(); ++i)
+    {
+        message[i] = next();
+    }
+    message.back() &= (uint64_t(1) << (numBlocks * 57 % 64)) - 1;
+    std::vector<uint64_t> code(PackedBits::GetNumberOfWords(numBlocks * 63), 0);
+    std::vector<uint64_t> decoded(message.size(), 0);
+    std::vector<uint64_t> scratch(hc.GetScratchSize(), 0);
+    std::vector<size_t> errors(numBlocks, 0);
+    uint64_t blockIn[1] = { message[0] & ((uint64_t(1) << 57) - 1) };
+    uint64_t block[1] = { 0 };
+    uint64_t blockMessage[1] = { 0 };
+
+    std::vector<uint64_t> dividend(4, 0);
+    for (size_t i = 0; i < dividend.size(); ++i)
+    {
+        dividend[i] = next();
+    }
+    std::vector<uint64_t> divisor = PackedBits::FromVector(DataIo::FromString("1 0000 0100 1100 0001 0001 1101 1011 0111"));
+    std::vector<uint64_t> quotient(4, 0);
+    std::vector<uint64_t> remainder(1, 0);
+
+    LfsrDivider crc32(DataIo::FromString("1 0000 0100 1100 0001 0001 1101 1011 0111"));
+    std::vector<uint8_t> bytes(1000, 0x5A);
+    BitView lsbView(&bytes[0], 8 * bytes.size() - 3, BitView::BO_LSB_FIRST);
+    BitView msbView(&bytes[0], 8 * bytes.size() - 3, BitView::BO_MSB_FIRST);
+    uint64_t reg = 0;
+
+    before = GetCount();
+    matrix.Multiply(&vec[0], &product[0]);
+    hc.Encode(blockIn, block);
+    PackedBits::FlipBit(block, 10);
+    assert(hc.CheckError(block) == 11);
+    hc.Decode(block, blockMessage);
+    assert(blockMessage[0] == blockIn[0]);
+    size_t position = hc.Correct(block);
+    assert(position == 11);
+    hc.ExtractMessage(block, blockMessage);
+    assert(blockMessage[0] == blockIn[0]);
+    hc.EncodeBlocks(&message[0], numBlocks, &code[0], &scratch[0]);
+    PackedBits::FlipBit(&code[0], 63 * 99 + 5);
+    size_t numCorrected = hc.DecodeBlocks(&code[0], numBlocks, &decoded[0], &errors[0], &scratch[0]);
+    assert(numCorrected == 1);
+    assert(errors[99] == 6);
+    PolynomialDivider::Divide(&dividend[0], 256, &divisor[0], 33, &quotient[0], &remainder[0]);
+    crc32.Update(&reg, lsbView);
+    crc32.Update(&reg, msbView);
+    crc32.MultiplyByPowerOfX(&reg, 123456789);
+    crc32.UpdateCrc(&reg, 8 * bytes.size(), 80, &vec[0], &product[0], 100);
+    assert(GetCount() == before);
+    assert(decoded == message);
+    (void)before;
+    (void)position;
+    (void)numCorrected;
+}
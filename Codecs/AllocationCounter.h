@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * Counts heap allocations made through the global operator new.
+ *
+ * Built only with CODECS_ALLOCATION_COUNTER defined, as the test builds
+ * do: the global allocation operators are then replaced (in
+ * AllocationCounter.cpp) to count, per thread, the allocations made by
+ * the calling thread, so tests can assert that a call performs no
+ * allocation.  Otherwise the program keeps the standard operators and
+ * the count stays 0.
+ */
+class AllocationCounter
+{
+public:
+    static bool IsEnabled(void);
+
+    /**
+     * @return The number of allocations made by the calling thread so far.
+     */
+    static size_t GetCount(void);
+
+    static void Test(void);
+};
@@ -0,0 +1,503 @@
+#include "BchCodecs.h"
+#include "PackedBits.h"
+#include "Simd.h"
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+    // Primitive polynomials of GF(2^m), indexed by m.
+    const unsigned PRIMITIVE_POLYNOMIALS[17] =
+    {
+        0, 0, 0x7, 0xB, 0x13, 0x25, 0x43, 0x89, 0x11D,
+        0x211, 0x409, 0x805, 0x1053, 0x201B, 0x4443, 0x8003, 0x1100B,
+    };
+
+    // The number of positions evaluated per step of the Chien search.
+#if defined(CODECS_HAS_AVX2)
+    const size_t CHIEN_STEP = 32;
+#elif defined(CODECS_HAS_SSSE3)
+    const size_t CHIEN_STEP = 16;
+#else
+    const size_t CHIEN_STEP = 1;
+#endif
+
+    // Bytes of Chien tables per locator term:
+    // for each nibble of an element, the low and high bytes of its products.
+    const size_t CHIEN_TABLE_SIZE = 4 * 2 * 16;
+}
+
+BchCodecs::BchCodecs(size_t numMessageBits, size_t t) :
+    numMessageBits_(numMessageBits),
+    t_(t),
+    m_(3)
+{
+    assert(numMessageBits > 0);
+    assert(t > 0);
+    while (numMessageBits_ + m_ * t_ > (size_t(1) << m_) - 1)
+    {
+        ++m_;
+    }
+    assert(m_ <= 16);
+    CalculateField();
+    CalculateGenerator();
+    CalculateChienTables();
+}
+
+void BchCodecs::CalculateField(void)
+{
+    fieldSize_ = (size_t(1) << m_) - 1;
+    exp_.assign(2 * fieldSize_, 0);
+    log_.assign(fieldSize_ + 1, 0);
+    unsigned a = 1;
+    for (size_t n = 0; n < fieldSize_; ++n)
+    {
+        exp_[n] = static_cast<uint16_t>(a);
+        exp_[n + fieldSize_] = static_cast<uint16_t>(a);
+        log_[a] = static_cast<uint16_t>(n);
+        a <<= 1;
+        if (a >> m_)
+        {
+            a ^= PRIMITIVE_POLYNOMIALS[m_];
+        }
+    }
+}
+
+uint16_t BchCodecs::Multiply(uint16_t a, uint16_t b) const
+{
+    return (a && b) ? exp_[log_[a] + log_[b]] : 0;
+}
+
+uint16_t BchCodecs::Power(size_t n) const
+{
+    return exp_[n % fieldSize_];
+}
+
+void BchCodecs::CalculateGenerator(void)
+{
+    // g(x) in ascending order of degree.
+    std::vector<bool> g(1, true);
+    std::vector<bool> covered(fieldSize_, false);
+    for (size_t i = 1; i < 2 * t_; i += 2)
+    {
+        if (covered[i % fieldSize_])
+        {
+            continue;
+        }
+        // The minimal polynomial of alpha^i is the product of (x + alpha^c)
+        // over the cyclotomic coset c = i, 2i, 4i, ... (mod 2^m - 1).
+        std::vector<uint16_t> phi(1, 1);
+        size_t c = i % fieldSize_;
+        do
+        {
+            covered[c] = true;
+            uint16_t root = Power(c);
+            phi.push_back(0);
+            for (size_t d = phi.size() - 1; d > 0; --d)
+            {
+                phi[d] = phi[d - 1] ^ Multiply(phi[d], root);
+            }
+            phi[0] = Multiply(phi[0], root);
+            c = (2 * c) % fieldSize_;
+        }
+        while (c != i % fieldSize_);
+        // g *= phi over GF(2).
+        std::vector<bool> product(g.size() + phi.size() - 1, false);
+        for (size_t a = 0; a < g.size(); ++a)
+        {
+            if (g[a])
+            {
+                for (size_t b = 0; b < phi.size(); ++b)
+                {
+                    assert(phi[b] <= 1);
+                    product[a + b] = product[a + b] != (phi[b] != 0);
+                }
+            }
+        }
+        g.swap(product);
+    }
+    generator_.assign(g.rbegin(), g.rend());
+    divider_.reset(new LfsrDivider(generator_));
+}
+
+void BchCodecs::CalculateChienTables(void)
+{
+    // Term j of the locator is multiplied by alpha^(-j * CHIEN_STEP) per step.
+    chienTables_.assign(t_ * CHIEN_TABLE_SIZE, 0);
+    for (size_t j = 1; j <= t_; ++j)
+    {
+        uint16_t c = Power(fieldSize_ - (j * CHIEN_STEP) % fieldSize_);
+        uint8_t* table = &chienTables_[(j - 1) * CHIEN_TABLE_SIZE];
+        for (size_t q = 0; q < 4; ++q)
+        {
+            for (unsigned n = 0; n < 16; ++n)
+            {
+                uint16_t v = static_cast<uint16_t>(n << (4 * q));
+                uint16_t p = (v >> m_) ? 0 : Multiply(c, v);
+                table[(2 * q) * 16 + n] = static_cast<uint8_t>(p);
+                table[(2 * q + 1) * 16 + n] = static_cast<uint8_t>(p >> 8);
+            }
+        }
+    }
+}
+
+size_t BchCodecs::GetNumberOfMessageBits(void) const
+{
+    return numMessageBits_;
+}
+
+size_t BchCodecs::GetNumberOfRedundantBits(void) const
+{
+    return divider_->GetDegree();
+}
+
+size_t BchCodecs::GetNumberOfCodeBits(void) const
+{
+    return numMessageBits_ + GetNumberOfRedundantBits();
+}
+
+size_t BchCodecs::GetNumberOfCorrectableErrors(void) const
+{
+    return t_;
+}
+
+size_t BchCodecs::GetFieldDegree(void) const
+{
+    return m_;
+}
+
+const std::vector<bool>& BchCodecs::GetGenerator(void) const
+{
+    return generator_;
+}
+
+void BchCodecs::Encode(const uint64_t* message, uint64_t* code) const
+{
+    size_t r = GetNumberOfRedundantBits();
+    std::vector<uint64_t> reg(divider_->GetNumberOfWords() + 1, 0);
+    divider_->Update(&reg[0], message, numMessageBits_);
+    PackedBits::CopyBits(message, 0, code, 0, numMessageBits_);
+    PackedBits::CopyBits(&reg[0], 0, code, numMessageBits_, r);
+    size_t n = GetNumberOfCodeBits();
+    if (n % PackedBits::WORD_BITS)
+    {
+        code[n / PackedBits::WORD_BITS] &= PackedBits::GetLowMask(n % PackedBits::WORD_BITS);
+    }
+}
+
+std::vector<bool> BchCodecs::Encode(const std::vector<bool>& message) const
+{
+    assert(message.size() == numMessageBits_);
+    std::vector<uint64_t> m = PackedBits::FromVector(message);
+    std::vector<uint64_t> code(PackedBits::GetNumberOfWords(GetNumberOfCodeBits()), 0);
+    Encode(&m[0], &code[0]);
+    return PackedBits::ToVector(&code[0], GetNumberOfCodeBits());
+}
+
+std::vector<bool> BchCodecs::Decode(const std::vector<bool>& code) const
+{
+    assert(code.size() == GetNumberOfCodeBits());
+    std::vector<uint64_t> c = PackedBits::FromVector(code);
+    Correct(&c[0]);
+    return PackedBits::ToVector(&c[0], numMessageBits_);
+}
+
+void BchCodecs::CalculateSyndromes(const uint64_t* remainder, uint16_t* syndromes) const
+{
+    // r(alpha^j) = R(alpha^j) since g(alpha^j) = 0 for 1 <= j <= 2t.
+    // Bit b of R is the coefficient of x^(r - 1 - b); only set bits contribute.
+    size_t r = GetNumberOfRedundantBits();
+    size_t numWords = PackedBits::GetNumberOfWords(r);
+    for (size_t j = 1; j <= 2 * t_; j += 2)
+    {
+        uint16_t s = 0;
+        for (size_t w = 0; w < numWords; ++w)
+        {
+            uint64_t bits = remainder[w];
+            while (bits)
+            {
+                size_t b = w * PackedBits::WORD_BITS + PackedBits::CountTrailingZeros(bits);
+                bits &= bits - 1;
+                s ^= Power(j * (r - 1 - b));
+            }
+        }
+        syndromes[j - 1] = s;
+    }
+    // S_2j = S_j^2 for binary codes.
+    for (size_t j = 2; j <= 2 * t_; j += 2)
+    {
+        syndromes[j - 1] = Multiply(syndromes[j / 2 - 1], syndromes[j / 2 - 1]);
+    }
+}
+
+size_t BchCodecs::CalculateErrorLocator(const uint16_t* syndromes, uint16_t* locator) const
+{
+    // Berlekamp-Massey: the shortest LFSR locator(x) generating the syndromes.
+    std::vector<uint16_t> c(2 * t_ + 1, 0);
+    std::vector<uint16_t> b(2 * t_ + 1, 0);
+    std::vector<uint16_t> temp(2 * t_ + 1, 0);
+    c[0] = 1;
+    b[0] = 1;
+    size_t l = 0;
+    size_t shift = 1;
+    uint16_t lastDiscrepancy = 1;
+    for (size_t i = 0; i < 2 * t_; ++i)
+    {
+        uint16_t d = syndromes[i];
+        for (size_t k = 1; k <= l; ++k)
+        {
+            d ^= Multiply(c[k], syndromes[i - k]);
+        }
+        if (!d)
+        {
+            ++shift;
+            continue;
+        }
+        // c(x) -= d / lastDiscrepancy * x^shift * b(x)
+        uint16_t factor = exp_[log_[d] + fieldSize_ - log_[lastDiscrepancy]];
+        bool grow = (2 * l <= i);
+        if (grow)
+        {
+            temp = c;
+        }
+        for (size_t k = 0; k + shift <= 2 * t_; ++k)
+        {
+            c[k + shift] ^= Multiply(factor, b[k]);
+        }
+        if (grow)
+        {
+            l = i + 1 - l;
+            b.swap(temp);
+            lastDiscrepancy = d;
+            shift = 1;
+        }
+        else
+        {
+            ++shift;
+        }
+    }
+    for (size_t k = 0; k <= t_; ++k)
+    {
+        locator[k] = c[k];
+    }
+    return l;
+}
+
+size_t BchCodecs::FindErrorPositions(const uint16_t* locator, size_t degree, size_t* positions) const
+{
+    // Chien search: the errors are at the powers p with locator(alpha^-p) = 0.
+    // Term j of locator(alpha^-p) is locator[j] * alpha^(-j * p).
+    size_t n = GetNumberOfCodeBits();
+    size_t count = 0;
+#if defined(CODECS_HAS_SSSE3)
+    // Terms are kept as byte planes of CHIEN_STEP consecutive positions.
+    std::vector<uint8_t> planes(degree * 2 * CHIEN_STEP, 0);
+    for (size_t j = 1; j <= degree; ++j)
+    {
+        for (size_t i = 0; i < CHIEN_STEP; ++i)
+        {
+            uint16_t v = Multiply(locator[j], Power(fieldSize_ - (j * i) % fieldSize_));
+            planes[(j - 1) * 2 * CHIEN_STEP + i] = static_cast<uint8_t>(v);
+            planes[(j - 1) * 2 * CHIEN_STEP + CHIEN_STEP + i] = static_cast<uint8_t>(v >> 8);
+        }
+    }
+#if defined(CODECS_HAS_AVX2)
+    typedef __m256i Vector;
+#define CHIEN_LOAD(p) _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))
+#define CHIEN_LOAD_TABLE(p) _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)))
+#define CHIEN_STORE(p, v) _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v)
+#define CHIEN_XOR _mm256_xor_si256
+#define CHIEN_AND _mm256_and_si256
+#define CHIEN_OR _mm256_or_si256
+#define CHIEN_SHUFFLE _mm256_shuffle_epi8
+#define CHIEN_SRLI16 _mm256_srli_epi16
+#define CHIEN_SET1 _mm256_set1_epi8
+#define CHIEN_ZERO_MASK(v) static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256())))
+#else
+    typedef __m128i Vector;
+#define CHIEN_LOAD(p) _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))
+#define CHIEN_LOAD_TABLE(p) _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))
+#define CHIEN_STORE(p, v) _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v)
+#define CHIEN_XOR _mm_xor_si128
+#define CHIEN_AND _mm_and_si128
+#define CHIEN_OR _mm_or_si128
+#define CHIEN_SHUFFLE _mm_shuffle_epi8
+#define CHIEN_SRLI16 _mm_srli_epi16
+#define CHIEN_SET1 _mm_set1_epi8
+#define CHIEN_ZERO_MASK(v) static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())))
+#endif
+    const Vector nibble = CHIEN_SET1(0x0F);
+    for (size_t p0 = 0; p0 < n && count < degree; p0 += CHIEN_STEP)
+    {
+        // locator[0] = 1.
+        Vector sumLow = CHIEN_SET1(1);
+        Vector sumHigh = CHIEN_SET1(0);
+        for (size_t j = 1; j <= degree; ++j)
+        {
+            uint8_t* plane = &planes[(j - 1) * 2 * CHIEN_STEP];
+            const uint8_t* table = &chienTables_[(j - 1) * CHIEN_TABLE_SIZE];
+            Vector low = CHIEN_LOAD(plane);
+            Vector high = CHIEN_LOAD(plane + CHIEN_STEP);
+            sumLow = CHIEN_XOR(sumLow, low);
+            sumHigh = CHIEN_XOR(sumHigh, high);
+            // Multiply by the step constant, nibble by nibble.
+            Vector n0 = CHIEN_AND(low, nibble);
+            Vector n1 = CHIEN_AND(CHIEN_SRLI16(low, 4), nibble);
+            Vector n2 = CHIEN_AND(high, nibble);
+            Vector n3 = CHIEN_AND(CHIEN_SRLI16(high, 4), nibble);
+            Vector newLow = CHIEN_XOR(CHIEN_XOR(CHIEN_SHUFFLE(CHIEN_LOAD_TABLE(table + 0 * 16), n0),
+                                                CHIEN_SHUFFLE(CHIEN_LOAD_TABLE(table + 2 * 16), n1)),
+                                      CHIEN_XOR(CHIEN_SHUFFLE(CHIEN_LOAD_TABLE(table + 4 * 16), n2),
+                                                CHIEN_SHUFFLE(CHIEN_LOAD_TABLE(table + 6 * 16), n3)));
+            Vector newHigh = CHIEN_XOR(CHIEN_XOR(CHIEN_SHUFFLE(CHIEN_LOAD_TABLE(table + 1 * 16), n0),
+                                                 CHIEN_SHUFFLE(CHIEN_LOAD_TABLE(table + 3 * 16), n1)),
+                                       CHIEN_XOR(CHIEN_SHUFFLE(CHIEN_LOAD_TABLE(table + 5 * 16), n2),
+                                                 CHIEN_SHUFFLE(CHIEN_LOAD_TABLE(table + 7 * 16), n3)));
+            CHIEN_STORE(plane, newLow);
+            CHIEN_STORE(plane + CHIEN_STEP, newHigh);
+        }
+        uint32_t roots = CHIEN_ZERO_MASK(CHIEN_OR(sumLow, sumHigh));
+        while (roots)
+        {
+            size_t p = p0 + PackedBits::CountTrailingZeros(roots);
+            roots &= roots - 1;
+            if (p < n && count < degree)
+            {
+                positions[count++] = p;
+            }
+        }
+    }
+#undef CHIEN_LOAD
+#undef CHIEN_LOAD_TABLE
+#undef CHIEN_STORE
+#undef CHIEN_XOR
+#undef CHIEN_AND
+#undef CHIEN_OR
+#undef CHIEN_SHUFFLE
+#undef CHIEN_SRLI16
+#undef CHIEN_SET1
+#undef CHIEN_ZERO_MASK
+#else
+    std::vector<uint16_t> terms(locator + 1, locator + degree + 1);
+    for (size_t p = 0; p < n && count < degree; ++p)
+    {
+        uint16_t sum = 1;
+        for (size_t j = 1; j <= degree; ++j)
+        {
+            sum ^= terms[j - 1];
+            if (terms[j - 1])
+            {
+                terms[j - 1] = exp_[log_[terms[j - 1]] + fieldSize_ - j % fieldSize_];
+            }
+        }
+        if (!sum)
+        {
+            positions[count++] = p;
+        }
+    }
+#endif
+    return count;
+}
+
+size_t BchCodecs::Correct(uint64_t* code) const
+{
+    size_t r = GetNumberOfRedundantBits();
+    size_t n = GetNumberOfCodeBits();
+    // code(x) mod g(x) = (message(x) * x^r mod g(x)) + parity(x).
+    size_t numWords = divider_->GetNumberOfWords();
+    std::vector<uint64_t> remainder(numWords + 1, 0);
+    std::vector<uint64_t> parity(numWords + 1, 0);
+    divider_->Update(&remainder[0], code, numMessageBits_);
+    PackedBits::CopyBits(code, numMessageBits_, &parity[0], 0, r);
+    PackedBits::XorBits(&parity[0], &remainder[0], r);
+    if (PackedBits::IsZero(&remainder[0], r))
+    {
+        return 0;
+    }
+    std::vector<uint16_t> syndromes(2 * t_, 0);
+    CalculateSyndromes(&remainder[0], &syndromes[0]);
+    std::vector<uint16_t> locator(t_ + 1, 0);
+    size_t degree = CalculateErrorLocator(&syndromes[0], &locator[0]);
+    if (degree == 0 || degree > t_)
+    {
+        return UNCORRECTABLE;
+    }
+    std::vector<size_t> positions(degree, 0);
+    if (FindErrorPositions(&locator[0], degree, &positions[0]) != degree)
+    {
+        return UNCORRECTABLE;
+    }
+    for (size_t i = 0; i < degree; ++i)
+    {
+        PackedBits::FlipBit(code, n - 1 - positions[i]);
+    }
+    return degree;
+}
+
+#include "DataIo.h"
+void BchCodecs::Test(void)
+{
+    // BCH(15, 7), t = 2.
+    BchCodecs bch15(7, 2);
+    assert(bch15.GetFieldDegree() == 4);
+    assert(bch15.GetNumberOfCodeBits() == 15);
+    assert(bch15.GetGenerator() == DataIo::FromString("1 1101 0001"));
+    std::vector<bool> msg = DataIo::FromString("101 1001");
+    std::vector<bool> code = bch15.Encode(msg);
+    assert(code.size() == 15);
+    std::vector<bool> quotient;
+    std::vector<bool> remainder;
+    for (size_t i = 0; i < 15; ++i)
+    {
+        for (size_t j = i; j < 15; ++j)
+        {
+            std::vector<bool> received = code;
+            received[i] = !received[i];
+            if (j != i)
+            {
+                received[j] = !received[j];
+            }
+            assert(bch15.Decode(received) == msg);
+        }
+    }
+    assert(bch15.Decode(code) == msg);
+
+    // A 4 KB page with t = 8.
+    BchCodecs page(4096 * 8, 8);
+    assert(page.GetFieldDegree() == 16);
+    assert(page.GetNumberOfRedundantBits() == 16 * 8);
+    size_t n = page.GetNumberOfCodeBits();
+    std::vector<uint64_t> message(4096 / 8, 0);
+    uint64_t x = 0x13198A2E03707344ULL;
+    for (size_t i = 0; i < message.size(); ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        message[i] = x;
+    }
+    std::vector<uint64_t> encoded(PackedBits::GetNumberOfWords(n), 0);
+    page.Encode(&message[0], &encoded[0]);
+    std::vector<uint64_t> received = encoded;
+    size_t numCorrected = page.Correct(&received[0]);
+    assert(numCorrected == 0);
+    for (size_t numErrors = 1; numErrors <= 8; ++numErrors)
+    {
+        received = encoded;
+        for (size_t e = 0; e < numErrors; ++e)
+        {
+            PackedBits::FlipBit(&received[0], (e * 4099 + numErrors * 31) % n);
+        }
+        numCorrected = page.Correct(&received[0]);
+        assert(numCorrected == numErrors);
+        assert(received == encoded);
+    }
+    // Errors in the last and first bits.
+    received = encoded;
+    PackedBits::FlipBit(&received[0], 0);
+    PackedBits::FlipBit(&received[0], n - 1);
+    numCorrected = page.Correct(&received[0]);
+    assert(numCorrected == 2);
+    assert(received == encoded);
+    (void)numCorrected;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "LfsrDivider.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Systematic binary BCH codec correcting up to t bit errors.
+ *
+ * The code is a shortened primitive BCH code over GF(2^m), where m is the
+ * smallest degree that fits the message and t.  A code word is the message
+ * followed by the remainder of message(x) * x^r divided by the generator
+ * g(x), the least common multiple of the minimal polynomials of
+ * alpha, alpha^3, ..., alpha^(2t - 1).
+ *
+ * Encoding is table-driven LFSR division (see LfsrDivider).
+ * Decoding divides the received word by g(x) the same way; a zero remainder
+ * means no error.  Otherwise the syndromes are evaluated on the remainder,
+ * Berlekamp-Massey finds the error locator, and a Chien search finds its
+ * roots, 16 (SSSE3) or 32 (AVX2) positions per step.
+ */
+class BchCodecs
+{
+public:
+    /**
+     * Returned by \c Correct() when there are more errors than can be corrected.
+     */
+    static const size_t UNCORRECTABLE = static_cast<size_t>(-1);
+
+    /**
+     * @param [in] numMessageBits   k > 0
+     * @param [in] t                the number of correctable errors, t > 0.
+     */
+    BchCodecs(size_t numMessageBits, size_t t);
+
+    size_t GetNumberOfMessageBits(void) const;
+    size_t GetNumberOfRedundantBits(void) const;
+    size_t GetNumberOfCodeBits(void) const;
+    size_t GetNumberOfCorrectableErrors(void) const;
+
+    /**
+     * @return m, the degree of the field GF(2^m).
+     */
+    size_t GetFieldDegree(void) const;
+
+    const std::vector<bool>& GetGenerator(void) const;
+
+    /**
+     * @param [in] message   The size of \c message must be equal to \c GetNumberOfMessageBits().
+     */
+    std::vector<bool> Encode(const std::vector<bool>& message) const;
+
+    /**
+     * @param [in] code   The size of \c code must be equal to \c GetNumberOfCodeBits().
+     * @return The message, with up to t errors corrected.
+     */
+    std::vector<bool> Decode(const std::vector<bool>& code) const;
+
+    /**
+     * @param [in]  message   GetNumberOfMessageBits() packed bits.
+     * @param [out] code      GetNumberOfCodeBits() packed bits.
+     */
+    void Encode(const uint64_t* message, uint64_t* code) const;
+
+    /**
+     * Correct a packed code word in place.
+     * @return The number of corrected bits, or UNCORRECTABLE.
+     */
+    size_t Correct(uint64_t* code) const;
+
+private:
+    uint16_t Multiply(uint16_t a, uint16_t b) const;
+    uint16_t Power(size_t n) const;
+
+    void CalculateField(void);
+    void CalculateGenerator(void);
+    void CalculateChienTables(void);
+
+    void CalculateSyndromes(const uint64_t* remainder, uint16_t* syndromes) const;
+    size_t CalculateErrorLocator(const uint16_t* syndromes, uint16_t* locator) const;
+    size_t FindErrorPositions(const uint16_t* locator, size_t degree, size_t* positions) const;
+
+public:
+    static void Test(void);
+
+private:
+    size_t numMessageBits_;
+    size_t t_;
+    size_t m_;
+    size_t fieldSize_;                  ///< 2^m - 1, the order of alpha.
+    std::vector<uint16_t> exp_;         ///< exp_[n] = alpha^n, 0 <= n < 2 * fieldSize_.
+    std::vector<uint16_t> log_;         ///< log_[alpha^n] = n.
+    std::vector<bool> generator_;
+    std::unique_ptr<LfsrDivider> divider_;
+    std::vector<uint8_t> chienTables_;  ///< per locator term: nibble product tables of its step.
+};
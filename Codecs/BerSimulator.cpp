@@ -0,0 +1,401 @@
+#include "BerSimulator.h"
+#include "PackedBits.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    uint64_t Mix(uint64_t x)
+    {
+        // The SplitMix64 finalizer.
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    /// A counter-based generator: the n-th output depends only on the key and n.
+    class CounterRandom
+    {
+    public:
+        explicit CounterRandom(uint64_t key) : key_(key), counter_(0) {}
+
+        uint64_t Next(void)
+        {
+            return Mix(key_ + 0x9E3779B97F4A7C15ULL * ++counter_);
+        }
+
+        /**
+         * @return A uniform number in (0, 1].
+         */
+        double NextUnit(void)
+        {
+            return static_cast<double>((Next() >> 11) + 1) * (1.0 / 9007199254740992.0);
+        }
+
+    private:
+        uint64_t key_;
+        uint64_t counter_;
+    };
+
+    /// Draws the number of trials before the next success, for a success probability p.
+    class Geometric
+    {
+    public:
+        explicit Geometric(double p) :
+            never_(p <= 0),
+            always_(p >= 1),
+            scale_(p > 0 && p < 1 ? 1 / std::log1p(-p) : 0)
+        {
+        }
+
+        /**
+         * @return The gap, or \c limit if it is at least \c limit.
+         */
+        size_t Draw(CounterRandom& random, size_t limit) const
+        {
+            if (never_)
+            {
+                return limit;
+            }
+            if (always_)
+            {
+                return 0;
+            }
+            double gap = std::floor(std::log(random.NextUnit()) * scale_);
+            return gap < static_cast<double>(limit) ? static_cast<size_t>(gap) : limit;
+        }
+
+    private:
+        bool never_;
+        bool always_;
+        double scale_;
+    };
+}
+
+/**
+ * The error positions of the batches of a channel.
+ */
+class BerSimulator::ErrorSource
+{
+public:
+    ErrorSource(const Channel& channel, uint64_t seed) :
+        channel_(channel),
+        seed_(seed),
+        errors_(channel.bitErrorRate),
+        goodErrors_(channel.goodErrorRate),
+        badErrors_(channel.badErrorRate),
+        leaveGood_(channel.goodToBad),
+        leaveBad_(channel.badToGood)
+    {
+    }
+
+    /**
+     * @param [out] positions   the error positions in [0, numBits), ascending.
+     */
+    void Generate(uint64_t batch, size_t numBits, std::vector<size_t>& positions) const
+    {
+        positions.clear();
+        CounterRandom random(Mix(seed_ ^ Mix(batch + 0x632BE59BD9B4E019ULL)));
+        if (channel_.model == CM_BINARY_SYMMETRIC)
+        {
+            Place(random, errors_, 0, numBits, positions);
+            return;
+        }
+        // Start in the stationary state distribution, then alternate runs.
+        double total = channel_.goodToBad + channel_.badToGood;
+        bool bad = total > 0 && random.NextUnit() <= channel_.goodToBad / total;
+        for (size_t first = 0; first < numBits; bad = !bad)
+        {
+            size_t length = 1 + (bad ? leaveBad_ : leaveGood_).Draw(random, numBits - first - 1);
+            Place(random, bad ? badErrors_ : goodErrors_, first, first + length, positions);
+            first += length;
+        }
+    }
+
+private:
+    static void Place(CounterRandom& random, const Geometric& errors, size_t first, size_t last,
+                      std::vector<size_t>& positions)
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            i += errors.Draw(random, last - i);
+            if (i < last)
+            {
+                positions.push_back(i);
+            }
+        }
+    }
+
+private:
+    Channel channel_;
+    uint64_t seed_;
+    Geometric errors_;
+    Geometric goodErrors_;
+    Geometric badErrors_;
+    Geometric leaveGood_;
+    Geometric leaveBad_;
+};
+
+BerSimulator::Statistics& BerSimulator::Statistics::operator+=(const Statistics& rhs)
+{
+    numFrames += rhs.numFrames;
+    numBits += rhs.numBits;
+    numChannelErrors += rhs.numChannelErrors;
+    numErroredFrames += rhs.numErroredFrames;
+    numFrameErrors += rhs.numFrameErrors;
+    numBitErrors += rhs.numBitErrors;
+    numDetected += rhs.numDetected;
+    numUndetected += rhs.numUndetected;
+    return *this;
+}
+
+BerSimulator::Channel BerSimulator::BinarySymmetric(double bitErrorRate)
+{
+    Channel channel;
+    channel.model = CM_BINARY_SYMMETRIC;
+    channel.bitErrorRate = bitErrorRate;
+    channel.goodToBad = 0;
+    channel.badToGood = 0;
+    channel.goodErrorRate = bitErrorRate;
+    channel.badErrorRate = bitErrorRate;
+    return channel;
+}
+
+BerSimulator::Channel BerSimulator::GilbertElliott(double goodToBad, double badToGood,
+                                                   double goodErrorRate, double badErrorRate)
+{
+    Channel channel;
+    channel.model = CM_GILBERT_ELLIOTT;
+    channel.bitErrorRate = 0;
+    channel.goodToBad = goodToBad;
+    channel.badToGood = badToGood;
+    channel.goodErrorRate = goodErrorRate;
+    channel.badErrorRate = badErrorRate;
+    return channel;
+}
+
+BerSimulator::BerSimulator(const Channel& channel, uint64_t seed) :
+    channel_(channel),
+    seed_(seed)
+{
+}
+
+template <typename Simulate>
+BerSimulator::Statistics BerSimulator::Run(uint64_t numFrames, size_t frameBits, ThreadPool& pool,
+                                           Simulate simulate) const
+{
+    uint64_t numBatches = (numFrames + BATCH_FRAMES - 1) / BATCH_FRAMES;
+    // A few tasks per thread even out the batches rich in errors.
+    uint64_t numTasks = std::min<uint64_t>(numBatches, 8 * pool.GetNumberOfThreads());
+    std::vector<Statistics> partial(static_cast<size_t>(numTasks), Statistics());
+    ErrorSource source(channel_, seed_);
+    for (uint64_t t = 0; t < numTasks; ++t)
+    {
+        uint64_t first = numBatches * t / numTasks;
+        uint64_t last = numBatches * (t + 1) / numTasks;
+        Statistics* statistics = &partial[static_cast<size_t>(t)];
+        pool.Submit([&source, &simulate, first, last, frameBits, statistics](void)
+        {
+            std::vector<size_t> positions;
+            for (uint64_t batch = first; batch < last; ++batch)
+            {
+                source.Generate(batch, BATCH_FRAMES * frameBits, positions);
+                statistics->numFrames += BATCH_FRAMES;
+                statistics->numBits += BATCH_FRAMES * frameBits;
+                statistics->numChannelErrors += positions.size();
+                if (!positions.empty())
+                {
+                    simulate(positions, *statistics);
+                }
+            }
+        });
+    }
+    pool.Wait();
+    Statistics total = Statistics();
+    for (size_t t = 0; t < partial.size(); ++t)
+    {
+        total += partial[t];
+    }
+    return total;
+}
+
+namespace
+{
+    /**
+     * Call \c frame(f, first, last) for each frame f with errors at positions[first..last).
+     */
+    template <typename Frame>
+    void ForEachErroredFrame(const std::vector<size_t>& positions, size_t frameBits, Frame frame)
+    {
+        size_t first = 0;
+        while (first < positions.size())
+        {
+            size_t f = positions[first] / frameBits;
+            size_t last = first + 1;
+            while (last < positions.size() && positions[last] / frameBits == f)
+            {
+                ++last;
+            }
+            frame(f, first, last);
+            first = last;
+        }
+    }
+}
+
+BerSimulator::Statistics BerSimulator::SimulateHamming(const HammingCodecs& hamming, uint64_t numFrames,
+                                                       ThreadPool& pool) const
+{
+    const size_t k = hamming.GetNumberOfMessageBits();
+    const size_t n = hamming.GetNumberOfCodeBits();
+    return Run(numFrames, n, pool, [&hamming, k, n](const std::vector<size_t>& positions, Statistics& statistics)
+    {
+        // Per-thread buffers: a batch of error patterns and of decoded messages.
+        thread_local std::vector<uint64_t> pattern;
+        thread_local std::vector<uint64_t> message;
+        thread_local std::vector<uint64_t> scratch;
+        pattern.assign(PackedBits::GetNumberOfWords(BATCH_FRAMES * n), 0);
+        message.assign(PackedBits::GetNumberOfWords(BATCH_FRAMES * k), 0);
+        size_t numErroredFrames = 0;
+        ForEachErroredFrame(positions, n, [&numErroredFrames](size_t, size_t, size_t) { ++numErroredFrames; });
+        statistics.numErroredFrames += numErroredFrames;
+        if (numErroredFrames > BATCH_FRAMES / 8)
+        {
+            // Many errored frames: decode the whole batch with the bit-sliced kernel.
+            for (size_t i = 0; i < positions.size(); ++i)
+            {
+                PackedBits::FlipBit(&pattern[0], positions[i]);
+            }
+            scratch.resize(hamming.GetScratchSize());
+            hamming.DecodeBlocks(&pattern[0], BATCH_FRAMES, &message[0], nullptr, &scratch[0]);
+            for (size_t f = 0; f < BATCH_FRAMES; ++f)
+            {
+                size_t numWrong = 0;
+                for (size_t i = 0; i < k; i += PackedBits::WORD_BITS)
+                {
+                    size_t m = k - i < PackedBits::WORD_BITS ? k - i : PackedBits::WORD_BITS;
+                    numWrong += PackedBits::PopCount(PackedBits::ExtractBits(&message[0], f * k + i, m));
+                }
+                statistics.numBitErrors += numWrong;
+                statistics.numFrameErrors += numWrong ? 1 : 0;
+            }
+            return;
+        }
+        // Few errored frames: decode only those.
+        ForEachErroredFrame(positions, n, [&](size_t f, size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                PackedBits::FlipBit(&pattern[0], positions[i] - f * n);
+            }
+            hamming.Decode(&pattern[0], &message[0]);
+            size_t numWrong = 0;
+            for (size_t w = 0; w < PackedBits::GetNumberOfWords(k); ++w)
+            {
+                numWrong += PackedBits::PopCount(message[w]);
+            }
+            statistics.numBitErrors += numWrong;
+            statistics.numFrameErrors += numWrong ? 1 : 0;
+            std::fill(pattern.begin(), pattern.begin() + PackedBits::GetNumberOfWords(n), 0);
+        });
+    });
+}
+
+BerSimulator::Statistics BerSimulator::SimulateCrc(const LfsrDivider& divider, size_t numMessageBits,
+                                                   uint64_t numFrames, ThreadPool& pool) const
+{
+    const size_t n = numMessageBits + divider.GetDegree();
+    return Run(numFrames, n, pool, [&divider, n](const std::vector<size_t>& positions, Statistics& statistics)
+    {
+        thread_local std::vector<uint64_t> pattern;
+        thread_local std::vector<uint64_t> reg;
+        pattern.assign(PackedBits::GetNumberOfWords(n), 0);
+        reg.resize(divider.GetNumberOfWords() + 1);
+        // An error pattern passes the check if and only if the generator divides it.
+        ForEachErroredFrame(positions, n, [&](size_t f, size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                PackedBits::FlipBit(&pattern[0], positions[i] - f * n);
+            }
+            std::fill(reg.begin(), reg.end(), 0);
+            divider.Update(&reg[0], &pattern[0], n);
+            bool passed = PackedBits::IsZero(&reg[0], divider.GetDegree());
+            ++statistics.numErroredFrames;
+            ++(passed ? statistics.numUndetected : statistics.numDetected);
+            std::fill(pattern.begin(), pattern.end(), 0);
+        });
+    });
+}
+
+#include "DataIo.h"
+void BerSimulator::Test(void)
+{
+    ThreadPool one(1);
+    ThreadPool three(3);
+    HammingCodecs hamming(57);
+
+    // Results do not depend on the number of threads.
+    BerSimulator bsc(BinarySymmetric(0.01), 7);
+    Statistics a = bsc.SimulateHamming(hamming, 20000, one);
+    Statistics b = bsc.SimulateHamming(hamming, 20000, three);
+    assert(a.numFrames == 20032 && a.numBits == 20032 * 63);
+    assert(a.numChannelErrors == b.numChannelErrors);
+    assert(a.numFrameErrors == b.numFrameErrors && a.numBitErrors == b.numBitErrors);
+    // A different seed gives different errors.
+    assert(BerSimulator(BinarySymmetric(0.01), 8).SimulateHamming(hamming, 20000, one).numChannelErrors
+           != a.numChannelErrors);
+
+    // The channel error rate, and the frames with two or more errors, which a
+    // Hamming code always decodes wrongly, within 5 standard deviations.
+    double expected = 0.01 * a.numBits;
+    assert(std::fabs(a.numChannelErrors - expected) < 5 * std::sqrt(expected));
+    double p0 = std::pow(0.99, 63);
+    double p1 = 63 * 0.01 * std::pow(0.99, 62);
+    expected = (1 - p0 - p1) * a.numFrames;
+    assert(std::fabs(a.numFrameErrors - expected) < 5 * std::sqrt(expected));
+    expected = (1 - p0) * a.numFrames;
+    assert(std::fabs(a.numErroredFrames - expected) < 5 * std::sqrt(expected));
+    assert(a.numBitErrors >= a.numFrameErrors);
+
+    // At a low error rate only the errored frames are decoded one by one.
+    Statistics r = BerSimulator(BinarySymmetric(1e-4), 3).SimulateHamming(hamming, 100000, three);
+    expected = (1 - std::pow(1 - 1e-4, 63)) * r.numFrames;
+    assert(std::fabs(r.numErroredFrames - expected) < 5 * std::sqrt(expected));
+    assert(r.numFrameErrors <= r.numErroredFrames / 50);
+
+    // CRC-4 (x^4 + x + 1) on 11 message bits detects all single and double
+    // errors, and misses about 1 in 16 random patterns.
+    LfsrDivider crc4(DataIo::FromString("10011"));
+    Statistics c = BerSimulator(BinarySymmetric(1e-3), 5).SimulateCrc(crc4, 11, 100000, three);
+    assert(c.numDetected + c.numUndetected == c.numErroredFrames);
+    c = BerSimulator(BinarySymmetric(0.5), 5).SimulateCrc(crc4, 11, 64000, three);
+    expected = c.numErroredFrames / 16.0;
+    assert(std::fabs(c.numUndetected - expected) < 5 * std::sqrt(expected));
+    Statistics single = BerSimulator(BinarySymmetric(1e-5), 9).SimulateCrc(crc4, 11, 640000, one);
+    assert(single.numErroredFrames > 0 && single.numUndetected == 0);
+
+    // Gilbert-Elliott: the bad state is entered 1 in 1000 bits and lasts 20 bits
+    // on average, so the channel error rate is about 0.5 * 20 / 1020.
+    BerSimulator ge(GilbertElliott(1e-3, 0.05, 0, 0.5), 11);
+    Statistics g = ge.SimulateHamming(hamming, 50000, three);
+    Statistics g1 = ge.SimulateHamming(hamming, 50000, one);
+    assert(g.numChannelErrors == g1.numChannelErrors && g.numFrameErrors == g1.numFrameErrors);
+    double rate = static_cast<double>(g.numChannelErrors) / g.numBits;
+    assert(rate > 0.7 * 0.5 * 20 / 1020 && rate < 1.3 * 0.5 * 20 / 1020);
+    // Bursts put several errors in a frame far more often than independent errors at the same rate.
+    Statistics i = BerSimulator(BinarySymmetric(rate), 11).SimulateHamming(hamming, 50000, three);
+    assert(g.numFrameErrors < i.numFrameErrors);
+    assert(static_cast<double>(g.numFrameErrors) / g.numErroredFrames >
+           static_cast<double>(i.numFrameErrors) / i.numErroredFrames);
+    (void)b;
+    (void)expected;
+    (void)single;
+    (void)g1;
+    (void)i;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "HammingCodecs.h"
+#include "LfsrDivider.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Monte Carlo simulation of the codecs over noisy binary channels.
+ *
+ * The codes are linear and their decoders depend on the received word only
+ * through the error pattern, so every frame sends the all-zero code word:
+ * the received word is the error pattern, and anything left after decoding
+ * is a residual error.
+ *
+ * Frames are simulated in batches of 64.  The error pattern of a batch is
+ * drawn from a counter-based generator keyed by the seed and the batch
+ * index, by sampling the gaps between errors, so the cost follows the
+ * number of errors rather than the number of bits, and the results do not
+ * depend on the number of threads.
+ */
+class BerSimulator
+{
+public:
+    static const size_t BATCH_FRAMES = 64;
+
+    enum ChannelModel
+    {
+        CM_BINARY_SYMMETRIC,    ///< independent errors at bitErrorRate.
+        CM_GILBERT_ELLIOTT,     ///< a good and a bad state, each with its own error rate.
+    };
+
+    struct Channel
+    {
+        ChannelModel model;
+        double bitErrorRate;    ///< CM_BINARY_SYMMETRIC only.
+        double goodToBad;       ///< per-bit probability of entering the bad state.
+        double badToGood;       ///< per-bit probability of leaving the bad state.
+        double goodErrorRate;
+        double badErrorRate;
+    };
+
+    /**
+     * Totals over the simulated frames.
+     */
+    struct Statistics
+    {
+        uint64_t numFrames;
+        uint64_t numBits;               ///< code bits sent.
+        uint64_t numChannelErrors;      ///< bits flipped by the channel.
+        uint64_t numErroredFrames;      ///< frames with at least one channel error.
+        uint64_t numFrameErrors;        ///< Hamming: frames whose decoded message is wrong.
+        uint64_t numBitErrors;          ///< Hamming: wrong message bits after decoding.
+        uint64_t numDetected;           ///< CRC: errored frames whose check fails.
+        uint64_t numUndetected;         ///< CRC: errored frames whose check passes.
+
+        Statistics& operator+=(const Statistics& rhs);
+    };
+
+    static Channel BinarySymmetric(double bitErrorRate);
+
+    /**
+     * The bad state lasts 1 / badToGood bits on average.
+     */
+    static Channel GilbertElliott(double goodToBad, double badToGood, double goodErrorRate, double badErrorRate);
+
+    BerSimulator(const Channel& channel, uint64_t seed = 1);
+
+    /**
+     * Send \c numFrames code blocks of \c hamming; frames are rounded up to whole batches.
+     */
+    Statistics SimulateHamming(const HammingCodecs& hamming, uint64_t numFrames, ThreadPool& pool) const;
+
+    /**
+     * Send \c numFrames frames of \c numMessageBits message bits followed by the CRC of \c divider.
+     */
+    Statistics SimulateCrc(const LfsrDivider& divider, size_t numMessageBits, uint64_t numFrames, ThreadPool& pool) const;
+
+    static void Test(void);
+
+private:
+    class ErrorSource;
+
+    /**
+     * Run \c simulate(firstBatch, numBatches, statistics) over the batches,
+     * spread over \c pool, and add up the statistics in batch order.
+     */
+    template <typename Simulate>
+    Statistics Run(uint64_t numFrames, size_t frameBits, ThreadPool& pool, Simulate simulate) const;
+
+private:
+    Channel channel_;
+    uint64_t seed_;
+};
@@ -1,47 +1,85 @@
 #include "BitMatrix.h"
+#include "BitTranspose.h"
 #include "DataIo.h"
+#include "MappedFile.h"
+#include "PackedBits.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <istream>
 #include <memory>
 #include <sstream>
 
+BitMatrix::Reference::Reference(uint64_t* word, uint64_t mask) :
+    word_(word),
+    mask_(mask)
+{
+}
+
+BitMatrix::Reference::operator bool(void) const
+{
+    return (*word_ & mask_) != 0;
+}
+
+BitMatrix::Reference& BitMatrix::Reference::operator=(bool value)
+{
+    if (value)
+    {
+        *word_ |= mask_;
+    }
+    else
+    {
+        *word_ &= ~mask_;
+    }
+    return *this;
+}
+
+BitMatrix::Reference& BitMatrix::Reference::operator=(const Reference& rhs)
+{
+    return *this = static_cast<bool>(rhs);
+}
+
 BitMatrix::BitMatrix(void) :
     d1_(0),
     d2_(0),
+    order_(SO_COLUMN_MAJOR),
+    stride_(0),
     data_(nullptr)
 {
 }
 
-BitMatrix::BitMatrix(size_t d1, size_t d2) :
+BitMatrix::BitMatrix(size_t d1, size_t d2, StorageOrder order) :
     d1_(d1),
     d2_(d2),
+    order_(order),
+    stride_(0),
     data_(nullptr)
 {
-    data_ = new bool[d1 * d2];
-    assert(data_);
-    std::memset(data_, 0, d1_ * d2_);
+    Allocate();
+    std::memset(data_, 0, GetNumberOfLines() * stride_ * sizeof (uint64_t));
 }
 
 BitMatrix::BitMatrix(const BitMatrix& rhs) :
     d1_(rhs.d1_),
-    d2_(rhs.d2_)
+    d2_(rhs.d2_),
+    order_(rhs.order_),
+    stride_(0),
+    data_(nullptr)
 {
-    if (data_)
-    {
-        delete[] data_;
-        data_ = nullptr;
-    }
-    data_ = new bool[d1_ * d2_];
-    assert(data_);
-    std::memcpy(data_, rhs.data_, d1_ * d2_);
+    Allocate();
+    std::memcpy(data_, rhs.data_, GetNumberOfLines() * stride_ * sizeof (uint64_t));
 }
 
 BitMatrix::BitMatrix(BitMatrix&& rhs) :
     d1_(rhs.d1_),
     d2_(rhs.d2_),
+    order_(rhs.order_),
+    stride_(rhs.stride_),
     data_(rhs.data_)
 {
     rhs.d1_ = 0;
     rhs.d2_ = 0;
+    rhs.stride_ = 0;
     rhs.data_ = nullptr;
 }
 
@@ -62,28 +100,45 @@ void BitMatrix::Clear(void)
     }
     d1_ = 0;
     d2_ = 0;
+    stride_ = 0;
 }
 
-BitMatrix& BitMatrix::operator=(const BitMatrix& rhs)
+void BitMatrix::Allocate(void)
 {
-    Clear();
-    d1_ = rhs.d1_;
-    d2_ = rhs.d2_;
-    data_ = new bool[d1_ * d2_];
+    stride_ = PackedBits::GetNumberOfWords(GetLineLength());
+    data_ = new uint64_t[GetNumberOfLines() * stride_];
     assert(data_);
-    std::memcpy(data_, rhs.data_, d1_ * d2_);
+}
+
+BitMatrix& BitMatrix::operator=(const BitMatrix& rhs)
+{
+    if (this != &rhs)
+    {
+        Clear();
+        d1_ = rhs.d1_;
+        d2_ = rhs.d2_;
+        order_ = rhs.order_;
+        Allocate();
+        std::memcpy(data_, rhs.data_, GetNumberOfLines() * stride_ * sizeof (uint64_t));
+    }
     return *this;
 }
 
 BitMatrix& BitMatrix::operator=(BitMatrix&& rhs)
 {
-    Clear();
-    d1_ = rhs.d1_;
-    d2_ = rhs.d2_;
-    data_ = rhs.data_;
-    rhs.d1_ = 0;
-    rhs.d2_ = 0;
-    rhs.data_ = nullptr;
+    if (this != &rhs)
+    {
+        Clear();
+        d1_ = rhs.d1_;
+        d2_ = rhs.d2_;
+        order_ = rhs.order_;
+        stride_ = rhs.stride_;
+        data_ = rhs.data_;
+        rhs.d1_ = 0;
+        rhs.d2_ = 0;
+        rhs.stride_ = 0;
+        rhs.data_ = nullptr;
+    }
     return *this;
 }
 
@@ -97,7 +152,14 @@ bool BitMatrix::operator==(const BitMatrix& rhs) const
     }
     if (result)
     {
-        result = !std::memcmp(data_, rhs.data_, d1_ * d2_);
+        if (order_ == rhs.order_)
+        {
+            result = !std::memcmp(data_, rhs.data_, GetNumberOfLines() * stride_ * sizeof (uint64_t));
+        }
+        else
+        {
+            result = (*this == rhs.ToStorageOrder(order_));
+        }
     }
     return result;
 }
@@ -107,105 +169,413 @@ bool BitMatrix::operator!=(const BitMatrix& rhs) const
     return !(*this == rhs);
 }
 
-BitMatrix BitMatrix::FromString(const std::string& matrix)
+/**
+ * Incremental parser of the text form of a matrix.
+ *
+ * Bits go straight into the word storage of the result, row after row;
+ * the number of columns is fixed by the first row, so every later row is
+ * checked as it is read.
+ */
+class BitMatrix::Parser
 {
-    BitMatrix result;
-    bool bad = false;
-    do
+public:
+    /**
+     * @param [in] sizeHint   the length of the text if known, else 0.
+     */
+    explicit Parser(size_t sizeHint) :
+        state_(ST_BEFORE),
+        sizeHint_(sizeHint),
+        offset_(0),
+        line_(1),
+        lineStart_(0),
+        data_(nullptr),
+        capacity_(0),
+        numWords_(0),
+        d1_(0),
+        d2_(0),
+        stride_(0),
+        column_(0),
+        acc_(0)
     {
-        // Find '['.
-        size_t openBracket = matrix.find('[', 0);
-        if (openBracket == std::string::npos)
-        {
-            bad = true;
-            break;
-        }
-        size_t closeBracket = matrix.find(']', openBracket + 1);
-        if (closeBracket == std::string::npos)
-        {
-            bad = true;
-            break;
-        }
-        // Obtain d1 and d2.
-        size_t d1 = 0;
-        size_t d2 = 0;
-        size_t start = openBracket + 1;
-        while (start < closeBracket)
+        error_.message = nullptr;
+        error_.line = 0;
+        error_.column = 0;
+        error_.row = 0;
+        error_.expected = 0;
+        error_.found = 0;
+    }
+
+    ~Parser(void)
+    {
+        delete[] data_;
+    }
+
+    /**
+     * @return false once the text is known to be malformed.
+     */
+    bool Feed(const char* text, size_t length)
+    {
+        size_t i = 0;
+        while (i < length && state_ == ST_BEFORE)
         {
-            size_t end = matrix.find_first_of(";\r\n", start + 1);
-            if (end == std::string::npos || end > closeBracket)
+            Advance(text[i]);
+            if (text[i++] == '[')
             {
-                end = closeBracket;
+                state_ = ST_INSIDE;
             }
-            std::vector<bool> row = DataIo::FromString(matrix.substr(start, end - start));
-            if (row.size())
+        }
+        for (; i < length && state_ == ST_INSIDE; ++i)
+        {
+            char c = text[i];
+            switch (c)
             {
-                if (!d2)
-                {
-                    d2 = row.size();
-                }
-                else if (d2 != row.size())
+            case '0':
+            case '1':
+                AppendBit(c - '0');
+                break;
+            case ';':
+            case '\r':
+            case '\n':
+                EndRow();
+                break;
+            case ']':
+                if (EndRow())
                 {
-                    // Column size mismatch.
-                    bad = true;
-                    break;
+                    state_ = ST_DONE;
                 }
-                ++d1;
+                break;
             }
-            start = end + 1;
+            Advance(c);
         }
-        if (bad)
+        offset_ += length - i;
+        return state_ != ST_FAILED;
+    }
+
+    /**
+     * @return false if the text is malformed.
+     */
+    bool Finish(BitMatrix& matrix)
+    {
+        if (state_ == ST_BEFORE)
         {
-            break;
+            Fail(d1_, "'[' not found");
         }
-        // Generate matrix.
-        result = BitMatrix(d1, d2);
-        size_t i1 = 0;
-        start = openBracket + 1;
-        while (start < closeBracket)
+        else if (state_ == ST_INSIDE)
         {
-            size_t end = matrix.find_first_of(";\r\n", start + 1);
-            if (end == std::string::npos || end > closeBracket)
-            {
-                end = closeBracket;
-            }
-            std::vector<bool> row = DataIo::FromString(matrix.substr(start, end - start));
-            if (row.size())
+            Fail(d1_, "']' not found");
+        }
+        if (state_ == ST_FAILED)
+        {
+            return false;
+        }
+        matrix.Clear();
+        matrix.d1_ = d1_;
+        matrix.d2_ = d2_;
+        matrix.order_ = SO_ROW_MAJOR;
+        matrix.stride_ = stride_;
+        if (data_)
+        {
+            matrix.data_ = data_;
+            data_ = nullptr;
+        }
+        else
+        {
+            matrix.Allocate();
+        }
+        return true;
+    }
+
+    const ParseError& GetError(void) const
+    {
+        return error_;
+    }
+
+private:
+    void Advance(char c)
+    {
+        ++offset_;
+        if (c == '\n')
+        {
+            ++line_;
+            lineStart_ = offset_;
+        }
+    }
+
+    void Fail(size_t row, const char* message)
+    {
+        state_ = ST_FAILED;
+        error_.message = message;
+        error_.line = line_;
+        error_.column = offset_ - lineStart_ + 1;
+        error_.row = row;
+    }
+
+    void AppendBit(unsigned bit)
+    {
+        if (d1_ && column_ == d2_)
+        {
+            error_.expected = d2_;
+            error_.found = column_ + 1;
+            Fail(d1_, "too many columns");
+            return;
+        }
+        acc_ |= uint64_t(bit) << (column_ % PackedBits::WORD_BITS);
+        ++column_;
+        if (column_ % PackedBits::WORD_BITS == 0)
+        {
+            Store();
+        }
+    }
+
+    /**
+     * @return false on a column mismatch.
+     */
+    bool EndRow(void)
+    {
+        if (!column_)
+        {
+            // Empty rows are skipped.
+            return true;
+        }
+        if (d1_ && column_ != d2_)
+        {
+            error_.expected = d2_;
+            error_.found = column_;
+            Fail(d1_, "too few columns");
+            return false;
+        }
+        if (column_ % PackedBits::WORD_BITS)
+        {
+            Store();
+        }
+        if (!d1_)
+        {
+            d2_ = column_;
+            stride_ = PackedBits::GetNumberOfWords(d2_);
+        }
+        ++d1_;
+        column_ = 0;
+        return true;
+    }
+
+    void Store(void)
+    {
+        if (numWords_ == capacity_)
+        {
+            Grow();
+        }
+        data_[numWords_++] = acc_;
+        acc_ = 0;
+    }
+
+    void Grow(void)
+    {
+        size_t capacity = capacity_ ? 2 * capacity_ : 64;
+        if (d1_ && sizeHint_ > offset_)
+        {
+            // Every row takes at least d2_ characters, which bounds the
+            // remaining rows; one allocation then holds the whole matrix.
+            size_t bound = numWords_ + ((sizeHint_ - offset_) / d2_ + 1) * stride_;
+            if (bound > capacity_)
             {
-                for (size_t i2 = 0; i2 < row.size(); ++i2)
-                {
-                    result.Get(i1, i2) = row[i2];
-                }
-                ++i1;
+                capacity = bound;
             }
-            start = end + 1;
         }
+        uint64_t* data = new uint64_t[capacity];
+        if (numWords_)
+        {
+            std::memcpy(data, data_, numWords_ * sizeof (uint64_t));
+        }
+        delete[] data_;
+        data_ = data;
+        capacity_ = capacity;
     }
-    while (false);
+
+private:
+    enum State
+    {
+        ST_BEFORE,      ///< looking for '['.
+        ST_INSIDE,      ///< reading rows.
+        ST_DONE,        ///< ']' read; the rest is ignored.
+        ST_FAILED,
+    };
+
+    State state_;
+    size_t sizeHint_;
+    size_t offset_;         ///< characters read so far.
+    size_t line_;
+    size_t lineStart_;      ///< offset of the current line.
+    uint64_t* data_;
+    size_t capacity_;       ///< words allocated.
+    size_t numWords_;       ///< words stored.
+    size_t d1_;             ///< complete rows.
+    size_t d2_;             ///< columns of the first row.
+    size_t stride_;
+    size_t column_;         ///< bits of the current row.
+    uint64_t acc_;          ///< the word being filled.
+    ParseError error_;
+};
+
+BitMatrix BitMatrix::FromString(const std::string& matrix)
+{
+    BitMatrix result;
+    Parse(matrix.data(), matrix.length(), result);
     return result;
 }
 
+bool BitMatrix::Parse(const char* text, size_t length, BitMatrix& matrix, ParseError* error)
+{
+    Parser parser(length);
+    parser.Feed(text, length);
+    bool ok = parser.Finish(matrix);
+    if (!ok && error)
+    {
+        *error = parser.GetError();
+    }
+    return ok;
+}
+
+bool BitMatrix::Parse(std::istream& in, BitMatrix& matrix, ParseError* error)
+{
+    const size_t BLOCK_SIZE = 64 * 1024;
+    std::unique_ptr<char[]> block(new char[BLOCK_SIZE]);
+    Parser parser(0);
+    while (in)
+    {
+        in.read(block.get(), BLOCK_SIZE);
+        if (!parser.Feed(block.get(), static_cast<size_t>(in.gcount())))
+        {
+            break;
+        }
+    }
+    bool ok = parser.Finish(matrix);
+    if (!ok && error)
+    {
+        *error = parser.GetError();
+    }
+    return ok;
+}
+
+bool BitMatrix::Load(const std::string& path, BitMatrix& matrix, ParseError* error)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        if (error)
+        {
+            error->message = "cannot open file";
+            error->line = 0;
+            error->column = 0;
+            error->row = 0;
+            error->expected = 0;
+            error->found = 0;
+        }
+        return false;
+    }
+    return Parse(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), matrix, error);
+}
+
 std::string BitMatrix::ToString(void) const
 {
     std::ostringstream oss;
-    oss << "[";
-    for (size_t i1 = 0; i1 < d1_; ++i1)
+    Write(oss, OF_TEXT);
+    return oss.str();
+}
+
+const uint64_t* BitMatrix::GetRow(size_t i1, uint64_t* buffer) const
+{
+    if (order_ == SO_ROW_MAJOR)
     {
-        if (i1 == 0)
+        return GetLine(i1);
+    }
+    std::fill(buffer, buffer + PackedBits::GetNumberOfWords(d2_), 0);
+    for (size_t i2 = 0; i2 < d2_; ++i2)
+    {
+        if (PackedBits::GetBit(GetLine(i2), i1))
         {
-            oss << ' ';
+            PackedBits::SetBit(buffer, i2, true);
         }
-        else
+    }
+    return buffer;
+}
+
+void BitMatrix::Write(std::ostream& os, OutputFormat format) const
+{
+    if (format == OF_BINARY)
+    {
+        // Byte by byte, so that the file does not depend on the host order.
+        std::vector<uint8_t> bytes(stride_ * sizeof (uint64_t));
+        for (size_t i = 0; i < GetNumberOfLines() && !bytes.empty(); ++i)
+        {
+            for (size_t w = 0; w < stride_; ++w)
+            {
+                PackedBits::StoreLittleEndian(&bytes[w * sizeof (uint64_t)], GetLine(i)[w]);
+            }
+            os.write(reinterpret_cast<const char*>(&bytes[0]), static_cast<std::streamsize>(bytes.size()));
+        }
+        return;
+    }
+    std::vector<uint64_t> buffer(order_ == SO_ROW_MAJOR ? 0 : PackedBits::GetNumberOfWords(d2_) + 1);
+    std::string text;
+    if (format == OF_SPARSE)
+    {
+        size_t numOnes = 0;
+        for (size_t i = 0; i < GetNumberOfLines(); ++i)
         {
-            oss << ';' << std::endl << "  ";
+            for (size_t w = 0; w < stride_; ++w)
+            {
+                numOnes += PackedBits::PopCount(GetLine(i)[w]);
+            }
         }
-        for (size_t i2 = 0; i2 < d2_; ++i2)
+        os << "%%MatrixMarket matrix coordinate pattern general\n"
+           << d1_ << ' ' << d2_ << ' ' << numOnes << '\n';
+    }
+    else if (format == OF_TEXT)
+    {
+        os << '[';
+        text.reserve(2 * d2_ + 4);
+    }
+    for (size_t i1 = 0; i1 < d1_; ++i1)
+    {
+        const uint64_t* row = GetRow(i1, buffer.empty() ? nullptr : &buffer[0]);
+        switch (format)
         {
-            oss << (Get(i1, i2) ? 1 : 0) << ' ';
+        case OF_TEXT:
+            text.assign(i1 == 0 ? " " : ";\n  ");
+            for (size_t i2 = 0; i2 < d2_; ++i2)
+            {
+                text.push_back(PackedBits::GetBit(row, i2) ? '1' : '0');
+                text.push_back(' ');
+            }
+            os << text;
+            break;
+        case OF_HEX:
+            DataIo::ToHex(row, d2_, text);
+            os << text << '\n';
+            break;
+        case OF_SPARSE:
+            for (size_t w = 0; w < PackedBits::GetNumberOfWords(d2_); ++w)
+            {
+                for (uint64_t bits = row[w]; bits; bits &= bits - 1)
+                {
+                    os << i1 + 1 << ' ' << w * PackedBits::WORD_BITS + PackedBits::CountTrailingZeros(bits) + 1 << '\n';
+                }
+            }
+            break;
+        default:
+            break;
         }
     }
-    oss << ']';
-    return oss.str();
+    if (format == OF_TEXT)
+    {
+        os << ']';
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const BitMatrix& matrix)
+{
+    matrix.Write(os, BitMatrix::OF_TEXT);
+    return os;
 }
 
 size_t BitMatrix::GetSize(size_t d) const
@@ -214,37 +584,146 @@ size_t BitMatrix::GetSize(size_t d) const
     return d == 0 ? d1_ : d2_;
 }
 
-const bool& BitMatrix::Get(size_t i1, size_t i2) const
+BitMatrix::StorageOrder BitMatrix::GetStorageOrder(void) const
+{
+    return order_;
+}
+
+size_t BitMatrix::GetNumberOfLines(void) const
+{
+    return order_ == SO_COLUMN_MAJOR ? d2_ : d1_;
+}
+
+size_t BitMatrix::GetLineLength(void) const
+{
+    return order_ == SO_COLUMN_MAJOR ? d1_ : d2_;
+}
+
+size_t BitMatrix::GetWordsPerLine(void) const
+{
+    return stride_;
+}
+
+const uint64_t* BitMatrix::GetLine(size_t i) const
+{
+    assert(i < GetNumberOfLines());
+    return data_ + i * stride_;
+}
+
+uint64_t* BitMatrix::GetLine(size_t i)
+{
+    assert(i < GetNumberOfLines());
+    return data_ + i * stride_;
+}
+
+bool BitMatrix::Get(size_t i1, size_t i2) const
 {
     assert(i1 < d1_);
     assert(i2 < d2_);
-    return data_[i2 * d1_ + i1];
+    return order_ == SO_COLUMN_MAJOR ? PackedBits::GetBit(data_ + i2 * stride_, i1)
+                                     : PackedBits::GetBit(data_ + i1 * stride_, i2);
 }
 
-bool& BitMatrix::Get(size_t i1, size_t i2)
+BitMatrix::Reference BitMatrix::Get(size_t i1, size_t i2)
 {
     assert(i1 < d1_);
     assert(i2 < d2_);
-    return data_[i2 * d1_ + i1];
+    size_t line = order_ == SO_COLUMN_MAJOR ? i2 : i1;
+    size_t bit = order_ == SO_COLUMN_MAJOR ? i1 : i2;
+    return Reference(data_ + line * stride_ + bit / PackedBits::WORD_BITS,
+                     uint64_t(1) << (bit % PackedBits::WORD_BITS));
 }
 
 std::vector<bool> BitMatrix::Multiply(const std::vector<bool>& vec) const
 {
     assert(vec.size() == d2_);
-    std::vector<bool> result(d1_, false);
-    const bool* p = data_;
-    for (size_t i = 0; i < d2_; ++i)
+    std::vector<uint64_t> v = PackedBits::FromVector(vec);
+    std::vector<uint64_t> result(PackedBits::GetNumberOfWords(d1_) + 1, 0);
+    Multiply(v.empty() ? nullptr : &v[0], &result[0]);
+    return PackedBits::ToVector(&result[0], d1_);
+}
+
+void BitMatrix::Multiply(const uint64_t* vec, uint64_t* result) const
+{
+    size_t numWords = PackedBits::GetNumberOfWords(d1_);
+    for (size_t w = 0; w < numWords; ++w)
     {
+        result[w] = 0;
+    }
+    if (order_ == SO_COLUMN_MAJOR)
+    {
+        // Sum the columns selected by the set bits of vec.
+        for (size_t v = 0; v < PackedBits::GetNumberOfWords(d2_); ++v)
+        {
+            for (uint64_t bits = vec[v]; bits; bits &= bits - 1)
+            {
+                const uint64_t* column = GetLine(v * PackedBits::WORD_BITS + PackedBits::CountTrailingZeros(bits));
+                for (size_t w = 0; w < stride_; ++w)
+                {
+                    result[w] ^= column[w];
+                }
+            }
+        }
+    }
+    else
+    {
+        // Inner product of each row and vec.
         for (size_t j = 0; j < d1_; ++j)
         {
-            result[j] = result[j] ^ (vec[i] & *p);
-            ++p;
+            const uint64_t* row = GetLine(j);
+            uint64_t acc = 0;
+            for (size_t w = 0; w < stride_; ++w)
+            {
+                acc ^= row[w] & vec[w];
+            }
+            if (PackedBits::Parity(acc))
+            {
+                PackedBits::FlipBit(result, j);
+            }
         }
     }
+}
+
+BitMatrix BitMatrix::Transpose(void) const
+{
+    // The lines of the transpose are the cross-lines of this matrix.
+    BitMatrix result(d2_, d1_, order_);
+    if (d1_ && d2_)
+    {
+        BitTranspose::Transpose(data_, stride_, GetNumberOfLines(), GetLineLength(),
+                                result.data_, result.stride_);
+    }
     return result;
 }
 
-#include "DataIo.h"
+void BitMatrix::TransposeInPlace(void)
+{
+    if (d1_ == d2_)
+    {
+        BitTranspose::TransposeSquare(data_, stride_, d1_);
+    }
+    else
+    {
+        *this = Transpose();
+    }
+}
+
+BitMatrix BitMatrix::ToStorageOrder(StorageOrder order) const
+{
+    if (order == order_)
+    {
+        return *this;
+    }
+    BitMatrix result(d1_, d2_, order);
+    if (d1_ && d2_)
+    {
+        BitTranspose::Transpose(data_, stride_, GetNumberOfLines(), GetLineLength(),
+                                result.data_, result.stride_);
+    }
+    return result;
+}
+
+#include <cstdio>
 void BitMatrix::Test(void)
 {
     // FromString
@@ -259,12 +738,87 @@ void BitMatrix::Test(void)
     assert(m1.Get(2,1) == false);
     assert(m1.Get(2,2) == true);
 
+    // Malformed text, with the location of the error.
+    ParseError error;
+    BitMatrix bad;
+    assert(FromString("1 0 1").GetSize(0) == 0);
+    bool ok = Parse("[1 0 1;\n 1 0\n 1 1 1]", 20, bad, &error);
+    assert(!ok);
+    assert(std::string(error.message) == "too few columns");
+    assert(error.line == 2 && error.column == 5);
+    assert(error.row == 1 && error.expected == 3 && error.found == 2);
+    const char* wide = "[1 0 1;\n 1 0 1 1]";
+    ok = Parse(wide, std::strlen(wide), bad, &error);
+    assert(!ok);
+    assert(std::string(error.message) == "too many columns");
+    assert(error.line == 2 && error.column == 8 && error.row == 1);
+    ok = Parse("[1 0", 4, bad, &error);
+    assert(!ok);
+    assert(error.line == 1 && error.column == 5);
+    assert(bad.GetSize(0) == 0);
+    ok = Parse("[]", 2, bad);
+    assert(ok && bad.GetSize(0) == 0 && bad.GetSize(1) == 0);
+
+    // Rows of several words, from a string, a stream and a mapped file.
+    BitMatrix wideMatrix(37, 150, SO_ROW_MAJOR);
+    for (size_t i1 = 0; i1 < 37; ++i1)
+    {
+        for (size_t i2 = 0; i2 < 150; ++i2)
+        {
+            wideMatrix.Get(i1, i2) = ((i1 * 31 + i2 * 17) % 7) < 3;
+        }
+    }
+    std::string text = wideMatrix.ToString();
+    assert(FromString(text) == wideMatrix);
+    std::istringstream iss(text);
+    BitMatrix parsed;
+    ok = Parse(iss, parsed);
+    assert(ok && parsed == wideMatrix);
+    const char* path = "BitMatrix.test.tmp";
+    {
+        MappedFile out;
+        ok = out.Create(path, text.size());
+        assert(ok);
+        std::memcpy(out.GetData(), text.data(), text.size());
+    }
+    parsed = BitMatrix();
+    ok = Load(path, parsed);
+    assert(ok && parsed == wideMatrix);
+    std::remove(path);
+    ok = Load("BitMatrix.missing.tmp", parsed, &error);
+    assert(!ok);
+    (void)ok;
+
     // ToString
     std::string str = m1.ToString();
     assert(str == "[ 1 1 1 ;\n"
                   "  0 0 0 ;\n"
                   "  1 0 1 ]");
 
+    // Streaming output in every format, from both storage orders.
+    BitMatrix m2 = FromString("[1 0 1 1 0; 0 1 0 0 1]");
+    for (int order = 0; order < 2; ++order)
+    {
+        BitMatrix m = m2.ToStorageOrder(order ? SO_COLUMN_MAJOR : SO_ROW_MAJOR);
+        std::ostringstream text;
+        text << m;
+        assert(text.str() == "[ 1 0 1 1 0 ;\n  0 1 0 0 1 ]");
+        std::ostringstream hex;
+        m.Write(hex, OF_HEX);
+        assert(hex.str() == "16\n09\n");
+        std::ostringstream sparse;
+        m.Write(sparse, OF_SPARSE);
+        assert(sparse.str() == "%%MatrixMarket matrix coordinate pattern general\n"
+                               "2 5 5\n"
+                               "1 1\n1 3\n1 4\n2 2\n2 5\n");
+    }
+    std::ostringstream binary;
+    m2.Write(binary, OF_BINARY);
+    assert(binary.str().size() == 2 * sizeof (uint64_t));
+    std::string bytes = binary.str();
+    assert(bytes == std::string("\x0D\0\0\0\0\0\0\0\x12\0\0\0\0\0\0\0", 16));
+    (void)bytes;
+
     // Multiply
     BitMatrix bm = FromString("[ 1 1 ; \
                                  1 0 ; \
@@ -278,4 +832,33 @@ void BitMatrix::Test(void)
                                                    1 \
                                                    0");
     assert(DataIo::IsEqual(u, result));
+
+    // Storage order
+    BitMatrix cm = bm.ToStorageOrder(SO_COLUMN_MAJOR);
+    assert(cm.GetStorageOrder() == SO_COLUMN_MAJOR);
+    assert(cm == bm);
+    assert(cm.ToString() == bm.ToString());
+    assert(DataIo::IsEqual(cm.Multiply(v), result));
+    cm.Get(2, 0) = true;
+    assert(cm != bm);
+
+    // Transpose
+    BitMatrix t = bm.Transpose();
+    assert(t == FromString("[ 1 1 0 ; 1 0 1 ]"));
+    assert(t.Transpose() == bm);
+    bm.TransposeInPlace();
+    assert(t == bm);
+
+    BitMatrix big(130, 130, SO_COLUMN_MAJOR);
+    for (size_t i = 0; i < 130; ++i)
+    {
+        big.Get(i, (i * 7 + 3) % 130) = true;
+    }
+    BitMatrix bigT = big.Transpose();
+    big.TransposeInPlace();
+    assert(big == bigT);
+    for (size_t i = 0; i < 130; ++i)
+    {
+        assert(big.Get((i * 7 + 3) % 130, i));
+    }
 }
@@ -1,11 +1,67 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
 #include <vector>
 
+/**
+ * A matrix over GF(2).
+ *
+ * Elements are packed into 64-bit words (see PackedBits), line by line.
+ * A line is a column or a row depending on the storage order chosen at
+ * construction.  Each line starts at a word boundary.
+ */
 class BitMatrix
 {
+public:
+    enum StorageOrder
+    {
+        SO_COLUMN_MAJOR,    ///< each column is a packed line.
+        SO_ROW_MAJOR,       ///< each row is a packed line.
+    };
+
+    enum OutputFormat
+    {
+        OF_TEXT,            ///< "[ 1 0 1 ;\n  0 1 1 ]", as ToString().
+        OF_HEX,             ///< one row per line in hexadecimal, as DataIo::ToHex().
+        OF_SPARSE,          ///< the positions of ones, in Matrix Market coordinate format.
+        OF_BINARY,          ///< the packed lines as stored, stride words each, every word little-endian.
+    };
+
+    /**
+     * A writable reference to an element.
+     */
+    class Reference
+    {
+    public:
+        Reference(uint64_t* word, uint64_t mask);
+
+        operator bool(void) const;
+        Reference& operator=(bool value);
+        Reference& operator=(const Reference& rhs);
+
+    private:
+        uint64_t* word_;
+        uint64_t mask_;
+    };
+
+    /**
+     * Where and why parsing a matrix failed.
+     */
+    struct ParseError
+    {
+        const char* message;    ///< what went wrong.
+        size_t line;            ///< 1-based line of the text.
+        size_t column;          ///< 1-based character within the line.
+        size_t row;             ///< 0-based row of the matrix.
+        size_t expected;        ///< columns of the first row, for a column mismatch.
+        size_t found;           ///< columns of the offending row, for a column mismatch.
+    };
+
 public:
     BitMatrix(void);
-    BitMatrix(size_t d1, size_t d2);
+    BitMatrix(size_t d1, size_t d2, StorageOrder order = SO_COLUMN_MAJOR);
     BitMatrix(const BitMatrix& rhs);
     BitMatrix(BitMatrix&& rhs);
 
@@ -14,6 +70,10 @@ public:
     BitMatrix& operator=(const BitMatrix& rhs);
     BitMatrix& operator=(BitMatrix&& rhs);
 
+    /**
+     * Matrices are equal if they have the same size and elements,
+     * regardless of their storage order.
+     */
     bool operator==(const BitMatrix& rhs) const;
     bool operator!=(const BitMatrix& rhs) const;
 
@@ -23,34 +83,135 @@ public:
      */
     size_t GetSize(size_t d) const;
 
+    StorageOrder GetStorageOrder(void) const;
+
+    /**
+     * @return The number of lines, i.e. d2_ if column-major, or d1_ if row-major.
+     */
+    size_t GetNumberOfLines(void) const;
+
+    /**
+     * @return The number of bits per line, i.e. d1_ if column-major, or d2_ if row-major.
+     */
+    size_t GetLineLength(void) const;
+
+    /**
+     * @return The number of words between consecutive lines.
+     */
+    size_t GetWordsPerLine(void) const;
+
+    /**
+     * @param [in] i   0 <= i <= GetNumberOfLines() - 1
+     */
+    const uint64_t* GetLine(size_t i) const;
+
+    /**
+     * @param [in] i   0 <= i <= GetNumberOfLines() - 1
+     *
+     * The unused bits of the last word of the line must be kept zero.
+     */
+    uint64_t* GetLine(size_t i);
+
+    /**
+     * Parse a matrix such as "[1 0 1; 0 1 1]".
+     * The result is row-major.
+     * If the string is malformed, an empty matrix is returned.
+     */
     static BitMatrix FromString(const std::string& matrix);
+
+    /**
+     * Parse a matrix such as "[1 0 1; 0 1 1]" in a single pass, straight into
+     * packed row-major storage.  Rows end at ';' or a line break; characters
+     * other than '0', '1', ';', line breaks and brackets are ignored.
+     * @param [in]  text     the characters, e.g. a memory-mapped file.
+     * @param [out] matrix   the matrix; left unchanged on failure.
+     * @param [out] error    if not null, set on failure.
+     * @return false if the text is malformed.
+     */
+    static bool Parse(const char* text, size_t length, BitMatrix& matrix, ParseError* error = nullptr);
+
+    /**
+     * Parse() reading \c in a block at a time.
+     */
+    static bool Parse(std::istream& in, BitMatrix& matrix, ParseError* error = nullptr);
+
+    /**
+     * Parse() a memory-mapped file.
+     * @return false if the file cannot be mapped or is malformed.
+     */
+    static bool Load(const std::string& path, BitMatrix& matrix, ParseError* error = nullptr);
     std::string ToString(void) const;
 
+    /**
+     * Write the matrix a row at a time, without building it as a string.
+     * Open the stream in binary mode for OF_BINARY.
+     */
+    void Write(std::ostream& os, OutputFormat format = OF_TEXT) const;
+
     /**
      * @param [in] i1   0 <= i1 <= d1_ - 1
      * @param [in] i2   0 <= i2 <= d2_ - 1
      */
-    const bool& Get(size_t i1, size_t i2) const;
+    bool Get(size_t i1, size_t i2) const;
 
     /**
      * @param [in] i1   0 <= i1 <= d1_ - 1
      * @param [in] i2   0 <= i2 <= d2_ - 1
      */
-    bool& Get(size_t i1, size_t i2);
+    Reference Get(size_t i1, size_t i2);
 
     /**
      * Multiply a column vector.
      */
     std::vector<bool> Multiply(const std::vector<bool>& vec) const;
 
+    /**
+     * Multiply a packed column vector.
+     * @param [in]  vec      (d2_ + 63) / 64 words.
+     * @param [out] result   (d1_ + 63) / 64 words.
+     */
+    void Multiply(const uint64_t* vec, uint64_t* result) const;
+
+    /**
+     * @return The transpose, in the same storage order.
+     */
+    BitMatrix Transpose(void) const;
+
+    /**
+     * Transpose this matrix.
+     * Square matrices are transposed without allocation.
+     */
+    void TransposeInPlace(void);
+
+    /**
+     * @return The same matrix in the storage order \c order.
+     */
+    BitMatrix ToStorageOrder(StorageOrder order) const;
+
 private:
+    class Parser;
+
+    /**
+     * @param [in] buffer   GetNumberOfWords(d2_) words, used if the matrix is column-major.
+     * @return Row \c i1 as packed bits.
+     */
+    const uint64_t* GetRow(size_t i1, uint64_t* buffer) const;
+
     void Clear(void);
+    void Allocate(void);
 
 public:
     static void Test(void);
 
 private:
-    size_t d1_;     ///< number of rows.
-    size_t d2_;     ///< number of columns.
-    bool* data_;    ///< values are stored column-wise.
+    size_t d1_;             ///< number of rows.
+    size_t d2_;             ///< number of columns.
+    StorageOrder order_;    ///< whether the lines are columns or rows.
+    size_t stride_;         ///< number of words per line.
+    uint64_t* data_;        ///< values are stored line-wise.
 };
+
+/**
+ * Write the matrix as text, as BitMatrix::Write(os, BitMatrix::OF_TEXT).
+ */
+std::ostream& operator<<(std::ostream& os, const BitMatrix& matrix);
@@ -0,0 +1,276 @@
+#include "BitTranspose.h"
+#include "PackedBits.h"
+#include "Simd.h"
+#include <cassert>
+
+namespace
+{
+    // The mask of the low half of each 2j-bit group, for j = 32, 16, ..., 1.
+    const uint64_t SWAP_MASKS[6] =
+    {
+        0x00000000FFFFFFFFULL,
+        0x0000FFFF0000FFFFULL,
+        0x00FF00FF00FF00FFULL,
+        0x0F0F0F0F0F0F0F0FULL,
+        0x3333333333333333ULL,
+        0x5555555555555555ULL,
+    };
+}
+
+void BitTranspose::Transpose64(uint64_t* block)
+{
+    // For each j, the upper j bits of every 2j-bit group of line k are swapped
+    // with the lower j bits of line k + j, for all k with (k & j) == 0.
+    // After the pass for j = 1, the block is transposed.
+    size_t pass = 0;
+    size_t j = 32;
+#if defined(CODECS_HAS_AVX2)
+    for (; j >= 4; j >>= 1, ++pass)
+    {
+        __m256i m = _mm256_set1_epi64x(static_cast<long long>(SWAP_MASKS[pass]));
+        __m128i shift = _mm_cvtsi32_si128(static_cast<int>(j));
+        for (size_t k = 0; k < 64; k += 2 * j)
+        {
+            for (size_t i = k; i < k + j; i += 4)
+            {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i + j));
+                __m256i t = _mm256_and_si256(_mm256_xor_si256(_mm256_srl_epi64(a, shift), b), m);
+                b = _mm256_xor_si256(b, t);
+                a = _mm256_xor_si256(a, _mm256_sll_epi64(t, shift));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(block + i), a);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(block + i + j), b);
+            }
+        }
+    }
+#elif defined(CODECS_HAS_SSE2)
+    for (; j >= 2; j >>= 1, ++pass)
+    {
+        __m128i m = _mm_set1_epi64x(static_cast<long long>(SWAP_MASKS[pass]));
+        __m128i shift = _mm_cvtsi32_si128(static_cast<int>(j));
+        for (size_t k = 0; k < 64; k += 2 * j)
+        {
+            for (size_t i = k; i < k + j; i += 2)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i + j));
+                __m128i t = _mm_and_si128(_mm_xor_si128(_mm_srl_epi64(a, shift), b), m);
+                b = _mm_xor_si128(b, t);
+                a = _mm_xor_si128(a, _mm_sll_epi64(t, shift));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(block + i), a);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(block + i + j), b);
+            }
+        }
+    }
+#endif
+    for (; j >= 1; j >>= 1, ++pass)
+    {
+        uint64_t m = SWAP_MASKS[pass];
+        for (size_t k = 0; k < 64; k += 2 * j)
+        {
+            for (size_t i = k; i < k + j; ++i)
+            {
+                uint64_t t = ((block[i] >> j) ^ block[i + j]) & m;
+                block[i + j] ^= t;
+                block[i] ^= t << j;
+            }
+        }
+    }
+}
+
+void BitTranspose::LoadBlock(const uint64_t* src, size_t stride, size_t numLines, uint64_t* block)
+{
+    size_t k = 0;
+    for (; k < numLines; ++k)
+    {
+        block[k] = src[k * stride];
+    }
+    for (; k < 64; ++k)
+    {
+        block[k] = 0;
+    }
+}
+
+void BitTranspose::StoreBlock(const uint64_t* block, size_t numLines, uint64_t* dst, size_t stride)
+{
+    for (size_t k = 0; k < numLines; ++k)
+    {
+        dst[k * stride] = block[k];
+    }
+}
+
+void BitTranspose::Transpose(const uint64_t* src, size_t srcStride, size_t numLines, size_t lineLength,
+                             uint64_t* dst, size_t dstStride)
+{
+    assert(dstStride >= PackedBits::GetNumberOfWords(numLines));
+    uint64_t block[64];
+    size_t numBlockRows = PackedBits::GetNumberOfWords(numLines);
+    size_t numBlockColumns = PackedBits::GetNumberOfWords(lineLength);
+    for (size_t br = 0; br < numBlockRows; ++br)
+    {
+        size_t numRows = numLines - br * 64 < 64 ? numLines - br * 64 : 64;
+        for (size_t bc = 0; bc < numBlockColumns; ++bc)
+        {
+            size_t numColumns = lineLength - bc * 64 < 64 ? lineLength - bc * 64 : 64;
+            LoadBlock(src + br * 64 * srcStride + bc, srcStride, numRows, block);
+            Transpose64(block);
+            StoreBlock(block, numColumns, dst + bc * 64 * dstStride + br, dstStride);
+        }
+    }
+    // Clear the padding words of dst.
+    for (size_t w = numBlockRows; w < dstStride; ++w)
+    {
+        for (size_t k = 0; k < lineLength; ++k)
+        {
+            dst[k * dstStride + w] = 0;
+        }
+    }
+}
+
+void BitTranspose::TransposeContiguous(const uint64_t* src, size_t srcFirst, size_t numLines, size_t lineLength,
+                                       uint64_t* dst, size_t dstFirst)
+{
+    uint64_t block[64];
+    for (size_t r0 = 0; r0 < numLines; r0 += 64)
+    {
+        size_t numRows = numLines - r0 < 64 ? numLines - r0 : 64;
+        for (size_t c0 = 0; c0 < lineLength; c0 += 64)
+        {
+            size_t numColumns = lineLength - c0 < 64 ? lineLength - c0 : 64;
+            size_t k = 0;
+            for (; k < numRows; ++k)
+            {
+                block[k] = PackedBits::ExtractBits(src, srcFirst + (r0 + k) * lineLength + c0, numColumns);
+            }
+            for (; k < 64; ++k)
+            {
+                block[k] = 0;
+            }
+            Transpose64(block);
+            for (k = 0; k < numColumns; ++k)
+            {
+                PackedBits::InsertBits(dst, dstFirst + (c0 + k) * numLines + r0, block[k], numRows);
+            }
+        }
+    }
+}
+
+void BitTranspose::TransposeSquare(uint64_t* data, size_t stride, size_t n)
+{
+    uint64_t a[64];
+    uint64_t b[64];
+    size_t numBlocks = PackedBits::GetNumberOfWords(n);
+    for (size_t br = 0; br < numBlocks; ++br)
+    {
+        size_t numRows = n - br * 64 < 64 ? n - br * 64 : 64;
+        // Diagonal block.
+        uint64_t* diagonal = data + br * 64 * stride + br;
+        LoadBlock(diagonal, stride, numRows, a);
+        Transpose64(a);
+        StoreBlock(a, numRows, diagonal, stride);
+        // Swap the block pair (br, bc) and (bc, br).
+        for (size_t bc = br + 1; bc < numBlocks; ++bc)
+        {
+            size_t numColumns = n - bc * 64 < 64 ? n - bc * 64 : 64;
+            uint64_t* upper = data + br * 64 * stride + bc;
+            uint64_t* lower = data + bc * 64 * stride + br;
+            LoadBlock(upper, stride, numRows, a);
+            LoadBlock(lower, stride, numColumns, b);
+            Transpose64(a);
+            Transpose64(b);
+            StoreBlock(a, numColumns, lower, stride);
+            StoreBlock(b, numRows, upper, stride);
+        }
+    }
+}
+
+void BitTranspose::Test(void)
+{
+    // Transpose64
+    uint64_t block[64];
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (size_t k = 0; k < 64; ++k)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        block[k] = x;
+    }
+    uint64_t original[64];
+    for (size_t k = 0; k < 64; ++k)
+    {
+        original[k] = block[k];
+    }
+    Transpose64(block);
+    for (size_t r = 0; r < 64; ++r)
+    {
+        for (size_t c = 0; c < 64; ++c)
+        {
+            assert(((block[c] >> r) & 1) == ((original[r] >> c) & 1));
+        }
+    }
+    (void)original;
+
+    // Transpose: 3 lines of 70 bits.
+    const size_t numLines = 3;
+    const size_t lineLength = 70;
+    uint64_t src[numLines * 2] = { 0 };
+    PackedBits::SetBit(src + 0, 0, true);
+    PackedBits::SetBit(src + 0, 69, true);
+    PackedBits::SetBit(src + 2, 5, true);
+    PackedBits::SetBit(src + 4, 64, true);
+    uint64_t dst[lineLength];
+    Transpose(src, 2, numLines, lineLength, dst, 1);
+    for (size_t i = 0; i < lineLength; ++i)
+    {
+        for (size_t j = 0; j < numLines; ++j)
+        {
+            assert(PackedBits::GetBit(dst + i, j) == PackedBits::GetBit(src + 2 * j, i));
+        }
+        assert(!(dst[i] >> numLines));
+    }
+
+    // TransposeContiguous: 5 lines of 67 bits, starting at bit 3, into bit 1.
+    uint64_t lines[6];
+    for (size_t k = 0; k < 6; ++k)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        lines[k] = x;
+    }
+    uint64_t columns[6] = { 0 };
+    TransposeContiguous(lines, 3, 5, 67, columns, 1);
+    for (size_t i = 0; i < 5; ++i)
+    {
+        for (size_t j = 0; j < 67; ++j)
+        {
+            assert(PackedBits::GetBit(columns, 1 + j * 5 + i) == PackedBits::GetBit(lines, 3 + i * 67 + j));
+        }
+    }
+    assert(!(columns[0] & 1));
+
+    // TransposeSquare: 100x100.
+    const size_t n = 100;
+    uint64_t square[n * 2];
+    uint64_t copy[n * 2];
+    for (size_t k = 0; k < n; ++k)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        square[2 * k] = x;
+        square[2 * k + 1] = (x >> 7) & PackedBits::GetLowMask(n - 64);
+        copy[2 * k] = square[2 * k];
+        copy[2 * k + 1] = square[2 * k + 1];
+    }
+    TransposeSquare(square, 2, n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            assert(PackedBits::GetBit(square + 2 * i, j) == PackedBits::GetBit(copy + 2 * j, i));
+        }
+    }
+    (void)copy;
+}
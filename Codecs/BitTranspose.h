@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Transposition of bit matrices packed into 64-bit words.
+ *
+ * A packed bit matrix is a sequence of lines, each line being a packed bit
+ * sequence (see PackedBits) that starts at a multiple of \c stride words.
+ * Transposition turns a matrix of \c numLines lines of \c lineLength bits
+ * into a matrix of \c lineLength lines of \c numLines bits.
+ *
+ * The work is done on 64x64 blocks by the recursive swap-and-mask kernel
+ * \c Transpose64(), which uses SSE2/AVX2 where available.
+ */
+class BitTranspose
+{
+public:
+    /**
+     * Transpose a 64x64 block in place.
+     * Bit c of block[r] is exchanged with bit r of block[c].
+     */
+    static void Transpose64(uint64_t* block);
+
+    /**
+     * Out-of-place transposition.
+     *
+     * @param [in]  src          numLines lines of lineLength bits.
+     * @param [in]  srcStride    the number of words between consecutive lines of \c src.
+     * @param [in]  numLines     the number of lines of \c src.
+     * @param [in]  lineLength   the number of bits per line of \c src.
+     * @param [out] dst          lineLength lines of numLines bits.
+     * @param [in]  dstStride    the number of words between consecutive lines of \c dst,
+     *                           at least (numLines + 63) / 64.
+     *
+     * The unused bits of the last word of each line of \c src must be zero.
+     * Every word of every line of \c dst is written.
+     */
+    static void Transpose(const uint64_t* src, size_t srcStride, size_t numLines, size_t lineLength,
+                          uint64_t* dst, size_t dstStride);
+
+    /**
+     * Out-of-place transposition of lines stored back to back without padding,
+     * e.g. a run of codewords in a packed stream.
+     *
+     * @param [in]  src          numLines lines of lineLength bits, line i starting at bit
+     *                           (srcFirst + i * lineLength) of \c src.
+     * @param [in]  srcFirst     the bit offset of the first line in \c src.
+     * @param [in]  numLines     the number of lines of \c src.
+     * @param [in]  lineLength   the number of bits per line of \c src.
+     * @param [out] dst          lineLength lines of numLines bits, line j starting at bit
+     *                           (dstFirst + j * numLines) of \c dst.
+     * @param [in]  dstFirst     the bit offset of the first line in \c dst.
+     *
+     * Bits of \c dst outside the destination range are preserved.
+     */
+    static void TransposeContiguous(const uint64_t* src, size_t srcFirst, size_t numLines, size_t lineLength,
+                                    uint64_t* dst, size_t dstFirst);
+
+    /**
+     * In-place transposition of a square matrix of \c n lines of \c n bits.
+     */
+    static void TransposeSquare(uint64_t* data, size_t stride, size_t n);
+
+    static void Test(void);
+
+private:
+    static void LoadBlock(const uint64_t* src, size_t stride, size_t numLines, uint64_t* block);
+    static void StoreBlock(const uint64_t* block, size_t numLines, uint64_t* dst, size_t stride);
+};
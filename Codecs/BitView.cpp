@@ -0,0 +1,118 @@
+#include "BitView.h"
+#include "PackedBits.h"
+#include <cassert>
+#include <cstring>
+
+BitView::BitView(const uint8_t* bytes, size_t numBits, BitOrder order) :
+    bytes_(bytes),
+    numBits_(numBits),
+    order_(order)
+{
+    assert(bytes || !numBits);
+}
+
+const uint8_t* BitView::GetBytes(void) const
+{
+    return bytes_;
+}
+
+size_t BitView::GetNumberOfBits(void) const
+{
+    return numBits_;
+}
+
+size_t BitView::GetNumberOfBytes(void) const
+{
+    return (numBits_ + 7) / 8;
+}
+
+BitView::BitOrder BitView::GetBitOrder(void) const
+{
+    return order_;
+}
+
+bool BitView::GetBit(size_t i) const
+{
+    assert(i < numBits_);
+    unsigned shift = order_ == BO_LSB_FIRST ? i % 8 : 7 - i % 8;
+    return (bytes_[i / 8] >> shift) & 1;
+}
+
+uint64_t BitView::ReverseBitsInBytes(uint64_t w)
+{
+    w = ((w >> 1) & 0x5555555555555555ULL) | ((w & 0x5555555555555555ULL) << 1);
+    w = ((w >> 2) & 0x3333333333333333ULL) | ((w & 0x3333333333333333ULL) << 2);
+    w = ((w >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((w & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return w;
+}
+
+uint64_t BitView::LoadWord(size_t i) const
+{
+    size_t numBytes = GetNumberOfBytes();
+    uint64_t w = 0;
+    if (i < numBytes)
+    {
+        // Assumes a little-endian host, as PackedBits does.
+        std::memcpy(&w, bytes_ + i, numBytes - i < 8 ? numBytes - i : 8);
+    }
+    return order_ == BO_LSB_FIRST ? w : ReverseBitsInBytes(w);
+}
+
+void BitView::CopyBits(size_t first, size_t numBits, uint64_t* words) const
+{
+    assert(first + numBits <= numBits_);
+    size_t numWords = PackedBits::GetNumberOfWords(numBits);
+    size_t byte = first / 8;
+    unsigned shift = first % 8;
+    for (size_t w = 0; w < numWords; ++w, byte += 8)
+    {
+        uint64_t word = LoadWord(byte);
+        if (shift)
+        {
+            word = (word >> shift) | (LoadWord(byte + 8) << (64 - shift));
+        }
+        words[w] = word;
+    }
+    if (numBits % PackedBits::WORD_BITS)
+    {
+        words[numWords - 1] &= PackedBits::GetLowMask(numBits % PackedBits::WORD_BITS);
+    }
+}
+
+#include "DataIo.h"
+void BitView::Test(void)
+{
+    const uint8_t bytes[] = { 0xA5, 0x0F, 0x81, 0x3C, 0x00, 0xFF, 0x12, 0x34, 0x56, 0x78 };
+
+    // GetBit in both orders.
+    BitView lsb(bytes, 80);
+    BitView msb(bytes, 80, BO_MSB_FIRST);
+    assert(lsb.GetNumberOfBytes() == 10);
+    assert(lsb.GetBit(0) && !lsb.GetBit(1) && lsb.GetBit(2));
+    assert(msb.GetBit(0) && !msb.GetBit(1) && msb.GetBit(2) && !msb.GetBit(3));
+    assert(!msb.GetBit(8) && msb.GetBit(12));
+
+    // CopyBits agrees with GetBit at every alignment.
+    for (size_t first = 0; first < 20; ++first)
+    {
+        for (size_t n = 0; first + n <= 80; n += 9)
+        {
+            uint64_t words[2] = { ~uint64_t(0), ~uint64_t(0) };
+            const BitView* views[] = { &lsb, &msb };
+            for (size_t v = 0; v < 2; ++v)
+            {
+                views[v]->CopyBits(first, n, words);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    assert(PackedBits::GetBit(words, i) == views[v]->GetBit(first + i));
+                }
+                assert(n % 64 == 0 || (words[n / 64] >> (n % 64)) == 0);
+            }
+        }
+    }
+
+    // A view shorter than its last byte.
+    uint64_t word = 0;
+    BitView(bytes, 12, BO_MSB_FIRST).CopyBits(0, 12, &word);
+    assert(PackedBits::ToVector(&word, 12) == DataIo::FromString("1010 0101 0000"));
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A read-only view of a byte buffer as a bit sequence.
+ *
+ * The buffer is neither copied nor owned.  Bit i of the sequence is bit
+ * (i % 8) of byte (i / 8), counted from the least or the most significant
+ * bit depending on the bit order.  With BO_LSB_FIRST the bytes have the
+ * layout of packed words (see PackedBits) on a little-endian host, so they
+ * can be fed to the word kernels as they are.
+ */
+class BitView
+{
+public:
+    enum BitOrder
+    {
+        BO_LSB_FIRST,   ///< the first bit is the least significant bit of a byte.
+        BO_MSB_FIRST,   ///< the first bit is the most significant bit of a byte, as in hex dumps.
+    };
+
+public:
+    /**
+     * @param [in] bytes     at least (numBits + 7) / 8 bytes.
+     * @param [in] numBits   the number of bits of the sequence.
+     * @param [in] order     the order of the bits within each byte.
+     */
+    BitView(const uint8_t* bytes, size_t numBits, BitOrder order = BO_LSB_FIRST);
+
+    const uint8_t* GetBytes(void) const;
+    size_t GetNumberOfBits(void) const;
+    size_t GetNumberOfBytes(void) const;
+    BitOrder GetBitOrder(void) const;
+
+    /**
+     * @param [in] i   0 <= i <= GetNumberOfBits() - 1
+     */
+    bool GetBit(size_t i) const;
+
+    /**
+     * Copy bits [first, first + numBits) as a packed bit sequence.
+     * @param [out] words   (numBits + 63) / 64 words; unused bits of the last word are cleared.
+     */
+    void CopyBits(size_t first, size_t numBits, uint64_t* words) const;
+
+    /**
+     * @return The bits of each byte of \c w in reverse order.
+     */
+    static uint64_t ReverseBitsInBytes(uint64_t w);
+
+    static void Test(void);
+
+private:
+    /**
+     * @return Up to 8 bytes from byte \c i on, as a little-endian word in LSB-first order.
+     */
+    uint64_t LoadWord(size_t i) const;
+
+private:
+    const uint8_t* bytes_;
+    size_t numBits_;
+    BitOrder order_;
+};
@@ -0,0 +1,177 @@
+#include "BlockInterleaver.h"
+#include "BitTranspose.h"
+#include "PackedBits.h"
+#include <algorithm>
+#include <cassert>
+
+BlockInterleaver::BlockInterleaver(size_t codeLength, size_t depth) :
+    codeLength_(codeLength),
+    depth_(depth)
+{
+    assert(codeLength > 0);
+    assert(depth > 0);
+}
+
+size_t BlockInterleaver::GetCodeLength(void) const
+{
+    return codeLength_;
+}
+
+size_t BlockInterleaver::GetDepth(void) const
+{
+    return depth_;
+}
+
+size_t BlockInterleaver::GetFrameLength(void) const
+{
+    return codeLength_ * depth_;
+}
+
+void BlockInterleaver::Interleave(const uint64_t* codewords, size_t numFrames, uint64_t* frames) const
+{
+    size_t frameLength = GetFrameLength();
+    for (size_t f = 0; f < numFrames; ++f)
+    {
+        BitTranspose::TransposeContiguous(codewords, f * frameLength, depth_, codeLength_,
+                                          frames, f * frameLength);
+    }
+}
+
+void BlockInterleaver::Deinterleave(const uint64_t* frames, size_t numFrames, uint64_t* codewords) const
+{
+    size_t frameLength = GetFrameLength();
+    for (size_t f = 0; f < numFrames; ++f)
+    {
+        BitTranspose::TransposeContiguous(frames, f * frameLength, codeLength_, depth_,
+                                          codewords, f * frameLength);
+    }
+}
+
+InterleaverStream::InterleaverStream(const BlockInterleaver& interleaver, bool deinterleave,
+                                     size_t windowFrames, const Sink& sink) :
+    interleaver_(interleaver),
+    deinterleave_(deinterleave),
+    windowBits_(interleaver.GetFrameLength() * windowFrames),
+    sink_(sink),
+    input_(PackedBits::GetNumberOfWords(windowBits_), 0),
+    output_(PackedBits::GetNumberOfWords(windowBits_), 0),
+    numPending_(0)
+{
+    assert(windowFrames > 0);
+}
+
+void InterleaverStream::Push(const uint64_t* bits, size_t numBits)
+{
+    size_t first = 0;
+    while (first < numBits)
+    {
+        size_t n = std::min(numBits - first, windowBits_ - numPending_);
+        PackedBits::CopyBits(bits, first, &input_[0], numPending_, n);
+        numPending_ += n;
+        first += n;
+        if (numPending_ == windowBits_)
+        {
+            EmitWindow(windowBits_ / interleaver_.GetFrameLength());
+        }
+    }
+}
+
+void InterleaverStream::Flush(void)
+{
+    if (numPending_)
+    {
+        size_t frameLength = interleaver_.GetFrameLength();
+        size_t numFrames = (numPending_ + frameLength - 1) / frameLength;
+        size_t numBits = numFrames * frameLength;
+        // Zero the padding.
+        if (numPending_ % PackedBits::WORD_BITS)
+        {
+            input_[numPending_ / PackedBits::WORD_BITS] &= PackedBits::GetLowMask(numPending_ % PackedBits::WORD_BITS);
+        }
+        std::fill(input_.begin() + PackedBits::GetNumberOfWords(numPending_),
+                  input_.begin() + PackedBits::GetNumberOfWords(numBits), 0);
+        EmitWindow(numFrames);
+    }
+}
+
+void InterleaverStream::EmitWindow(size_t numFrames)
+{
+    size_t numBits = numFrames * interleaver_.GetFrameLength();
+    if (deinterleave_)
+    {
+        interleaver_.Deinterleave(&input_[0], numFrames, &output_[0]);
+    }
+    else
+    {
+        interleaver_.Interleave(&input_[0], numFrames, &output_[0]);
+    }
+    if (numBits % PackedBits::WORD_BITS)
+    {
+        output_[numBits / PackedBits::WORD_BITS] &= PackedBits::GetLowMask(numBits % PackedBits::WORD_BITS);
+    }
+    sink_(&output_[0], numBits);
+    numPending_ = 0;
+}
+
+#include "HammingCodecs.h"
+#include "DataIo.h"
+void BlockInterleaver::Test(void)
+{
+    // Interleave, Deinterleave: 3 codewords of 4 bits.
+    BlockInterleaver bi(4, 3);
+    std::vector<uint64_t> code = PackedBits::FromVector(DataIo::FromString("1100 1010 0110"));
+    std::vector<uint64_t> frame(1, 0);
+    bi.Interleave(&code[0], 1, &frame[0]);
+    assert(PackedBits::ToVector(&frame[0], 12) == DataIo::FromString("110 101 011 000"));
+    std::vector<uint64_t> back(1, 0);
+    bi.Deinterleave(&frame[0], 1, &back[0]);
+    assert(back == code);
+
+    // A burst of 'depth' bits is corrected by Hamming after deinterleaving.
+    const size_t depth = 16;
+    HammingCodecs hc(8);
+    size_t n = hc.GetNumberOfCodeBits();
+    BlockInterleaver hbi(n, depth);
+    std::vector<uint64_t> codewords(PackedBits::GetNumberOfWords(n * depth), 0);
+    std::vector<std::vector<bool> > messages;
+    for (size_t d = 0; d < depth; ++d)
+    {
+        std::vector<bool> msg(8, false);
+        for (size_t i = 0; i < 8; ++i)
+        {
+            msg[i] = ((d * 37 + 11) >> i) & 1;
+        }
+        messages.push_back(msg);
+        std::vector<uint64_t> c = PackedBits::FromVector(hc.Encode(msg));
+        PackedBits::CopyBits(&c[0], 0, &codewords[0], d * n, n);
+    }
+    std::vector<uint64_t> sent(codewords.size(), 0);
+    hbi.Interleave(&codewords[0], 1, &sent[0]);
+    for (size_t i = 50; i < 50 + depth; ++i)
+    {
+        PackedBits::FlipBit(&sent[0], i);
+    }
+
+    // Deinterleave through a stream of one frame per window, fed in odd pieces.
+    std::vector<uint64_t> received;
+    size_t numReceived = 0;
+    InterleaverStream stream(hbi, true, 1, [&] (const uint64_t* bits, size_t numBits)
+    {
+        received.resize(PackedBits::GetNumberOfWords(numReceived + numBits), 0);
+        PackedBits::CopyBits(bits, 0, &received[0], numReceived, numBits);
+        numReceived += numBits;
+    });
+    for (size_t first = 0; first < n * depth; first += 29)
+    {
+        std::vector<uint64_t> piece(1, PackedBits::ExtractBits(&sent[0], first, std::min<size_t>(29, n * depth - first)));
+        stream.Push(&piece[0], std::min<size_t>(29, n * depth - first));
+    }
+    stream.Flush();
+    assert(numReceived == n * depth);
+    for (size_t d = 0; d < depth; ++d)
+    {
+        std::vector<uint64_t> c(PackedBits::GetNumberOfWords(n), 0);
+        PackedBits::CopyBits(&received[0], d * n, &c[0], 0, n);
+        assert(hc.Decode(PackedBits::ToVector(&c[0], n)) == messages[d]);
+    }
+}
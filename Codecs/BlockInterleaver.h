@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Block interleaver for packed bit streams.
+ *
+ * A frame holds \c depth consecutive codewords of \c codeLength bits.
+ * The interleaved frame sends bit 0 of every codeword, then bit 1 of every
+ * codeword, and so on, so that a burst of up to \c depth bits hits each
+ * codeword at most once.  Interleaving transposes the depth x codeLength
+ * bit matrix of the frame; deinterleaving transposes it back.
+ */
+class BlockInterleaver
+{
+public:
+    BlockInterleaver(size_t codeLength, size_t depth);
+
+    size_t GetCodeLength(void) const;
+    size_t GetDepth(void) const;
+
+    /**
+     * @return The number of bits per frame, i.e. codeLength * depth.
+     */
+    size_t GetFrameLength(void) const;
+
+    /**
+     * Interleave \c numFrames frames.
+     * @param [in]  codewords   numFrames * GetFrameLength() bits of back-to-back codewords.
+     * @param [out] frames      numFrames * GetFrameLength() bits.
+     */
+    void Interleave(const uint64_t* codewords, size_t numFrames, uint64_t* frames) const;
+
+    /**
+     * Deinterleave \c numFrames frames.
+     * @param [in]  frames      numFrames * GetFrameLength() bits.
+     * @param [out] codewords   numFrames * GetFrameLength() bits of back-to-back codewords.
+     */
+    void Deinterleave(const uint64_t* frames, size_t numFrames, uint64_t* codewords) const;
+
+    static void Test(void);
+
+private:
+    size_t codeLength_;
+    size_t depth_;
+};
+
+/**
+ * Streaming form of \c BlockInterleaver.
+ *
+ * Bits are pushed in pieces of any length and collected into a window of
+ * a fixed number of frames.  Each time the window is full, it is
+ * (de)interleaved and handed to the sink, so memory stays bounded by the
+ * window size whatever the stream length.
+ */
+class InterleaverStream
+{
+public:
+    /**
+     * Receives (bits, numBits) of (de)interleaved output.
+     */
+    typedef std::function<void (const uint64_t*, size_t)> Sink;
+
+    /**
+     * @param [in] interleaver    the frame geometry.
+     * @param [in] deinterleave   true to deinterleave instead of interleave.
+     * @param [in] windowFrames   the number of frames per window, at least 1.
+     * @param [in] sink           the receiver of the output.
+     */
+    InterleaverStream(const BlockInterleaver& interleaver, bool deinterleave, size_t windowFrames, const Sink& sink);
+
+    /**
+     * @param [in] bits      a packed bit sequence.
+     * @param [in] numBits   the number of bits of \c bits.
+     */
+    void Push(const uint64_t* bits, size_t numBits);
+
+    /**
+     * Pad the pending partial frame (if any) with zeros and emit the window.
+     */
+    void Flush(void);
+
+private:
+    void EmitWindow(size_t numFrames);
+
+private:
+    const BlockInterleaver& interleaver_;
+    bool deinterleave_;
+    size_t windowBits_;
+    Sink sink_;
+    std::vector<uint64_t> input_;
+    std::vector<uint64_t> output_;
+    size_t numPending_;     ///< number of bits in input_.
+};
@@ -0,0 +1,676 @@
+#include "CliEngine.h"
+#include "BerSimulator.h"
+#include "CrcAnalyzer.h"
+#include "CrcManifest.h"
+#include "DataIo.h"
+#include "FileCodecs.h"
+#include "Instrumentation.h"
+#include "JobClient.h"
+#include "JobServer.h"
+#include "MappedFile.h"
+#include "PackedBits.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+enum ExitCodes
+{
+    EC_SUCCESS = 0,
+    EC_CHECK_FAILED = 1,
+    EC_ERROR = 2,
+};
+
+int CliEngine::Run(const std::vector<std::string>& args)
+{
+    if (args.empty())
+    {
+        ShowUsage();
+        return EC_ERROR;
+    }
+    if (!ParseArguments(std::vector<std::string>(args.begin() + 1, args.end())))
+    {
+        ShowUsage();
+        return EC_ERROR;
+    }
+#if defined(_WIN32)
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    std::ios::sync_with_stdio(false);
+    int result = RunCommand(args[0]);
+    // The counters of the codecs go to stderr, clear of the output.
+    std::string stats = GetOption("--stats", "", "");
+    if (stats == "text")
+    {
+        Instrumentation::TakeSnapshot().WriteText(std::cerr);
+    }
+    else if (stats == "json")
+    {
+        Instrumentation::TakeSnapshot().WriteJson(std::cerr);
+    }
+    return result;
+}
+
+int CliEngine::RunCommand(const std::string& command)
+{
+    if (command == "crc")
+    {
+        return Crc();
+    }
+    if (command == "hamming-encode")
+    {
+        return HammingEncode();
+    }
+    if (command == "hamming-decode")
+    {
+        return HammingDecode();
+    }
+    if (command == "crc-analyze")
+    {
+        return CrcAnalyze();
+    }
+    if (command == "crc-sweep")
+    {
+        return CrcSweep();
+    }
+    if (command == "crc-manifest")
+    {
+        return CrcManifestBuild();
+    }
+    if (command == "crc-refresh")
+    {
+        return CrcManifestRefresh();
+    }
+    if (command == "crc-verify")
+    {
+        return CrcManifestVerify();
+    }
+    if (command == "ber")
+    {
+        return Ber();
+    }
+    if (command == "serve")
+    {
+        return Serve();
+    }
+    if (command == "job")
+    {
+        return Job();
+    }
+    if (command == "job-load")
+    {
+        return JobLoad();
+    }
+    std::cerr << "Error: Unknown command " << command << "!" << std::endl;
+    ShowUsage();
+    return EC_ERROR;
+}
+
+void CliEngine::ShowUsage(void)
+{
+    std::cerr << "Usage:" << std::endl
+              << "  codecs crc -g <generator> [--expect <hex>] [input]" << std::endl
+              << "  codecs hamming-encode -k <message block bits> [-j <threads>] [input output]" << std::endl
+              << "  codecs hamming-decode -k <message block bits> [-j <threads>] [--bytes <n>] [input output]" << std::endl
+              << "  codecs crc-analyze -g <generator> --lengths <message bits,...> [--max-weight <w>] [-j <threads>]" << std::endl
+              << "  codecs crc-sweep --degree <r> -m <message bits> [--max-weight <w>] [--best <n>] [-j <threads>]" << std::endl
+              << "  codecs crc-manifest -g <generator> [--chunk-size <bytes>] [-j <threads>] input manifest" << std::endl
+              << "  codecs crc-refresh [--dirty <offset+bytes,...>] [-j <threads>] input manifest" << std::endl
+              << "  codecs crc-verify [-j <threads>] input manifest" << std::endl
+              << "  codecs ber (-k <message block bits> | -g <generator> -m <message bits>) --ber <p>" << std::endl
+              << "         [--bad-ber <p> --good-to-bad <p> --bad-to-good <p>] [--frames <n>] [--seed <n>] [-j <threads>]" << std::endl
+              << "  codecs serve --socket <path> [--chunk-size <bytes>] [--max-queued <jobs>] [-j <threads>]" << std::endl
+              << "  codecs job --socket <path> (crc -g <generator> | hamming-encode -k <message block bits>" << std::endl
+              << "         | hamming-decode -k <message block bits> [--bytes <n>] | statistics) [input [output]]" << std::endl
+              << "  codecs job-load --socket <path> [--connections <n>] [--jobs <n>] [--depth <n>]" << std::endl
+              << "         [--min-bytes <n>] [--max-bytes <n>] [-g <generator>] [-k <message block bits>] [--seed <n>]" << std::endl
+              << "  codecs --menu          the interactive menu" << std::endl
+              << "  codecs --self-test     run the built-in tests" << std::endl
+              << "Without files, commands read stdin and write stdout." << std::endl
+              << "Generators are bits such as \"1 0011\" or hex such as 0x13." << std::endl
+              << "Bytes are read least significant bit first." << std::endl
+              << "Options: -g/--generator, -k/--block-size, -j/--threads (default: all cores)," << std::endl
+              << "         --bytes (the message length to restore), --expect (the CRC to check)," << std::endl
+              << "         --dirty (the byte ranges written since the manifest was made; if none is given" << std::endl
+              << "         and the file size or time changed, all chunks are read)," << std::endl
+              << "         --max-weight (the heaviest undetectable error patterns to count, default 4)," << std::endl
+              << "         --ber (the channel bit error rate; with --bad-ber, that of the good state" << std::endl
+              << "         of a Gilbert-Elliott channel), --frames (default: 1000000)," << std::endl
+              << "         --socket (the Unix-domain socket of the job server, POSIX only)," << std::endl
+              << "         --depth (the requests in flight per connection of job-load)," << std::endl
+              << "         --stats text|json (print the codec counters to stderr, if built with" << std::endl
+              << "         CODECS_INSTRUMENTATION)." << std::endl;
+}
+
+int CliEngine::Crc(void)
+{
+    std::vector<bool> generator = ParseBits(GetOption("--generator", "-g", ""));
+    if (DataIo::IsZero(generator) || operands_.size() > 1)
+    {
+        std::cerr << "Error: A non-zero CRC generator is required!" << std::endl;
+        return EC_ERROR;
+    }
+    LfsrDivider divider(generator);
+    std::vector<uint64_t> reg(divider.GetNumberOfWords() + 1, 0);
+    if (operands_.empty())
+    {
+        std::vector<char> buffer(1 << 16);
+        while (std::cin.read(&buffer[0], buffer.size()) || std::cin.gcount())
+        {
+            divider.Update(&reg[0], reinterpret_cast<const uint8_t*>(&buffer[0]), 8 * static_cast<size_t>(std::cin.gcount()));
+        }
+    }
+    else if (!FileCodecs::CrcFile(divider, operands_[0], reg))
+    {
+        std::cerr << "Error: Cannot read " << operands_[0] << "!" << std::endl;
+        return EC_ERROR;
+    }
+    reg.resize(PackedBits::GetNumberOfWords(divider.GetDegree()));
+    std::string crc;
+    DataIo::ToHex(reg.empty() ? nullptr : &reg[0], divider.GetDegree(), crc);
+    std::cout << crc << std::endl;
+    std::string expect = GetOption("--expect", "", "");
+    if (!expect.empty())
+    {
+        std::vector<uint64_t> expected;
+        DataIo::FromHex(expect.data(), expect.length(), expected, divider.GetDegree());
+        CODECS_COUNT(Instrumentation::CT_CRC_CHECKS, 1);
+        if (expected != reg)
+        {
+            CODECS_COUNT(Instrumentation::CT_CRC_MISMATCHES, 1);
+            std::cerr << "CRC mismatch." << std::endl;
+            return EC_CHECK_FAILED;
+        }
+    }
+    return EC_SUCCESS;
+}
+
+int CliEngine::HammingEncode(void)
+{
+    size_t size = ParseSize(GetOption("--block-size", "-k", ""), 0);
+    if (size == 0 || (operands_.size() != 0 && operands_.size() != 2))
+    {
+        std::cerr << "Error: A message block size and either no file or both files are required!" << std::endl;
+        return EC_ERROR;
+    }
+    HammingCodecs hamming(size);
+    ThreadPool pool(GetNumberOfThreads());
+    bool ok = operands_.empty() ? FileCodecs::HammingEncodeStream(hamming, std::cin, std::cout, pool)
+                                : FileCodecs::HammingEncodeFile(hamming, operands_[0], operands_[1], pool);
+    std::cout.flush();
+    if (!ok)
+    {
+        std::cerr << "Error: Cannot encode!" << std::endl;
+        return EC_ERROR;
+    }
+    return EC_SUCCESS;
+}
+
+int CliEngine::HammingDecode(void)
+{
+    size_t size = ParseSize(GetOption("--block-size", "-k", ""), 0);
+    if (size == 0 || (operands_.size() != 0 && operands_.size() != 2))
+    {
+        std::cerr << "Error: A message block size and either no file or both files are required!" << std::endl;
+        return EC_ERROR;
+    }
+    size_t numBytes = ParseSize(GetOption("--bytes", "", ""), DataIo::ALL_BITS);
+    HammingCodecs hamming(size);
+    ThreadPool pool(GetNumberOfThreads());
+    size_t numCorrected = 0;
+    bool ok = operands_.empty() ? FileCodecs::HammingDecodeStream(hamming, std::cin, std::cout, pool, numBytes, numCorrected)
+                                : FileCodecs::HammingDecodeFile(hamming, operands_[0], operands_[1], numBytes, numCorrected, pool);
+    std::cout.flush();
+    if (!ok)
+    {
+        std::cerr << "Error: Cannot decode!" << std::endl;
+        return EC_ERROR;
+    }
+    std::cerr << numCorrected << " blocks corrected." << std::endl;
+    return EC_SUCCESS;
+}
+
+int CliEngine::CrcAnalyze(void)
+{
+    std::vector<bool> generator = ParseBits(GetOption("--generator", "-g", ""));
+    std::vector<size_t> lengths = ParseSizes(GetOption("--lengths", "", ""));
+    size_t maxWeight = ParseSize(GetOption("--max-weight", "", ""), CrcAnalyzer::DEFAULT_MAX_WEIGHT);
+    size_t degree = generator.end() - std::find(generator.begin(), generator.end(), true) - 1;
+    if (DataIo::IsZero(generator) || !generator.back() || degree > 64 || lengths.empty() || maxWeight < 2)
+    {
+        std::cerr << "Error: A generator of degree 1 to 64 with a constant term, "
+                  << "and message lengths are required!" << std::endl;
+        return EC_ERROR;
+    }
+    CrcAnalyzer analyzer(generator, *std::max_element(lengths.begin(), lengths.end()), maxWeight);
+    ThreadPool pool(GetNumberOfThreads());
+    analyzer.Run(pool);
+    analyzer.Write(std::cout, lengths);
+    for (size_t d = 3; d <= maxWeight + 1; ++d)
+    {
+        std::cout << "# distance " << d << " up to " << analyzer.GetLongestMessage(d) << " message bits" << std::endl;
+    }
+    return EC_SUCCESS;
+}
+
+int CliEngine::CrcSweep(void)
+{
+    size_t degree = ParseSize(GetOption("--degree", "", ""), 0);
+    size_t numMessageBits = ParseSize(GetOption("--message-bits", "-m", ""), 0);
+    size_t maxWeight = ParseSize(GetOption("--max-weight", "", ""), CrcAnalyzer::DEFAULT_MAX_WEIGHT);
+    if (degree == 0 || degree > CrcAnalyzer::MAX_SWEEP_DEGREE || numMessageBits == 0 || maxWeight < 2)
+    {
+        std::cerr << "Error: A degree of 1 to " << CrcAnalyzer::MAX_SWEEP_DEGREE
+                  << " and a message length are required!" << std::endl;
+        return EC_ERROR;
+    }
+    ThreadPool pool(GetNumberOfThreads());
+    std::vector<CrcAnalyzer::Candidate> best = CrcAnalyzer::Sweep(degree, numMessageBits, maxWeight, pool,
+                                                                  ParseSize(GetOption("--best", "", ""), 10));
+    std::cout << "# generator, minimum distance, undetectable patterns of that weight" << std::endl;
+    for (size_t i = 0; i < best.size(); ++i)
+    {
+        std::vector<uint64_t> words = PackedBits::FromVector(best[i].generator);
+        std::string hex;
+        DataIo::ToHex(&words[0], best[i].generator.size(), hex);
+        std::cout << "0x" << hex << " " << best[i].distance << " " << best[i].count << std::endl;
+    }
+    return EC_SUCCESS;
+}
+
+int CliEngine::CrcManifestBuild(void)
+{
+    std::vector<bool> generator = ParseBits(GetOption("--generator", "-g", ""));
+    size_t chunkSize = ParseSize(GetOption("--chunk-size", "", ""), CrcManifest::DEFAULT_CHUNK_SIZE);
+    if (DataIo::IsZero(generator) || generator.end() - std::find(generator.begin(), generator.end(), true) < 2
+        || chunkSize == 0 || operands_.size() != 2)
+    {
+        std::cerr << "Error: A generator of degree 1 or more, an input and a manifest file are required!" << std::endl;
+        return EC_ERROR;
+    }
+    CrcManifest manifest(generator, chunkSize);
+    ThreadPool pool(GetNumberOfThreads());
+    std::ofstream output(operands_[1].c_str());
+    if (!manifest.Build(operands_[0], pool) || !(manifest.Write(output), output))
+    {
+        std::cerr << "Error: Cannot read " << operands_[0] << " or write " << operands_[1] << "!" << std::endl;
+        return EC_ERROR;
+    }
+    return EC_SUCCESS;
+}
+
+int CliEngine::CrcManifestRefresh(void)
+{
+    CrcManifest manifest(std::vector<bool>(2, true));
+    std::ifstream input(operands_.size() == 2 ? operands_[1].c_str() : "");
+    if (operands_.size() != 2 || !CrcManifest::Read(input, manifest))
+    {
+        std::cerr << "Error: An input and its manifest file are required!" << std::endl;
+        return EC_ERROR;
+    }
+    input.close();
+    std::string dirty = GetOption("--dirty", "", "");
+    for (size_t first = 0; first < dirty.size(); )
+    {
+        size_t last = std::min(dirty.find(',', first), dirty.size());
+        std::string range = dirty.substr(first, last - first);
+        size_t plus = range.find('+');
+        manifest.MarkDirty(std::strtoull(range.c_str(), nullptr, 10),
+                           plus == std::string::npos ? 1 : std::strtoull(range.c_str() + plus + 1, nullptr, 10));
+        first = last + 1;
+    }
+    ThreadPool pool(GetNumberOfThreads());
+    std::vector<size_t> changed;
+    size_t numRead = manifest.Refresh(operands_[0], pool, &changed);
+    std::ofstream output(operands_[1].c_str());
+    if (numRead == DataIo::ALL_BITS || !(manifest.Write(output), output))
+    {
+        std::cerr << "Error: Cannot read " << operands_[0] << " or write " << operands_[1] << "!" << std::endl;
+        return EC_ERROR;
+    }
+    std::string crc;
+    DataIo::ToHex(manifest.GetCrc(), manifest.GetDivider().GetDegree(), crc);
+    std::cout << crc << std::endl;
+    std::cerr << numRead << " of " << manifest.GetNumberOfChunks() << " chunks read, "
+              << changed.size() << " changed." << std::endl;
+    return EC_SUCCESS;
+}
+
+int CliEngine::CrcManifestVerify(void)
+{
+    CrcManifest manifest(std::vector<bool>(2, true));
+    std::ifstream input(operands_.size() == 2 ? operands_[1].c_str() : "");
+    if (operands_.size() != 2 || !CrcManifest::Read(input, manifest))
+    {
+        std::cerr << "Error: An input and its manifest file are required!" << std::endl;
+        return EC_ERROR;
+    }
+    ThreadPool pool(GetNumberOfThreads());
+    std::vector<size_t> mismatches;
+    if (manifest.Verify(operands_[0], pool, mismatches))
+    {
+        return EC_SUCCESS;
+    }
+    if (mismatches.empty())
+    {
+        std::cerr << "Error: " << operands_[0] << " cannot be read or has another size!" << std::endl;
+        return EC_CHECK_FAILED;
+    }
+    for (size_t i = 0; i < mismatches.size(); ++i)
+    {
+        std::cerr << "Chunk " << mismatches[i] << " (bytes from " << uint64_t(mismatches[i]) * manifest.GetChunkSize()
+                  << ") differs." << std::endl;
+    }
+    return EC_CHECK_FAILED;
+}
+
+int CliEngine::Ber(void)
+{
+    size_t size = ParseSize(GetOption("--block-size", "-k", ""), 0);
+    std::vector<bool> generator = ParseBits(GetOption("--generator", "-g", ""));
+    size_t numMessageBits = ParseSize(GetOption("--message-bits", "-m", ""), 0);
+    double ber = ParseDouble(GetOption("--ber", "", ""), -1);
+    double badBer = ParseDouble(GetOption("--bad-ber", "", ""), -1);
+    if ((size == 0) == DataIo::IsZero(generator) || (size == 0 && numMessageBits == 0) || ber < 0 || ber > 1)
+    {
+        std::cerr << "Error: Either a message block size or a CRC generator and message length, "
+                  << "and a bit error rate are required!" << std::endl;
+        return EC_ERROR;
+    }
+    BerSimulator::Channel channel = BerSimulator::BinarySymmetric(ber);
+    if (badBer >= 0)
+    {
+        channel = BerSimulator::GilbertElliott(ParseDouble(GetOption("--good-to-bad", "", ""), 0),
+                                               ParseDouble(GetOption("--bad-to-good", "", ""), 1), ber, badBer);
+    }
+    BerSimulator simulator(channel, ParseSize(GetOption("--seed", "", ""), 1));
+    uint64_t numFrames = ParseSize(GetOption("--frames", "", ""), 1000000);
+    ThreadPool pool(GetNumberOfThreads());
+    auto start = std::chrono::steady_clock::now();
+    BerSimulator::Statistics statistics;
+    if (size)
+    {
+        HammingCodecs hamming(size);
+        statistics = simulator.SimulateHamming(hamming, numFrames, pool);
+    }
+    else
+    {
+        LfsrDivider divider(generator);
+        statistics = simulator.SimulateCrc(divider, numMessageBits, numFrames, pool);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "frames: " << statistics.numFrames << std::endl
+              << "channel bit errors: " << statistics.numChannelErrors << " ("
+              << static_cast<double>(statistics.numChannelErrors) / statistics.numBits << ")" << std::endl
+              << "errored frames: " << statistics.numErroredFrames << std::endl;
+    if (size)
+    {
+        std::cout << "residual frame errors: " << statistics.numFrameErrors << " ("
+                  << static_cast<double>(statistics.numFrameErrors) / statistics.numFrames << ")" << std::endl
+                  << "residual bit errors: " << statistics.numBitErrors << " ("
+                  << static_cast<double>(statistics.numBitErrors) / (statistics.numFrames * size) << ")" << std::endl;
+    }
+    else
+    {
+        std::cout << "detected: " << statistics.numDetected << std::endl
+                  << "undetected: " << statistics.numUndetected << " ("
+                  << static_cast<double>(statistics.numUndetected) / statistics.numFrames << ")" << std::endl;
+    }
+    std::cerr << statistics.numFrames / (seconds > 0 ? seconds : 1e-9) << " frames/s" << std::endl;
+    return EC_SUCCESS;
+}
+
+int CliEngine::Serve(void)
+{
+    std::string path = GetOption("--socket", "", "");
+    JobServer server(GetNumberOfThreads(), ParseSize(GetOption("--chunk-size", "", ""), JobServer::DEFAULT_CHUNK_SIZE),
+                     ParseSize(GetOption("--max-queued", "", ""), JobServer::DEFAULT_MAX_QUEUED_JOBS));
+    if (path.empty() || !operands_.empty())
+    {
+        std::cerr << "Error: A socket path is required!" << std::endl;
+        return EC_ERROR;
+    }
+    if (!server.Listen(path))
+    {
+        std::cerr << "Error: Cannot listen on " << path << "!" << std::endl;
+        return EC_ERROR;
+    }
+    std::cerr << "Listening on " << path << "." << std::endl;
+    server.Serve();
+    return EC_SUCCESS;
+}
+
+int CliEngine::Job(void)
+{
+    static const char* const operations[] = { "", "crc", "hamming-encode", "hamming-decode", "statistics" };
+    size_t operation = 0;
+    while (!operands_.empty() && operation < JobProtocol::OP_COUNT && operands_[0] != operations[operation])
+    {
+        ++operation;
+    }
+    std::string path = GetOption("--socket", "", "");
+    if (path.empty() || operation == 0 || operation == JobProtocol::OP_COUNT || operands_.size() > 3)
+    {
+        std::cerr << "Error: A socket path and an operation are required!" << std::endl;
+        return EC_ERROR;
+    }
+    std::string parameters;
+    if (operation == JobProtocol::OP_CRC)
+    {
+        parameters = DataIo::ToString(ParseBits(GetOption("--generator", "-g", "")));
+    }
+    else if (operation != JobProtocol::OP_STATISTICS)
+    {
+        parameters = GetOption("--block-size", "-k", "");
+        std::string bytes = GetOption("--bytes", "", "");
+        if (operation == JobProtocol::OP_HAMMING_DECODE && !bytes.empty())
+        {
+            parameters += "," + bytes;
+        }
+    }
+    std::vector<uint8_t> payload;
+    std::string input = operands_.size() > 1 ? operands_[1] : "";
+    if (operation != JobProtocol::OP_STATISTICS && !ReadInput(input, payload))
+    {
+        std::cerr << "Error: Cannot read " << (input.empty() ? "stdin" : input) << "!" << std::endl;
+        return EC_ERROR;
+    }
+    JobClient client;
+    JobProtocol::Response response;
+    if (!client.Connect(path)
+        || !client.Call(static_cast<uint8_t>(operation), parameters, payload, response))
+    {
+        std::cerr << "Error: No answer from the server at " << path << "!" << std::endl;
+        return EC_ERROR;
+    }
+    if (response.status == JobProtocol::JS_BUSY)
+    {
+        std::cerr << "Error: The server is busy!" << std::endl;
+        return EC_ERROR;
+    }
+    if (response.status != JobProtocol::JS_OK)
+    {
+        std::cerr << "Error: The server rejected the job!" << std::endl;
+        return EC_ERROR;
+    }
+    size_t first = 0;
+    if (operation == JobProtocol::OP_HAMMING_DECODE)
+    {
+        if (response.payload.size() < 8)
+        {
+            std::cerr << "Error: The server sent no count of corrected blocks!" << std::endl;
+            return EC_ERROR;
+        }
+        std::cerr << JobProtocol::GetUint64(&response.payload[0]) << " blocks corrected." << std::endl;
+        first = 8;
+    }
+    const char* data = reinterpret_cast<const char*>(response.payload.data()) + first;
+    std::streamsize numBytes = static_cast<std::streamsize>(response.payload.size() - first);
+    if (operands_.size() == 3)
+    {
+        std::ofstream output(operands_[2].c_str(), std::ios::binary);
+        if (!output.write(data, numBytes))
+        {
+            std::cerr << "Error: Cannot write " << operands_[2] << "!" << std::endl;
+            return EC_ERROR;
+        }
+    }
+    else
+    {
+        std::cout.write(data, numBytes);
+        if (operation == JobProtocol::OP_CRC)
+        {
+            std::cout << std::endl;
+        }
+        std::cout.flush();
+    }
+    std::cerr << response.serviceNs / 1000 << " us at the server." << std::endl;
+    return EC_SUCCESS;
+}
+
+int CliEngine::JobLoad(void)
+{
+    JobClient::LoadOptions options = JobClient::GetDefaultLoadOptions();
+    std::string path = GetOption("--socket", "", "");
+    options.numConnections = ParseSize(GetOption("--connections", "", ""), options.numConnections);
+    options.numJobs = ParseSize(GetOption("--jobs", "", ""), options.numJobs);
+    options.depth = ParseSize(GetOption("--depth", "", ""), options.depth);
+    options.minBytes = ParseSize(GetOption("--min-bytes", "", ""), options.minBytes);
+    options.maxBytes = ParseSize(GetOption("--max-bytes", "", ""), options.maxBytes);
+    options.numMessageBits = ParseSize(GetOption("--block-size", "-k", ""), options.numMessageBits);
+    options.seed = ParseSize(GetOption("--seed", "", ""), options.seed);
+    std::string generator = GetOption("--generator", "-g", "");
+    if (!generator.empty())
+    {
+        options.generator = DataIo::ToString(ParseBits(generator));
+    }
+    if (path.empty() || options.numConnections == 0 || options.depth == 0 || options.minBytes == 0
+        || options.minBytes > options.maxBytes || !operands_.empty())
+    {
+        std::cerr << "Error: A socket path, and at least one connection, request in flight and byte are required!"
+                  << std::endl;
+        return EC_ERROR;
+    }
+    JobClient::LoadReport report;
+    JobClient client;
+    JobProtocol::Response response;
+    if (!JobClient::RunLoad(path, options, report) || !client.Connect(path)
+        || !client.Call(JobProtocol::OP_STATISTICS, "", std::vector<uint8_t>(), response))
+    {
+        std::cerr << "Error: No answer from the server at " << path << "!" << std::endl;
+        return EC_ERROR;
+    }
+    JobClient::WriteReport(std::cout, report);
+    std::cout << "# server" << std::endl;
+    std::cout.write(reinterpret_cast<const char*>(response.payload.data()),
+                    static_cast<std::streamsize>(response.payload.size()));
+    return report.numFailed ? EC_CHECK_FAILED : EC_SUCCESS;
+}
+
+bool CliEngine::ReadInput(const std::string& path, std::vector<uint8_t>& data)
+{
+    if (path.empty())
+    {
+        std::vector<char> buffer(1 << 16);
+        while (std::cin.read(&buffer[0], buffer.size()) || std::cin.gcount())
+        {
+            data.insert(data.end(), buffer.begin(), buffer.begin() + std::cin.gcount());
+        }
+        return true;
+    }
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        return false;
+    }
+    data.assign(file.GetData(), file.GetData() + file.GetSize());
+    return true;
+}
+
+bool CliEngine::ParseArguments(const std::vector<std::string>& args)
+{
+    options_.clear();
+    operands_.clear();
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        if (args[i].size() > 1 && args[i][0] == '-')
+        {
+            if (i + 1 == args.size())
+            {
+                std::cerr << "Error: Option " << args[i] << " needs a value!" << std::endl;
+                return false;
+            }
+            options_[args[i]] = args[i + 1];
+            ++i;
+        }
+        else
+        {
+            operands_.push_back(args[i]);
+        }
+    }
+    return true;
+}
+
+std::string CliEngine::GetOption(const std::string& name, const std::string& shortName, const std::string& fallback) const
+{
+    auto it = options_.find(name);
+    if (it == options_.end() && !shortName.empty())
+    {
+        it = options_.find(shortName);
+    }
+    return it == options_.end() ? fallback : it->second;
+}
+
+size_t CliEngine::GetNumberOfThreads(void) const
+{
+    return ParseSize(GetOption("--threads", "-j", ""), 0);
+}
+
+std::vector<bool> CliEngine::ParseBits(const std::string& text)
+{
+    if (text.compare(0, 2, "0x") == 0 || text.compare(0, 2, "0X") == 0)
+    {
+        std::vector<uint64_t> words;
+        size_t numBits = DataIo::FromHex(text.data(), text.length(), words);
+        return PackedBits::ToVector(words.empty() ? nullptr : &words[0], numBits);
+    }
+    return DataIo::FromString(text);
+}
+
+size_t CliEngine::ParseSize(const std::string& text, size_t fallback)
+{
+    char* end = nullptr;
+    unsigned long value = std::strtoul(text.c_str(), &end, 10);
+    return !text.empty() && end && *end == '\0' ? static_cast<size_t>(value) : fallback;
+}
+
+std::vector<size_t> CliEngine::ParseSizes(const std::string& text)
+{
+    std::vector<size_t> sizes;
+    for (size_t first = 0; first <= text.size(); )
+    {
+        size_t last = std::min(text.find(',', first), text.size());
+        size_t size = ParseSize(text.substr(first, last - first), 0);
+        if (size == 0)
+        {
+            return std::vector<size_t>();
+        }
+        sizes.push_back(size);
+        first = last + 1;
+    }
+    return sizes;
+}
+
+double CliEngine::ParseDouble(const std::string& text, double fallback)
+{
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    return !text.empty() && end && *end == '\0' ? value : fallback;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Command-line mode: runs one command given by the program arguments and
+ * returns the process exit code.
+ *
+ * Commands read the named input file (memory-mapped) or stdin, and write
+ * the named output file or stdout, so they can be used in shell pipelines.
+ */
+class CliEngine
+{
+public:
+    /**
+     * @param [in] args   the arguments after the program name.
+     * @return 0 on success, 1 if a check fails, 2 on usage or I/O errors.
+     */
+    int Run(const std::vector<std::string>& args);
+
+    static void ShowUsage(void);
+
+private:
+    int RunCommand(const std::string& command);
+    int Crc(void);
+    int HammingEncode(void);
+    int HammingDecode(void);
+    int Ber(void);
+    int CrcAnalyze(void);
+    int CrcSweep(void);
+    int CrcManifestBuild(void);
+    int CrcManifestRefresh(void);
+    int CrcManifestVerify(void);
+    int Serve(void);
+    int Job(void);
+    int JobLoad(void);
+
+    /**
+     * Split the arguments into options ("--name value" or "-n value") and operands.
+     * @return false if an option lacks its value.
+     */
+    bool ParseArguments(const std::vector<std::string>& args);
+
+    /**
+     * @return The value of an option given by its long or short name, or \c fallback.
+     */
+    std::string GetOption(const std::string& name, const std::string& shortName, const std::string& fallback) const;
+
+    /**
+     * @return The number of worker threads asked for with --threads, 0 for one per hardware thread.
+     */
+    size_t GetNumberOfThreads(void) const;
+
+    /**
+     * Read a whole file, or stdin if \c path is empty.
+     * @return false if the file cannot be read.
+     */
+    static bool ReadInput(const std::string& path, std::vector<uint8_t>& data);
+
+    /**
+     * Parse a bit sequence given as bits, or as hex digits after "0x".
+     */
+    static std::vector<bool> ParseBits(const std::string& text);
+
+    /**
+     * Parse a decimal number.
+     * @return \c fallback if \c text is not one.
+     */
+    static size_t ParseSize(const std::string& text, size_t fallback);
+
+    /**
+     * Parse a comma-separated list of decimal numbers.
+     * @return An empty list if \c text is not one.
+     */
+    static std::vector<size_t> ParseSizes(const std::string& text);
+
+    /**
+     * Parse a decimal or scientific number.
+     * @return \c fallback if \c text is not one.
+     */
+    static double ParseDouble(const std::string& text, double fallback);
+
+private:
+    std::map<std::string, std::string> options_;
+    std::vector<std::string> operands_;
+};
@@ -0,0 +1,649 @@
+#include "CodecPipeline.h"
+#include "BlockInterleaver.h"
+#include "HammingCodecs.h"
+#include "LfsrDivider.h"
+#include "PackedBits.h"
+#include "ScratchArena.h"
+#include <cassert>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ostream>
+
+namespace
+{
+    size_t Gcd(size_t a, size_t b)
+    {
+        while (b)
+        {
+            size_t t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    size_t Lcm(size_t a, size_t b)
+    {
+        return a / Gcd(a, b) * b;
+    }
+
+    uint64_t* AllocateWords(ScratchArena& arena, size_t numWords)
+    {
+        return static_cast<uint64_t*>(arena.Allocate(std::max<size_t>(numWords, 1) * sizeof (uint64_t), 64));
+    }
+
+    /**
+     * Clear the bits from \c first to the end of \c numWords words.
+     */
+    void ClearFrom(uint64_t* words, size_t first, size_t numWords)
+    {
+        size_t w = first / PackedBits::WORD_BITS;
+        if (w >= numWords)
+        {
+            return;
+        }
+        if (first % PackedBits::WORD_BITS)
+        {
+            words[w++] &= PackedBits::GetLowMask(first % PackedBits::WORD_BITS);
+        }
+        std::fill(words + w, words + numWords, 0);
+    }
+
+    /**
+     * Copy \c numBits bits of the last tile to or from a stream, clearing the unused bits of its last word.
+     */
+    void CopyTail(const uint64_t* src, size_t srcFirst, uint64_t* dst, size_t dstFirst, size_t numBits)
+    {
+        PackedBits::CopyBits(src, srcFirst, dst, dstFirst, numBits);
+        size_t end = dstFirst + numBits;
+        if (end % PackedBits::WORD_BITS)
+        {
+            dst[end / PackedBits::WORD_BITS] &= PackedBits::GetLowMask(end % PackedBits::WORD_BITS);
+        }
+    }
+
+    uint64_t GetNanoseconds(std::chrono::steady_clock::time_point start)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+CodecPipeline::CodecPipeline(size_t tileBits) :
+    aimedTileBits_(tileBits),
+    numRegWords_(0),
+    numScratchWords_(0),
+    maxBlocks_(0)
+{
+    assert(tileBits > 0);
+    Plan();
+}
+
+CodecPipeline& CodecPipeline::AddCrc(const LfsrDivider& divider)
+{
+    Stage stage = { SK_CRC, &divider, nullptr, nullptr };
+    AddStage(stage);
+    return *this;
+}
+
+CodecPipeline& CodecPipeline::AddHamming(const HammingCodecs& hamming)
+{
+    Stage stage = { SK_HAMMING, nullptr, &hamming, nullptr };
+    AddStage(stage);
+    return *this;
+}
+
+CodecPipeline& CodecPipeline::AddInterleaver(const BlockInterleaver& interleaver)
+{
+    Stage stage = { SK_INTERLEAVER, nullptr, nullptr, &interleaver };
+    AddStage(stage);
+    return *this;
+}
+
+void CodecPipeline::AddStage(const Stage& stage)
+{
+    stages_.push_back(stage);
+    Plan();
+}
+
+size_t CodecPipeline::GetNumberOfStages(void) const
+{
+    return stages_.size();
+}
+
+CodecPipeline::StageKind CodecPipeline::GetStageKind(size_t stage) const
+{
+    return stages_[stage].kind;
+}
+
+size_t CodecPipeline::GetTileLength(void) const
+{
+    return tileBits_[0];
+}
+
+size_t CodecPipeline::GetOutputLength(size_t stage, size_t numBits) const
+{
+    const Stage& s = stages_[stage];
+    switch (s.kind)
+    {
+    case SK_CRC:
+        return numBits + s.divider->GetDegree();
+    case SK_HAMMING:
+        return (numBits + s.hamming->GetNumberOfMessageBits() - 1) / s.hamming->GetNumberOfMessageBits()
+               * s.hamming->GetNumberOfCodeBits();
+    case SK_INTERLEAVER:
+        return GetPaddedLength(stage, numBits);
+    }
+    return numBits;
+}
+
+size_t CodecPipeline::GetPaddedLength(size_t stage, size_t numBits) const
+{
+    const Stage& s = stages_[stage];
+    size_t unit = 1;
+    switch (s.kind)
+    {
+    case SK_CRC:
+        break;
+    case SK_HAMMING:
+        unit = s.hamming->GetNumberOfMessageBits();
+        break;
+    case SK_INTERLEAVER:
+        unit = s.interleaver->GetFrameLength();
+        break;
+    }
+    return (numBits + unit - 1) / unit * unit;
+}
+
+size_t CodecPipeline::GetEncodedLength(size_t numBits) const
+{
+    for (size_t s = 0; s < stages_.size(); ++s)
+    {
+        numBits = GetOutputLength(s, numBits);
+    }
+    return numBits;
+}
+
+void CodecPipeline::Plan(void)
+{
+    size_t numStages = stages_.size();
+    // Walk back from the end, where a tile must fill whole words, to find
+    // the smallest tile made of whole units of every stage and whole words
+    // between any two stages.
+    std::vector<size_t> inUnits(numStages, 1);
+    std::vector<size_t> outUnits(numStages, 1);
+    for (size_t s = 0; s < numStages; ++s)
+    {
+        if (stages_[s].kind == SK_HAMMING)
+        {
+            inUnits[s] = stages_[s].hamming->GetNumberOfMessageBits();
+            outUnits[s] = stages_[s].hamming->GetNumberOfCodeBits();
+        }
+        else if (stages_[s].kind == SK_INTERLEAVER)
+        {
+            inUnits[s] = outUnits[s] = stages_[s].interleaver->GetFrameLength();
+        }
+    }
+    size_t granularity = PackedBits::WORD_BITS;
+    for (size_t s = numStages; s-- > 0; )
+    {
+        size_t numUnits = Lcm(granularity, outUnits[s]) / outUnits[s];
+        granularity = Lcm(numUnits * inUnits[s], PackedBits::WORD_BITS);
+    }
+    tileBits_.assign(numStages + 1, 0);
+    tileBits_[0] = std::max<size_t>(aimedTileBits_ / granularity, 1) * granularity;
+    for (size_t s = 0; s < numStages; ++s)
+    {
+        tileBits_[s + 1] = tileBits_[s] / inUnits[s] * outUnits[s];
+    }
+
+    // The last tile is the longest: a whole tile plus the appended CRCs and padding.
+    bufferWords_.assign(numStages + 1, 0);
+    regOffsets_.assign(numStages, 0);
+    numRegWords_ = 0;
+    numScratchWords_ = 0;
+    maxBlocks_ = 0;
+    size_t numBits = tileBits_[0];
+    for (size_t s = 0; s < numStages; ++s)
+    {
+        size_t padded = GetPaddedLength(s, numBits);
+        bufferWords_[s] = PackedBits::GetNumberOfWords(padded);
+        if (stages_[s].kind == SK_CRC)
+        {
+            regOffsets_[s] = numRegWords_;
+            numRegWords_ += stages_[s].divider->GetNumberOfWords();
+        }
+        else if (stages_[s].kind == SK_HAMMING)
+        {
+            numScratchWords_ = std::max(numScratchWords_, stages_[s].hamming->GetScratchSize());
+            maxBlocks_ = std::max(maxBlocks_, padded / inUnits[s]);
+        }
+        numBits = GetOutputLength(s, numBits);
+    }
+    bufferWords_[numStages] = PackedBits::GetNumberOfWords(numBits);
+}
+
+const uint64_t* CodecPipeline::EncodeStage(size_t stage, const uint64_t* in, size_t numBits, uint64_t* out,
+                                           bool last, uint64_t* reg, uint64_t* scratch) const
+{
+    const Stage& s = stages_[stage];
+    switch (s.kind)
+    {
+    case SK_CRC:
+        s.divider->Update(reg, in, numBits);
+        if (!last)
+        {
+            return in;
+        }
+        PackedBits::CopyBits(in, 0, out, 0, numBits);
+        PackedBits::CopyBits(reg, 0, out, numBits, s.divider->GetDegree());
+        break;
+    case SK_HAMMING:
+        s.hamming->EncodeBlocks(in, GetPaddedLength(stage, numBits) / s.hamming->GetNumberOfMessageBits(),
+                                out, scratch);
+        break;
+    case SK_INTERLEAVER:
+        s.interleaver->Interleave(in, GetPaddedLength(stage, numBits) / s.interleaver->GetFrameLength(), out);
+        break;
+    }
+    return out;
+}
+
+void CodecPipeline::Encode(const uint64_t* message, size_t numBits, uint64_t* code,
+                           StageStatistics* statistics) const
+{
+    size_t numStages = stages_.size();
+    ScratchArena::Scope scope;
+    ScratchArena& arena = ScratchArena::GetInstance();
+    std::vector<uint64_t*> buffers(numStages + 1);
+    for (size_t s = 0; s <= numStages; ++s)
+    {
+        buffers[s] = AllocateWords(arena, bufferWords_[s]);
+    }
+    uint64_t* regs = AllocateWords(arena, numRegWords_);
+    uint64_t* scratch = AllocateWords(arena, numScratchWords_);
+    std::fill(regs, regs + numRegWords_, 0);
+
+    // Whole tiles go from the message to the code through the buffers,
+    // the last tile, shorter and padded, from buffer to buffer.
+    size_t numTiles = numBits ? (numBits - 1) / tileBits_[0] : 0;
+    for (size_t t = 0; t <= numTiles; ++t)
+    {
+        bool last = t == numTiles;
+        size_t length = tileBits_[0];
+        const uint64_t* in = message + t * (tileBits_[0] / PackedBits::WORD_BITS);
+        uint64_t* tile = code + t * (tileBits_[numStages] / PackedBits::WORD_BITS);
+        if (last)
+        {
+            length = numBits - t * tileBits_[0];
+            CopyTail(message, t * tileBits_[0], buffers[0], 0, length);
+            in = buffers[0];
+        }
+        for (size_t s = 0; s < numStages; ++s)
+        {
+            std::chrono::steady_clock::time_point start;
+            if (statistics)
+            {
+                start = std::chrono::steady_clock::now();
+            }
+            uint64_t* out = !last && s + 1 == numStages ? tile : buffers[s + 1];
+            if (last)
+            {
+                ClearFrom(buffers[s], length, bufferWords_[s]);
+            }
+            in = EncodeStage(s, in, length, out, last, regs + regOffsets_[s], scratch);
+            size_t outLength = last ? GetOutputLength(s, length) : tileBits_[s + 1];
+            if (statistics)
+            {
+                statistics[s].numInputBits += length;
+                statistics[s].numOutputBits += outLength;
+                statistics[s].numNanoseconds += GetNanoseconds(start);
+            }
+            length = outLength;
+        }
+        if (last)
+        {
+            CopyTail(in, 0, code, t * tileBits_[numStages], length);
+        }
+        else if (in != tile)
+        {
+            // The tile went through CRCs only.
+            std::memcpy(tile, in, tileBits_[numStages] / PackedBits::WORD_BITS * sizeof (uint64_t));
+        }
+    }
+}
+
+const uint64_t* CodecPipeline::DecodeStage(size_t stage, const uint64_t* in, size_t numBits, uint64_t* out,
+                                           bool last, uint64_t* reg, uint64_t* scratch, size_t* errors,
+                                           StageStatistics* statistics, DecodeResult& result) const
+{
+    const Stage& s = stages_[stage];
+    switch (s.kind)
+    {
+    case SK_CRC:
+        s.divider->Update(reg, in, numBits);
+        if (last && !PackedBits::IsZero(reg, s.divider->GetDegree()))
+        {
+            if (statistics)
+            {
+                ++statistics[stage].numFailures;
+            }
+            result = DR_CRC_MISMATCH;
+            return nullptr;
+        }
+        return in;
+    case SK_HAMMING:
+        {
+            size_t numCodeBits = s.hamming->GetNumberOfCodeBits();
+            size_t numBlocks = numBits / numCodeBits;
+            if (s.hamming->DecodeBlocks(in, numBlocks, out, errors, scratch) == 0)
+            {
+                break;
+            }
+            size_t numCorrected = 0;
+            size_t numFailures = 0;
+            for (size_t b = 0; b < numBlocks; ++b)
+            {
+                if (errors[b] > numCodeBits)
+                {
+                    ++numFailures;
+                }
+                else if (errors[b])
+                {
+                    ++numCorrected;
+                }
+            }
+            if (statistics)
+            {
+                statistics[stage].numCorrected += numCorrected;
+                statistics[stage].numFailures += numFailures;
+            }
+            if (numFailures)
+            {
+                result = DR_UNCORRECTABLE;
+                return nullptr;
+            }
+            if (numCorrected)
+            {
+                result = DR_CORRECTED;
+            }
+        }
+        break;
+    case SK_INTERLEAVER:
+        s.interleaver->Deinterleave(in, numBits / s.interleaver->GetFrameLength(), out);
+        break;
+    }
+    return out;
+}
+
+CodecPipeline::DecodeResult CodecPipeline::Decode(const uint64_t* code, size_t numBits, uint64_t* message,
+                                                  StageStatistics* statistics) const
+{
+    size_t numStages = stages_.size();
+    ScratchArena::Scope scope;
+    ScratchArena& arena = ScratchArena::GetInstance();
+    std::vector<uint64_t*> buffers(numStages + 1);
+    for (size_t s = 0; s <= numStages; ++s)
+    {
+        buffers[s] = AllocateWords(arena, bufferWords_[s]);
+    }
+    uint64_t* regs = AllocateWords(arena, numRegWords_);
+    uint64_t* scratch = AllocateWords(arena, numScratchWords_);
+    size_t* errors = static_cast<size_t*>(arena.Allocate(std::max<size_t>(maxBlocks_, 1) * sizeof (size_t), 8));
+    std::fill(regs, regs + numRegWords_, 0);
+
+    // The lengths of the last tile before and after each stage.
+    std::vector<size_t> lastBits(numStages + 1);
+    size_t numTiles = numBits ? (numBits - 1) / tileBits_[0] : 0;
+    lastBits[0] = numBits - numTiles * tileBits_[0];
+    for (size_t s = 0; s < numStages; ++s)
+    {
+        lastBits[s + 1] = GetOutputLength(s, lastBits[s]);
+    }
+
+    DecodeResult result = DR_NO_ERROR;
+    for (size_t t = 0; t <= numTiles; ++t)
+    {
+        bool last = t == numTiles;
+        const uint64_t* in = code + t * (tileBits_[numStages] / PackedBits::WORD_BITS);
+        uint64_t* tile = message + t * (tileBits_[0] / PackedBits::WORD_BITS);
+        if (last)
+        {
+            CopyTail(code, t * tileBits_[numStages], buffers[numStages], 0, lastBits[numStages]);
+            in = buffers[numStages];
+        }
+        for (size_t s = numStages; s-- > 0; )
+        {
+            std::chrono::steady_clock::time_point start;
+            if (statistics)
+            {
+                start = std::chrono::steady_clock::now();
+            }
+            size_t length = last ? lastBits[s + 1] : tileBits_[s + 1];
+            uint64_t* out = !last && s == 0 ? tile : buffers[s];
+            in = DecodeStage(s, in, length, out, last, regs + regOffsets_[s], scratch, errors, statistics, result);
+            if (!in)
+            {
+                return result;
+            }
+            if (statistics)
+            {
+                statistics[s].numInputBits += length;
+                statistics[s].numOutputBits += last ? lastBits[s] : tileBits_[s];
+                statistics[s].numNanoseconds += GetNanoseconds(start);
+            }
+        }
+        if (last)
+        {
+            CopyTail(in, 0, message, t * tileBits_[0], lastBits[0]);
+        }
+        else if (in != tile)
+        {
+            std::memcpy(tile, in, tileBits_[0] / PackedBits::WORD_BITS * sizeof (uint64_t));
+        }
+    }
+    return result;
+}
+
+std::vector<bool> CodecPipeline::Encode(const std::vector<bool>& message) const
+{
+    std::vector<uint64_t> packed = PackedBits::FromVector(message);
+    size_t numCodeBits = GetEncodedLength(message.size());
+    std::vector<uint64_t> code(std::max<size_t>(PackedBits::GetNumberOfWords(numCodeBits), 1));
+    Encode(packed.empty() ? nullptr : &packed[0], message.size(), &code[0]);
+    return PackedBits::ToVector(&code[0], numCodeBits);
+}
+
+CodecPipeline::DecodeResult CodecPipeline::Decode(const std::vector<bool>& code, size_t numBits,
+                                                  std::vector<bool>& message) const
+{
+    assert(code.size() == GetEncodedLength(numBits));
+    std::vector<uint64_t> packed = PackedBits::FromVector(code);
+    std::vector<uint64_t> decoded(std::max<size_t>(PackedBits::GetNumberOfWords(numBits), 1));
+    DecodeResult result = Decode(packed.empty() ? nullptr : &packed[0], numBits, &decoded[0]);
+    message = PackedBits::ToVector(&decoded[0], numBits);
+    return result;
+}
+
+void CodecPipeline::WriteStatistics(std::ostream& os, const StageStatistics* statistics) const
+{
+    static const char* const names[] = { "crc", "hamming", "interleaver" };
+    for (size_t s = 0; s < stages_.size(); ++s)
+    {
+        const StageStatistics& st = statistics[s];
+        os << s << ' ' << names[stages_[s].kind]
+           << ": " << st.numInputBits << " -> " << st.numOutputBits << " bits, "
+           << st.numNanoseconds / 1000 << " us";
+        if (st.numNanoseconds)
+        {
+            os << " (" << st.numInputBits * 1000 / st.numNanoseconds << " Mbit/s)";
+        }
+        if (stages_[s].kind != SK_INTERLEAVER)
+        {
+            os << ", " << st.numCorrected << " corrected, " << st.numFailures << " failed";
+        }
+        os << '\n';
+    }
+}
+
+#include "DataIo.h"
+void CodecPipeline::Test(void)
+{
+    LfsrDivider crc16(DataIo::FromString("1 1000 0000 0000 0101"));
+    HammingCodecs hamming(11);
+    BlockInterleaver interleaver(hamming.GetNumberOfCodeBits(), 8);
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    DecodeResult result = DR_NO_ERROR;
+
+    // The stages run one after another over whole streams, as a reference.
+    auto encodeStaged = [&](const std::vector<bool>& message)
+    {
+        std::vector<bool> frame = message;
+        std::vector<bool> crc = crc16.Remainder(message);
+        frame.insert(frame.end(), crc.begin(), crc.end());
+        size_t numBlocks = (frame.size() + 10) / 11;
+        frame.resize(numBlocks * 11, false);
+        std::vector<uint64_t> packed = PackedBits::FromVector(frame);
+        size_t numFrames = (numBlocks * 15 + interleaver.GetFrameLength() - 1) / interleaver.GetFrameLength();
+        std::vector<uint64_t> code(PackedBits::GetNumberOfWords(numFrames * interleaver.GetFrameLength()) + 1, 0);
+        hamming.EncodeBlocks(&packed[0], numBlocks, &code[0]);
+        std::vector<uint64_t> interleaved(code.size(), 0);
+        interleaver.Interleave(&code[0], numFrames, &interleaved[0]);
+        return PackedBits::ToVector(&interleaved[0], numFrames * interleaver.GetFrameLength());
+    };
+
+    // Fused tiles against whole-stream stages, with small tiles so that
+    // messages span several of them.
+    const size_t tileLengths[] = { 1, 1000, TILE_BITS };
+    const size_t lengths[] = { 0, 1, 63, 64, 500, 1320, 1321, 5000 };
+    for (size_t i = 0; i < sizeof (tileLengths) / sizeof (tileLengths[0]); ++i)
+    {
+        CodecPipeline pipeline(tileLengths[i]);
+        pipeline.AddCrc(crc16).AddHamming(hamming).AddInterleaver(interleaver);
+        assert(pipeline.GetNumberOfStages() == 3);
+        assert(pipeline.GetStageKind(1) == SK_HAMMING);
+        assert(pipeline.GetTileLength() % (11 * 64) == 0);
+        for (size_t j = 0; j < sizeof (lengths) / sizeof (lengths[0]); ++j)
+        {
+            std::vector<bool> message(lengths[j]);
+            for (size_t b = 0; b < message.size(); ++b)
+            {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                message[b] = x & 1;
+            }
+            std::vector<bool> code = pipeline.Encode(message);
+            assert(code.size() == pipeline.GetEncodedLength(message.size()));
+            assert(code == encodeStaged(message));
+            std::vector<bool> decoded;
+            result = pipeline.Decode(code, message.size(), decoded);
+            assert(result == DR_NO_ERROR);
+            assert(decoded == message);
+
+            // A burst as long as the interleaving depth hits each codeword once.
+            size_t at = code.size() / 2;
+            for (size_t b = at; b < at + interleaver.GetDepth(); ++b)
+            {
+                code[b] = !code[b];
+            }
+            result = pipeline.Decode(code, message.size(), decoded);
+            assert(result == DR_CORRECTED);
+            assert(decoded == message);
+        }
+    }
+
+    // Statistics: corrections, and the lengths seen by each stage.
+    {
+        CodecPipeline pipeline(1000);
+        pipeline.AddCrc(crc16).AddHamming(hamming).AddInterleaver(interleaver);
+        std::vector<uint64_t> message(80, 0x0123456789ABCDEFULL);
+        size_t numBits = 80 * 64 - 5;
+        message.back() &= PackedBits::GetLowMask(59);
+        size_t numCodeBits = pipeline.GetEncodedLength(numBits);
+        std::vector<uint64_t> code(PackedBits::GetNumberOfWords(numCodeBits), ~uint64_t(0));
+        StageStatistics statistics[3] = {};
+        pipeline.Encode(&message[0], numBits, &code[0], statistics);
+        assert(statistics[0].numInputBits == numBits);
+        assert(statistics[0].numOutputBits == numBits + 16);
+        assert(statistics[2].numOutputBits == numCodeBits);
+        assert(numCodeBits % 64 && !(code.back() >> (numCodeBits % 64)));
+        PackedBits::FlipBit(&code[0], 3);
+        PackedBits::FlipBit(&code[0], 2000);
+        std::vector<uint64_t> decoded(message.size(), ~uint64_t(0));
+        StageStatistics decodeStatistics[3] = {};
+        result = pipeline.Decode(&code[0], numBits, &decoded[0], decodeStatistics);
+        assert(result == DR_CORRECTED);
+        assert(decoded == message);
+        assert(decodeStatistics[1].numCorrected == 2);
+        assert(decodeStatistics[1].numFailures == 0);
+        assert(decodeStatistics[0].numOutputBits == numBits);
+    }
+
+    // A double error the perfect (7, 4) code miscorrects is caught by the CRC.
+    {
+        HammingCodecs hamming4(4);
+        CodecPipeline pipeline(256);
+        pipeline.AddCrc(crc16).AddHamming(hamming4);
+        std::vector<bool> message(1000, true);
+        std::vector<bool> code = pipeline.Encode(message);
+        code[700] = !code[700];
+        code[701] = !code[701];
+        std::vector<bool> decoded;
+        result = pipeline.Decode(code, message.size(), decoded);
+        assert(result == DR_CRC_MISMATCH);
+    }
+
+    // An invalid syndrome of a shortened code stops decoding at once.
+    {
+        HammingCodecs hamming8(8);
+        assert(hamming8.GetNumberOfCodeBits() == 12);
+        CodecPipeline pipeline(256);
+        pipeline.AddCrc(crc16).AddHamming(hamming8);
+        std::vector<uint64_t> message(64, 0xFEDCBA9876543210ULL);
+        size_t numCodeBits = pipeline.GetEncodedLength(64 * 64);
+        std::vector<uint64_t> code(PackedBits::GetNumberOfWords(numCodeBits));
+        pipeline.Encode(&message[0], 64 * 64, &code[0]);
+        // Errors at positions 5 and 8 leave the syndrome 13.
+        PackedBits::FlipBit(&code[0], 12 + 4);
+        PackedBits::FlipBit(&code[0], 12 + 7);
+        std::vector<uint64_t> decoded(message.size());
+        StageStatistics statistics[2] = {};
+        result = pipeline.Decode(&code[0], 64 * 64, &decoded[0], statistics);
+        assert(result == DR_UNCORRECTABLE);
+        assert(statistics[1].numFailures == 1);
+        // Decoding stopped in the first tile: the CRC saw nothing.
+        assert(statistics[0].numInputBits == 0);
+    }
+
+    // A CRC last, and no stage at all.
+    {
+        CodecPipeline pipeline(100);
+        pipeline.AddHamming(hamming).AddCrc(crc16);
+        CodecPipeline identity(100);
+        for (size_t n = 0; n < 3000; n += 701)
+        {
+            std::vector<bool> message(n, false);
+            for (size_t b = 0; b < n; b += 3)
+            {
+                message[b] = true;
+            }
+            std::vector<bool> code = pipeline.Encode(message);
+            assert(code.size() == (n + 10) / 11 * 15 + 16);
+            std::vector<bool> decoded;
+            result = pipeline.Decode(code, n, decoded);
+            assert(result == DR_NO_ERROR);
+            assert(decoded == message);
+            code[0] = !code[0];
+            result = pipeline.Decode(code, n, decoded);
+            assert(result == DR_CRC_MISMATCH);
+            assert(identity.Encode(message) == message);
+            result = identity.Decode(message, n, decoded);
+            assert(result == DR_NO_ERROR);
+            assert(decoded == message);
+        }
+    }
+    (void)encodeStaged;
+    (void)result;
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+class LfsrDivider;
+class HammingCodecs;
+class BlockInterleaver;
+
+/**
+ * A chain of codec stages run as one streaming loop.
+ *
+ * Stages are declared once, in encoding order, e.g. a CRC, then Hamming
+ * blocks, then an interleaver.  Encode() cuts the message into tiles of
+ * about GetTileLength() bits and runs every stage on a tile before moving
+ * to the next, so only tile-sized buffers, kept in the scratch arena, lie
+ * between the stages and the working set stays in cache whatever the
+ * message length.  Decode() runs the stages in reverse on the same tiles
+ * and stops at the first block it cannot correct.
+ *
+ * A stage pads the end of the stream to its own unit: a CRC appends its
+ * remainder, Hamming codes whole blocks, an interleaver whole frames, all
+ * padded with zeros.  The tiles are whole units of every stage, so only
+ * the last tile is padded.
+ *
+ * The pipeline keeps pointers to the codecs, which must outlive it.
+ */
+class CodecPipeline
+{
+public:
+    /// The default tile length, in message bits.
+    static const size_t TILE_BITS = 32768;
+
+    enum StageKind
+    {
+        SK_CRC,             ///< appends the remainder of a LfsrDivider.
+        SK_HAMMING,         ///< HammingCodecs blocks.
+        SK_INTERLEAVER,     ///< BlockInterleaver frames.
+    };
+
+    enum DecodeResult
+    {
+        DR_NO_ERROR,        ///< every block and CRC checked out.
+        DR_CORRECTED,       ///< some blocks were corrected.
+        DR_UNCORRECTABLE,   ///< a block had an invalid syndrome; decoding stopped.
+        DR_CRC_MISMATCH,    ///< a CRC check failed; decoding stopped.
+    };
+
+    /**
+     * Totals of one stage over the calls given them, in the direction run.
+     */
+    struct StageStatistics
+    {
+        uint64_t numInputBits;
+        uint64_t numOutputBits;
+        uint64_t numNanoseconds;
+        uint64_t numCorrected;      ///< Hamming blocks corrected.
+        uint64_t numFailures;       ///< uncorrectable blocks or CRC mismatches.
+    };
+
+    /**
+     * @param [in] tileBits   the aimed tile length in message bits, rounded to whole units of the stages.
+     */
+    explicit CodecPipeline(size_t tileBits = TILE_BITS);
+
+    CodecPipeline& AddCrc(const LfsrDivider& divider);
+    CodecPipeline& AddHamming(const HammingCodecs& hamming);
+    CodecPipeline& AddInterleaver(const BlockInterleaver& interleaver);
+
+    size_t GetNumberOfStages(void) const;
+    StageKind GetStageKind(size_t stage) const;
+
+    /**
+     * @return The message bits of a whole tile.
+     */
+    size_t GetTileLength(void) const;
+
+    /**
+     * @return The number of code bits of a \c numBits-bit message.
+     */
+    size_t GetEncodedLength(size_t numBits) const;
+
+    /**
+     * @param [in]  message      a packed bit sequence.
+     * @param [in]  numBits      the number of bits of \c message.
+     * @param [out] code         GetEncodedLength(numBits) bits, the unused bits of the last word cleared.
+     * @param [out] statistics   GetNumberOfStages() entries to add to, or nullptr.
+     */
+    void Encode(const uint64_t* message, size_t numBits, uint64_t* code,
+                StageStatistics* statistics = nullptr) const;
+
+    /**
+     * @param [in]  code         GetEncodedLength(numBits) bits.
+     * @param [in]  numBits      the number of message bits.
+     * @param [out] message      \c numBits bits, the unused bits of the last word cleared;
+     *                           undefined past the failing tile if decoding stops.
+     * @param [out] statistics   GetNumberOfStages() entries to add to, or nullptr.
+     */
+    DecodeResult Decode(const uint64_t* code, size_t numBits, uint64_t* message,
+                        StageStatistics* statistics = nullptr) const;
+
+    std::vector<bool> Encode(const std::vector<bool>& message) const;
+    DecodeResult Decode(const std::vector<bool>& code, size_t numBits, std::vector<bool>& message) const;
+
+    /**
+     * Write one line per stage.
+     */
+    void WriteStatistics(std::ostream& os, const StageStatistics* statistics) const;
+
+    static void Test(void);
+
+private:
+    struct Stage
+    {
+        StageKind kind;
+        const LfsrDivider* divider;
+        const HammingCodecs* hamming;
+        const BlockInterleaver* interleaver;
+    };
+
+    void AddStage(const Stage& stage);
+
+    /**
+     * Size the tiles and the buffers between the stages.
+     */
+    void Plan(void);
+
+    /**
+     * @return The stream length after \c stage, given \c numBits bits before it.
+     */
+    size_t GetOutputLength(size_t stage, size_t numBits) const;
+
+    /**
+     * @return \c numBits rounded up to whole units of \c stage.
+     */
+    size_t GetPaddedLength(size_t stage, size_t numBits) const;
+
+    /**
+     * Encode \c numBits bits of a tile through one stage.
+     * @return The output, \c out or \c in for a CRC passing a whole tile through.
+     */
+    const uint64_t* EncodeStage(size_t stage, const uint64_t* in, size_t numBits, uint64_t* out,
+                                bool last, uint64_t* reg, uint64_t* scratch) const;
+
+    /**
+     * Decode a tile through one stage, \c numBits bits of its output side.
+     * @return The output, \c out or \c in for a CRC; nullptr if decoding must stop.
+     */
+    const uint64_t* DecodeStage(size_t stage, const uint64_t* in, size_t numBits, uint64_t* out,
+                                bool last, uint64_t* reg, uint64_t* scratch, size_t* errors,
+                                StageStatistics* statistics, DecodeResult& result) const;
+
+private:
+    std::vector<Stage> stages_;
+    size_t aimedTileBits_;
+    std::vector<size_t> tileBits_;          ///< the bits of a whole tile before each stage, plus after the last.
+    std::vector<size_t> bufferWords_;       ///< the capacity of the buffer before each stage, plus after the last.
+    std::vector<size_t> regOffsets_;        ///< the first word of the register of each CRC stage.
+    size_t numRegWords_;
+    size_t numScratchWords_;
+    size_t maxBlocks_;                      ///< the most Hamming blocks of a tile.
+};
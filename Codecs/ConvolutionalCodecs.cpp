@@ -0,0 +1,565 @@
+#include "ConvolutionalCodecs.h"
+#include "DataIo.h"
+#include "PackedBits.h"
+#include "Simd.h"
+#include <cassert>
+#include <algorithm>
+
+ConvolutionalCodecs::ConvolutionalCodecs(const std::vector<std::vector<bool> >& generators) :
+    k_(generators.empty() ? 0 : generators[0].size())
+{
+    assert(generators.size() == 2 || generators.size() == 3);
+    assert(k_ >= 2 && k_ <= 9);
+    for (size_t g = 0; g < generators.size(); ++g)
+    {
+        assert(generators[g].size() == k_);
+        unsigned mask = 0;
+        for (size_t d = 0; d < k_; ++d)
+        {
+            if (generators[g][d])
+            {
+                mask |= 1u << (k_ - 1 - d);
+            }
+        }
+        generators_.push_back(mask);
+    }
+    size_t numStates = GetNumberOfStates();
+    outputs_.assign(2 * numStates, 0);
+    for (size_t s = 0; s < numStates; ++s)
+    {
+        for (unsigned u = 0; u < 2; ++u)
+        {
+            unsigned window = (u << (k_ - 1)) | static_cast<unsigned>(s);
+            unsigned out = 0;
+            for (size_t g = 0; g < generators_.size(); ++g)
+            {
+                if (PackedBits::Parity(window & generators_[g]))
+                {
+                    out |= 1u << g;
+                }
+            }
+            outputs_[2 * s + u] = out;
+        }
+    }
+}
+
+size_t ConvolutionalCodecs::GetConstraintLength(void) const
+{
+    return k_;
+}
+
+size_t ConvolutionalCodecs::GetNumberOfOutputs(void) const
+{
+    return generators_.size();
+}
+
+size_t ConvolutionalCodecs::GetNumberOfStates(void) const
+{
+    return size_t(1) << (k_ - 1);
+}
+
+unsigned ConvolutionalCodecs::GetOutput(size_t state, bool input) const
+{
+    return outputs_[2 * state + (input ? 1 : 0)];
+}
+
+size_t ConvolutionalCodecs::Encode(const uint64_t* input, size_t numBits, size_t state, uint64_t* output) const
+{
+    size_t n = generators_.size();
+    for (size_t i = 0; i < numBits; ++i)
+    {
+        size_t u = PackedBits::GetBit(input, i) ? 1 : 0;
+        PackedBits::InsertBits(output, i * n, outputs_[2 * state + u], n);
+        state = (state >> 1) | (u << (k_ - 2));
+    }
+    return state;
+}
+
+std::vector<bool> ConvolutionalCodecs::Encode(const std::vector<bool>& message) const
+{
+    std::vector<bool> input = message;
+    input.resize(message.size() + k_ - 1, false);
+    std::vector<uint64_t> packed = PackedBits::FromVector(input);
+    size_t numCodeBits = input.size() * generators_.size();
+    std::vector<uint64_t> code(PackedBits::GetNumberOfWords(numCodeBits) + 1, 0);
+    Encode(&packed[0], input.size(), 0, &code[0]);
+    return PackedBits::ToVector(&code[0], numCodeBits);
+}
+
+std::vector<bool> ConvolutionalCodecs::Decode(const std::vector<bool>& code) const
+{
+    size_t n = generators_.size();
+    assert(code.size() % n == 0);
+    std::vector<uint8_t> symbols(code.size(), 0);
+    for (size_t i = 0; i < code.size(); ++i)
+    {
+        symbols[i] = code[i] ? 255 : 0;
+    }
+    std::vector<bool> message;
+    ViterbiDecoder decoder(*this);
+    decoder.Push(symbols.empty() ? nullptr : &symbols[0], code.size() / n, message);
+    decoder.Finish(true, message);
+    return message;
+}
+
+#if defined(CODECS_HAS_SSE2)
+namespace
+{
+    // Thin wrappers so the add-compare-select is written once for SSE2 and AVX2.
+#if defined(CODECS_HAS_AVX2)
+    typedef __m256i Vector;
+    const size_t VECTOR_BYTES = 32;
+
+    inline Vector Load(const void* p) { return _mm256_loadu_si256(static_cast<const __m256i*>(p)); }
+    inline void Store(void* p, Vector v) { _mm256_storeu_si256(static_cast<__m256i*>(p), v); }
+    inline Vector Xor(Vector a, Vector b) { return _mm256_xor_si256(a, b); }
+    inline Vector Set8(int v) { return _mm256_set1_epi8(static_cast<char>(v)); }
+    inline Vector Set16(int v) { return _mm256_set1_epi16(static_cast<short>(v)); }
+    inline Vector Zero(void) { return _mm256_setzero_si256(); }
+    inline Vector Adds8(Vector a, Vector b) { return _mm256_adds_epu8(a, b); }
+    inline Vector Adds16(Vector a, Vector b) { return _mm256_adds_epi16(a, b); }
+    inline Vector Subs8(Vector a, Vector b) { return _mm256_subs_epu8(a, b); }
+    inline Vector Subs16(Vector a, Vector b) { return _mm256_subs_epi16(a, b); }
+    inline Vector Min8(Vector a, Vector b) { return _mm256_min_epu8(a, b); }
+    inline Vector Min16(Vector a, Vector b) { return _mm256_min_epi16(a, b); }
+    // Packing works within 128-bit lanes; restore the element order.
+    inline Vector Unlane(Vector v) { return _mm256_permute4x64_epi64(v, 0xD8); }
+    inline Vector Evens8(Vector a, Vector b)
+    {
+        Vector low = _mm256_set1_epi16(0x00FF);
+        return Unlane(_mm256_packus_epi16(_mm256_and_si256(a, low), _mm256_and_si256(b, low)));
+    }
+    inline Vector Odds8(Vector a, Vector b)
+    {
+        return Unlane(_mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8)));
+    }
+    inline Vector Evens16(Vector a, Vector b)
+    {
+        return Unlane(_mm256_packs_epi32(_mm256_srai_epi32(_mm256_slli_epi32(a, 16), 16),
+                                         _mm256_srai_epi32(_mm256_slli_epi32(b, 16), 16)));
+    }
+    inline Vector Odds16(Vector a, Vector b)
+    {
+        return Unlane(_mm256_packs_epi32(_mm256_srai_epi32(a, 16), _mm256_srai_epi32(b, 16)));
+    }
+    inline uint64_t Differ8(Vector a, Vector b)
+    {
+        return ~static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)))) & 0xFFFFFFFFULL;
+    }
+    inline uint64_t Differ16(Vector a, Vector b)
+    {
+        Vector eq = _mm256_cmpeq_epi16(a, b);
+        return ~static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(Unlane(_mm256_packs_epi16(eq, eq))))) & 0xFFFF;
+    }
+    inline __m128i Narrow(Vector v) { return _mm256_castsi256_si128(v); }
+    inline __m128i NarrowMin8(Vector v) { return _mm_min_epu8(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)); }
+    inline __m128i NarrowMin16(Vector v) { return _mm_min_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)); }
+#else
+    typedef __m128i Vector;
+    const size_t VECTOR_BYTES = 16;
+
+    inline Vector Load(const void* p) { return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+    inline void Store(void* p, Vector v) { _mm_storeu_si128(static_cast<__m128i*>(p), v); }
+    inline Vector Xor(Vector a, Vector b) { return _mm_xor_si128(a, b); }
+    inline Vector Set8(int v) { return _mm_set1_epi8(static_cast<char>(v)); }
+    inline Vector Set16(int v) { return _mm_set1_epi16(static_cast<short>(v)); }
+    inline Vector Zero(void) { return _mm_setzero_si128(); }
+    inline Vector Adds8(Vector a, Vector b) { return _mm_adds_epu8(a, b); }
+    inline Vector Adds16(Vector a, Vector b) { return _mm_adds_epi16(a, b); }
+    inline Vector Subs8(Vector a, Vector b) { return _mm_subs_epu8(a, b); }
+    inline Vector Subs16(Vector a, Vector b) { return _mm_subs_epi16(a, b); }
+    inline Vector Min8(Vector a, Vector b) { return _mm_min_epu8(a, b); }
+    inline Vector Min16(Vector a, Vector b) { return _mm_min_epi16(a, b); }
+    inline Vector Evens8(Vector a, Vector b)
+    {
+        Vector low = _mm_set1_epi16(0x00FF);
+        return _mm_packus_epi16(_mm_and_si128(a, low), _mm_and_si128(b, low));
+    }
+    inline Vector Odds8(Vector a, Vector b)
+    {
+        return _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+    }
+    inline Vector Evens16(Vector a, Vector b)
+    {
+        return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+    }
+    inline Vector Odds16(Vector a, Vector b)
+    {
+        return _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+    }
+    inline uint64_t Differ8(Vector a, Vector b)
+    {
+        return ~static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) & 0xFFFF;
+    }
+    inline uint64_t Differ16(Vector a, Vector b)
+    {
+        Vector eq = _mm_cmpeq_epi16(a, b);
+        return ~static_cast<uint64_t>(_mm_movemask_epi8(_mm_packs_epi16(eq, eq))) & 0xFF;
+    }
+    inline __m128i NarrowMin8(Vector v) { return v; }
+    inline __m128i NarrowMin16(Vector v) { return v; }
+#endif
+
+    inline unsigned HorizontalMin8(Vector v)
+    {
+        __m128i m = NarrowMin8(v);
+        m = _mm_min_epu8(m, _mm_srli_si128(m, 8));
+        m = _mm_min_epu8(m, _mm_srli_si128(m, 4));
+        m = _mm_min_epu8(m, _mm_srli_si128(m, 2));
+        m = _mm_min_epu8(m, _mm_srli_si128(m, 1));
+        return static_cast<unsigned>(_mm_cvtsi128_si32(m)) & 0xFF;
+    }
+
+    inline unsigned HorizontalMin16(Vector v)
+    {
+        __m128i m = NarrowMin16(v);
+        m = _mm_min_epi16(m, _mm_srli_si128(m, 8));
+        m = _mm_min_epi16(m, _mm_srli_si128(m, 4));
+        m = _mm_min_epi16(m, _mm_srli_si128(m, 2));
+        return static_cast<unsigned>(_mm_cvtsi128_si32(m)) & 0xFFFF;
+    }
+}
+#endif
+
+ViterbiDecoder::ViterbiDecoder(const ConvolutionalCodecs& codecs, MetricWidth width,
+                               size_t tracebackDepth, size_t blockLength) :
+    codecs_(codecs),
+    width_(width),
+    tracebackDepth_(tracebackDepth ? tracebackDepth : 8 * codecs.GetConstraintLength()),
+    blockLength_(blockLength ? blockLength : 256),
+    numStates_(codecs.GetNumberOfStates()),
+    numOutputs_(codecs.GetNumberOfOutputs()),
+    simd_(false)
+{
+    assert(tracebackDepth_ >= codecs.GetConstraintLength() - 1);
+    size_t half = numStates_ / 2;
+#if defined(CODECS_HAS_SSE2)
+    simd_ = half >= (width_ == MW_8_BIT ? VECTOR_BYTES : VECTOR_BYTES / 2);
+#endif
+    // Expected outputs of the transitions from states 2i + p on input u,
+    // as all-ones (in the quantized symbol range) or zero.
+    expect8_.assign(4 * numOutputs_ * half, 0);
+    expect16_.assign(4 * numOutputs_ * half, 0);
+    for (unsigned p = 0; p < 2; ++p)
+    {
+        for (unsigned u = 0; u < 2; ++u)
+        {
+            for (size_t b = 0; b < numOutputs_; ++b)
+            {
+                for (size_t i = 0; i < half; ++i)
+                {
+                    bool bit = (codecs_.GetOutput(2 * i + p, u != 0) >> b) & 1;
+                    size_t index = ((p * 2 + u) * numOutputs_ + b) * half + i;
+                    expect8_[index] = bit ? 7 : 0;
+                    expect16_[index] = bit ? 255 : 0;
+                }
+            }
+        }
+    }
+    wordsPerStep_ = PackedBits::GetNumberOfWords(numStates_);
+    decisions_.assign((tracebackDepth_ + blockLength_) * wordsPerStep_, 0);
+    metrics8_.assign(2 * numStates_, 0);
+    metrics16_.assign(2 * numStates_, 0);
+    Reset();
+}
+
+void ViterbiDecoder::Reset(void)
+{
+    // Start from state 0; the other states get a penalty that the first
+    // K - 1 steps wash out.
+    std::fill(metrics8_.begin(), metrics8_.end(), 63);
+    std::fill(metrics16_.begin(), metrics16_.end(), 2047);
+    metrics8_[0] = 0;
+    metrics16_[0] = 0;
+    current_ = 0;
+    bias_ = 0;
+    first_ = 0;
+    numStored_ = 0;
+}
+
+template <typename Metric, unsigned MAX_SYMBOL>
+void ViterbiDecoder::StepScalar(const unsigned* symbols, Metric* oldMetrics, Metric* newMetrics, uint64_t* decisions)
+{
+    const unsigned maxMetric = sizeof (Metric) == 1 ? 0xFF : 0x7FFF;
+    const size_t half = numStates_ / 2;
+    unsigned minimum = maxMetric;
+    for (size_t i = 0; i < half; ++i)
+    {
+        unsigned even = static_cast<unsigned>(oldMetrics[2 * i]) - bias_;
+        unsigned odd = static_cast<unsigned>(oldMetrics[2 * i + 1]) - bias_;
+        for (unsigned u = 0; u < 2; ++u)
+        {
+            unsigned bm0 = 0;
+            unsigned bm1 = 0;
+            for (size_t b = 0; b < numOutputs_; ++b)
+            {
+                size_t index0 = ((0 * 2 + u) * numOutputs_ + b) * half + i;
+                size_t index1 = ((1 * 2 + u) * numOutputs_ + b) * half + i;
+                bm0 += symbols[b] ^ (MAX_SYMBOL == 7 ? expect8_[index0] : static_cast<unsigned>(expect16_[index0]));
+                bm1 += symbols[b] ^ (MAX_SYMBOL == 7 ? expect8_[index1] : static_cast<unsigned>(expect16_[index1]));
+            }
+            unsigned a0 = std::min(even + bm0, maxMetric);
+            unsigned a1 = std::min(odd + bm1, maxMetric);
+            size_t j = i + u * half;
+            if (a1 < a0)
+            {
+                newMetrics[j] = static_cast<Metric>(a1);
+                decisions[j / PackedBits::WORD_BITS] |= uint64_t(1) << (j % PackedBits::WORD_BITS);
+            }
+            else
+            {
+                newMetrics[j] = static_cast<Metric>(a0);
+            }
+            minimum = std::min(minimum, static_cast<unsigned>(newMetrics[j]));
+        }
+    }
+    bias_ = minimum;
+}
+
+void ViterbiDecoder::StepSimd8(const unsigned* symbols, uint64_t* decisions)
+{
+#if defined(CODECS_HAS_SSE2)
+    const size_t lanes = VECTOR_BYTES;
+    const size_t half = numStates_ / 2;
+    const uint8_t* oldMetrics = &metrics8_[current_ * numStates_];
+    uint8_t* newMetrics = &metrics8_[(1 - current_) * numStates_];
+    Vector q[3];
+    for (size_t b = 0; b < numOutputs_; ++b)
+    {
+        q[b] = Set8(static_cast<int>(symbols[b]));
+    }
+    Vector bias = Set8(static_cast<int>(bias_));
+    Vector minimum = Set8(0xFF);
+    for (size_t i = 0; i < half; i += lanes)
+    {
+        Vector a = Load(oldMetrics + 2 * i);
+        Vector b = Load(oldMetrics + 2 * i + lanes);
+        Vector even = Subs8(Evens8(a, b), bias);
+        Vector odd = Subs8(Odds8(a, b), bias);
+        for (unsigned u = 0; u < 2; ++u)
+        {
+            Vector bm0 = Zero();
+            Vector bm1 = Zero();
+            for (size_t k = 0; k < numOutputs_; ++k)
+            {
+                bm0 = Adds8(bm0, Xor(q[k], Load(&expect8_[((0 * 2 + u) * numOutputs_ + k) * half + i])));
+                bm1 = Adds8(bm1, Xor(q[k], Load(&expect8_[((1 * 2 + u) * numOutputs_ + k) * half + i])));
+            }
+            Vector a0 = Adds8(even, bm0);
+            Vector a1 = Adds8(odd, bm1);
+            Vector m = Min8(a0, a1);
+            Store(newMetrics + u * half + i, m);
+            minimum = Min8(minimum, m);
+            PackedBits::InsertBits(decisions, u * half + i, Differ8(a0, m), lanes);
+        }
+    }
+    bias_ = HorizontalMin8(minimum);
+#else
+    (void)symbols;
+    (void)decisions;
+#endif
+}
+
+void ViterbiDecoder::StepSimd16(const unsigned* symbols, uint64_t* decisions)
+{
+#if defined(CODECS_HAS_SSE2)
+    const size_t lanes = VECTOR_BYTES / 2;
+    const size_t half = numStates_ / 2;
+    const int16_t* oldMetrics = &metrics16_[current_ * numStates_];
+    int16_t* newMetrics = &metrics16_[(1 - current_) * numStates_];
+    Vector q[3];
+    for (size_t b = 0; b < numOutputs_; ++b)
+    {
+        q[b] = Set16(static_cast<int>(symbols[b]));
+    }
+    Vector bias = Set16(static_cast<int>(bias_));
+    Vector minimum = Set16(0x7FFF);
+    for (size_t i = 0; i < half; i += lanes)
+    {
+        Vector a = Load(oldMetrics + 2 * i);
+        Vector b = Load(oldMetrics + 2 * i + lanes);
+        Vector even = Subs16(Evens16(a, b), bias);
+        Vector odd = Subs16(Odds16(a, b), bias);
+        for (unsigned u = 0; u < 2; ++u)
+        {
+            Vector bm0 = Zero();
+            Vector bm1 = Zero();
+            for (size_t k = 0; k < numOutputs_; ++k)
+            {
+                bm0 = Adds16(bm0, Xor(q[k], Load(&expect16_[((0 * 2 + u) * numOutputs_ + k) * half + i])));
+                bm1 = Adds16(bm1, Xor(q[k], Load(&expect16_[((1 * 2 + u) * numOutputs_ + k) * half + i])));
+            }
+            Vector a0 = Adds16(even, bm0);
+            Vector a1 = Adds16(odd, bm1);
+            Vector m = Min16(a0, a1);
+            Store(newMetrics + u * half + i, m);
+            minimum = Min16(minimum, m);
+            PackedBits::InsertBits(decisions, u * half + i, Differ16(a0, m), lanes);
+        }
+    }
+    bias_ = HorizontalMin16(minimum);
+#else
+    (void)symbols;
+    (void)decisions;
+#endif
+}
+
+void ViterbiDecoder::Step(const uint8_t* symbols)
+{
+    size_t capacity = tracebackDepth_ + blockLength_;
+    uint64_t* decisions = &decisions_[((first_ + numStored_) % capacity) * wordsPerStep_];
+    std::fill(decisions, decisions + wordsPerStep_, 0);
+    unsigned q[3];
+    for (size_t b = 0; b < numOutputs_; ++b)
+    {
+        q[b] = width_ == MW_8_BIT ? symbols[b] >> 5 : symbols[b];
+    }
+    if (simd_)
+    {
+        if (width_ == MW_8_BIT)
+        {
+            StepSimd8(q, decisions);
+        }
+        else
+        {
+            StepSimd16(q, decisions);
+        }
+    }
+    else if (width_ == MW_8_BIT)
+    {
+        StepScalar<uint8_t, 7>(q, &metrics8_[current_ * numStates_], &metrics8_[(1 - current_) * numStates_], decisions);
+    }
+    else
+    {
+        StepScalar<int16_t, 255>(q, &metrics16_[current_ * numStates_], &metrics16_[(1 - current_) * numStates_], decisions);
+    }
+    current_ = 1 - current_;
+    ++numStored_;
+}
+
+size_t ViterbiDecoder::FindBestState(void) const
+{
+    size_t best = 0;
+    for (size_t s = 1; s < numStates_; ++s)
+    {
+        bool better = width_ == MW_8_BIT ? metrics8_[current_ * numStates_ + s] < metrics8_[current_ * numStates_ + best]
+                                         : metrics16_[current_ * numStates_ + s] < metrics16_[current_ * numStates_ + best];
+        if (better)
+        {
+            best = s;
+        }
+    }
+    return best;
+}
+
+void ViterbiDecoder::Traceback(size_t state, size_t numSkipped, size_t numOutput, std::vector<bool>& output)
+{
+    size_t capacity = tracebackDepth_ + blockLength_;
+    size_t half = numStates_ / 2;
+    size_t base = output.size();
+    output.resize(base + numOutput, false);
+    size_t step = numStored_;
+    while (step > numStored_ - numSkipped - numOutput)
+    {
+        --step;
+        if (step < numStored_ - numSkipped)
+        {
+            // The input bit is the most recent bit of the state.
+            output[base + step - (numStored_ - numSkipped - numOutput)] = state >= half;
+        }
+        const uint64_t* decisions = &decisions_[((first_ + step) % capacity) * wordsPerStep_];
+        state = 2 * (state % half) + (PackedBits::GetBit(decisions, state) ? 1 : 0);
+    }
+}
+
+void ViterbiDecoder::Push(const uint8_t* symbols, size_t numSteps, std::vector<bool>& output)
+{
+    size_t capacity = tracebackDepth_ + blockLength_;
+    for (size_t t = 0; t < numSteps; ++t)
+    {
+        Step(symbols + t * numOutputs_);
+        if (numStored_ == capacity)
+        {
+            Traceback(FindBestState(), tracebackDepth_, blockLength_, output);
+            first_ = (first_ + blockLength_) % capacity;
+            numStored_ -= blockLength_;
+        }
+    }
+}
+
+void ViterbiDecoder::Finish(bool terminated, std::vector<bool>& output)
+{
+    size_t tail = codecs_.GetConstraintLength() - 1;
+    if (terminated)
+    {
+        size_t numSkipped = std::min(tail, numStored_);
+        Traceback(0, numSkipped, numStored_ - numSkipped, output);
+    }
+    else
+    {
+        Traceback(FindBestState(), 0, numStored_, output);
+    }
+    Reset();
+}
+
+void ConvolutionalCodecs::Test(void)
+{
+    // Encode: K = 3, (7, 5).
+    std::vector<std::vector<bool> > g3;
+    g3.push_back(DataIo::FromString("111"));
+    g3.push_back(DataIo::FromString("101"));
+    ConvolutionalCodecs cc3(g3);
+    assert(cc3.Encode(DataIo::FromString("1011")) == DataIo::FromString("11 10 00 01 01 11"));
+    assert(cc3.Decode(DataIo::FromString("11 10 00 01 01 11")) == DataIo::FromString("1011"));
+    assert(cc3.Decode(DataIo::FromString("11 10 10 01 01 11")) == DataIo::FromString("1011"));
+
+    // Decode with scattered errors: K = 7 rate 1/2 (171, 133) and K = 9 rate 1/3 (557, 663, 711),
+    // with both metric widths.
+    std::vector<std::vector<bool> > g7;
+    g7.push_back(DataIo::FromString("1111001"));
+    g7.push_back(DataIo::FromString("1011011"));
+    std::vector<std::vector<bool> > g9;
+    g9.push_back(DataIo::FromString("101101111"));
+    g9.push_back(DataIo::FromString("110110011"));
+    g9.push_back(DataIo::FromString("111001001"));
+    const std::vector<std::vector<bool> >* generators[] = { &g3, &g7, &g9 };
+    uint64_t x = 0xA4093822299F31D0ULL;
+    for (size_t c = 0; c < 3; ++c)
+    {
+        ConvolutionalCodecs cc(*generators[c]);
+        std::vector<bool> message(1500, false);
+        for (size_t i = 0; i < message.size(); ++i)
+        {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            message[i] = x & 1;
+        }
+        std::vector<bool> code = cc.Encode(message);
+        assert(code.size() == (message.size() + cc.GetConstraintLength() - 1) * cc.GetNumberOfOutputs());
+        for (size_t i = 5; i < code.size(); i += 23)
+        {
+            code[i] = !code[i];
+        }
+        assert(cc.Decode(code) == message);
+
+        // Soft symbols fed in odd pieces, with a short traceback window.
+        std::vector<uint8_t> symbols(code.size(), 0);
+        for (size_t i = 0; i < code.size(); ++i)
+        {
+            symbols[i] = code[i] ? 200 : 40;
+        }
+        for (unsigned w = 0; w < 2; ++w)
+        {
+            ViterbiDecoder decoder(cc, w ? ViterbiDecoder::MW_16_BIT : ViterbiDecoder::MW_8_BIT, 0, 100);
+            std::vector<bool> decoded;
+            size_t numSteps = code.size() / cc.GetNumberOfOutputs();
+            for (size_t t = 0; t < numSteps; t += 37)
+            {
+                decoder.Push(&symbols[t * cc.GetNumberOfOutputs()], std::min<size_t>(37, numSteps - t), decoded);
+            }
+            decoder.Finish(true, decoded);
+            assert(decoded == message);
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Rate 1/n convolutional code (n = 2 or 3), constraint length K <= 9.
+ *
+ * Each generator is a bit string of K bits in the format parsed by
+ * DataIo::FromString(); its first bit taps the current input bit, its last
+ * bit the input bit K - 1 steps earlier.  For each input bit, one output
+ * bit per generator is emitted, in the order of the generators.
+ *
+ * The trellis state holds the last K - 1 input bits, the most recent one
+ * being the most significant bit, so the predecessors of states i and
+ * i + 2^(K-2) are states 2i and 2i + 1.
+ */
+class ConvolutionalCodecs
+{
+public:
+    /**
+     * @param [in] generators   2 or 3 generators of the same length K, 2 <= K <= 9.
+     */
+    explicit ConvolutionalCodecs(const std::vector<std::vector<bool> >& generators);
+
+    size_t GetConstraintLength(void) const;
+    size_t GetNumberOfOutputs(void) const;
+    size_t GetNumberOfStates(void) const;
+
+    /**
+     * @return The n output bits of the transition from \c state on \c input,
+     *         the output of the first generator being bit 0.
+     */
+    unsigned GetOutput(size_t state, bool input) const;
+
+    /**
+     * Encode a packed bit sequence, continuing from \c state.
+     * @param [in]  input     numBits packed bits.
+     * @param [in]  numBits   the number of input bits.
+     * @param [in]  state     the encoder state before the first bit; 0 at start.
+     * @param [out] output    numBits * n packed bits.
+     * @return The encoder state after the last bit.
+     */
+    size_t Encode(const uint64_t* input, size_t numBits, size_t state, uint64_t* output) const;
+
+    /**
+     * Encode a message and terminate the trellis with K - 1 zero bits.
+     */
+    std::vector<bool> Encode(const std::vector<bool>& message) const;
+
+    /**
+     * Hard-decision decoding of a terminated code sequence.
+     */
+    std::vector<bool> Decode(const std::vector<bool>& code) const;
+
+    static void Test(void);
+
+private:
+    size_t k_;
+    std::vector<unsigned> generators_;  ///< tap masks, the current bit being bit K - 1.
+    std::vector<unsigned> outputs_;     ///< outputs_[2 * state + input]
+};
+
+/**
+ * Streaming Viterbi decoder for a \c ConvolutionalCodecs.
+ *
+ * Each trellis step takes n soft symbols from 0 (a certain 0) to 255
+ * (a certain 1).  The add-compare-select of all states of a step is
+ * vectorized across states with saturating 8-bit (symbols quantized to
+ * 3 bits) or 16-bit metrics, using SSE2 or AVX2; small trellises and
+ * builds without SIMD use the same algorithm in scalar code.
+ *
+ * Decisions are kept for at most tracebackDepth + blockLength steps.
+ * Whenever that many are stored, a single traceback emits the oldest
+ * blockLength bits, so memory stays bounded on endless streams.
+ */
+class ViterbiDecoder
+{
+public:
+    enum MetricWidth
+    {
+        MW_8_BIT,
+        MW_16_BIT,
+    };
+
+    /**
+     * @param [in] codecs           the code; it must outlive the decoder.
+     * @param [in] width            the width of path metrics.
+     * @param [in] tracebackDepth   steps traced back before bits are decided, 0 for 8K.
+     * @param [in] blockLength      bits decided per traceback, 0 for 256.
+     */
+    ViterbiDecoder(const ConvolutionalCodecs& codecs, MetricWidth width = MW_16_BIT,
+                   size_t tracebackDepth = 0, size_t blockLength = 0);
+
+    /**
+     * Restart from state 0.
+     */
+    void Reset(void);
+
+    /**
+     * @param [in]  symbols    numSteps * n soft symbols.
+     * @param [in]  numSteps   the number of trellis steps.
+     * @param [out] output     decided bits are appended.
+     */
+    void Push(const uint8_t* symbols, size_t numSteps, std::vector<bool>& output);
+
+    /**
+     * Decide all pending bits.
+     * @param [in]  terminated   true if the sequence ends with K - 1 zero tail bits,
+     *                           which are then traced from state 0 and not output.
+     * @param [out] output       decided bits are appended.
+     */
+    void Finish(bool terminated, std::vector<bool>& output);
+
+private:
+    void Step(const uint8_t* symbols);
+    template <typename Metric, unsigned MAX_SYMBOL>
+    void StepScalar(const unsigned* symbols, Metric* oldMetrics, Metric* newMetrics, uint64_t* decisions);
+    void StepSimd8(const unsigned* symbols, uint64_t* decisions);
+    void StepSimd16(const unsigned* symbols, uint64_t* decisions);
+
+    size_t FindBestState(void) const;
+    void Traceback(size_t state, size_t numSkipped, size_t numOutput, std::vector<bool>& output);
+
+private:
+    const ConvolutionalCodecs& codecs_;
+    MetricWidth width_;
+    size_t tracebackDepth_;
+    size_t blockLength_;
+    size_t numStates_;
+    size_t numOutputs_;
+    bool simd_;                         ///< whether the trellis is wide enough for vectors.
+    std::vector<uint8_t> expect8_;      ///< 0 or 7 per (predecessor parity, input, output, state pair).
+    std::vector<int16_t> expect16_;     ///< 0 or 255, same layout.
+    std::vector<uint8_t> metrics8_;     ///< 2 x numStates_, current and next.
+    std::vector<int16_t> metrics16_;    ///< 2 x numStates_, current and next.
+    size_t current_;                    ///< which half of the metrics is current.
+    unsigned bias_;                     ///< the minimum metric of the last step, subtracted next.
+    size_t wordsPerStep_;
+    std::vector<uint64_t> decisions_;   ///< ring of (tracebackDepth_ + blockLength_) steps.
+    size_t first_;                      ///< the ring index of the oldest stored step.
+    size_t numStored_;                  ///< the number of stored steps.
+};
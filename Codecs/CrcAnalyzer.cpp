@@ -0,0 +1,463 @@
+#include "CrcAnalyzer.h"
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <ostream>
+
+CrcAnalyzer::CrcAnalyzer(const std::vector<bool>& generator, size_t maxMessageBits, size_t maxWeight) :
+    maxMessageBits_(maxMessageBits),
+    maxWeight_(maxWeight)
+{
+    auto first = generator.begin();
+    while (first != generator.end() && !*first)
+    {
+        ++first;
+    }
+    generator_.assign(first, generator.end());
+    degree_ = generator_.empty() ? 0 : generator_.size() - 1;
+    assert(degree_ >= 1 && degree_ <= 64);
+    assert(generator_.back());
+    // remainders_[p] = x^p mod G; bit j is the coefficient of x^j.
+    const size_t numBits = maxMessageBits_ + degree_;
+    const uint64_t top = uint64_t(1) << (degree_ - 1);
+    uint64_t feedback = 0;
+    for (size_t j = 0; j < degree_; ++j)
+    {
+        feedback |= uint64_t(generator_[degree_ - j]) << j;
+    }
+    remainders_.resize(numBits);
+    uint64_t r = 1;
+    for (size_t p = 0; p < numBits; ++p)
+    {
+        remainders_[p] = r;
+        r = (r & top) ? ((r ^ top) << 1) ^ feedback : r << 1;
+    }
+    BuildIndex();
+    counts_.assign(maxWeight_ + 1, std::vector<uint64_t>(numBits, 0));
+}
+
+size_t CrcAnalyzer::GetDegree(void) const
+{
+    return degree_;
+}
+
+size_t CrcAnalyzer::GetMaximumMessageBits(void) const
+{
+    return maxMessageBits_;
+}
+
+size_t CrcAnalyzer::GetMaximumWeight(void) const
+{
+    return maxWeight_;
+}
+
+void CrcAnalyzer::BuildIndex(void)
+{
+    const size_t numBits = remainders_.size();
+    positions_.resize(numBits);
+    for (size_t p = 0; p < numBits; ++p)
+    {
+        positions_[p] = static_cast<uint32_t>(p);
+    }
+    std::sort(positions_.begin(), positions_.end(), [this](uint32_t a, uint32_t b)
+    {
+        return remainders_[a] < remainders_[b] || (remainders_[a] == remainders_[b] && a < b);
+    });
+    size_t numSlots = 2;
+    while (numSlots < 2 * numBits)
+    {
+        numSlots *= 2;
+    }
+    Slot empty = { 0, 0, 0 };
+    slots_.assign(numSlots, empty);
+    for (size_t i = 0; i < numBits; )
+    {
+        uint64_t remainder = remainders_[positions_[i]];
+        size_t j = i + 1;
+        while (j < numBits && remainders_[positions_[j]] == remainder)
+        {
+            ++j;
+        }
+        size_t s = (remainder * 0x9E3779B97F4A7C15ULL) & (numSlots - 1);
+        while (slots_[s].count)
+        {
+            s = (s + 1) & (numSlots - 1);
+        }
+        slots_[s].remainder = remainder;
+        slots_[s].first = static_cast<uint32_t>(i);
+        slots_[s].count = static_cast<uint32_t>(j - i);
+        i = j;
+    }
+}
+
+size_t CrcAnalyzer::CountPositions(uint64_t target, size_t first, size_t last) const
+{
+    const size_t mask = slots_.size() - 1;
+    for (size_t s = (target * 0x9E3779B97F4A7C15ULL) & mask; slots_[s].count; s = (s + 1) & mask)
+    {
+        if (slots_[s].remainder == target)
+        {
+            const uint32_t* begin = &positions_[slots_[s].first];
+            const uint32_t* end = begin + slots_[s].count;
+            return std::lower_bound(begin, end, static_cast<uint32_t>(last))
+                 - std::lower_bound(begin, end, static_cast<uint32_t>(first));
+        }
+    }
+    return 0;
+}
+
+uint64_t CrcAnalyzer::CountPatterns(uint64_t target, size_t below, size_t numPositions) const
+{
+    if (numPositions == 1)
+    {
+        return CountPositions(target, 1, below);
+    }
+    // The highest of the positions leaves numPositions - 1 below it.
+    uint64_t count = 0;
+    for (size_t p = numPositions; p < below; ++p)
+    {
+        count += CountPatterns(target ^ remainders_[p], p, numPositions - 1);
+    }
+    return count;
+}
+
+void CrcAnalyzer::Search(size_t weight, size_t firstSpan, size_t lastSpan)
+{
+    // Patterns {0, ..., s}: x^0 = 1 and x^s mod G leave weight - 2 positions to pick.
+    std::vector<uint64_t>& counts = counts_[weight];
+    for (size_t s = firstSpan; s < lastSpan; ++s)
+    {
+        uint64_t target = 1 ^ remainders_[s];
+        counts[s] = weight == 2 ? (target == 0) : CountPatterns(target, s, weight - 2);
+    }
+}
+
+void CrcAnalyzer::SubmitSearch(ThreadPool& pool, size_t weight, size_t firstSpan, size_t lastSpan)
+{
+    pool.Submit([this, &pool, weight, firstSpan, lastSpan](void)
+    {
+        // Long spans cost more; halving on the worker lets idle ones steal the rest.
+        const size_t grain = weight > 3 ? 16 : 4096;
+        size_t last = lastSpan;
+        while (last - firstSpan > grain)
+        {
+            size_t middle = firstSpan + (last - firstSpan) / 2;
+            SubmitSearch(pool, weight, middle, last);
+            last = middle;
+        }
+        Search(weight, firstSpan, last);
+    });
+}
+
+void CrcAnalyzer::Run(ThreadPool& pool)
+{
+    for (size_t w = 2; w <= maxWeight_; ++w)
+    {
+        if (w - 1 < remainders_.size())
+        {
+            SubmitSearch(pool, w, w - 1, remainders_.size());
+        }
+    }
+    pool.Wait();
+}
+
+uint64_t CrcAnalyzer::GetCount(size_t weight, size_t numMessageBits) const
+{
+    assert(weight <= maxWeight_ && numMessageBits <= maxMessageBits_);
+    if (weight < 2)
+    {
+        return 0;
+    }
+    const size_t numBits = numMessageBits + degree_;
+    const std::vector<uint64_t>& counts = counts_[weight];
+    uint64_t count = 0;
+    for (size_t s = weight - 1; s < numBits; ++s)
+    {
+        count += counts[s] * (numBits - s);
+    }
+    return count;
+}
+
+size_t CrcAnalyzer::GetMinimumDistance(size_t numMessageBits) const
+{
+    for (size_t w = 2; w <= maxWeight_; ++w)
+    {
+        if (GetCount(w, numMessageBits))
+        {
+            return w;
+        }
+    }
+    return maxWeight_ + 1;
+}
+
+size_t CrcAnalyzer::GetLongestMessage(size_t distance) const
+{
+    assert(distance <= maxWeight_ + 1);
+    // A pattern of span s fits code words of s + 1 bits or more.
+    size_t numBits = remainders_.size();
+    for (size_t w = 2; w < distance; ++w)
+    {
+        const std::vector<uint64_t>& counts = counts_[w];
+        for (size_t s = w - 1; s < numBits; ++s)
+        {
+            if (counts[s])
+            {
+                numBits = s;
+                break;
+            }
+        }
+    }
+    return numBits - degree_;
+}
+
+void CrcAnalyzer::Write(std::ostream& os, const std::vector<size_t>& messageLengths) const
+{
+    os << "# message bits, minimum distance, undetectable patterns of weight 2.." << maxWeight_ << std::endl;
+    for (size_t i = 0; i < messageLengths.size(); ++i)
+    {
+        os << messageLengths[i] << " " << GetMinimumDistance(messageLengths[i]);
+        for (size_t w = 2; w <= maxWeight_; ++w)
+        {
+            os << " " << GetCount(w, messageLengths[i]);
+        }
+        os << std::endl;
+    }
+}
+
+namespace
+{
+    /**
+     * @return The generator of \c degree whose coefficient of x^j is bit j of \c value.
+     */
+    std::vector<bool> ToGenerator(uint64_t value, size_t degree)
+    {
+        std::vector<bool> generator(degree + 1, false);
+        for (size_t j = 0; j <= degree; ++j)
+        {
+            generator[degree - j] = (value >> j) & 1;
+        }
+        return generator;
+    }
+
+    uint64_t Reverse(uint64_t value, size_t numBits)
+    {
+        uint64_t reversed = 0;
+        for (size_t j = 0; j < numBits; ++j)
+        {
+            reversed |= ((value >> j) & 1) << (numBits - 1 - j);
+        }
+        return reversed;
+    }
+
+    /// The generators analyzed by a task of Sweep().
+    const uint64_t SWEEP_GRAIN = 1 << 12;
+
+    /**
+     * Run \c body(first, end) on ranges of at most \c grain in [first, last),
+     * halving the range on the workers; \c body is referenced by the tasks,
+     * so it must outlive the pool's Wait().
+     */
+    template <typename Body>
+    void SubmitRange(ThreadPool& pool, uint64_t first, uint64_t last, uint64_t grain, const Body& body)
+    {
+        pool.Submit([&pool, first, last, grain, &body](void)
+        {
+            uint64_t end = last;
+            while (end - first > grain)
+            {
+                uint64_t middle = first + (end - first) / 2;
+                SubmitRange(pool, middle, end, grain, body);
+                end = middle;
+            }
+            body(first, end);
+        });
+    }
+
+    /**
+     * @return Whether \c a ranks before \c b in the results of Sweep().
+     */
+    bool IsBetter(const CrcAnalyzer::Candidate& a, const CrcAnalyzer::Candidate& b)
+    {
+        if (a.distance != b.distance)
+        {
+            return a.distance > b.distance;
+        }
+        if (a.count != b.count)
+        {
+            return a.count < b.count;
+        }
+        return a.generator < b.generator;
+    }
+
+    /**
+     * Add \c candidate to \c best, a heap of at most \c numBest candidates with the worst in front.
+     */
+    void Keep(std::vector<CrcAnalyzer::Candidate>& best, CrcAnalyzer::Candidate& candidate, size_t numBest)
+    {
+        if (best.size() == numBest && !IsBetter(candidate, best.front()))
+        {
+            return;
+        }
+        best.push_back(std::move(candidate));
+        std::push_heap(best.begin(), best.end(), IsBetter);
+        if (best.size() > numBest)
+        {
+            std::pop_heap(best.begin(), best.end(), IsBetter);
+            best.pop_back();
+        }
+    }
+}
+
+std::vector<CrcAnalyzer::Candidate> CrcAnalyzer::Sweep(size_t degree, size_t numMessageBits, size_t maxWeight,
+                                                       ThreadPool& pool, size_t numBest)
+{
+    assert(degree >= 1 && degree <= MAX_SWEEP_DEGREE);
+    // x^degree and 1 are fixed; the other coefficients run through all values.
+    const uint64_t numGenerators = uint64_t(1) << (degree - 1);
+    // The best candidates found by each worker, and by the caller if it is not one.
+    std::vector<std::vector<Candidate>> best(pool.GetNumberOfThreads() + 1);
+    auto evaluate = [&best, &pool, degree, numMessageBits, maxWeight, numBest](uint64_t first, uint64_t last)
+    {
+        std::vector<Candidate>& kept = best[pool.GetWorkerIndex()];
+        for (uint64_t i = first; i < last; ++i)
+        {
+            uint64_t value = (uint64_t(1) << degree) | (i << 1) | 1;
+            if (Reverse(value, degree + 1) < value)
+            {
+                continue;
+            }
+            // Lighter weights are cheaper: stop at the first undetectable one.
+            CrcAnalyzer analyzer(ToGenerator(value, degree), numMessageBits, maxWeight);
+            Candidate candidate;
+            candidate.generator = analyzer.generator_;
+            candidate.distance = maxWeight + 1;
+            candidate.count = 0;
+            for (size_t w = 2; w <= maxWeight; ++w)
+            {
+                analyzer.Search(w, w - 1, analyzer.remainders_.size());
+                uint64_t count = analyzer.GetCount(w, numMessageBits);
+                if (count)
+                {
+                    candidate.distance = w;
+                    candidate.count = count;
+                    break;
+                }
+            }
+            Keep(kept, candidate, numBest);
+        }
+    };
+    if (numBest)
+    {
+        SubmitRange(pool, 0, numGenerators, SWEEP_GRAIN, evaluate);
+        pool.Wait();
+    }
+    std::vector<Candidate> candidates;
+    for (size_t w = 0; w < best.size(); ++w)
+    {
+        std::move(best[w].begin(), best[w].end(), std::back_inserter(candidates));
+    }
+    std::sort(candidates.begin(), candidates.end(), IsBetter);
+    if (candidates.size() > numBest)
+    {
+        candidates.resize(numBest);
+    }
+    return candidates;
+}
+
+#include "DataIo.h"
+#include "PackedBits.h"
+#include "PolynomialDivider.h"
+void CrcAnalyzer::Test(void)
+{
+    ThreadPool pool(3);
+
+    // Against every pattern of up to 14 bits, checked by PolynomialDivider.
+    const char* generators[] = { "1011", "11101", "100101", "1 0000 0111" };
+    for (size_t g = 0; g < sizeof (generators) / sizeof (generators[0]); ++g)
+    {
+        std::vector<bool> generator = DataIo::FromString(generators[g]);
+        const size_t degree = generator.size() - 1;
+        const size_t numBits = 14;
+        CrcAnalyzer analyzer(generator, numBits - degree, 5);
+        analyzer.Run(pool);
+        // expected[w][n]: the undetectable patterns of weight w within the low n bits.
+        std::vector<std::vector<uint64_t>> expected(6, std::vector<uint64_t>(numBits + 1, 0));
+        for (uint32_t e = 1; e < (1u << numBits); ++e)
+        {
+            size_t weight = PackedBits::PopCount(e);
+            if (weight > 5)
+            {
+                continue;
+            }
+            std::vector<bool> dividend(numBits, false);
+            size_t high = 0;
+            for (size_t p = 0; p < numBits; ++p)
+            {
+                dividend[numBits - 1 - p] = (e >> p) & 1;
+                high = (e >> p) & 1 ? p : high;
+            }
+            std::vector<bool> quotient;
+            std::vector<bool> remainder;
+            PolynomialDivider::Divide(dividend, generator, quotient, remainder);
+            if (DataIo::IsZero(remainder))
+            {
+                for (size_t n = high + 1; n <= numBits; ++n)
+                {
+                    ++expected[weight][n];
+                }
+            }
+        }
+        for (size_t k = 0; k + degree <= numBits; ++k)
+        {
+            for (size_t w = 0; w <= 5; ++w)
+            {
+                assert(analyzer.GetCount(w, k) == expected[w][k + degree]);
+            }
+        }
+    }
+
+    // x^3 + x + 1 is the Hamming (7, 4) code.
+    CrcAnalyzer hamming(DataIo::FromString("1011"), 20, 4);
+    hamming.Run(pool);
+    assert(hamming.GetMinimumDistance(4) == 3);
+    assert(hamming.GetCount(3, 4) == 7);
+    assert(hamming.GetMinimumDistance(5) == 2);
+    assert(hamming.GetLongestMessage(3) == 4);
+    assert(hamming.GetLongestMessage(2) == 20);
+
+    // CRC-8 (0x07) keeps a distance of 4 up to 119 message bits, the same on any number of threads.
+    std::vector<bool> crc8 = DataIo::FromString("1 0000 0111");
+    CrcAnalyzer a(crc8, 200, 4);
+    a.Run(pool);
+    assert(a.GetLongestMessage(4) == 119);
+    assert(a.GetMinimumDistance(119) == 4 && a.GetMinimumDistance(120) == 2);
+    ThreadPool one(1);
+    CrcAnalyzer b(crc8, 200, 4);
+    b.Run(one);
+    for (size_t k = 0; k <= 200; k += 7)
+    {
+        assert(a.GetCount(4, k) == b.GetCount(4, k));
+    }
+
+    // The best generators of degree 4: x^4 + x + 1 (or its reciprocal) for
+    // 11 message bits, and (x + 1)(x^3 + x^2 + 1) for 3.
+    std::vector<Candidate> best = Sweep(4, 11, 4, pool, 3);
+    assert(best[0].generator == DataIo::FromString("10011"));
+    assert(best[0].distance == 3 && best[0].count == 35);
+    assert(best[1].distance < 3 || best[1].count > 35);
+    best = Sweep(4, 3, 5, pool);
+    assert(best.size() == 1);
+    assert(best[0].generator == DataIo::FromString("10111"));
+    assert(best[0].distance == 4 && best[0].count == 7);
+
+    // Several tasks keep their best apart; the merge agrees with keeping everything.
+    std::vector<Candidate> all = Sweep(14, 20, 3, pool, 1 << 13);
+    best = Sweep(14, 20, 3, pool, 5);
+    assert(best.size() == 5 && all.size() > 5);
+    for (size_t i = 0; i < best.size(); ++i)
+    {
+        assert(best[i].generator == all[i].generator && best[i].count == all[i].count);
+    }
+    assert(Sweep(3, 4, 3, pool, 0).empty());
+    (void)all;
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/**
+ * The error detection performance of a CRC generator.
+ *
+ * An error pattern goes undetected if and only if the generator divides it,
+ * i.e. if the remainders x^p mod G of its bit positions p add up to zero.
+ * The generator must have a constant term, so shifting a pattern keeps it
+ * undetectable: the analyzer counts the patterns that start at position 0
+ * by their span, once for all lengths, and a pattern of span s then occurs
+ * at n - s positions of an n-bit code word.
+ *
+ * The search fixes the highest positions of a pattern and finds the last
+ * one by its remainder in an index of all positions, so a weight w takes
+ * about N^(w-2) lookups for code words of up to N bits.  The spans are
+ * searched in parallel; the cost grows with the span, so the work is split
+ * on the fly and balanced by the work stealing of ThreadPool.
+ */
+class CrcAnalyzer
+{
+public:
+    static const size_t DEFAULT_MAX_WEIGHT = 4;
+
+    /// The highest degree Sweep() accepts: 2^23 generators, about 2^22 of them analyzed.
+    static const size_t MAX_SWEEP_DEGREE = 24;
+
+    /**
+     * A generator found by Sweep().
+     */
+    struct Candidate
+    {
+        std::vector<bool> generator;    ///< big-endian, as DataIo.
+        size_t distance;                ///< the minimum distance, or maxWeight + 1 if larger.
+        uint64_t count;                 ///< undetectable patterns of that weight, 0 if larger than maxWeight.
+    };
+
+    /**
+     * @param [in] generator        big-endian, of degree 1 to 64, with a constant term.
+     * @param [in] maxMessageBits   the longest message to analyze.
+     * @param [in] maxWeight        the heaviest error patterns to count.
+     */
+    CrcAnalyzer(const std::vector<bool>& generator, size_t maxMessageBits, size_t maxWeight = DEFAULT_MAX_WEIGHT);
+
+    size_t GetDegree(void) const;
+    size_t GetMaximumMessageBits(void) const;
+    size_t GetMaximumWeight(void) const;
+
+    /**
+     * Count the undetectable patterns of every weight up to the maximum.
+     */
+    void Run(ThreadPool& pool);
+
+    /**
+     * @return The number of undetectable error patterns of \c weight bits in
+     * a code word of \c numMessageBits message bits and the CRC.
+     */
+    uint64_t GetCount(size_t weight, size_t numMessageBits) const;
+
+    /**
+     * @return The minimum Hamming distance of the code words of \c numMessageBits
+     * message bits, or GetMaximumWeight() + 1 if no lighter pattern is undetectable.
+     */
+    size_t GetMinimumDistance(size_t numMessageBits) const;
+
+    /**
+     * @return The longest message whose code words have a minimum distance of
+     * at least \c distance (<= GetMaximumWeight() + 1), up to GetMaximumMessageBits().
+     */
+    size_t GetLongestMessage(size_t distance) const;
+
+    /**
+     * Write a line per message length: the length, the minimum distance and
+     * the number of undetectable patterns of each weight.
+     */
+    void Write(std::ostream& os, const std::vector<size_t>& messageLengths) const;
+
+    /**
+     * Analyze every generator of \c degree with a constant term for messages
+     * of \c numMessageBits bits, the longest frame to protect.  A generator
+     * and its reciprocal detect the same patterns, so only the smaller one is
+     * analyzed.  Each task covers a range of generators and keeps only its
+     * worker's \c numBest best, so memory does not grow with the degree.
+     * @param [in] degree   1 to MAX_SWEEP_DEGREE.
+     * @return The \c numBest generators, best first: the largest distance,
+     * then the fewest undetectable patterns of that weight, then the smallest
+     * generator.
+     */
+    static std::vector<Candidate> Sweep(size_t degree, size_t numMessageBits, size_t maxWeight,
+                                        ThreadPool& pool, size_t numBest = 1);
+
+    static void Test(void);
+
+private:
+    /**
+     * Count the anchored patterns of \c weight bits whose span is in [firstSpan, lastSpan).
+     */
+    void Search(size_t weight, size_t firstSpan, size_t lastSpan);
+
+    /**
+     * Split the spans of \c weight into tasks of about equal cost.
+     */
+    void SubmitSearch(ThreadPool& pool, size_t weight, size_t firstSpan, size_t lastSpan);
+
+    /**
+     * @return The ways to pick \c numPositions positions in (0, below) whose remainders add up to \c target.
+     */
+    uint64_t CountPatterns(uint64_t target, size_t below, size_t numPositions) const;
+
+    /**
+     * @return The positions in [first, last) whose remainder is \c target.
+     */
+    size_t CountPositions(uint64_t target, size_t first, size_t last) const;
+
+    void BuildIndex(void);
+
+private:
+    /**
+     * The positions of a remainder, a run of positions_.
+     */
+    struct Slot
+    {
+        uint64_t remainder;
+        uint32_t first;
+        uint32_t count;     ///< 0 for an empty slot.
+    };
+
+    std::vector<bool> generator_;
+    size_t degree_;
+    size_t maxMessageBits_;
+    size_t maxWeight_;
+    std::vector<uint64_t> remainders_;              ///< x^p mod G, for p < maxMessageBits + degree.
+    std::vector<uint32_t> positions_;               ///< sorted by remainder, then position.
+    std::vector<Slot> slots_;                       ///< a hash table of the remainders.
+    std::vector<std::vector<uint64_t>> counts_;     ///< [weight][span] anchored patterns.
+};
@@ -0,0 +1,185 @@
+#include "CrcCorrector.h"
+#include "PackedBits.h"
+#include <cassert>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace
+{
+    size_t Hash(uint64_t remainder, size_t mask)
+    {
+        return static_cast<size_t>((remainder * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    }
+}
+
+CrcCorrector::CrcCorrector(const std::vector<bool>& generator, size_t numMessageBits) :
+    divider_(generator),
+    numBits_(numMessageBits + divider_.GetDegree()),
+    correctable_(true)
+{
+    assert(divider_.GetDegree() >= 1 && divider_.GetDegree() <= 64);
+    size_t numSlots = 2;
+    while (numSlots < 2 * numBits_)
+    {
+        numSlots *= 2;
+    }
+    Slot empty = { 0, NOT_FOUND, false };
+    slots_.assign(numSlots, empty);
+    // The last bit leaves x^r mod G, each bit before it x times the one after.
+    const uint8_t one = 1;
+    uint64_t reg = 0;
+    divider_.Update(&reg, &one, 1);
+    for (size_t i = numBits_; i-- > 0; divider_.MultiplyByPowerOfX(&reg, 1))
+    {
+        size_t s = Hash(reg, numSlots - 1);
+        while (slots_[s].used && slots_[s].remainder != reg)
+        {
+            s = (s + 1) & (numSlots - 1);
+        }
+        if (slots_[s].used)
+        {
+            slots_[s].position = NOT_FOUND;
+            correctable_ = false;
+            continue;
+        }
+        slots_[s].remainder = reg;
+        slots_[s].position = i;
+        slots_[s].used = true;
+    }
+}
+
+std::shared_ptr<const CrcCorrector> CrcCorrector::Get(const std::vector<bool>& generator, size_t numMessageBits)
+{
+    static std::mutex mutex;
+    static std::map<std::pair<std::vector<bool>, size_t>, std::shared_ptr<const CrcCorrector>> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<const CrcCorrector>& corrector = cache[std::make_pair(generator, numMessageBits)];
+    if (!corrector)
+    {
+        corrector.reset(new CrcCorrector(generator, numMessageBits));
+    }
+    return corrector;
+}
+
+const LfsrDivider& CrcCorrector::GetDivider(void) const
+{
+    return divider_;
+}
+
+size_t CrcCorrector::GetFrameLength(void) const
+{
+    return numBits_;
+}
+
+bool CrcCorrector::IsCorrectable(void) const
+{
+    return correctable_;
+}
+
+size_t CrcCorrector::Locate(uint64_t remainder) const
+{
+    const size_t mask = slots_.size() - 1;
+    for (size_t s = Hash(remainder, mask); slots_[s].used; s = (s + 1) & mask)
+    {
+        if (slots_[s].remainder == remainder)
+        {
+            return slots_[s].position;
+        }
+    }
+    return NOT_FOUND;
+}
+
+CrcCorrector::CheckResult CrcCorrector::Correct(uint64_t* frame, size_t& position) const
+{
+    uint64_t reg = 0;
+    divider_.Update(&reg, frame, numBits_);
+    position = NOT_FOUND;
+    if (!reg)
+    {
+        return CR_NO_ERROR;
+    }
+    position = Locate(reg);
+    if (position == NOT_FOUND)
+    {
+        return CR_UNCORRECTABLE;
+    }
+    PackedBits::FlipBit(frame, position);
+    return CR_CORRECTED;
+}
+
+CrcCorrector::CheckResult CrcCorrector::Correct(std::vector<bool>& frame, size_t& position) const
+{
+    assert(frame.size() == numBits_);
+    std::vector<uint64_t> words = PackedBits::FromVector(frame);
+    CheckResult result = Correct(&words[0], position);
+    if (result == CR_CORRECTED)
+    {
+        frame[position] = !frame[position];
+    }
+    return result;
+}
+
+#include "DataIo.h"
+#include "PolynomialDivider.h"
+void CrcCorrector::Test(void)
+{
+    // CRC-8 (0x07) has period 127: frames of 64 + 8 bits are correctable.
+    std::vector<bool> crc8 = DataIo::FromString("1 0000 0111");
+    CrcCorrector corrector(crc8, 64);
+    assert(corrector.GetFrameLength() == 72 && corrector.IsCorrectable());
+    std::vector<bool> message(64, false);
+    for (size_t i = 0; i < message.size(); ++i)
+    {
+        message[i] = (i * 7 + i / 5) % 3 == 0;
+    }
+    std::vector<bool> frame = message;
+    std::vector<bool> crc = corrector.GetDivider().Remainder(message);
+    frame.insert(frame.end(), crc.begin(), crc.end());
+    size_t position = 0;
+    std::vector<bool> received = frame;
+    CheckResult result = CR_NO_ERROR;
+    result = corrector.Correct(received, position);
+    assert(result == CR_NO_ERROR && position == NOT_FOUND);
+    for (size_t i = 0; i < frame.size(); ++i)
+    {
+        received = frame;
+        received[i] = !received[i];
+        // The check agrees with PolynomialDivider on the received frame.
+        std::vector<bool> quotient;
+        std::vector<bool> remainder;
+        PolynomialDivider::Divide(received, crc8, quotient, remainder);
+        assert(!DataIo::IsZero(remainder));
+        result = corrector.Correct(received, position);
+        assert(result == CR_CORRECTED);
+        assert(position == i && received == frame);
+    }
+
+    // A double error is not taken for a single one at a distance of 4.
+    received = frame;
+    received[3] = !received[3];
+    received[40] = !received[40];
+    result = corrector.Correct(received, position);
+    assert(result == CR_UNCORRECTABLE);
+
+    // x^3 + x + 1 has period 7: bits 7 apart share their remainder.
+    CrcCorrector hamming(DataIo::FromString("1011"), 5);
+    assert(!hamming.IsCorrectable());
+    CrcCorrector short74(DataIo::FromString("1011"), 4);
+    assert(short74.IsCorrectable());
+    // 1000 101 is (x^3 + x + 1)^2.
+    uint64_t packed = 0;
+    PackedBits::FlipBit(&packed, 0);
+    PackedBits::FlipBit(&packed, 4);
+    PackedBits::FlipBit(&packed, 6);
+    result = short74.Correct(&packed, position);
+    assert(result == CR_NO_ERROR);
+    PackedBits::FlipBit(&packed, 2);
+    result = short74.Correct(&packed, position);
+    assert(result == CR_CORRECTED && position == 2);
+
+    // Shared instances per generator and length.
+    assert(Get(crc8, 64) == Get(crc8, 64));
+    assert(Get(crc8, 64) != Get(crc8, 65));
+    (void)result;
+}
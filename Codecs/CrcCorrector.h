@@ -0,0 +1,89 @@
+#pragma once
+#include "LfsrDivider.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Correction of single-bit errors in frames protected by a CRC.
+ *
+ * A frame is a message followed by its CRC (see LfsrDivider).  An error
+ * at bit i of an n-bit frame leaves the remainder x^(n - 1 - i + r) mod G
+ * after the check, so if these remainders are distinct the remainder
+ * locates the error.  A table from remainder to position, 2n slots of
+ * open addressing, is built once per generator and frame length, and a
+ * correction then costs a lookup after the check.
+ *
+ * Two or more errors may look like a single one and be miscorrected; the
+ * generator must keep a minimum distance of 4 or more at the frame length
+ * (see CrcAnalyzer) for every double error to be detected as such.
+ */
+class CrcCorrector
+{
+public:
+    static const size_t NOT_FOUND = ~size_t(0);
+
+    enum CheckResult
+    {
+        CR_NO_ERROR,        ///< the remainder is zero.
+        CR_CORRECTED,       ///< a single-bit error was corrected.
+        CR_UNCORRECTABLE,   ///< the remainder is not that of a single-bit error.
+    };
+
+    /**
+     * @param [in] generator        big-endian, of degree 1 to 64.
+     * @param [in] numMessageBits   the message bits of a frame, before its CRC.
+     */
+    CrcCorrector(const std::vector<bool>& generator, size_t numMessageBits);
+
+    /**
+     * @return A corrector shared by all callers asking for the same generator and length.
+     */
+    static std::shared_ptr<const CrcCorrector> Get(const std::vector<bool>& generator, size_t numMessageBits);
+
+    const LfsrDivider& GetDivider(void) const;
+
+    /**
+     * @return The bits of a frame, message and CRC.
+     */
+    size_t GetFrameLength(void) const;
+
+    /**
+     * @return Whether every single-bit error has its own remainder.
+     */
+    bool IsCorrectable(void) const;
+
+    /**
+     * @param [in] remainder   the register left by feeding a frame to GetDivider().
+     * @return The position of a single-bit error leaving \c remainder, or NOT_FOUND.
+     */
+    size_t Locate(uint64_t remainder) const;
+
+    /**
+     * Check a frame and correct a single-bit error in place.
+     * @param [in,out] frame      GetFrameLength() bits, packed.
+     * @param [out]    position   the corrected bit, or NOT_FOUND.
+     */
+    CheckResult Correct(uint64_t* frame, size_t& position) const;
+
+    /**
+     * @param [in,out] frame   GetFrameLength() bits in big-endian order, as DataIo.
+     */
+    CheckResult Correct(std::vector<bool>& frame, size_t& position) const;
+
+    static void Test(void);
+
+private:
+    struct Slot
+    {
+        uint64_t remainder;
+        size_t position;    ///< NOT_FOUND for an empty slot, or a remainder shared by two positions.
+        bool used;
+    };
+
+    LfsrDivider divider_;
+    size_t numBits_;
+    bool correctable_;
+    std::vector<Slot> slots_;
+};
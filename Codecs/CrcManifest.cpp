@@ -0,0 +1,394 @@
+#include "CrcManifest.h"
+#include "DataIo.h"
+#include "MappedFile.h"
+#include "PackedBits.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+CrcManifest::CrcManifest(const std::vector<bool>& generator, size_t chunkSize) :
+    divider_(generator),
+    chunkSize_(chunkSize),
+    numWords_(divider_.GetNumberOfWords()),
+    fileSize_(0),
+    modificationTime_(0),
+    crc_(numWords_, 0)
+{
+    assert(divider_.GetDegree() > 0 && chunkSize_ > 0);
+}
+
+const LfsrDivider& CrcManifest::GetDivider(void) const
+{
+    return divider_;
+}
+
+size_t CrcManifest::GetChunkSize(void) const
+{
+    return chunkSize_;
+}
+
+uint64_t CrcManifest::GetFileSize(void) const
+{
+    return fileSize_;
+}
+
+size_t CrcManifest::GetNumberOfChunks(void) const
+{
+    return chunkCrcs_.size() / numWords_;
+}
+
+const uint64_t* CrcManifest::GetChunkCrc(size_t chunk) const
+{
+    assert(chunk < GetNumberOfChunks());
+    return &chunkCrcs_[chunk * numWords_];
+}
+
+const uint64_t* CrcManifest::GetCrc(void) const
+{
+    return &crc_[0];
+}
+
+void CrcManifest::ComputeChunks(const uint8_t* data, uint64_t fileSize, const std::vector<size_t>& chunks,
+                                std::vector<uint64_t>& crcs, ThreadPool& pool) const
+{
+    crcs.assign(chunks.size() * numWords_, 0);
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        uint64_t first = uint64_t(chunks[i]) * chunkSize_;
+        size_t numBytes = static_cast<size_t>(std::min<uint64_t>(chunkSize_, fileSize - first));
+        uint64_t* crc = &crcs[i * numWords_];
+        const LfsrDivider& divider = divider_;
+        pool.Submit([&divider, data, first, numBytes, crc](void)
+        {
+            divider.Update(crc, data + first, 8 * numBytes);
+        });
+    }
+    pool.Wait();
+}
+
+void CrcManifest::Combine(void)
+{
+    std::fill(crc_.begin(), crc_.end(), 0);
+    for (size_t c = 0; c < GetNumberOfChunks(); ++c)
+    {
+        uint64_t numBytes = std::min<uint64_t>(chunkSize_, fileSize_ - uint64_t(c) * chunkSize_);
+        divider_.MultiplyByPowerOfX(&crc_[0], 8 * numBytes);
+        for (size_t w = 0; w < numWords_; ++w)
+        {
+            crc_[w] ^= chunkCrcs_[c * numWords_ + w];
+        }
+    }
+}
+
+bool CrcManifest::Build(const std::string& path, ThreadPool& pool)
+{
+    MappedFile file;
+    if (!MappedFile::GetModificationTime(path, modificationTime_) || !file.Open(path))
+    {
+        return false;
+    }
+    fileSize_ = file.GetSize();
+    std::vector<size_t> chunks(static_cast<size_t>((fileSize_ + chunkSize_ - 1) / chunkSize_));
+    for (size_t c = 0; c < chunks.size(); ++c)
+    {
+        chunks[c] = c;
+    }
+    ComputeChunks(file.GetData(), fileSize_, chunks, chunkCrcs_, pool);
+    dirty_.assign(chunks.size(), false);
+    Combine();
+    return true;
+}
+
+void CrcManifest::MarkDirty(uint64_t offset, uint64_t numBytes)
+{
+    if (!numBytes)
+    {
+        return;
+    }
+    size_t first = static_cast<size_t>(offset / chunkSize_);
+    size_t last = static_cast<size_t>((offset + numBytes - 1) / chunkSize_);
+    if (dirty_.size() <= last)
+    {
+        dirty_.resize(last + 1, false);
+    }
+    std::fill(dirty_.begin() + first, dirty_.begin() + last + 1, true);
+}
+
+size_t CrcManifest::Refresh(const std::string& path, ThreadPool& pool, std::vector<size_t>* changed)
+{
+    uint64_t time = 0;
+    MappedFile file;
+    if (!MappedFile::GetModificationTime(path, time) || !file.Open(path))
+    {
+        return DataIo::ALL_BITS;
+    }
+    const uint64_t size = file.GetSize();
+    const size_t numChunks = static_cast<size_t>((size + chunkSize_ - 1) / chunkSize_);
+    const bool modified = size != fileSize_ || time != modificationTime_;
+    const bool marked = std::find(dirty_.begin(), dirty_.end(), true) != dirty_.end();
+    // Chunks past the common length of the old and new files changed, or are new.
+    const bool resized = size != fileSize_;
+    const uint64_t common = std::min(size, fileSize_) / chunkSize_ * chunkSize_;
+    std::vector<size_t> chunks;
+    for (size_t c = 0; c < numChunks; ++c)
+    {
+        if ((modified && !marked) || (c < dirty_.size() && dirty_[c]) || (resized && uint64_t(c + 1) * chunkSize_ > common))
+        {
+            chunks.push_back(c);
+        }
+    }
+    std::vector<uint64_t> crcs;
+    ComputeChunks(file.GetData(), size, chunks, crcs, pool);
+    const size_t numOldChunks = GetNumberOfChunks();
+    chunkCrcs_.resize(numChunks * numWords_, 0);
+    if (changed)
+    {
+        changed->clear();
+    }
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        uint64_t* crc = &chunkCrcs_[chunks[i] * numWords_];
+        if (changed && (chunks[i] >= numOldChunks || std::memcmp(crc, &crcs[i * numWords_], numWords_ * sizeof (uint64_t))))
+        {
+            changed->push_back(chunks[i]);
+        }
+        std::memcpy(crc, &crcs[i * numWords_], numWords_ * sizeof (uint64_t));
+    }
+    fileSize_ = size;
+    modificationTime_ = time;
+    dirty_.assign(numChunks, false);
+    Combine();
+    return chunks.size();
+}
+
+bool CrcManifest::Verify(const std::string& path, ThreadPool& pool, std::vector<size_t>& mismatches) const
+{
+    mismatches.clear();
+    MappedFile file;
+    if (!file.Open(path) || file.GetSize() != fileSize_)
+    {
+        return false;
+    }
+    std::vector<size_t> chunks(GetNumberOfChunks());
+    for (size_t c = 0; c < chunks.size(); ++c)
+    {
+        chunks[c] = c;
+    }
+    std::vector<uint64_t> crcs;
+    ComputeChunks(file.GetData(), fileSize_, chunks, crcs, pool);
+    for (size_t c = 0; c < chunks.size(); ++c)
+    {
+        if (std::memcmp(&crcs[c * numWords_], &chunkCrcs_[c * numWords_], numWords_ * sizeof (uint64_t)))
+        {
+            mismatches.push_back(c);
+        }
+    }
+    return mismatches.empty();
+}
+
+void CrcManifest::Write(std::ostream& os) const
+{
+    const size_t degree = divider_.GetDegree();
+    std::string hex;
+    std::vector<uint64_t> generator = PackedBits::FromVector(divider_.GetGenerator());
+    DataIo::ToHex(&generator[0], degree + 1, hex);
+    os << "crc-manifest 1" << std::endl
+       << "generator 0x" << hex << std::endl
+       << "chunk-size " << chunkSize_ << std::endl
+       << "file-size " << fileSize_ << std::endl
+       << "modification-time " << modificationTime_ << std::endl;
+    DataIo::ToHex(&crc_[0], degree, hex);
+    os << "crc " << hex << std::endl
+       << "chunks " << GetNumberOfChunks() << std::endl;
+    for (size_t c = 0; c < GetNumberOfChunks(); ++c)
+    {
+        DataIo::ToHex(GetChunkCrc(c), degree, hex);
+        os << hex << std::endl;
+    }
+}
+
+bool CrcManifest::Read(std::istream& is, CrcManifest& manifest)
+{
+    std::string name;
+    std::string version;
+    std::string generator;
+    std::string crc;
+    size_t chunkSize = 0;
+    uint64_t fileSize = 0;
+    uint64_t time = 0;
+    size_t numChunks = 0;
+    if (!(is >> name >> version) || name != "crc-manifest" || version != "1"
+        || !(is >> name >> generator) || name != "generator"
+        || !(is >> name >> chunkSize) || name != "chunk-size" || chunkSize == 0
+        || !(is >> name >> fileSize) || name != "file-size"
+        || !(is >> name >> time) || name != "modification-time"
+        || !(is >> name >> crc) || name != "crc"
+        || !(is >> name >> numChunks) || name != "chunks"
+        || numChunks != (fileSize + chunkSize - 1) / chunkSize)
+    {
+        return false;
+    }
+    std::vector<uint64_t> words;
+    size_t numBits = DataIo::FromHex(generator.data(), generator.length(), words);
+    std::vector<bool> bits = PackedBits::ToVector(words.empty() ? nullptr : &words[0], numBits);
+    // A generator of degree 1 or more, without its leading zeros.
+    if (bits.end() - std::find(bits.begin(), bits.end(), true) < 2)
+    {
+        return false;
+    }
+    CrcManifest result(bits, chunkSize);
+    const size_t degree = result.divider_.GetDegree();
+    const size_t numWords = result.numWords_;
+    result.fileSize_ = fileSize;
+    result.modificationTime_ = time;
+    result.chunkCrcs_.assign(numChunks * numWords, 0);
+    result.dirty_.assign(numChunks, false);
+    for (size_t c = 0; c < numChunks; ++c)
+    {
+        std::string hex;
+        if (!(is >> hex))
+        {
+            return false;
+        }
+        DataIo::FromHex(hex.data(), hex.length(), words, degree);
+        std::copy(words.begin(), words.end(), result.chunkCrcs_.begin() + c * numWords);
+    }
+    result.Combine();
+    // The whole-file CRC is redundant; a mismatch means a damaged manifest.
+    DataIo::FromHex(crc.data(), crc.length(), words, degree);
+    if (words != result.crc_)
+    {
+        return false;
+    }
+    manifest = result;
+    return true;
+}
+
+#include "FileCodecs.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+void CrcManifest::Test(void)
+{
+    const char* path = "CrcManifest.test.tmp";
+    const size_t chunkSize = 4096;
+    std::vector<uint8_t> content(10 * chunkSize + 100);
+    for (size_t i = 0; i < content.size(); ++i)
+    {
+        content[i] = static_cast<uint8_t>(i * 131 + (i >> 9));
+    }
+    {
+        // Written through a stream: pages written through a mapping may update the time later.
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&content[0]), content.size());
+    }
+    ThreadPool pool(3);
+    std::vector<bool> crc32 = DataIo::FromString("1 0000 0100 1100 0001 0001 1101 1011 0111");
+    CrcManifest manifest(crc32, chunkSize);
+    bool ok = manifest.Build(path, pool);
+    assert(ok);
+    assert(manifest.GetNumberOfChunks() == 11);
+    std::vector<uint64_t> reg;
+    ok = FileCodecs::CrcFile(manifest.GetDivider(), path, reg);
+    assert(ok);
+    assert(reg[0] == manifest.GetCrc()[0]);
+    for (size_t c = 0; c < manifest.GetNumberOfChunks(); ++c)
+    {
+        uint64_t crc = 0;
+        manifest.GetDivider().Update(&crc, &content[c * chunkSize], 8 * std::min(chunkSize, content.size() - c * chunkSize));
+        assert(crc == *manifest.GetChunkCrc(c));
+    }
+
+    // Nothing changed: nothing is read.
+    std::vector<size_t> changed;
+    size_t numRefreshed = manifest.Refresh(path, pool, &changed);
+    assert(numRefreshed == 0 && changed.empty());
+
+    // Writes in place to chunks 3 and 7, the second one marked twice, and a mark on unchanged chunk 9.
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(3 * chunkSize + 10);
+        file.write("abc", 3);
+        file.seekp(8 * chunkSize - 2);
+        file.write("de", 2);
+    }
+    manifest.MarkDirty(3 * chunkSize + 10, 3);
+    manifest.MarkDirty(8 * chunkSize - 2, 2);
+    manifest.MarkDirty(7 * chunkSize, 1);
+    manifest.MarkDirty(9 * chunkSize, chunkSize);
+    numRefreshed = manifest.Refresh(path, pool, &changed);
+    assert(numRefreshed == 3);
+    assert(changed.size() == 2 && changed[0] == 3 && changed[1] == 7);
+    ok = FileCodecs::CrcFile(manifest.GetDivider(), path, reg);
+    assert(ok);
+    assert(reg[0] == manifest.GetCrc()[0]);
+    std::vector<size_t> mismatches;
+    ok = manifest.Verify(path, pool, mismatches);
+    assert(ok);
+
+    // An unmarked change is found by a full check only.
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(5 * chunkSize);
+        file.write("f", 1);
+    }
+    ok = manifest.Verify(path, pool, mismatches);
+    assert(!ok);
+    assert(mismatches.size() == 1 && mismatches[0] == 5);
+    manifest.MarkDirty(5 * chunkSize, 1);
+    numRefreshed = manifest.Refresh(path, pool);
+    assert(numRefreshed == 1);
+
+    // Appending rereads the old last chunk and the new ones; without marks, everything.
+    {
+        std::ofstream file(path, std::ios::app | std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&content[0]), 2 * chunkSize);
+    }
+    manifest.MarkDirty(content.size(), 2 * chunkSize);
+    numRefreshed = manifest.Refresh(path, pool, &changed);
+    assert(numRefreshed == 3);
+    assert(changed.size() == 3 && changed[0] == 10 && manifest.GetNumberOfChunks() == 13);
+    ok = FileCodecs::CrcFile(manifest.GetDivider(), path, reg);
+    assert(ok);
+    assert(reg[0] == manifest.GetCrc()[0]);
+    {
+        std::ofstream file(path, std::ios::app | std::ios::binary);
+        file.write("g", 1);
+    }
+    numRefreshed = manifest.Refresh(path, pool);
+    assert(numRefreshed == 13);
+    ok = FileCodecs::CrcFile(manifest.GetDivider(), path, reg);
+    assert(ok);
+    assert(reg[0] == manifest.GetCrc()[0]);
+
+    // The text form, with a generator of two words.
+    std::stringstream text;
+    manifest.Write(text);
+    CrcManifest copy(DataIo::FromString("11"));
+    ok = Read(text, copy);
+    assert(ok);
+    assert(copy.GetNumberOfChunks() == 13 && copy.GetFileSize() == manifest.GetFileSize());
+    assert(copy.GetCrc()[0] == manifest.GetCrc()[0] && copy.GetChunkCrc(12)[0] == manifest.GetChunkCrc(12)[0]);
+    numRefreshed = copy.Refresh(path, pool);
+    assert(numRefreshed == 0);
+    CrcManifest wide(DataIo::FromString("1 0100 0010 1111 0000 1110 0001 1110 1010 1110 1001 0011 0010 0100 1001 1011 0110 1010 1011"), 1000);
+    ok = wide.Build(path, pool);
+    assert(ok);
+    text.str("");
+    text.clear();
+    wide.Write(text);
+    std::string damaged = text.str();
+    ok = Read(text, copy);
+    assert(ok);
+    assert(copy.GetNumberOfChunks() == wide.GetNumberOfChunks());
+    assert(std::equal(copy.GetCrc(), copy.GetCrc() + 2, wide.GetCrc()));
+    damaged[damaged.size() - 2] = damaged[damaged.size() - 2] == '0' ? '1' : '0';
+    std::istringstream bad(damaged);
+    ok = Read(bad, copy);
+    assert(!ok);
+    std::remove(path);
+    (void)ok;
+    (void)numRefreshed;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "LfsrDivider.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * The CRCs of the fixed-size chunks of a file and of the whole file.
+ *
+ * The remainder of a concatenation is linear in its parts:
+ * crc(A B) = crc(A) * x^|B| + crc(B) mod G, so the whole-file CRC is
+ * recombined from the chunk CRCs (see LfsrDivider::MultiplyByPowerOfX())
+ * and a change to a file costs the chunks it touches, not the file.
+ *
+ * Chunks are marked dirty by the caller, who knows what was written.
+ * A file whose size or modification time differs from the manifest also
+ * has the chunks past the smaller of the two sizes dirty, and, if no chunk
+ * was marked, all of them: the system does not tell which bytes changed.
+ */
+class CrcManifest
+{
+public:
+    static const size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+    /**
+     * @param [in] generator   big-endian, of degree 1 or more.
+     * @param [in] chunkSize   the bytes of a chunk, the last one being shorter.
+     */
+    CrcManifest(const std::vector<bool>& generator, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    const LfsrDivider& GetDivider(void) const;
+    size_t GetChunkSize(void) const;
+    uint64_t GetFileSize(void) const;
+    size_t GetNumberOfChunks(void) const;
+
+    /**
+     * @return The remainder of a chunk, GetDivider().GetNumberOfWords() words.
+     */
+    const uint64_t* GetChunkCrc(size_t chunk) const;
+
+    /**
+     * @return The remainder of the whole file, GetDivider().GetNumberOfWords() words.
+     */
+    const uint64_t* GetCrc(void) const;
+
+    /**
+     * Compute every chunk of a file, spread over \c pool.
+     * @return false if the file cannot be read.
+     */
+    bool Build(const std::string& path, ThreadPool& pool);
+
+    /**
+     * Mark the chunks holding \c numBytes bytes at \c offset for Refresh().
+     */
+    void MarkDirty(uint64_t offset, uint64_t numBytes);
+
+    /**
+     * Recompute the dirty chunks of a file on \c pool and recombine the whole-file CRC.
+     * @param [out] changed   the chunks whose CRC changed, ascending; may be null.
+     * @return The number of chunks read, or DataIo::ALL_BITS if the file cannot be read.
+     */
+    size_t Refresh(const std::string& path, ThreadPool& pool, std::vector<size_t>* changed = nullptr);
+
+    /**
+     * Check every chunk of a file against the manifest, on \c pool.
+     * @param [out] mismatches   the chunks whose CRC differs, ascending.
+     * @return false if the file cannot be read, or differs from the manifest.
+     */
+    bool Verify(const std::string& path, ThreadPool& pool, std::vector<size_t>& mismatches) const;
+
+    /**
+     * Write the manifest as text: a header of "name value" lines, then a
+     * chunk CRC per line, in hexadecimal.
+     */
+    void Write(std::ostream& os) const;
+
+    /**
+     * Read a manifest written by Write().
+     * @return false if the text is not a manifest.
+     */
+    static bool Read(std::istream& is, CrcManifest& manifest);
+
+    static void Test(void);
+
+private:
+    /**
+     * Compute the listed chunks of a mapped file into \c crcs, one task per chunk.
+     */
+    void ComputeChunks(const uint8_t* data, uint64_t fileSize, const std::vector<size_t>& chunks,
+                       std::vector<uint64_t>& crcs, ThreadPool& pool) const;
+
+    /**
+     * Fold the chunk CRCs into the whole-file CRC.
+     */
+    void Combine(void);
+
+private:
+    LfsrDivider divider_;
+    size_t chunkSize_;
+    size_t numWords_;                   ///< of a CRC.
+    uint64_t fileSize_;
+    uint64_t modificationTime_;         ///< see MappedFile::GetModificationTime().
+    std::vector<uint64_t> chunkCrcs_;   ///< numWords_ words per chunk.
+    std::vector<uint64_t> crc_;         ///< numWords_ words.
+    std::vector<bool> dirty_;           ///< per chunk.
+};
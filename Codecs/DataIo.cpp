@@ -1,25 +1,173 @@
 #include "DataIo.h"
+#include "PackedBits.h"
+#include "Simd.h"
 #include <iostream>
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 
 std::vector<bool> DataIo::FromString(const std::string& buffer)
 {
-    std::vector<bool> data;
-    size_t len = buffer.length();
-    for (size_t i = 0; i < len; ++i)
+    std::vector<uint64_t> words;
+    size_t numBits = FromString(buffer.data(), buffer.length(), words);
+    return PackedBits::ToVector(words.empty() ? nullptr : &words[0], numBits);
+}
+
+namespace
+{
+    /// Appends bit fields to packed words.
+    class BitAppender
+    {
+    public:
+        explicit BitAppender(uint64_t* words) : words_(words), count_(0), acc_(0), fill_(0) {}
+
+        /**
+         * @param [in] bits The bits, zero above numBits.
+         * @param [in] numBits The number of bits, at most 64.
+         */
+        void Append(uint64_t bits, unsigned numBits)
+        {
+            acc_ |= bits << fill_;
+            fill_ += numBits;
+            if (fill_ >= 64)
+            {
+                words_[count_++] = acc_;
+                fill_ -= 64;
+                acc_ = fill_ ? bits >> (numBits - fill_) : 0;
+            }
+        }
+
+        /// @return The number of bits, after storing the partial word.
+        size_t Finish(void)
+        {
+            if (fill_)
+            {
+                words_[count_] = acc_;
+            }
+            return count_ * 64 + fill_;
+        }
+
+    private:
+        uint64_t* words_;
+        size_t count_;
+        uint64_t acc_;
+        unsigned fill_;
+    };
+
+    /// Gathers the bits of value selected by mask into the low bits.
+    inline uint64_t Compact(uint64_t value, uint64_t mask)
+    {
+#if defined(CODECS_HAS_BMI2)
+        return _pext_u64(value, mask);
+#else
+        // PEXT on bytes, the few mask patterns of a formatted dump stay cached.
+        static const struct Table
+        {
+            uint8_t gather[256][256];
+            Table(void)
+            {
+                for (unsigned m = 0; m < 256; ++m)
+                {
+                    for (unsigned v = 0; v < 256; ++v)
+                    {
+                        unsigned out = 0;
+                        unsigned n = 0;
+                        for (unsigned j = 0; j < 8; ++j)
+                        {
+                            if (m & (1u << j))
+                            {
+                                out |= ((v >> j) & 1) << n++;
+                            }
+                        }
+                        gather[m][v] = static_cast<uint8_t>(out);
+                    }
+                }
+            }
+        } table;
+        uint64_t result = 0;
+        unsigned n = 0;
+        while (mask)
+        {
+            unsigned m = mask & 0xFF;
+            result |= static_cast<uint64_t>(table.gather[m][value & 0xFF]) << n;
+            n += PackedBits::PopCount(m);
+            mask >>= 8;
+            value >>= 8;
+        }
+        return result;
+#endif
+    }
+}
+
+size_t DataIo::FromString(const char* buffer, size_t length, std::vector<uint64_t>& words)
+{
+    words.assign(PackedBits::GetNumberOfWords(length), 0);
+    if (length == 0)
+    {
+        return 0;
+    }
+    size_t numBits = FromString(buffer, length, &words[0]);
+    words.resize(PackedBits::GetNumberOfWords(numBits));
+    return numBits;
+}
+
+size_t DataIo::FromString(const char* buffer, size_t length, uint64_t* words)
+{
+    std::fill(words, words + PackedBits::GetNumberOfWords(length), 0);
+    BitAppender appender(words);
+    size_t i = 0;
+#if defined(CODECS_HAS_SSE2)
+    // Classify a block of characters at a time: 'valid' marks '0' and '1',
+    // 'ones' marks '1', and the separators are compacted away.
+#if defined(CODECS_HAS_AVX2)
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i one = _mm256_set1_epi8('1');
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + i));
+        __m256i isOne = _mm256_cmpeq_epi8(c, one);
+        __m256i isBit = _mm256_or_si256(_mm256_cmpeq_epi8(c, zero), isOne);
+        uint64_t valid = static_cast<uint32_t>(_mm256_movemask_epi8(isBit));
+        uint64_t ones = static_cast<uint32_t>(_mm256_movemask_epi8(isOne));
+#else
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i one = _mm_set1_epi8('1');
+    for (; i + 32 <= length; i += 32)
+    {
+        __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+        __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i + 16));
+        __m128i isOne0 = _mm_cmpeq_epi8(c0, one);
+        __m128i isOne1 = _mm_cmpeq_epi8(c1, one);
+        __m128i isBit0 = _mm_or_si128(_mm_cmpeq_epi8(c0, zero), isOne0);
+        __m128i isBit1 = _mm_or_si128(_mm_cmpeq_epi8(c1, zero), isOne1);
+        uint64_t valid = static_cast<uint64_t>(_mm_movemask_epi8(isBit0))
+                       | static_cast<uint64_t>(_mm_movemask_epi8(isBit1)) << 16;
+        uint64_t ones = static_cast<uint64_t>(_mm_movemask_epi8(isOne0))
+                      | static_cast<uint64_t>(_mm_movemask_epi8(isOne1)) << 16;
+#endif
+        if (valid == 0xFFFFFFFF)
+        {
+            appender.Append(ones, 32);
+        }
+        else if (valid != 0)
+        {
+            appender.Append(Compact(ones, valid), PackedBits::PopCount(valid));
+        }
+    }
+#endif
+    for (; i < length; ++i)
     {
         switch (buffer[i])
         {
         case '0':
-            data.push_back(false);
+            appender.Append(0, 1);
             break;
         case '1':
-            data.push_back(true);
+            appender.Append(1, 1);
             break;
         }
     }
-    return data;
+    return appender.Finish();
 }
 
 bool DataIo::IsEqual(const std::vector<bool>& lhs, const std::vector<bool>& rhs)
@@ -57,24 +205,244 @@ bool DataIo::IsZero(const std::vector<bool> &lhs)
 
 std::string DataIo::ToString(const std::vector<bool>& data)
 {
+    std::vector<uint64_t> words = PackedBits::FromVector(data);
     std::string buffer;
-    size_t n = data.size();
-    if (n == 0)
+    ToString(words.empty() ? nullptr : &words[0], data.size(), buffer);
+    return buffer;
+}
+
+void DataIo::ToString(const uint64_t* words, size_t numBits, std::string& buffer)
+{
+    if (numBits == 0)
     {
-        buffer.push_back('0');
+        buffer.assign(1, '0');
+        return;
     }
-    else
+    // Each nibble expands to a space and its four characters; entries are
+    // written 8 bytes at a time, so the buffer has slack at the end.
+    static const struct Table
     {
-        for (size_t i = 0; i < data.size(); ++i, --n)
+        uint64_t group[16];
+        Table(void)
         {
-            if (i != 0 && n % 4 == 0)
+            for (unsigned v = 0; v < 16; ++v)
             {
-                buffer.push_back(' ');
+                char chars[8] = { ' ', 0, 0, 0, 0, 0, 0, 0 };
+                for (unsigned j = 0; j < 4; ++j)
+                {
+                    chars[1 + j] = (v >> j) & 1 ? '1' : '0';
+                }
+                std::memcpy(&group[v], chars, sizeof (chars));
             }
-            buffer.push_back(data[i] ? '1' : '0');
         }
+    } table;
+    size_t head = numBits % 4 ? numBits % 4 : 4;
+    size_t length = numBits + (numBits - 1) / 4;
+    buffer.resize(length + 8);
+    char* out = &buffer[0];
+    for (size_t i = 0; i < head; ++i)
+    {
+        *out++ = PackedBits::GetBit(words, i) ? '1' : '0';
+    }
+    size_t i = head;
+    // Expand 16 nibbles per 64 bits.  The nibbles start after the head, so
+    // they straddle words unless numBits is a multiple of 4.
+    for (; i + 64 <= numBits; i += 64)
+    {
+        uint64_t word = PackedBits::ExtractBits(words, i, 64);
+        for (unsigned j = 0; j < 16; ++j)
+        {
+            std::memcpy(out, &table.group[word & 0xF], 8);
+            out += 5;
+            word >>= 4;
+        }
+    }
+    for (; i < numBits; i += 4)
+    {
+        std::memcpy(out, &table.group[PackedBits::ExtractBits(words, i, 4)], 8);
+        out += 5;
+    }
+    buffer.resize(length);
+}
+
+namespace
+{
+    /// @return The value of a hex digit, or -1.
+    inline int HexValue(char c)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F')
+        {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    const char BASE64_DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+}
+
+size_t DataIo::FromHex(const char* buffer, size_t length, std::vector<uint64_t>& words, size_t numBits)
+{
+    if (length >= 2 && buffer[0] == '0' && (buffer[1] == 'x' || buffer[1] == 'X'))
+    {
+        buffer += 2;
+        length -= 2;
+    }
+    size_t numDigits = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (HexValue(buffer[i]) >= 0)
+        {
+            ++numDigits;
+        }
+    }
+    if (numBits == ALL_BITS)
+    {
+        numBits = 4 * numDigits;
+    }
+    words.assign(PackedBits::GetNumberOfWords(numBits), 0);
+    // The sequence position of the first bit of the current digit;
+    // the bits of the leading digits may fall before the sequence.
+    ptrdiff_t pos = static_cast<ptrdiff_t>(numBits) - static_cast<ptrdiff_t>(4 * numDigits);
+    for (size_t i = 0; i < length; ++i)
+    {
+        int value = HexValue(buffer[i]);
+        if (value < 0)
+        {
+            continue;
+        }
+        // The most significant bit of a digit comes first.
+        for (unsigned j = 0; j < 4; ++j, ++pos)
+        {
+            if (pos >= 0 && ((value >> (3 - j)) & 1))
+            {
+                PackedBits::SetBit(&words[0], static_cast<size_t>(pos), true);
+            }
+        }
+    }
+    return numBits;
+}
+
+void DataIo::ToHex(const uint64_t* words, size_t numBits, std::string& buffer)
+{
+    if (numBits == 0)
+    {
+        buffer.assign(1, '0');
+        return;
+    }
+    static const char DIGITS[] = "0123456789ABCDEF";
+    size_t head = numBits % 4 ? numBits % 4 : 4;
+    buffer.assign((numBits + 3) / 4, '0');
+    size_t i = 0;
+    for (size_t d = 0; d < buffer.size(); ++d)
+    {
+        size_t n = d == 0 ? head : 4;
+        unsigned value = 0;
+        for (size_t j = 0; j < n; ++j, ++i)
+        {
+            value = (value << 1) | (PackedBits::GetBit(words, i) ? 1 : 0);
+        }
+        buffer[d] = DIGITS[value];
+    }
+}
+
+bool DataIo::FromBase64(const char* buffer, size_t length, std::vector<uint8_t>& bytes)
+{
+    bytes.clear();
+    bytes.reserve(length / 4 * 3 + 3);
+    uint32_t acc = 0;
+    unsigned fill = 0;
+    bool padded = false;
+    for (size_t i = 0; i < length; ++i)
+    {
+        char c = buffer[i];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+        {
+            continue;
+        }
+        if (c == '=')
+        {
+            padded = true;
+            continue;
+        }
+        const char* digit = std::strchr(BASE64_DIGITS, c);
+        if (padded || c == '\0' || !digit)
+        {
+            return false;
+        }
+        acc = (acc << 6) | static_cast<uint32_t>(digit - BASE64_DIGITS);
+        fill += 6;
+        if (fill >= 8)
+        {
+            fill -= 8;
+            bytes.push_back(static_cast<uint8_t>(acc >> fill));
+        }
+    }
+    return true;
+}
+
+void DataIo::ToBase64(const uint8_t* bytes, size_t numBytes, std::string& buffer)
+{
+    buffer.clear();
+    buffer.reserve((numBytes + 2) / 3 * 4);
+    for (size_t i = 0; i < numBytes; i += 3)
+    {
+        uint32_t group = static_cast<uint32_t>(bytes[i]) << 16;
+        if (i + 1 < numBytes)
+        {
+            group |= static_cast<uint32_t>(bytes[i + 1]) << 8;
+        }
+        if (i + 2 < numBytes)
+        {
+            group |= bytes[i + 2];
+        }
+        buffer.push_back(BASE64_DIGITS[(group >> 18) & 0x3F]);
+        buffer.push_back(BASE64_DIGITS[(group >> 12) & 0x3F]);
+        buffer.push_back(i + 1 < numBytes ? BASE64_DIGITS[(group >> 6) & 0x3F] : '=');
+        buffer.push_back(i + 2 < numBytes ? BASE64_DIGITS[group & 0x3F] : '=');
+    }
+}
+
+void DataIo::FromBytes(const uint8_t* bytes, size_t numBits, BitView::BitOrder bitOrder,
+                       ByteOrder byteOrder, uint64_t* words)
+{
+    if (byteOrder == BO_BIG_ENDIAN)
+    {
+        BitView(bytes, numBits, bitOrder).CopyBits(0, numBits, words);
+        return;
+    }
+    size_t numBytes = (numBits + 7) / 8;
+    std::memset(words, 0, PackedBits::GetNumberOfWords(numBits) * sizeof (uint64_t));
+    for (size_t i = 0; i < numBytes; ++i)
+    {
+        uint8_t byte = bytes[numBytes - 1 - i];
+        uint64_t bits = bitOrder == BitView::BO_LSB_FIRST ? byte : BitView::ReverseBitsInBytes(byte);
+        size_t n = numBits - 8 * i < 8 ? numBits - 8 * i : 8;
+        PackedBits::InsertBits(words, 8 * i, bits & PackedBits::GetLowMask(n), n);
+    }
+}
+
+void DataIo::ToBytes(const uint64_t* words, size_t numBits, BitView::BitOrder bitOrder,
+                     ByteOrder byteOrder, uint8_t* bytes)
+{
+    size_t numBytes = (numBits + 7) / 8;
+    for (size_t i = 0; i < numBytes; ++i)
+    {
+        size_t n = numBits - 8 * i < 8 ? numBits - 8 * i : 8;
+        uint64_t bits = PackedBits::ExtractBits(words, 8 * i, n);
+        if (bitOrder == BitView::BO_MSB_FIRST)
+        {
+            bits = BitView::ReverseBitsInBytes(bits);
+        }
+        bytes[byteOrder == BO_BIG_ENDIAN ? i : numBytes - 1 - i] = static_cast<uint8_t>(bits);
     }
-    return buffer;
 }
 
 void DataIo::Test(void)
@@ -107,4 +475,107 @@ void DataIo::Test(void)
     std::vector<bool> lhs = FromString("001010");
     std::vector<bool> rhs = FromString("00001010");
     assert(IsEqual(lhs, rhs));
+
+    // ToString groups from the right.
+    assert(ToString(FromString("")) == "0");
+    assert(ToString(FromString("1")) == "1");
+    assert(ToString(FromString("10 1")) == "101");
+    assert(ToString(FromString("1011")) == "1011");
+    assert(ToString(FromString("1 0110")) == "1 0110");
+    assert(ToString(FromString("x11y0110:1100")) == "11 0110 1100");
+
+    // Long strings cross the block and word boundaries of both converters.
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (size_t n = 0; n < 300; n += 7)
+    {
+        std::string text;
+        std::vector<bool> bits;
+        for (size_t i = 0; i < n; ++i)
+        {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            bits.push_back((x & 1) != 0);
+            text.push_back(x & 1 ? '1' : '0');
+            if (x & 6)
+            {
+                text.push_back((x & 8) ? ' ' : '_');
+            }
+        }
+        std::vector<uint64_t> words;
+        size_t numBits = FromString(text.data(), text.length(), words);
+        assert(numBits == n);
+        (void)numBits;
+        assert(words.size() == PackedBits::GetNumberOfWords(n));
+        assert(FromString(text) == bits);
+        std::string expected;
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (i != 0 && (n - i) % 4 == 0)
+            {
+                expected.push_back(' ');
+            }
+            expected.push_back(bits[i] ? '1' : '0');
+        }
+        std::string output;
+        ToString(words.empty() ? nullptr : &words[0], n, output);
+        assert(n == 0 || output == expected);
+        assert(n == 0 || FromString(output) == bits);
+    }
+
+    // Hex, right-aligned to the explicit length.
+    std::vector<uint64_t> hex;
+    size_t numHexBits = FromHex("0x1A3", 5, hex);
+    assert(numHexBits == 12);
+    assert(PackedBits::ToVector(&hex[0], 12) == FromString("0001 1010 0011"));
+    numHexBits = FromHex("104C11DB7", 9, hex, 33);
+    assert(numHexBits == 33);
+    assert(PackedBits::ToVector(&hex[0], 33) == FromString("1 0000 0100 1100 0001 0001 1101 1011 0111"));
+    numHexBits = FromHex("f", 1, hex, 6);
+    assert(numHexBits == 6);
+    (void)numHexBits;
+    assert(PackedBits::ToVector(&hex[0], 6) == FromString("00 1111"));
+    std::string text;
+    ToHex(&hex[0], 6, text);
+    assert(text == "0F");
+    FromHex("104C11DB7", 9, hex, 33);
+    ToHex(&hex[0], 33, text);
+    assert(text == "104C11DB7");
+
+    // Base64 (RFC 4648 test vectors).
+    const char* plain[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+    const char* encoded[] = { "", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy" };
+    bool ok = false;
+    for (size_t i = 0; i < 7; ++i)
+    {
+        ToBase64(reinterpret_cast<const uint8_t*>(plain[i]), std::strlen(plain[i]), text);
+        assert(text == encoded[i]);
+        std::vector<uint8_t> bytes;
+        ok = FromBase64(text.data(), text.length(), bytes);
+        assert(ok && std::string(bytes.begin(), bytes.end()) == plain[i]);
+    }
+    std::vector<uint8_t> bytes;
+    ok = FromBase64("Zm9v!", 5, bytes);
+    assert(!ok);
+    (void)encoded;
+    (void)ok;
+
+    // Raw bytes in every bit and byte order.
+    const uint8_t raw[] = { 0xC1, 0x02, 0x80 };
+    uint64_t word = 0;
+    FromBytes(raw, 20, BitView::BO_MSB_FIRST, BO_BIG_ENDIAN, &word);
+    assert(PackedBits::ToVector(&word, 20) == FromString("1100 0001 0000 0010 1000"));
+    FromBytes(raw, 20, BitView::BO_LSB_FIRST, BO_BIG_ENDIAN, &word);
+    assert(PackedBits::ToVector(&word, 20) == FromString("1000 0011 0100 0000 0000"));
+    FromBytes(raw, 20, BitView::BO_MSB_FIRST, BO_LITTLE_ENDIAN, &word);
+    assert(PackedBits::ToVector(&word, 20) == FromString("1000 0000 0000 0010 1100"));
+    for (unsigned order = 0; order < 4; ++order)
+    {
+        BitView::BitOrder bitOrder = order & 1 ? BitView::BO_MSB_FIRST : BitView::BO_LSB_FIRST;
+        ByteOrder byteOrder = order & 2 ? BO_LITTLE_ENDIAN : BO_BIG_ENDIAN;
+        uint8_t out[3] = { 0xFF, 0xFF, 0xFF };
+        FromBytes(raw, 24, bitOrder, byteOrder, &word);
+        ToBytes(&word, 24, bitOrder, byteOrder, out);
+        assert(std::memcmp(raw, out, 3) == 0);
+    }
 }
@@ -1,10 +1,22 @@
 #pragma once
+#include "BitView.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 class DataIo
 {
 public:
+    enum ByteOrder
+    {
+        BO_BIG_ENDIAN,      ///< the first byte of a buffer holds the first bits.
+        BO_LITTLE_ENDIAN,   ///< the last byte of a buffer holds the first bits.
+    };
+
+    /// Take as many bits as the input holds.
+    static const size_t ALL_BITS = static_cast<size_t>(-1);
+
     /**
      * Convert a string in big-endian order.
      * Only '1' and '0' are recognized, all other characters are ignored.
@@ -17,6 +29,74 @@ public:
      */
     static std::string ToString(const std::vector<bool>& data);
 
+    /**
+     * Convert a string in big-endian order into packed words.
+     * Bit i of the sequence is bit (i % 64) of word (i / 64), padding bits are zero.
+     * @param [in] buffer The characters, only '1' and '0' are recognized.
+     * @param [in] length The number of characters.
+     * @param [out] words The packed bits, resized to fit.
+     * @return The number of bits.
+     */
+    static size_t FromString(const char* buffer, size_t length, std::vector<uint64_t>& words);
+
+    /**
+     * FromString() into caller storage.
+     * @param [out] words (length + 63) / 64 words; those past the bits are zeroed.
+     */
+    static size_t FromString(const char* buffer, size_t length, uint64_t* words);
+
+    /**
+     * Output packed words as a string in big-endian order, in 4-bit groups.
+     * @param [in] words The packed bits.
+     * @param [in] numBits The number of bits.
+     * @param [out] buffer The string, replaced.
+     */
+    static void ToString(const uint64_t* words, size_t numBits, std::string& buffer);
+
+    /**
+     * Convert hexadecimal digits in big-endian order into packed words.
+     * A leading "0x" is skipped; characters other than hex digits are ignored.
+     * @param [in] buffer    The characters.
+     * @param [in] length    The number of characters.
+     * @param [out] words    The packed bits, resized to fit.
+     * @param [in] numBits   The number of bits to keep, counted from the last digit;
+     *                       missing leading bits are zero.  By default, 4 bits per digit.
+     * @return The number of bits.
+     */
+    static size_t FromHex(const char* buffer, size_t length, std::vector<uint64_t>& words, size_t numBits = ALL_BITS);
+
+    /**
+     * Output packed words as hexadecimal digits in big-endian order.
+     * The first digit holds the leading numBits % 4 bits if that is not zero.
+     */
+    static void ToHex(const uint64_t* words, size_t numBits, std::string& buffer);
+
+    /**
+     * Decode base64 (RFC 4648, with or without padding); white space is ignored.
+     * @return false if the input holds other characters.
+     */
+    static bool FromBase64(const char* buffer, size_t length, std::vector<uint8_t>& bytes);
+
+    static void ToBase64(const uint8_t* bytes, size_t numBytes, std::string& buffer);
+
+    /**
+     * Unpack raw bytes into packed words.
+     * @param [in] bytes       (numBits + 7) / 8 bytes.
+     * @param [in] numBits     The number of bits, the first ones in sequence order.
+     * @param [in] bitOrder    The order of the bits within each byte.
+     * @param [in] byteOrder   The order of the bytes.
+     * @param [out] words      (numBits + 63) / 64 words.
+     */
+    static void FromBytes(const uint8_t* bytes, size_t numBits, BitView::BitOrder bitOrder,
+                          ByteOrder byteOrder, uint64_t* words);
+
+    /**
+     * Pack packed words into raw bytes, the inverse of FromBytes().
+     * The unused bits of the last byte in sequence order are cleared.
+     */
+    static void ToBytes(const uint64_t* words, size_t numBits, BitView::BitOrder bitOrder,
+                        ByteOrder byteOrder, uint8_t* bytes);
+
     static bool IsEqual(const std::vector<bool>& lhs, const std::vector<bool>& rhs);
 
     static bool IsZero(const std::vector<bool> &lhs);
@@ -0,0 +1,443 @@
+#include "FileCodecs.h"
+#include "MappedFile.h"
+#include "BitView.h"
+#include "DataIo.h"
+#include "Instrumentation.h"
+#include "PackedBits.h"
+#include "OrderedPipeline.h"
+#include <algorithm>
+#include <atomic>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    /// The number of blocks coded per call of the batch kernels.
+    const size_t BATCH_BLOCKS = 256;
+
+    /// Appends bit fields to a byte buffer of a known size.
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(uint8_t* bytes) : bytes_(bytes), acc_(0), fill_(0) {}
+
+        /**
+         * @param [in] words     a packed bit sequence.
+         * @param [in] numBits   the number of bits to append.
+         */
+        void Write(const uint64_t* words, size_t numBits)
+        {
+            for (; numBits >= 64; numBits -= 64)
+            {
+                Append(*words++, 64);
+            }
+            if (numBits)
+            {
+                Append(*words & PackedBits::GetLowMask(numBits), static_cast<unsigned>(numBits));
+            }
+        }
+
+        /// Store the last partial word, only its used bytes.
+        void Finish(void)
+        {
+            std::memcpy(bytes_, &acc_, (fill_ + 7) / 8);
+        }
+
+    private:
+        void Append(uint64_t bits, unsigned numBits)
+        {
+            acc_ |= bits << fill_;
+            fill_ += numBits;
+            if (fill_ >= 64)
+            {
+                // Assumes a little-endian host, as PackedBits does.
+                std::memcpy(bytes_, &acc_, 8);
+                bytes_ += 8;
+                fill_ -= 64;
+                acc_ = fill_ ? bits >> (numBits - fill_) : 0;
+            }
+        }
+
+    private:
+        uint8_t* bytes_;
+        uint64_t acc_;
+        unsigned fill_;
+    };
+}
+
+size_t FileCodecs::GetEncodedSize(const HammingCodecs& hamming, size_t numBytes)
+{
+    size_t k = hamming.GetNumberOfMessageBits();
+    size_t numBlocks = (8 * numBytes + k - 1) / k;
+    return (numBlocks * hamming.GetNumberOfCodeBits() + 7) / 8;
+}
+
+size_t FileCodecs::GetDecodedSize(const HammingCodecs& hamming, size_t numBytes)
+{
+    size_t numBlocks = 8 * numBytes / hamming.GetNumberOfCodeBits();
+    return numBlocks * hamming.GetNumberOfMessageBits() / 8;
+}
+
+void FileCodecs::HammingEncode(const HammingCodecs& hamming, const uint8_t* input, size_t numBytes, uint8_t* output)
+{
+    CODECS_TIME(Instrumentation::OP_HAMMING_ENCODE_BUFFER);
+    CODECS_COUNT(Instrumentation::CT_HAMMING_BYTES_ENCODED, numBytes);
+    size_t k = hamming.GetNumberOfMessageBits();
+    size_t n = hamming.GetNumberOfCodeBits();
+    // One batch of message and code blocks, reused for every batch.
+    std::vector<uint64_t> message(PackedBits::GetNumberOfWords(BATCH_BLOCKS * k), 0);
+    std::vector<uint64_t> code(PackedBits::GetNumberOfWords(BATCH_BLOCKS * n), 0);
+    BitView view(input, 8 * numBytes);
+    BitWriter writer(output);
+    for (size_t first = 0; first < view.GetNumberOfBits(); first += BATCH_BLOCKS * k)
+    {
+        size_t numBits = std::min(view.GetNumberOfBits() - first, BATCH_BLOCKS * k);
+        size_t numBlocks = (numBits + k - 1) / k;
+        if (numBits < BATCH_BLOCKS * k)
+        {
+            std::fill(message.begin(), message.end(), 0);
+        }
+        view.CopyBits(first, numBits, &message[0]);
+        hamming.EncodeBlocks(&message[0], numBlocks, &code[0]);
+        writer.Write(&code[0], numBlocks * n);
+    }
+    writer.Finish();
+}
+
+size_t FileCodecs::HammingDecode(const HammingCodecs& hamming, const uint8_t* input, size_t numBytes,
+                                 uint8_t* output, size_t numOutputBytes)
+{
+    assert(numOutputBytes <= GetDecodedSize(hamming, numBytes));
+    CODECS_TIME(Instrumentation::OP_HAMMING_DECODE_BUFFER);
+    CODECS_COUNT(Instrumentation::CT_HAMMING_BYTES_DECODED, numOutputBytes);
+    size_t k = hamming.GetNumberOfMessageBits();
+    size_t n = hamming.GetNumberOfCodeBits();
+    std::vector<uint64_t> message(PackedBits::GetNumberOfWords(BATCH_BLOCKS * k), 0);
+    std::vector<uint64_t> code(PackedBits::GetNumberOfWords(BATCH_BLOCKS * n), 0);
+    BitView view(input, 8 * numBytes);
+    BitWriter writer(output);
+    size_t numCorrected = 0;
+    size_t remaining = 8 * numOutputBytes;
+    for (size_t first = 0; remaining; first += BATCH_BLOCKS * n)
+    {
+        // Whole blocks covering the remaining output.
+        size_t numBlocks = std::min(BATCH_BLOCKS, (remaining + k - 1) / k);
+        view.CopyBits(first, numBlocks * n, &code[0]);
+        numCorrected += hamming.DecodeBlocks(&code[0], numBlocks, &message[0], nullptr);
+        size_t numBits = std::min(remaining, numBlocks * k);
+        writer.Write(&message[0], numBits);
+        remaining -= numBits;
+    }
+    writer.Finish();
+    return numCorrected;
+}
+
+bool FileCodecs::CrcFile(const LfsrDivider& divider, const std::string& path, std::vector<uint64_t>& reg)
+{
+    CODECS_TIME(Instrumentation::OP_FILE_CRC);
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        return false;
+    }
+    reg.assign(divider.GetNumberOfWords(), 0);
+    if (!reg.empty())
+    {
+        divider.Update(&reg[0], file.GetData(), 8 * file.GetSize());
+    }
+    return true;
+}
+
+bool FileCodecs::HammingEncodeFile(const HammingCodecs& hamming, const std::string& input, const std::string& output)
+{
+    MappedFile in;
+    MappedFile out;
+    if (!in.Open(input) || !out.Create(output, GetEncodedSize(hamming, in.GetSize())))
+    {
+        return false;
+    }
+    HammingEncode(hamming, in.GetData(), in.GetSize(), out.GetData());
+    return true;
+}
+
+bool FileCodecs::HammingDecodeFile(const HammingCodecs& hamming, const std::string& input, const std::string& output,
+                                   size_t numBytes, size_t& numCorrected)
+{
+    MappedFile in;
+    MappedFile out;
+    if (!in.Open(input))
+    {
+        return false;
+    }
+    size_t maxBytes = GetDecodedSize(hamming, in.GetSize());
+    if (numBytes == DataIo::ALL_BITS)
+    {
+        numBytes = maxBytes;
+    }
+    if (numBytes > maxBytes || !out.Create(output, numBytes))
+    {
+        return false;
+    }
+    numCorrected = HammingDecode(hamming, in.GetData(), in.GetSize(), out.GetData(), numBytes);
+    return true;
+}
+
+size_t FileCodecs::GetChunkSize(size_t blockBits)
+{
+    // blockBits bytes hold 8 whole blocks and start on a block boundary.
+    const size_t TARGET = 64 * 1024;
+    return blockBits * (TARGET > blockBits ? TARGET / blockBits : 1);
+}
+
+bool FileCodecs::HammingEncodeFile(const HammingCodecs& hamming, const std::string& input, const std::string& output,
+                                   ThreadPool& pool)
+{
+    MappedFile in;
+    MappedFile out;
+    if (!in.Open(input) || !out.Create(output, GetEncodedSize(hamming, in.GetSize())))
+    {
+        return false;
+    }
+    size_t chunkSize = GetChunkSize(hamming.GetNumberOfMessageBits());
+    const uint8_t* source = in.GetData();
+    uint8_t* destination = out.GetData();
+    for (size_t first = 0; first < in.GetSize(); first += chunkSize)
+    {
+        size_t numBytes = std::min(chunkSize, in.GetSize() - first);
+        pool.Submit([&hamming, source, destination, first, numBytes]()
+        {
+            HammingEncode(hamming, source + first, numBytes, destination + GetEncodedSize(hamming, first));
+        });
+    }
+    pool.Wait();
+    return true;
+}
+
+bool FileCodecs::HammingDecodeFile(const HammingCodecs& hamming, const std::string& input, const std::string& output,
+                                   size_t numBytes, size_t& numCorrected, ThreadPool& pool)
+{
+    MappedFile in;
+    MappedFile out;
+    if (!in.Open(input))
+    {
+        return false;
+    }
+    size_t maxBytes = GetDecodedSize(hamming, in.GetSize());
+    if (numBytes == DataIo::ALL_BITS)
+    {
+        numBytes = maxBytes;
+    }
+    if (numBytes > maxBytes || !out.Create(output, numBytes))
+    {
+        return false;
+    }
+    size_t chunkSize = GetChunkSize(hamming.GetNumberOfCodeBits());
+    const uint8_t* source = in.GetData();
+    uint8_t* destination = out.GetData();
+    std::atomic<size_t> total(0);
+    for (size_t first = 0; first < in.GetSize(); first += chunkSize)
+    {
+        size_t offset = GetDecodedSize(hamming, first);
+        if (offset >= numBytes)
+        {
+            break;
+        }
+        size_t numInputBytes = std::min(chunkSize, in.GetSize() - first);
+        size_t numOutputBytes = std::min(GetDecodedSize(hamming, numInputBytes), numBytes - offset);
+        pool.Submit([&hamming, &total, source, destination, first, offset, numInputBytes, numOutputBytes]()
+        {
+            total += HammingDecode(hamming, source + first, numInputBytes, destination + offset, numOutputBytes);
+        });
+    }
+    pool.Wait();
+    numCorrected = total;
+    return true;
+}
+
+namespace
+{
+    /// @return A reader filling chunks from \c input.
+    OrderedPipeline::Reader StreamReader(std::istream& input)
+    {
+        return [&input](uint8_t* buffer, size_t capacity) -> size_t
+        {
+            input.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(capacity));
+            return static_cast<size_t>(input.gcount());
+        };
+    }
+}
+
+bool FileCodecs::HammingEncodeStream(const HammingCodecs& hamming, std::istream& input, std::ostream& output,
+                                     ThreadPool& pool)
+{
+    size_t chunkSize = GetChunkSize(hamming.GetNumberOfMessageBits());
+    OrderedPipeline pipeline(pool, chunkSize, GetEncodedSize(hamming, chunkSize));
+    return pipeline.Run(StreamReader(input),
+        [&hamming](const uint8_t* in, size_t numBytes, bool, uint8_t* out) -> size_t
+        {
+            HammingEncode(hamming, in, numBytes, out);
+            return GetEncodedSize(hamming, numBytes);
+        },
+        [&output](const uint8_t* out, size_t numBytes) -> bool
+        {
+            output.write(reinterpret_cast<const char*>(out), static_cast<std::streamsize>(numBytes));
+            return !output.fail();
+        });
+}
+
+bool FileCodecs::HammingDecodeStream(const HammingCodecs& hamming, std::istream& input, std::ostream& output,
+                                     ThreadPool& pool, size_t numBytes, size_t& numCorrected)
+{
+    size_t chunkSize = GetChunkSize(hamming.GetNumberOfCodeBits());
+    OrderedPipeline pipeline(pool, chunkSize, GetDecodedSize(hamming, chunkSize));
+    std::atomic<size_t> total(0);
+    size_t remaining = numBytes;
+    bool ok = pipeline.Run(StreamReader(input),
+        [&hamming, &total](const uint8_t* in, size_t numBytes, bool, uint8_t* out) -> size_t
+        {
+            size_t numOutputBytes = GetDecodedSize(hamming, numBytes);
+            total += HammingDecode(hamming, in, numBytes, out, numOutputBytes);
+            return numOutputBytes;
+        },
+        [&output, &remaining](const uint8_t* out, size_t numBytes) -> bool
+        {
+            numBytes = std::min(numBytes, remaining);
+            remaining -= numBytes;
+            output.write(reinterpret_cast<const char*>(out), static_cast<std::streamsize>(numBytes));
+            return !output.fail();
+        });
+    numCorrected = total;
+    return ok;
+}
+
+void FileCodecs::Test(void)
+{
+    // Round trips through caller buffers, with one error in every other block.
+    const size_t sizes[] = { 1, 8, 11, 64 };
+    std::vector<uint8_t> message(1000, 0);
+    for (size_t i = 0; i < message.size(); ++i)
+    {
+        message[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    for (size_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); ++s)
+    {
+        HammingCodecs hamming(sizes[s]);
+        std::vector<uint8_t> code(GetEncodedSize(hamming, message.size()) + 1, 0xEE);
+        HammingEncode(hamming, &message[0], message.size(), &code[0]);
+        assert(code.back() == 0xEE);
+        // Check the first block against the bit-vector encoder.
+        std::vector<bool> block(sizes[s], false);
+        for (size_t i = 0; i < sizes[s]; ++i)
+        {
+            block[i] = BitView(&message[0], 8 * message.size()).GetBit(i);
+        }
+        std::vector<bool> expected = hamming.Encode(block);
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            assert(BitView(&code[0], 8 * code.size()).GetBit(i) == expected[i]);
+        }
+        size_t n = hamming.GetNumberOfCodeBits();
+        size_t numBlocks = 8 * (code.size() - 1) / n;
+        for (size_t b = 0; b < numBlocks; b += 2)
+        {
+            size_t bit = b * n + (b * 5) % n;
+            code[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+        }
+        std::vector<uint8_t> decoded(message.size(), 0);
+        size_t numCorrected = HammingDecode(hamming, &code[0], code.size() - 1, &decoded[0], decoded.size());
+        assert(decoded == message);
+        assert(numCorrected >= (message.size() * 8 / sizes[s] + 1) / 2);
+        (void)numCorrected;
+    }
+
+    // Files.
+    const char* plainPath = "FileCodecs.plain.tmp";
+    const char* codePath = "FileCodecs.code.tmp";
+    const char* decodedPath = "FileCodecs.decoded.tmp";
+    bool ok = false;
+    {
+        MappedFile plain;
+        ok = plain.Create(plainPath, message.size());
+        assert(ok);
+        std::memcpy(plain.GetData(), &message[0], message.size());
+    }
+    LfsrDivider crc32(DataIo::FromString("1 0000 0100 1100 0001 0001 1101 1011 0111"));
+    std::vector<uint64_t> reg;
+    ok = CrcFile(crc32, plainPath, reg);
+    assert(ok);
+    uint64_t expectedReg = 0;
+    crc32.Update(&expectedReg, &message[0], 8 * message.size());
+    assert(reg.size() == 1 && reg[0] == expectedReg);
+
+    HammingCodecs hamming(26);
+    size_t numCorrected = 0;
+    ok = HammingEncodeFile(hamming, plainPath, codePath);
+    assert(ok);
+    ok = HammingDecodeFile(hamming, codePath, decodedPath, message.size(), numCorrected);
+    assert(ok && numCorrected == 0);
+    MappedFile decoded;
+    ok = decoded.Open(decodedPath);
+    assert(ok);
+    assert(decoded.GetSize() == message.size());
+    assert(std::memcmp(decoded.GetData(), &message[0], message.size()) == 0);
+    decoded.Close();
+    ok = HammingDecodeFile(hamming, codePath, decodedPath, message.size() + 100, numCorrected);
+    assert(!ok);
+    std::remove(plainPath);
+    std::remove(codePath);
+    std::remove(decodedPath);
+    ok = CrcFile(crc32, plainPath, reg);
+    assert(!ok);
+
+    // Parallel and streamed forms give the same bytes as the serial ones.
+    ThreadPool pool(3);
+    std::vector<uint8_t> big(300001, 0);
+    for (size_t i = 0; i < big.size(); ++i)
+    {
+        big[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+    }
+    std::vector<uint8_t> code(GetEncodedSize(hamming, big.size()), 0);
+    HammingEncode(hamming, &big[0], big.size(), &code[0]);
+    {
+        MappedFile plain;
+        ok = plain.Create(plainPath, big.size());
+        assert(ok);
+        std::memcpy(plain.GetData(), &big[0], big.size());
+    }
+    ok = HammingEncodeFile(hamming, plainPath, codePath, pool);
+    assert(ok);
+    MappedFile mappedCode;
+    ok = mappedCode.Open(codePath);
+    assert(ok);
+    assert(mappedCode.GetSize() == code.size());
+    assert(std::memcmp(mappedCode.GetData(), &code[0], code.size()) == 0);
+    mappedCode.Close();
+    ok = HammingDecodeFile(hamming, codePath, decodedPath, big.size(), numCorrected, pool);
+    assert(ok);
+    ok = decoded.Open(decodedPath);
+    assert(ok);
+    assert(decoded.GetSize() == big.size());
+    assert(std::memcmp(decoded.GetData(), &big[0], big.size()) == 0);
+    decoded.Close();
+    std::remove(plainPath);
+    std::remove(codePath);
+    std::remove(decodedPath);
+
+    std::istringstream plainStream(std::string(big.begin(), big.end()));
+    std::ostringstream codeStream;
+    ok = HammingEncodeStream(hamming, plainStream, codeStream, pool);
+    assert(ok);
+    assert(codeStream.str() == std::string(code.begin(), code.end()));
+    std::string corrupted = codeStream.str();
+    corrupted[1000] ^= 0x10;
+    std::istringstream codeInput(corrupted);
+    std::ostringstream decodedStream;
+    ok = HammingDecodeStream(hamming, codeInput, decodedStream, pool, big.size(), numCorrected);
+    assert(ok && numCorrected == 1);
+    assert(decodedStream.str() == std::string(big.begin(), big.end()));
+    (void)ok;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "HammingCodecs.h"
+#include "LfsrDivider.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * Block-wise coding of byte buffers and memory-mapped files.
+ *
+ * A buffer is a bit sequence read least significant bit first (see
+ * BitView), which is the layout of packed words, so bytes reach the word
+ * kernels without conversion.  For Hamming coding the sequence is cut into
+ * message blocks of HammingCodecs::GetNumberOfMessageBits() bits, the last
+ * one padded with zeros, and the code blocks are written back to back.
+ */
+class FileCodecs
+{
+public:
+    /**
+     * @return The number of bytes of the code of a \c numBytes-byte message.
+     */
+    static size_t GetEncodedSize(const HammingCodecs& hamming, size_t numBytes);
+
+    /**
+     * @return The number of whole message bytes held by a \c numBytes-byte code.
+     */
+    static size_t GetDecodedSize(const HammingCodecs& hamming, size_t numBytes);
+
+    /**
+     * @param [in]  input      \c numBytes message bytes.
+     * @param [out] output     GetEncodedSize(hamming, numBytes) bytes.
+     */
+    static void HammingEncode(const HammingCodecs& hamming, const uint8_t* input, size_t numBytes, uint8_t* output);
+
+    /**
+     * Decode whole code blocks, correcting a single error per block.
+     * @param [in]  input            \c numBytes code bytes.
+     * @param [out] output           \c numOutputBytes message bytes, at most GetDecodedSize(hamming, numBytes).
+     * @return The number of blocks with an error.
+     */
+    static size_t HammingDecode(const HammingCodecs& hamming, const uint8_t* input, size_t numBytes,
+                                uint8_t* output, size_t numOutputBytes);
+
+    /**
+     * Divide the content of a file.
+     * @param [out] reg   the remainder, divider.GetNumberOfWords() words.
+     * @return false if the file cannot be read.
+     */
+    static bool CrcFile(const LfsrDivider& divider, const std::string& path, std::vector<uint64_t>& reg);
+
+    /**
+     * @return false if a file cannot be read or written.
+     */
+    static bool HammingEncodeFile(const HammingCodecs& hamming, const std::string& input, const std::string& output);
+
+    /**
+     * @param [in]  numBytes       the length of the original message, or DataIo::ALL_BITS for all whole bytes.
+     * @param [out] numCorrected   the number of blocks with an error.
+     * @return false if a file cannot be read or written, or is too short for \c numBytes.
+     */
+    static bool HammingDecodeFile(const HammingCodecs& hamming, const std::string& input, const std::string& output,
+                                  size_t numBytes, size_t& numCorrected);
+
+    /**
+     * Encode a file with chunks spread over \c pool, each written to its place in the output mapping.
+     * @return false if a file cannot be read or written.
+     */
+    static bool HammingEncodeFile(const HammingCodecs& hamming, const std::string& input, const std::string& output,
+                                  ThreadPool& pool);
+
+    /**
+     * Decode a file with chunks spread over \c pool, see HammingDecodeFile() above.
+     */
+    static bool HammingDecodeFile(const HammingCodecs& hamming, const std::string& input, const std::string& output,
+                                  size_t numBytes, size_t& numCorrected, ThreadPool& pool);
+
+    /**
+     * Encode a stream through an OrderedPipeline on \c pool.
+     * @return false if the output cannot be written.
+     */
+    static bool HammingEncodeStream(const HammingCodecs& hamming, std::istream& input, std::ostream& output,
+                                    ThreadPool& pool);
+
+    /**
+     * Decode a stream through an OrderedPipeline on \c pool; a trailing partial block is dropped.
+     * @param [in]  numBytes       the length of the original message, or DataIo::ALL_BITS for all whole bytes.
+     * @param [out] numCorrected   the number of blocks with an error.
+     * @return false if the output cannot be written.
+     */
+    static bool HammingDecodeStream(const HammingCodecs& hamming, std::istream& input, std::ostream& output,
+                                    ThreadPool& pool, size_t numBytes, size_t& numCorrected);
+
+    static void Test(void);
+
+private:
+    /**
+     * @return The number of bytes of a chunk of whole blocks of \c blockBits bits, about 64 KB.
+     */
+    static size_t GetChunkSize(size_t blockBits);
+};
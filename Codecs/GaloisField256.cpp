@@ -0,0 +1,279 @@
+#include "GaloisField256.h"
+#include "Simd.h"
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+    struct Tables
+    {
+        uint8_t exp[512];   ///< exp[n] = GENERATOR ^ n, doubled to skip the modulo.
+        uint8_t log[256];   ///< log[exp[n]] = n.
+
+        Tables(void)
+        {
+            unsigned a = 1;
+            for (size_t n = 0; n < 255; ++n)
+            {
+                exp[n] = static_cast<uint8_t>(a);
+                exp[n + 255] = static_cast<uint8_t>(a);
+                log[a] = static_cast<uint8_t>(n);
+                // a *= 0x03, i.e. a ^= a * x.
+                unsigned ax = a << 1;
+                if (ax & 0x100)
+                {
+                    ax ^= GaloisField256::POLYNOMIAL;
+                }
+                a ^= ax;
+            }
+            exp[510] = exp[0];
+            exp[511] = exp[1];
+            log[0] = 0;
+        }
+    };
+
+    const Tables& GetTables(void)
+    {
+        static const Tables tables;
+        return tables;
+    }
+}
+
+uint8_t GaloisField256::Add(uint8_t a, uint8_t b)
+{
+    return a ^ b;
+}
+
+uint8_t GaloisField256::Multiply(uint8_t a, uint8_t b)
+{
+    if (!a || !b)
+    {
+        return 0;
+    }
+    const Tables& t = GetTables();
+    return t.exp[t.log[a] + t.log[b]];
+}
+
+uint8_t GaloisField256::Divide(uint8_t a, uint8_t b)
+{
+    assert(b);
+    if (!a)
+    {
+        return 0;
+    }
+    const Tables& t = GetTables();
+    return t.exp[t.log[a] + 255 - t.log[b]];
+}
+
+uint8_t GaloisField256::Inverse(uint8_t a)
+{
+    return Divide(1, a);
+}
+
+uint8_t GaloisField256::Exp(size_t n)
+{
+    return GetTables().exp[n % 255];
+}
+
+size_t GaloisField256::Log(uint8_t a)
+{
+    assert(a);
+    return GetTables().log[a];
+}
+
+template <bool ACCUMULATE>
+void GaloisField256::MultiplyRegion(uint8_t c, const uint8_t* src, uint8_t* dst, size_t length)
+{
+    size_t i = 0;
+#if defined(CODECS_HAS_GFNI) && defined(CODECS_HAS_AVX2)
+    __m256i c32 = _mm256_set1_epi8(static_cast<char>(c));
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i p = _mm256_gf2p8mul_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), c32);
+        if (ACCUMULATE)
+        {
+            p = _mm256_xor_si256(p, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), p);
+    }
+#elif defined(CODECS_HAS_GFNI)
+    __m128i c16 = _mm_set1_epi8(static_cast<char>(c));
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i p = _mm_gf2p8mul_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), c16);
+        if (ACCUMULATE)
+        {
+            p = _mm_xor_si128(p, _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), p);
+    }
+#elif defined(CODECS_HAS_SSSE3)
+    // c * s = c * (s & 0x0F) ^ c * (s & 0xF0), each half looked up by PSHUFB.
+    uint8_t low[16];
+    uint8_t high[16];
+    for (unsigned n = 0; n < 16; ++n)
+    {
+        low[n] = Multiply(c, static_cast<uint8_t>(n));
+        high[n] = Multiply(c, static_cast<uint8_t>(n << 4));
+    }
+    __m128i low16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(low));
+    __m128i high16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(high));
+    __m128i mask16 = _mm_set1_epi8(0x0F);
+#if defined(CODECS_HAS_AVX2)
+    __m256i low32 = _mm256_broadcastsi128_si256(low16);
+    __m256i high32 = _mm256_broadcastsi128_si256(high16);
+    __m256i mask32 = _mm256_set1_epi8(0x0F);
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i p = _mm256_xor_si256(_mm256_shuffle_epi8(low32, _mm256_and_si256(s, mask32)),
+                                     _mm256_shuffle_epi8(high32, _mm256_and_si256(_mm256_srli_epi64(s, 4), mask32)));
+        if (ACCUMULATE)
+        {
+            p = _mm256_xor_si256(p, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), p);
+    }
+#endif
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i p = _mm_xor_si128(_mm_shuffle_epi8(low16, _mm_and_si128(s, mask16)),
+                                  _mm_shuffle_epi8(high16, _mm_and_si128(_mm_srli_epi64(s, 4), mask16)));
+        if (ACCUMULATE)
+        {
+            p = _mm_xor_si128(p, _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), p);
+    }
+#endif
+    // The tail, through the log and exp tables: no table of products to build.
+    const Tables& t = GetTables();
+    size_t logC = t.log[c];
+    for (; i < length; ++i)
+    {
+        uint8_t product = c && src[i] ? t.exp[logC + t.log[src[i]]] : 0;
+        dst[i] = ACCUMULATE ? dst[i] ^ product : product;
+    }
+}
+
+void GaloisField256::MultiplyRegion(uint8_t c, const uint8_t* src, uint8_t* dst, size_t length)
+{
+    MultiplyRegion<false>(c, src, dst, length);
+}
+
+void GaloisField256::MultiplyAddRegion(uint8_t c, const uint8_t* src, uint8_t* dst, size_t length)
+{
+    if (c)
+    {
+        MultiplyRegion<true>(c, src, dst, length);
+    }
+}
+
+bool GaloisField256::InvertMatrix(uint8_t* matrix, size_t n)
+{
+    // Augment with the identity: [M | I] -> [I | M^-1].
+    std::vector<uint8_t> work(n * 2 * n, 0);
+    for (size_t r = 0; r < n; ++r)
+    {
+        std::memcpy(&work[r * 2 * n], matrix + r * n, n);
+        work[r * 2 * n + n + r] = 1;
+    }
+    for (size_t c = 0; c < n; ++c)
+    {
+        // Find a pivot.
+        size_t p = c;
+        while (p < n && !work[p * 2 * n + c])
+        {
+            ++p;
+        }
+        if (p == n)
+        {
+            return false;
+        }
+        if (p != c)
+        {
+            for (size_t i = 0; i < 2 * n; ++i)
+            {
+                std::swap(work[p * 2 * n + i], work[c * 2 * n + i]);
+            }
+        }
+        // Normalize the pivot row.
+        uint8_t* pivot = &work[c * 2 * n];
+        MultiplyRegion(Inverse(pivot[c]), pivot, pivot, 2 * n);
+        // Eliminate the column from the other rows.
+        for (size_t r = 0; r < n; ++r)
+        {
+            if (r != c)
+            {
+                MultiplyAddRegion(work[r * 2 * n + c], pivot, &work[r * 2 * n], 2 * n);
+            }
+        }
+    }
+    for (size_t r = 0; r < n; ++r)
+    {
+        std::memcpy(matrix + r * n, &work[r * 2 * n + n], n);
+    }
+    return true;
+}
+
+void GaloisField256::Test(void)
+{
+    // Multiply, Divide, Inverse
+    assert(Multiply(0x57, 0x83) == 0xC1);
+    assert(Multiply(0x57, 0x13) == 0xFE);
+    assert(Multiply(0, 0x13) == 0);
+    for (unsigned a = 1; a < 256; ++a)
+    {
+        assert(Multiply(static_cast<uint8_t>(a), Inverse(static_cast<uint8_t>(a))) == 1);
+        assert(Exp(Log(static_cast<uint8_t>(a))) == a);
+        assert(Divide(Multiply(static_cast<uint8_t>(a), 0x35), 0x35) == a);
+    }
+
+    // MultiplyRegion, MultiplyAddRegion against the scalar multiply.
+    uint8_t src[100];
+    uint8_t dst[100];
+    for (size_t i = 0; i < 100; ++i)
+    {
+        src[i] = static_cast<uint8_t>(i * 29 + 7);
+        dst[i] = static_cast<uint8_t>(i);
+    }
+    MultiplyAddRegion(0xA7, src, dst, 100);
+    for (size_t i = 0; i < 100; ++i)
+    {
+        assert(dst[i] == (static_cast<uint8_t>(i) ^ Multiply(0xA7, src[i])));
+    }
+    MultiplyRegion(0x1D, src, dst, 100);
+    for (size_t i = 0; i < 100; ++i)
+    {
+        assert(dst[i] == Multiply(0x1D, src[i]));
+    }
+    MultiplyRegion(0, src, dst, 100);
+    for (size_t i = 0; i < 100; ++i)
+    {
+        assert(dst[i] == 0);
+    }
+
+    // InvertMatrix
+    uint8_t m[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 10 };
+    uint8_t inv[9];
+    std::memcpy(inv, m, 9);
+    bool invertible = InvertMatrix(inv, 3);
+    assert(invertible);
+    for (size_t r = 0; r < 3; ++r)
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            uint8_t sum = 0;
+            for (size_t i = 0; i < 3; ++i)
+            {
+                sum ^= Multiply(m[r * 3 + i], inv[i * 3 + c]);
+            }
+            assert(sum == (r == c ? 1 : 0));
+        }
+    }
+    uint8_t singular[4] = { 1, 2, 2, 4 };
+    invertible = InvertMatrix(singular, 2);
+    assert(!invertible);
+    (void)invertible;
+}
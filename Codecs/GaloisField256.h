@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Arithmetic in GF(2^8) = GF(2)[x] / (x^8 + x^4 + x^3 + x + 1).
+ *
+ * The modulus is the one built into GF2P8MULB, so that instruction is used
+ * for region multiplication when GFNI is available.  Otherwise regions are
+ * multiplied by split-nibble PSHUFB lookups (SSSE3/AVX2), or through the
+ * log/exp tables as the scalar fallback.
+ * Scalar multiplication uses the same log/exp tables, with the generator 0x03.
+ */
+class GaloisField256
+{
+public:
+    static const unsigned POLYNOMIAL = 0x11B;
+    static const unsigned GENERATOR = 0x03;
+
+    static uint8_t Add(uint8_t a, uint8_t b);
+    static uint8_t Multiply(uint8_t a, uint8_t b);
+
+    /**
+     * @param [in] b   b must not be zero.
+     */
+    static uint8_t Divide(uint8_t a, uint8_t b);
+
+    /**
+     * @param [in] a   a must not be zero.
+     */
+    static uint8_t Inverse(uint8_t a);
+
+    /**
+     * @return GENERATOR ^ n.
+     */
+    static uint8_t Exp(size_t n);
+
+    /**
+     * @param [in] a   a must not be zero.
+     * @return n such that GENERATOR ^ n == a, 0 <= n < 255.
+     */
+    static size_t Log(uint8_t a);
+
+    /**
+     * dst[i] = c * src[i], for 0 <= i < length.
+     */
+    static void MultiplyRegion(uint8_t c, const uint8_t* src, uint8_t* dst, size_t length);
+
+    /**
+     * dst[i] ^= c * src[i], for 0 <= i < length.
+     */
+    static void MultiplyAddRegion(uint8_t c, const uint8_t* src, uint8_t* dst, size_t length);
+
+    /**
+     * Invert an n x n row-major matrix in place by Gauss-Jordan elimination.
+     * @return false if the matrix is singular, in which case its content is unspecified.
+     */
+    static bool InvertMatrix(uint8_t* matrix, size_t n);
+
+    static void Test(void);
+
+private:
+    template <bool ACCUMULATE>
+    static void MultiplyRegion(uint8_t c, const uint8_t* src, uint8_t* dst, size_t length);
+};
@@ -1,7 +1,29 @@
 #include "HammingCodecs.h"
 #include "DataIo.h"
+#include "PackedBits.h"
+#include "ScratchArena.h"
+#include "BitTranspose.h"
+#include "Instrumentation.h"
+#include <algorithm>
 #include <cassert>
 
+#if defined(CODECS_INSTRUMENTATION)
+namespace
+{
+    /**
+     * @return The counter of the errors found at position \c e (1-based).
+     */
+    Instrumentation::Counter ClassifyError(size_t e, size_t numCodeBits)
+    {
+        if (!(e & (e - 1)))
+        {
+            return Instrumentation::CT_HAMMING_REDUNDANT_ERRORS;
+        }
+        return e <= numCodeBits ? Instrumentation::CT_HAMMING_MESSAGE_ERRORS : Instrumentation::CT_HAMMING_INVALID_SYNDROMES;
+    }
+}
+#endif
+
 HammingCodecs::HammingCodecs(size_t numMessageBits) :
     numMessageBits_(numMessageBits)
 {
@@ -10,6 +32,7 @@ HammingCodecs::HammingCodecs(size_t numMessageBits) :
     CalculateEncoder();
     CalculateChecker();
     CalculateDecoder();
+    CalculateBatchTables();
 }
 
 void HammingCodecs::CalculateNumberOfRedundantBits(void)
@@ -31,7 +54,8 @@ void HammingCodecs::CalculateEncoder(void)
     // Redundant bits are placed at $2^0 - 1, 2^1 - 1, 2^2 - 1, ...$.
     // The position of message bits.
     // The 'm'-th message bit is placed at the 'mbPos[m]'-th code bit.
-    std::vector<size_t> mbPos(numMessageBits_, 0);
+    ScratchArena::Scope scope;
+    std::vector<size_t, ScratchAllocator<size_t> > mbPos(numMessageBits_, 0);
     size_t p = 1;	// 2^0
     size_t c = 0;
     size_t m = 0;
@@ -88,9 +112,6 @@ void HammingCodecs::CalculateChecker(void)
     checker_ = BitMatrix(numRedundantBits_, numCodeBits);
     // The position of redundant bits.
     // Redundant bits are placed at $2^0 - 1, 2^1 - 1, 2^2 - 1, ...$.
-    // The position of message bits.
-    // The 'm'-th message bit is placed at the 'mbPos[m]'-th code bit.
-    std::vector<size_t> mbPos(numMessageBits_, 0);
     size_t r = 0;	// the 'r'-th redundant bit
     size_t p = 1;	// 2^r
     while (r < numRedundantBits_)
@@ -132,6 +153,46 @@ void HammingCodecs::CalculateDecoder(void)
     }
 }
 
+void HammingCodecs::CalculateBatchTables(void)
+{
+    size_t numCodeBits = GetNumberOfCodeBits();
+    encodeOffsets_.assign(1, 0);
+    for (size_t c = 0; c < numCodeBits; ++c)
+    {
+        for (size_t m = 0; m < numMessageBits_; ++m)
+        {
+            if (encoder_.Get(c, m))
+            {
+                encodeTaps_.push_back(static_cast<uint32_t>(m));
+            }
+        }
+        encodeOffsets_.push_back(static_cast<uint32_t>(encodeTaps_.size()));
+    }
+    checkOffsets_.assign(1, 0);
+    for (size_t r = 0; r < numRedundantBits_; ++r)
+    {
+        for (size_t c = 0; c < numCodeBits; ++c)
+        {
+            if (checker_.Get(r, c))
+            {
+                checkTaps_.push_back(static_cast<uint32_t>(c));
+            }
+        }
+        checkOffsets_.push_back(static_cast<uint32_t>(checkTaps_.size()));
+    }
+    messagePositions_.assign(numMessageBits_, 0);
+    for (size_t m = 0; m < numMessageBits_; ++m)
+    {
+        for (size_t c = 0; c < numCodeBits; ++c)
+        {
+            if (decoder_.Get(m, c))
+            {
+                messagePositions_[m] = static_cast<uint32_t>(c);
+            }
+        }
+    }
+}
+
 size_t HammingCodecs::GetNumberOfMessageBits(void) const
 {
     return numMessageBits_;
@@ -165,6 +226,7 @@ const BitMatrix& HammingCodecs::GetDecoderMatrix(void) const
 std::vector<bool> HammingCodecs::Encode(const std::vector<bool>& message) const
 {
     assert(message.size() == GetNumberOfMessageBits());
+    CODECS_COUNT(Instrumentation::CT_HAMMING_BLOCKS_ENCODED, 1);
     return encoder_.Multiply(message);
 }
 
@@ -188,11 +250,13 @@ size_t HammingCodecs::CheckError(const std::vector<bool>& code) const
 std::vector<bool> HammingCodecs::Decode(const std::vector<bool>& code) const
 {
     assert(code.size() == GetNumberOfCodeBits());
+    CODECS_COUNT(Instrumentation::CT_HAMMING_BLOCKS_DECODED, 1);
     std::vector<bool> result = decoder_.Multiply(code);
     // Correct error.
     size_t e = CheckError(code);    // the index of error bit (1-based) in the code bits
     if (e)
     {
+        CODECS_COUNT(ClassifyError(e, GetNumberOfCodeBits()), 1);
         size_t p = 1;	// 2^0
         size_t c = 0;
         size_t m = 0;
@@ -219,6 +283,300 @@ std::vector<bool> HammingCodecs::Decode(const std::vector<bool>& code) const
     return result;
 }
 
+void HammingCodecs::Encode(const uint64_t* message, uint64_t* code) const
+{
+    CODECS_COUNT(Instrumentation::CT_HAMMING_BLOCKS_ENCODED, 1);
+    encoder_.Multiply(message, code);
+}
+
+size_t HammingCodecs::CheckError(const uint64_t* code) const
+{
+    // The syndrome bits are the bits of the error position, least significant first.
+    assert(numRedundantBits_ <= PackedBits::WORD_BITS);
+    uint64_t syndrome = 0;
+    checker_.Multiply(code, &syndrome);
+    return static_cast<size_t>(syndrome);
+}
+
+void HammingCodecs::Decode(const uint64_t* code, uint64_t* message) const
+{
+    CODECS_COUNT(Instrumentation::CT_HAMMING_BLOCKS_DECODED, 1);
+    decoder_.Multiply(code, message);
+    size_t e = CheckError(code);
+    if (e)
+    {
+        CODECS_COUNT(ClassifyError(e, GetNumberOfCodeBits()), 1);
+    }
+    // Skip errors in redundant bits, at the powers of 2.
+    if (e & (e - 1))
+    {
+        // The message bits before position e are the positions that are not powers of 2.
+        size_t numRedundant = 0;
+        while ((size_t(1) << numRedundant) <= e)
+        {
+            ++numRedundant;
+        }
+        size_t m = e - 1 - numRedundant;
+        if (m < numMessageBits_)
+        {
+            PackedBits::FlipBit(message, m);
+        }
+    }
+}
+
+size_t HammingCodecs::Correct(uint64_t* code) const
+{
+    size_t e = CheckError(code);
+    if (e)
+    {
+        CODECS_COUNT(ClassifyError(e, GetNumberOfCodeBits()), 1);
+    }
+    if (e && e <= GetNumberOfCodeBits())
+    {
+        PackedBits::FlipBit(code, e - 1);
+    }
+    return e;
+}
+
+void HammingCodecs::ExtractMessage(const uint64_t* code, uint64_t* message) const
+{
+    decoder_.Multiply(code, message);
+}
+
+size_t HammingCodecs::GetScratchSize(void) const
+{
+    // Slices, then one batch of message blocks and one of code blocks for the tail.
+    return 2 * (numMessageBits_ + GetNumberOfCodeBits());
+}
+
+void HammingCodecs::EncodeBatch(const uint64_t* message, size_t messageFirst, uint64_t* code, size_t codeFirst,
+                                uint64_t* slices) const
+{
+    // Word m of messageSlices holds message bit m of the 64 blocks.
+    size_t numCodeBits = GetNumberOfCodeBits();
+    uint64_t* messageSlices = slices;
+    uint64_t* codeSlices = slices + numMessageBits_;
+    BitTranspose::TransposeContiguous(message, messageFirst, 64, numMessageBits_, messageSlices, 0);
+    for (size_t c = 0; c < numCodeBits; ++c)
+    {
+        uint64_t sum = 0;
+        for (uint32_t t = encodeOffsets_[c]; t < encodeOffsets_[c + 1]; ++t)
+        {
+            sum ^= messageSlices[encodeTaps_[t]];
+        }
+        codeSlices[c] = sum;
+    }
+    BitTranspose::TransposeContiguous(codeSlices, 0, numCodeBits, 64, code, codeFirst);
+}
+
+size_t HammingCodecs::DecodeBatch(const uint64_t* code, size_t codeFirst, uint64_t* message, size_t messageFirst,
+                                  size_t* errors, uint64_t* slices) const
+{
+    size_t numCodeBits = GetNumberOfCodeBits();
+    uint64_t* messageSlices = slices;
+    uint64_t* codeSlices = slices + numMessageBits_;
+    BitTranspose::TransposeContiguous(code, codeFirst, 64, numCodeBits, codeSlices, 0);
+    for (size_t m = 0; m < numMessageBits_; ++m)
+    {
+        messageSlices[m] = codeSlices[messagePositions_[m]];
+    }
+    // Bit b of syndrome[r] is bit r of the error position of block b.
+    uint64_t syndrome[64];
+    uint64_t wrong = 0;
+    for (size_t r = 0; r < numRedundantBits_; ++r)
+    {
+        uint64_t sum = 0;
+        for (uint32_t t = checkOffsets_[r]; t < checkOffsets_[r + 1]; ++t)
+        {
+            sum ^= codeSlices[checkTaps_[t]];
+        }
+        syndrome[r] = sum;
+        wrong |= sum;
+    }
+    if (errors)
+    {
+        std::fill(errors, errors + 64, 0);
+    }
+    size_t numErrors = 0;
+    for (; wrong; wrong &= wrong - 1)
+    {
+        unsigned b = PackedBits::CountTrailingZeros(wrong);
+        size_t e = 0;
+        for (size_t r = 0; r < numRedundantBits_; ++r)
+        {
+            e |= static_cast<size_t>((syndrome[r] >> b) & 1) << r;
+        }
+        if (errors)
+        {
+            errors[b] = e;
+        }
+        ++numErrors;
+        CODECS_COUNT(ClassifyError(e, numCodeBits), 1);
+        // Errors in redundant bits, at the powers of 2, leave the message intact.
+        if (e & (e - 1))
+        {
+            size_t numRedundant = 0;
+            while ((size_t(1) << numRedundant) <= e)
+            {
+                ++numRedundant;
+            }
+            size_t m = e - 1 - numRedundant;
+            if (m < numMessageBits_)
+            {
+                messageSlices[m] ^= uint64_t(1) << b;
+            }
+        }
+    }
+    BitTranspose::TransposeContiguous(messageSlices, 0, numMessageBits_, 64, message, messageFirst);
+    return numErrors;
+}
+
+void HammingCodecs::EncodeBlocks(const uint64_t* message, size_t numBlocks, uint64_t* code) const
+{
+    std::vector<uint64_t> scratch(GetScratchSize(), 0);
+    EncodeBlocks(message, numBlocks, code, &scratch[0]);
+}
+
+void HammingCodecs::EncodeBlocks(const uint64_t* message, size_t numBlocks, uint64_t* code, uint64_t* scratch) const
+{
+    CODECS_TIME(Instrumentation::OP_HAMMING_ENCODE_BLOCKS);
+    CODECS_COUNT(Instrumentation::CT_HAMMING_BLOCKS_ENCODED, numBlocks);
+    size_t numCodeBits = GetNumberOfCodeBits();
+    uint64_t* slices = scratch;
+    size_t b = 0;
+    for (; b + 64 <= numBlocks; b += 64)
+    {
+        EncodeBatch(message, b * numMessageBits_, code, b * numCodeBits, slices);
+    }
+    if (b < numBlocks)
+    {
+        // Pad the last batch with zero blocks.
+        size_t numLeft = numBlocks - b;
+        uint64_t* tailMessage = scratch + numMessageBits_ + numCodeBits;
+        uint64_t* tailCode = tailMessage + numMessageBits_;
+        std::fill(tailMessage, tailMessage + numMessageBits_, 0);
+        PackedBits::CopyBits(message, b * numMessageBits_, tailMessage, 0, numLeft * numMessageBits_);
+        EncodeBatch(tailMessage, 0, tailCode, 0, slices);
+        PackedBits::CopyBits(tailCode, 0, code, b * numCodeBits, numLeft * numCodeBits);
+    }
+}
+
+size_t HammingCodecs::DecodeBlocks(const uint64_t* code, size_t numBlocks, uint64_t* message, size_t* errors) const
+{
+    std::vector<uint64_t> scratch(GetScratchSize(), 0);
+    return DecodeBlocks(code, numBlocks, message, errors, &scratch[0]);
+}
+
+size_t HammingCodecs::DecodeBlocks(const uint64_t* code, size_t numBlocks, uint64_t* message, size_t* errors,
+                                   uint64_t* scratch) const
+{
+    CODECS_TIME(Instrumentation::OP_HAMMING_DECODE_BLOCKS);
+    CODECS_COUNT(Instrumentation::CT_HAMMING_BLOCKS_DECODED, numBlocks);
+    size_t numCodeBits = GetNumberOfCodeBits();
+    uint64_t* slices = scratch;
+    size_t numErrors = 0;
+    size_t b = 0;
+    for (; b + 64 <= numBlocks; b += 64)
+    {
+        numErrors += DecodeBatch(code, b * numCodeBits, message, b * numMessageBits_,
+                                 errors ? errors + b : nullptr, slices);
+    }
+    if (b < numBlocks)
+    {
+        size_t numLeft = numBlocks - b;
+        uint64_t* tailMessage = scratch + numMessageBits_ + numCodeBits;
+        uint64_t* tailCode = tailMessage + numMessageBits_;
+        size_t tailErrors[64];
+        std::fill(tailCode, tailCode + numCodeBits, 0);
+        PackedBits::CopyBits(code, b * numCodeBits, tailCode, 0, numLeft * numCodeBits);
+        numErrors += DecodeBatch(tailCode, 0, tailMessage, 0, tailErrors, slices);
+        PackedBits::CopyBits(tailMessage, 0, message, b * numMessageBits_, numLeft * numMessageBits_);
+        if (errors)
+        {
+            std::copy(tailErrors, tailErrors + numLeft, errors + b);
+        }
+    }
+    return numErrors;
+}
+
+size_t HammingCodecs::GetFrameLength(size_t numBits) const
+{
+    size_t numBlocks = (numBits + LENGTH_BITS + numMessageBits_ - 1) / numMessageBits_;
+    return numBlocks * GetNumberOfCodeBits();
+}
+
+void HammingCodecs::EncodeFrame(const uint64_t* message, size_t numBits, uint64_t* code) const
+{
+    size_t numCodeBits = GetNumberOfCodeBits();
+    size_t numBlocks = GetFrameLength(numBits) / numCodeBits;
+    std::fill(code, code + PackedBits::GetNumberOfWords(numBlocks * numCodeBits), 0);
+    // Blocks made of message bits only are encoded in place; the others go through a copy
+    // holding the end of the message, the padding and the length.
+    size_t numFull = numBits / numMessageBits_;
+    EncodeBlocks(message, numFull, code);
+    size_t numTail = numBlocks - numFull;
+    std::vector<uint64_t> tail(PackedBits::GetNumberOfWords(numTail * numMessageBits_), 0);
+    PackedBits::CopyBits(message, numFull * numMessageBits_, &tail[0], 0, numBits - numFull * numMessageBits_);
+    PackedBits::InsertBits(&tail[0], numTail * numMessageBits_ - LENGTH_BITS, numBits, LENGTH_BITS);
+    std::vector<uint64_t> tailCode(PackedBits::GetNumberOfWords(numTail * numCodeBits) + 1, 0);
+    EncodeBlocks(&tail[0], numTail, &tailCode[0]);
+    PackedBits::CopyBits(&tailCode[0], 0, code, numFull * numCodeBits, numTail * numCodeBits);
+}
+
+bool HammingCodecs::DecodeFrame(const uint64_t* code, size_t numCodeBits, std::vector<uint64_t>& message,
+                                size_t& numBits, std::vector<uint8_t>& corrections) const
+{
+    size_t numBlocks = numCodeBits / GetNumberOfCodeBits();
+    size_t capacity = numBlocks * numMessageBits_;
+    if (numCodeBits % GetNumberOfCodeBits() != 0 || capacity < LENGTH_BITS)
+    {
+        return false;
+    }
+    message.assign(PackedBits::GetNumberOfWords(capacity) + 1, 0);
+    std::vector<size_t> errors(numBlocks, 0);
+    DecodeBlocks(code, numBlocks, &message[0], &errors[0]);
+    numBits = static_cast<size_t>(PackedBits::ExtractBits(&message[0], capacity - LENGTH_BITS, LENGTH_BITS));
+    if (numBits > capacity - LENGTH_BITS || GetFrameLength(numBits) != numCodeBits)
+    {
+        return false;
+    }
+    corrections.assign(numBlocks, 0);
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+        corrections[b] = errors[b] ? 1 : 0;
+    }
+    // Drop the padding and the length.
+    message.resize(PackedBits::GetNumberOfWords(numBits));
+    if (numBits % PackedBits::WORD_BITS)
+    {
+        message.back() &= PackedBits::GetLowMask(numBits % PackedBits::WORD_BITS);
+    }
+    return true;
+}
+
+std::vector<bool> HammingCodecs::EncodeFrame(const std::vector<bool>& message) const
+{
+    std::vector<uint64_t> packed = PackedBits::FromVector(message);
+    size_t numCodeBits = GetFrameLength(message.size());
+    std::vector<uint64_t> code(PackedBits::GetNumberOfWords(numCodeBits), 0);
+    EncodeFrame(packed.empty() ? nullptr : &packed[0], message.size(), &code[0]);
+    return PackedBits::ToVector(&code[0], numCodeBits);
+}
+
+bool HammingCodecs::DecodeFrame(const std::vector<bool>& code, std::vector<bool>& message,
+                                std::vector<uint8_t>& corrections) const
+{
+    std::vector<uint64_t> packed = PackedBits::FromVector(code);
+    std::vector<uint64_t> words;
+    size_t numBits = 0;
+    if (packed.empty() || !DecodeFrame(&packed[0], code.size(), words, numBits, corrections))
+    {
+        return false;
+    }
+    message = PackedBits::ToVector(words.empty() ? nullptr : &words[0], numBits);
+    return true;
+}
+
 #include <string>
 #include <iostream>
 void HammingCodecs::Test(void)
@@ -271,6 +629,7 @@ void HammingCodecs::Test(void)
     code = DataIo::FromString("1111 0101 1010");
     err = hc8.CheckError(code);
     assert(err == 8);
+    (void)err;
 
     // Decode
     msg = DataIo::FromString("1010 1010");
@@ -348,4 +707,108 @@ void HammingCodecs::Test(void)
     msg = DataIo::FromString("1010 1010 1010");
     code = DataIo::FromString("1 0110 1101 0101 0100");
     assert(msg == hc12.Decode(code));
+
+    // Packed blocks agree with the bit vectors for every single error.
+    for (size_t k = 1; k <= 70; k += 23)
+    {
+        HammingCodecs hc(k);
+        std::vector<bool> message(k, false);
+        for (size_t i = 0; i < k; i += 3)
+        {
+            message[i] = true;
+        }
+        std::vector<uint64_t> packedMessage = PackedBits::FromVector(message);
+        std::vector<uint64_t> packedCode(PackedBits::GetNumberOfWords(hc.GetNumberOfCodeBits()), 0);
+        hc.Encode(&packedMessage[0], &packedCode[0]);
+        assert(PackedBits::ToVector(&packedCode[0], hc.GetNumberOfCodeBits()) == hc.Encode(message));
+        for (size_t e = 0; e <= hc.GetNumberOfCodeBits(); ++e)
+        {
+            std::vector<uint64_t> corrupted = packedCode;
+            if (e)
+            {
+                PackedBits::FlipBit(&corrupted[0], e - 1);
+            }
+            assert(hc.CheckError(&corrupted[0]) == e);
+            std::vector<uint64_t> corrected = corrupted;
+            size_t position = hc.Correct(&corrected[0]);
+            assert(position == e);
+            (void)position;
+            assert(corrected == packedCode);
+            std::vector<uint64_t> decoded(packedMessage.size(), ~uint64_t(0));
+            hc.Decode(&corrupted[0], &decoded[0]);
+            assert(decoded == packedMessage);
+        }
+    }
+
+    // Batches of blocks agree with single blocks, with one error in some blocks.
+    for (size_t k = 1; k <= 130; k += 43)
+    {
+        HammingCodecs hc(k);
+        size_t n = hc.GetNumberOfCodeBits();
+        const size_t numBlocks = 150;
+        std::vector<uint64_t> messages(PackedBits::GetNumberOfWords(numBlocks * k) + 1, 0);
+        uint64_t x = 0x2545F4914F6CDD1DULL;
+        for (size_t w = 0; w < messages.size() - 1; ++w)
+        {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            messages[w] = x;
+        }
+        messages[messages.size() - 2] &= PackedBits::GetLowMask((numBlocks * k) % 64 ? (numBlocks * k) % 64 : 64);
+        std::vector<uint64_t> codes(PackedBits::GetNumberOfWords(numBlocks * n) + 1, 0);
+        hc.EncodeBlocks(&messages[0], numBlocks, &codes[0]);
+        std::vector<uint64_t> block(PackedBits::GetNumberOfWords(n) + 1, 0);
+        std::vector<uint64_t> expected(PackedBits::GetNumberOfWords(n) + 1, 0);
+        for (size_t b = 0; b < numBlocks; ++b)
+        {
+            std::fill(block.begin(), block.end(), 0);
+            PackedBits::CopyBits(&messages[0], b * k, &block[0], 0, k);
+            hc.Encode(&block[0], &expected[0]);
+            for (size_t i = 0; i < n; ++i)
+            {
+                assert(PackedBits::GetBit(&codes[0], b * n + i) == PackedBits::GetBit(&expected[0], i));
+            }
+        }
+        for (size_t b = 0; b < numBlocks; b += 3)
+        {
+            PackedBits::FlipBit(&codes[0], b * n + (b * 7) % n);
+        }
+        std::vector<uint64_t> decoded(messages.size(), 0);
+        std::vector<size_t> errors(numBlocks, 0);
+        size_t numCorrected = hc.DecodeBlocks(&codes[0], numBlocks, &decoded[0], &errors[0]);
+        assert(numCorrected == (numBlocks + 2) / 3);
+        (void)numCorrected;
+        assert(decoded == messages);
+        for (size_t b = 0; b < numBlocks; ++b)
+        {
+            assert(errors[b] == (b % 3 ? 0 : (b * 7) % n + 1));
+        }
+
+        // Frames of any length, up to the bits of the messages.
+        for (size_t numBits = 0; numBits < 300 && numBits <= 64 * messages.size(); numBits += 37)
+        {
+            std::vector<bool> message(numBits, false);
+            for (size_t i = 0; i < numBits; ++i)
+            {
+                message[i] = PackedBits::GetBit(&messages[0], i);
+            }
+            std::vector<bool> frame = hc.EncodeFrame(message);
+            assert(frame.size() == hc.GetFrameLength(numBits));
+            assert(frame.size() % n == 0);
+            frame[frame.size() / 2] = !frame[frame.size() / 2];
+            std::vector<bool> result;
+            std::vector<uint8_t> corrections;
+            bool ok = hc.DecodeFrame(frame, result, corrections);
+            assert(ok && result == message);
+            (void)ok;
+            assert(corrections.size() == frame.size() / n);
+            assert(corrections[frame.size() / 2 / n] == 1);
+        }
+    }
+    std::vector<bool> result;
+    std::vector<uint8_t> corrections;
+    bool ok = hc8.DecodeFrame(std::vector<bool>(13, false), result, corrections);
+    assert(!ok);
+    (void)ok;
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "BitMatrix.h"
+#include <cstdint>
 #include <vector>
 
 class HammingCodecs
@@ -33,11 +34,130 @@ public:
      */
     std::vector<bool> Decode(const std::vector<bool>& code) const;
 
+    /**
+     * Encode a packed message block (see PackedBits).
+     * @param [in]  message   (GetNumberOfMessageBits() + 63) / 64 words.
+     * @param [out] code      (GetNumberOfCodeBits() + 63) / 64 words.
+     */
+    void Encode(const uint64_t* message, uint64_t* code) const;
+
+    /**
+     * @param [in] code   (GetNumberOfCodeBits() + 63) / 64 words.
+     *
+     * @return If there's no error, 0 is returned.
+     *         Otherwise, the index (1-based) of the error bit is returned.
+     */
+    size_t CheckError(const uint64_t* code) const;
+
+    /**
+     * Decode a packed code block, correcting a single error.
+     * @param [in]  code      (GetNumberOfCodeBits() + 63) / 64 words.
+     * @param [out] message   (GetNumberOfMessageBits() + 63) / 64 words.
+     */
+    void Decode(const uint64_t* code, uint64_t* message) const;
+
+    /**
+     * Correct a single error of a packed code block in place.
+     * @param [in,out] code   (GetNumberOfCodeBits() + 63) / 64 words.
+     * @return The error position as returned by CheckError().
+     */
+    size_t Correct(uint64_t* code) const;
+
+    /**
+     * Extract the message bits of a packed code block, without correction.
+     * @param [in]  code      (GetNumberOfCodeBits() + 63) / 64 words.
+     * @param [out] message   (GetNumberOfMessageBits() + 63) / 64 words.
+     */
+    void ExtractMessage(const uint64_t* code, uint64_t* message) const;
+
+    /**
+     * @return The number of words of scratch used by EncodeBlocks() and DecodeBlocks().
+     */
+    size_t GetScratchSize(void) const;
+
+    /**
+     * Encode \c numBlocks message blocks stored back to back.
+     * Blocks are coded 64 at a time on bit slices (see BitTranspose).
+     * @param [in]  message   numBlocks * GetNumberOfMessageBits() bits.
+     * @param [out] code      numBlocks * GetNumberOfCodeBits() bits; bits after them are preserved.
+     */
+    void EncodeBlocks(const uint64_t* message, size_t numBlocks, uint64_t* code) const;
+
+    /**
+     * EncodeBlocks() without allocation.
+     * @param [in] scratch   GetScratchSize() words.
+     */
+    void EncodeBlocks(const uint64_t* message, size_t numBlocks, uint64_t* code, uint64_t* scratch) const;
+
+    /**
+     * Decode \c numBlocks code blocks stored back to back, correcting a single error per block.
+     * @param [in]  code      numBlocks * GetNumberOfCodeBits() bits.
+     * @param [out] message   numBlocks * GetNumberOfMessageBits() bits; bits after them are preserved.
+     * @param [out] errors    numBlocks error positions as returned by CheckError(), or nullptr.
+     * @return The number of blocks with an error.
+     */
+    size_t DecodeBlocks(const uint64_t* code, size_t numBlocks, uint64_t* message, size_t* errors) const;
+
+    /**
+     * DecodeBlocks() without allocation.
+     * @param [in] scratch   GetScratchSize() words.
+     */
+    size_t DecodeBlocks(const uint64_t* code, size_t numBlocks, uint64_t* message, size_t* errors,
+                        uint64_t* scratch) const;
+
+    /**
+     * @return The number of code bits of the frame of a \c numBits-bit message.
+     */
+    size_t GetFrameLength(size_t numBits) const;
+
+    /**
+     * Encode a message of any length as a frame of whole blocks: the message,
+     * zero padding, then its length in the last LENGTH_BITS bits.
+     * @param [in]  message   a packed bit sequence.
+     * @param [in]  numBits   the number of bits of \c message.
+     * @param [out] code      GetFrameLength(numBits) bits, the unused bits of the last word cleared.
+     */
+    void EncodeFrame(const uint64_t* message, size_t numBits, uint64_t* code) const;
+
+    /**
+     * Decode a frame made by EncodeFrame().
+     * @param [in]  code          a packed bit sequence.
+     * @param [in]  numCodeBits   the number of bits of \c code, a multiple of GetNumberOfCodeBits().
+     * @param [out] message       the message, resized to fit.
+     * @param [out] numBits       the number of bits of \c message.
+     * @param [out] corrections   the number of corrected bits (0 or 1) of each block.
+     * @return false if the frame is malformed.
+     */
+    bool DecodeFrame(const uint64_t* code, size_t numCodeBits, std::vector<uint64_t>& message, size_t& numBits,
+                     std::vector<uint8_t>& corrections) const;
+
+    std::vector<bool> EncodeFrame(const std::vector<bool>& message) const;
+    bool DecodeFrame(const std::vector<bool>& code, std::vector<bool>& message, std::vector<uint8_t>& corrections) const;
+
+    /// The number of bits of the length at the end of a frame.
+    static const size_t LENGTH_BITS = 64;
+
 private:
     void CalculateNumberOfRedundantBits(void);
     void CalculateEncoder(void);
     void CalculateChecker(void);
     void CalculateDecoder(void);
+    void CalculateBatchTables(void);
+
+    /**
+     * Encode 64 blocks, from bit \c messageFirst of \c message to bit \c codeFirst of \c code.
+     * @param [in] slices   GetNumberOfMessageBits() + GetNumberOfCodeBits() words of scratch.
+     */
+    void EncodeBatch(const uint64_t* message, size_t messageFirst, uint64_t* code, size_t codeFirst,
+                     uint64_t* slices) const;
+
+    /**
+     * Decode 64 blocks, from bit \c codeFirst of \c code to bit \c messageFirst of \c message.
+     * @param [in] slices   GetNumberOfMessageBits() + GetNumberOfCodeBits() words of scratch.
+     * @return The number of blocks with an error.
+     */
+    size_t DecodeBatch(const uint64_t* code, size_t codeFirst, uint64_t* message, size_t messageFirst,
+                       size_t* errors, uint64_t* slices) const;
 
 public:
     static void Test(void);
@@ -48,4 +168,9 @@ private:
     BitMatrix encoder_;
     BitMatrix checker_;
     BitMatrix decoder_;
+    std::vector<uint32_t> encodeTaps_;      ///< the message bits summed into each code bit.
+    std::vector<uint32_t> encodeOffsets_;   ///< where the taps of each code bit start, plus the end.
+    std::vector<uint32_t> checkTaps_;       ///< the code bits summed into each syndrome bit.
+    std::vector<uint32_t> checkOffsets_;    ///< where the taps of each syndrome bit start, plus the end.
+    std::vector<uint32_t> messagePositions_;    ///< the code bit carrying each message bit.
 };
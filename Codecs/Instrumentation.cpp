@@ -0,0 +1,337 @@
+#include "Instrumentation.h"
+#include <cassert>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace
+{
+    const char* const COUNTER_NAMES[] =
+    {
+        "hamming.blocks_encoded",
+        "hamming.blocks_decoded",
+        "hamming.message_errors",
+        "hamming.redundant_errors",
+        "hamming.invalid_syndromes",
+        "hamming.bytes_encoded",
+        "hamming.bytes_decoded",
+        "crc.bytes",
+        "crc.checks",
+        "crc.mismatches",
+    };
+
+    const char* const OPERATION_NAMES[] =
+    {
+        "hamming.encode_blocks",
+        "hamming.decode_blocks",
+        "polynomial.divide",
+        "file.crc",
+        "hamming.encode_buffer",
+        "hamming.decode_buffer",
+    };
+
+    size_t GetBucket(uint64_t ns)
+    {
+        size_t b = 0;
+        while (ns)
+        {
+            ++b;
+            ns >>= 1;
+        }
+        return b < Instrumentation::NUM_BUCKETS ? b : Instrumentation::NUM_BUCKETS - 1;
+    }
+}
+
+/**
+ * The blocks of live threads and the sums of the exited ones.
+ */
+class Instrumentation::Registry
+{
+public:
+    /**
+     * The block of a thread, registered for its lifetime.
+     */
+    struct Local
+    {
+        Block block;
+
+        Local(void)
+        {
+            Clear(block);
+            Registry::Get().Add(&block);
+        }
+
+        ~Local(void)
+        {
+            Registry::Get().Remove(&block);
+        }
+    };
+
+    static Registry& Get(void)
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    void Add(Block* block)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        blocks_.push_back(block);
+    }
+
+    void Remove(Block* block)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Merge(*block, retired_);
+        for (size_t i = 0; i < blocks_.size(); ++i)
+        {
+            if (blocks_[i] == block)
+            {
+                blocks_.erase(blocks_.begin() + i);
+                break;
+            }
+        }
+    }
+
+    Snapshot TakeSnapshot(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Snapshot snapshot = retired_;
+        for (size_t i = 0; i < blocks_.size(); ++i)
+        {
+            Merge(*blocks_[i], snapshot);
+        }
+        return snapshot;
+    }
+
+    void Reset(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        retired_ = Snapshot();
+        for (size_t i = 0; i < blocks_.size(); ++i)
+        {
+            Clear(*blocks_[i]);
+        }
+    }
+
+private:
+    Registry(void) : retired_() {}
+
+    static void Clear(Block& block)
+    {
+        for (size_t c = 0; c < CT_COUNT; ++c)
+        {
+            block.counters[c].store(0, std::memory_order_relaxed);
+        }
+        for (size_t op = 0; op < OP_COUNT; ++op)
+        {
+            for (size_t b = 0; b < NUM_BUCKETS; ++b)
+            {
+                block.buckets[op][b].store(0, std::memory_order_relaxed);
+            }
+            block.totalNs[op].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static void Merge(const Block& block, Snapshot& snapshot)
+    {
+        for (size_t c = 0; c < CT_COUNT; ++c)
+        {
+            snapshot.counters[c] += block.counters[c].load(std::memory_order_relaxed);
+        }
+        for (size_t op = 0; op < OP_COUNT; ++op)
+        {
+            for (size_t b = 0; b < NUM_BUCKETS; ++b)
+            {
+                snapshot.buckets[op][b] += block.buckets[op][b].load(std::memory_order_relaxed);
+            }
+            snapshot.totalNs[op] += block.totalNs[op].load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<Block*> blocks_;
+    Snapshot retired_;
+};
+
+Instrumentation::Block& Instrumentation::GetLocal(void)
+{
+    static thread_local Registry::Local local;
+    return local.block;
+}
+
+bool Instrumentation::IsEnabled(void)
+{
+#if defined(CODECS_INSTRUMENTATION)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Instrumentation::Record(Operation op, uint64_t ns)
+{
+    Block& block = GetLocal();
+    std::atomic<uint64_t>& bucket = block.buckets[op][GetBucket(ns)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    block.totalNs[op].store(block.totalNs[op].load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+}
+
+Instrumentation::Snapshot Instrumentation::TakeSnapshot(void)
+{
+    return Registry::Get().TakeSnapshot();
+}
+
+void Instrumentation::Reset(void)
+{
+    Registry::Get().Reset();
+}
+
+const char* Instrumentation::GetName(Counter counter)
+{
+    assert(counter < CT_COUNT);
+    return COUNTER_NAMES[counter];
+}
+
+const char* Instrumentation::GetName(Operation op)
+{
+    assert(op < OP_COUNT);
+    return OPERATION_NAMES[op];
+}
+
+uint64_t Instrumentation::Snapshot::GetCount(Operation op) const
+{
+    uint64_t count = 0;
+    for (size_t b = 0; b < NUM_BUCKETS; ++b)
+    {
+        count += buckets[op][b];
+    }
+    return count;
+}
+
+uint64_t Instrumentation::Snapshot::GetQuantile(Operation op, double q) const
+{
+    uint64_t count = GetCount(op);
+    uint64_t seen = 0;
+    for (size_t b = 0; b < NUM_BUCKETS; ++b)
+    {
+        seen += buckets[op][b];
+        if (seen && seen >= q * count)
+        {
+            return b ? uint64_t(1) << b : 0;
+        }
+    }
+    return 0;
+}
+
+void Instrumentation::Snapshot::WriteText(std::ostream& os) const
+{
+    os << "Counters:" << std::endl;
+    for (size_t c = 0; c < CT_COUNT; ++c)
+    {
+        os << "  " << std::left << std::setw(28) << COUNTER_NAMES[c] << std::right
+           << std::setw(16) << counters[c] << std::endl;
+    }
+    os << "Operations:" << std::left << std::setw(19) << "" << std::right << std::setw(12) << "count"
+       << std::setw(14) << "mean ns" << std::setw(14) << "p50 ns <" << std::setw(14) << "p99 ns <" << std::endl;
+    for (size_t op = 0; op < OP_COUNT; ++op)
+    {
+        Operation o = static_cast<Operation>(op);
+        uint64_t count = GetCount(o);
+        if (!count)
+        {
+            continue;
+        }
+        os << "  " << std::left << std::setw(28) << OPERATION_NAMES[op] << std::right
+           << std::setw(12) << count << std::setw(14) << totalNs[op] / count
+           << std::setw(14) << GetQuantile(o, 0.5) << std::setw(14) << GetQuantile(o, 0.99) << std::endl;
+    }
+}
+
+void Instrumentation::Snapshot::WriteJson(std::ostream& os) const
+{
+    os << "{\n  \"enabled\": " << (IsEnabled() ? "true" : "false") << ",\n  \"counters\": {";
+    for (size_t c = 0; c < CT_COUNT; ++c)
+    {
+        os << (c ? ",\n" : "\n") << "    \"" << COUNTER_NAMES[c] << "\": " << counters[c];
+    }
+    os << "\n  },\n  \"operations\": {";
+    for (size_t op = 0; op < OP_COUNT; ++op)
+    {
+        Operation o = static_cast<Operation>(op);
+        os << (op ? ",\n" : "\n") << "    \"" << OPERATION_NAMES[op] << "\": {\"count\": " << GetCount(o)
+           << ", \"total_ns\": " << totalNs[op] << ", \"p50_ns\": " << GetQuantile(o, 0.5)
+           << ", \"p99_ns\": " << GetQuantile(o, 0.99) << ", \"buckets\": [";
+        // Trailing empty buckets are left out.
+        size_t numBuckets = NUM_BUCKETS;
+        while (numBuckets && !buckets[op][numBuckets - 1])
+        {
+            --numBuckets;
+        }
+        for (size_t b = 0; b < numBuckets; ++b)
+        {
+            os << (b ? ", " : "") << buckets[op][b];
+        }
+        os << "]}";
+    }
+    os << "\n  }\n}\n";
+}
+
+#include "HammingCodecs.h"
+#include <sstream>
+#include <thread>
+void Instrumentation::Test(void)
+{
+    assert(sizeof (COUNTER_NAMES) / sizeof (COUNTER_NAMES[0]) == CT_COUNT);
+    assert(sizeof (OPERATION_NAMES) / sizeof (OPERATION_NAMES[0]) == OP_COUNT);
+    assert(GetBucket(0) == 0 && GetBucket(1) == 1 && GetBucket(1000) == 10);
+
+    // Counts of this thread and of exited threads are merged.
+    Reset();
+    Add(CT_CRC_CHECKS, 3);
+    Record(OP_POLYNOMIAL_DIVIDE, 1000);
+    std::thread t([](void)
+    {
+        Add(CT_CRC_CHECKS, 4);
+        Add(CT_CRC_MISMATCHES, 1);
+        Record(OP_POLYNOMIAL_DIVIDE, 3);
+    });
+    t.join();
+    Snapshot s = TakeSnapshot();
+    assert(s.counters[CT_CRC_CHECKS] == 7);
+    assert(s.counters[CT_CRC_MISMATCHES] == 1);
+    assert(s.GetCount(OP_POLYNOMIAL_DIVIDE) == 2);
+    assert(s.totalNs[OP_POLYNOMIAL_DIVIDE] == 1003);
+    assert(s.GetQuantile(OP_POLYNOMIAL_DIVIDE, 0.5) == 4);
+    assert(s.GetQuantile(OP_POLYNOMIAL_DIVIDE, 0.99) == 1024);
+
+    std::ostringstream text;
+    s.WriteText(text);
+    assert(text.str().find("crc.mismatches") != std::string::npos);
+    std::ostringstream json;
+    s.WriteJson(json);
+    assert(json.str().find("\"polynomial.divide\": {\"count\": 2, \"total_ns\": 1003") != std::string::npos);
+
+    Reset();
+    assert(TakeSnapshot().counters[CT_CRC_CHECKS] == 0);
+
+    // The codec hooks, when built in.
+    HammingCodecs hc(4);
+    uint64_t message = 0xB;
+    uint64_t code = 0;
+    hc.Encode(&message, &code);
+    uint64_t corrupted = code ^ (uint64_t(1) << 5);
+    hc.Decode(&corrupted, &message);
+    corrupted = code ^ (uint64_t(1) << 3);
+    hc.Decode(&corrupted, &message);
+    s = TakeSnapshot();
+    uint64_t expected = IsEnabled() ? 1 : 0;
+    assert(s.counters[CT_HAMMING_BLOCKS_ENCODED] == expected);
+    assert(s.counters[CT_HAMMING_BLOCKS_DECODED] == 2 * expected);
+    assert(s.counters[CT_HAMMING_MESSAGE_ERRORS] == expected);
+    assert(s.counters[CT_HAMMING_REDUNDANT_ERRORS] == expected);
+    (void)expected;
+    Reset();
+}
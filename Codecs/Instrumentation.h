@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+/**
+ * Runtime counters and latency histograms of the codecs.
+ *
+ * Built only with CODECS_INSTRUMENTATION defined; otherwise the hooks
+ * CODECS_COUNT and CODECS_TIME expand to nothing and every snapshot is
+ * empty.  Each thread updates its own cache-line-aligned block of
+ * counters, so a hook costs one uncontended increment (plus two clock
+ * reads for a timed operation); TakeSnapshot() merges the blocks of all
+ * threads, including those that have exited.
+ */
+class Instrumentation
+{
+public:
+    enum Counter
+    {
+        CT_HAMMING_BLOCKS_ENCODED,
+        CT_HAMMING_BLOCKS_DECODED,
+        CT_HAMMING_MESSAGE_ERRORS,      ///< errors corrected in message bits.
+        CT_HAMMING_REDUNDANT_ERRORS,    ///< errors found in redundant bits.
+        CT_HAMMING_INVALID_SYNDROMES,   ///< syndromes beyond the code length.
+        CT_HAMMING_BYTES_ENCODED,       ///< message bytes of the file and stream coders.
+        CT_HAMMING_BYTES_DECODED,
+        CT_CRC_BYTES,                   ///< bytes fed to CRC registers.
+        CT_CRC_CHECKS,
+        CT_CRC_MISMATCHES,
+        CT_COUNT,
+    };
+
+    enum Operation
+    {
+        OP_HAMMING_ENCODE_BLOCKS,
+        OP_HAMMING_DECODE_BLOCKS,
+        OP_POLYNOMIAL_DIVIDE,
+        OP_FILE_CRC,
+        OP_HAMMING_ENCODE_BUFFER,
+        OP_HAMMING_DECODE_BUFFER,
+        OP_COUNT,
+    };
+
+    /// Bucket b holds latencies of [2^(b-1), 2^b) nanoseconds; bucket 0 holds 0.
+    static const size_t NUM_BUCKETS = 48;
+
+    /**
+     * The merged counters and histograms of all threads.
+     */
+    struct Snapshot
+    {
+        uint64_t counters[CT_COUNT];
+        uint64_t buckets[OP_COUNT][NUM_BUCKETS];
+        uint64_t totalNs[OP_COUNT];
+
+        uint64_t GetCount(Operation op) const;
+
+        /**
+         * @param [in] q   0 < q <= 1, e.g. 0.99.
+         * @return The upper bound, in nanoseconds, of the bucket holding quantile \c q.
+         */
+        uint64_t GetQuantile(Operation op, double q) const;
+
+        void WriteText(std::ostream& os) const;
+        void WriteJson(std::ostream& os) const;
+    };
+
+    /**
+     * Times a scope into the histogram of an operation.
+     */
+    class Timer
+    {
+    public:
+        explicit Timer(Operation op) : op_(op), start_(std::chrono::steady_clock::now()) {}
+
+        ~Timer(void)
+        {
+            Record(op_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_).count()));
+        }
+
+    private:
+        Timer(const Timer&);
+        Timer& operator=(const Timer&);
+
+    private:
+        Operation op_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    static bool IsEnabled(void);
+
+    static void Add(Counter counter, uint64_t n)
+    {
+        std::atomic<uint64_t>& value = GetLocal().counters[counter];
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static void Record(Operation op, uint64_t ns);
+
+    static Snapshot TakeSnapshot(void);
+
+    /**
+     * Zero the counters and histograms of all threads.
+     */
+    static void Reset(void);
+
+    static const char* GetName(Counter counter);
+    static const char* GetName(Operation op);
+
+    static void Test(void);
+
+private:
+    /**
+     * The counters of one thread; only that thread writes them.
+     */
+    struct alignas(64) Block
+    {
+        std::atomic<uint64_t> counters[CT_COUNT];
+        std::atomic<uint64_t> buckets[OP_COUNT][NUM_BUCKETS];
+        std::atomic<uint64_t> totalNs[OP_COUNT];
+    };
+
+    class Registry;
+
+    static Block& GetLocal(void);
+};
+
+#if defined(CODECS_INSTRUMENTATION)
+#define CODECS_COUNT(counter, n) Instrumentation::Add((counter), (n))
+#define CODECS_TIMER_NAME2(line) codecsTimer##line
+#define CODECS_TIMER_NAME(line) CODECS_TIMER_NAME2(line)
+#define CODECS_TIME(op) Instrumentation::Timer CODECS_TIMER_NAME(__LINE__)(op)
+#else
+#define CODECS_COUNT(counter, n) ((void)0)
+#define CODECS_TIME(op) ((void)0)
+#endif
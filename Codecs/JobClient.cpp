@@ -0,0 +1,264 @@
+#include "JobClient.h"
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    /// SplitMix64, to draw the job sizes from the seed and the job index.
+    uint64_t Mix(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+}
+
+JobClient::JobClient(void) :
+    fd_(-1),
+    nextId_(0)
+{
+}
+
+JobClient::~JobClient(void)
+{
+    Close();
+}
+
+#if defined(_WIN32)
+bool JobClient::Connect(const std::string&)
+{
+    return false;
+}
+
+void JobClient::Close(void)
+{
+}
+#else
+bool JobClient::Connect(const std::string& path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof (address));
+    if (fd_ >= 0 || path.empty() || path.size() >= sizeof (address.sun_path))
+    {
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof (address)) != 0)
+    {
+        close(fd);
+        return false;
+    }
+#if defined(SO_NOSIGPIPE)
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof (on));
+#endif
+    fd_ = fd;
+    return true;
+}
+
+void JobClient::Close(void)
+{
+    if (fd_ >= 0)
+    {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+#endif
+
+bool JobClient::Send(uint8_t operation, const std::string& parameters, const std::vector<uint8_t>& payload,
+                     uint32_t& id)
+{
+    JobProtocol::Request request;
+    request.id = id = nextId_++;
+    request.operation = operation;
+    request.parameters = parameters;
+    request.payload = payload;
+    return fd_ >= 0 && JobProtocol::WriteRequest(fd_, request);
+}
+
+bool JobClient::Receive(JobProtocol::Response& response)
+{
+    return fd_ >= 0 && JobProtocol::ReadResponse(fd_, response);
+}
+
+bool JobClient::Call(uint8_t operation, const std::string& parameters, const std::vector<uint8_t>& payload,
+                     JobProtocol::Response& response)
+{
+    uint32_t id = 0;
+    return Send(operation, parameters, payload, id) && Receive(response) && response.id == id;
+}
+
+JobClient::LoadOptions JobClient::GetDefaultLoadOptions(void)
+{
+    LoadOptions options;
+    options.numConnections = 4;
+    options.numJobs = 1000;
+    options.depth = 8;
+    options.minBytes = 64;
+    options.maxBytes = 4 << 20;
+    options.generator = "1 0000 0100 1100 0001 0001 1101 1011 0111";   // CRC-32
+    options.numMessageBits = 57;
+    options.seed = 1;
+    return options;
+}
+
+bool JobClient::RunLoad(const std::string& path, const LoadOptions& options, LoadReport& report)
+{
+    typedef std::chrono::steady_clock Clock;
+    assert(options.numConnections > 0 && options.depth > 0);
+    assert(options.minBytes > 0 && options.minBytes <= options.maxBytes);
+    std::vector<JobClient> clients(options.numConnections);
+    for (size_t c = 0; c < clients.size(); ++c)
+    {
+        if (!clients[c].Connect(path))
+        {
+            return false;
+        }
+    }
+    // The payloads are prefixes of one buffer.
+    std::vector<uint8_t> data(options.maxBytes);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<uint8_t>(Mix(options.seed + i));
+    }
+    std::string hammingParameters = std::to_string(options.numMessageBits);
+    double ratio = std::log(static_cast<double>(options.maxBytes) / options.minBytes);
+
+    std::atomic<size_t> nextJob(0);
+    std::atomic<uint64_t> numJobs(0);
+    std::atomic<uint64_t> numFailed(0);
+    std::atomic<uint64_t> numBytes(0);
+    std::mutex mutex;
+    std::vector<uint64_t> latencies;
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < clients.size(); ++c)
+    {
+        threads.push_back(std::thread([&, c]()
+        {
+            JobClient& client = clients[c];
+            std::map<uint32_t, Clock::time_point> inFlight;
+            std::vector<uint64_t> local;
+            for (;;)
+            {
+                size_t j = 0;
+                while (inFlight.size() < options.depth && (j = nextJob++) < options.numJobs)
+                {
+                    double u = static_cast<double>(Mix(options.seed ^ (j << 1)) >> 11) / 9007199254740992.0;
+                    size_t size = std::min(static_cast<size_t>(options.minBytes * std::exp(u * ratio)), data.size());
+                    std::vector<uint8_t> payload(data.begin(), data.begin() + size);
+                    uint32_t id = 0;
+                    bool crc = j % 2 == 0;
+                    if (!client.Send(crc ? JobProtocol::OP_CRC : JobProtocol::OP_HAMMING_ENCODE,
+                                     crc ? options.generator : hammingParameters, payload, id))
+                    {
+                        ++numFailed;
+                        continue;
+                    }
+                    inFlight[id] = Clock::now();
+                    numBytes += size;
+                }
+                if (inFlight.empty())
+                {
+                    break;
+                }
+                JobProtocol::Response response;
+                std::map<uint32_t, Clock::time_point>::iterator it;
+                if (!client.Receive(response) || (it = inFlight.find(response.id)) == inFlight.end())
+                {
+                    numFailed += inFlight.size();
+                    break;
+                }
+                local.push_back(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - it->second).count()));
+                inFlight.erase(it);
+                ++numJobs;
+                if (response.status != JobProtocol::JS_OK)
+                {
+                    ++numFailed;
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            latencies.insert(latencies.end(), local.begin(), local.end());
+        }));
+    }
+    for (size_t c = 0; c < threads.size(); ++c)
+    {
+        threads[c].join();
+    }
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    report.numJobs = numJobs;
+    report.numFailed = numFailed;
+    report.numBytes = numBytes;
+    std::sort(latencies.begin(), latencies.end());
+    report.p50Ns = latencies.empty() ? 0 : latencies[latencies.size() / 2];
+    report.p99Ns = latencies.empty() ? 0 : latencies[latencies.size() * 99 / 100];
+    report.maxNs = latencies.empty() ? 0 : latencies.back();
+    return true;
+}
+
+void JobClient::WriteReport(std::ostream& os, const LoadReport& report)
+{
+    os << "jobs " << report.numJobs << '\n'
+       << "failed " << report.numFailed << '\n'
+       << "seconds " << report.seconds << '\n'
+       << "jobs/s " << (report.seconds > 0 ? report.numJobs / report.seconds : 0) << '\n'
+       << "MB/s " << (report.seconds > 0 ? report.numBytes / report.seconds / 1e6 : 0) << '\n'
+       << "latency-us p50 " << report.p50Ns / 1000 << " p99 " << report.p99Ns / 1000
+       << " max " << report.maxNs / 1000 << '\n';
+}
+
+#include "JobServer.h"
+void JobClient::Test(void)
+{
+#if !defined(_WIN32)
+    const char* path = "codecs-test-client.sock";
+    JobClient client;
+    bool ok = client.Connect(path);
+    assert(!ok);
+    LoadReport report;
+    LoadOptions options = GetDefaultLoadOptions();
+    ok = RunLoad(path, options, report);
+    assert(!ok);
+
+    JobServer server(2, 4096);
+    ok = server.Listen(path);
+    assert(ok);
+    std::thread serving(&JobServer::Serve, &server);
+    options.numConnections = 3;
+    options.numJobs = 60;
+    options.depth = 4;
+    options.maxBytes = 50000;
+    ok = RunLoad(path, options, report);
+    assert(ok && report.numJobs == 60 && report.numFailed == 0);
+    assert(report.p50Ns <= report.p99Ns && report.p99Ns <= report.maxNs);
+    JobServer::Statistics statistics = server.GetStatistics();
+    assert(statistics.service[JobProtocol::OP_CRC].count == 30);
+    assert(statistics.service[JobProtocol::OP_HAMMING_ENCODE].count == 30);
+    (void)ok;
+    (void)statistics;
+    server.Stop();
+    serving.join();
+#endif
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "JobProtocol.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * A connection to a JobServer, and a load generator built on it.
+ *
+ * Requests may be sent ahead of the responses; each gets its own id, and
+ * the responses are matched to the requests by the caller.
+ */
+class JobClient
+{
+public:
+    JobClient(void);
+    ~JobClient(void);
+
+    /**
+     * @return false if no server listens at \c path, or on Windows.
+     */
+    bool Connect(const std::string& path);
+    void Close(void);
+
+    /**
+     * Send a request without waiting for its response.
+     * @param [out] id   the id of the request.
+     * @return false if the connection failed.
+     */
+    bool Send(uint8_t operation, const std::string& parameters, const std::vector<uint8_t>& payload, uint32_t& id);
+
+    /**
+     * Block until the next response arrives.
+     * @return false if the connection failed or was closed.
+     */
+    bool Receive(JobProtocol::Response& response);
+
+    /**
+     * Send a request and wait for its response; no other request may be pending.
+     */
+    bool Call(uint8_t operation, const std::string& parameters, const std::vector<uint8_t>& payload,
+              JobProtocol::Response& response);
+
+    struct LoadOptions
+    {
+        size_t numConnections;
+        size_t numJobs;             ///< over all connections.
+        size_t depth;               ///< requests in flight per connection.
+        size_t minBytes;            ///< payload sizes are spread evenly on a log scale
+        size_t maxBytes;            ///< from minBytes to maxBytes.
+        std::string generator;      ///< the CRC generator as bits.
+        size_t numMessageBits;      ///< the Hamming message block bits.
+        uint64_t seed;
+    };
+
+    struct LoadReport
+    {
+        uint64_t numJobs;           ///< jobs answered.
+        uint64_t numFailed;         ///< jobs answered with an error, or lost with their connection.
+        uint64_t numBytes;          ///< payload bytes sent.
+        double seconds;
+        uint64_t p50Ns;             ///< round-trip latency quantiles, measured by the client.
+        uint64_t p99Ns;
+        uint64_t maxNs;
+    };
+
+    static LoadOptions GetDefaultLoadOptions(void);
+
+    /**
+     * Send CRC and Hamming encoding jobs of mixed sizes to a server over
+     * several connections, each keeping \c depth requests in flight.
+     * @return false if a connection cannot be made.
+     */
+    static bool RunLoad(const std::string& path, const LoadOptions& options, LoadReport& report);
+
+    static void WriteReport(std::ostream& os, const LoadReport& report);
+
+    static void Test(void);
+
+private:
+    JobClient(const JobClient&);
+    JobClient& operator=(const JobClient&);
+
+private:
+    int fd_;
+    uint32_t nextId_;
+};
@@ -0,0 +1,253 @@
+#include "JobProtocol.h"
+#include <cassert>
+#include <algorithm>
+#include <cstring>
+#if !defined(_WIN32)
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const size_t REQUEST_HEADER_SIZE = 4 + 1 + 4;       // id, operation, paramSize
+    const size_t RESPONSE_HEADER_SIZE = 4 + 1 + 8;      // id, status, serviceNs
+}
+
+const char* JobProtocol::GetOperationName(uint8_t operation)
+{
+    static const char* const names[] = { "unknown", "crc", "hamming-encode", "hamming-decode", "statistics" };
+    return operation < OP_COUNT ? names[operation] : names[0];
+}
+
+void JobProtocol::PutUint32(uint8_t* p, uint32_t value)
+{
+    for (size_t i = 0; i < 4; ++i)
+    {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void JobProtocol::PutUint64(uint8_t* p, uint64_t value)
+{
+    for (size_t i = 0; i < 8; ++i)
+    {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t JobProtocol::GetUint32(const uint8_t* p)
+{
+    uint32_t value = 0;
+    for (size_t i = 4; i-- > 0; )
+    {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+uint64_t JobProtocol::GetUint64(const uint8_t* p)
+{
+    uint64_t value = 0;
+    for (size_t i = 8; i-- > 0; )
+    {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+#if defined(_WIN32)
+bool JobProtocol::ReadAll(int, uint8_t*, size_t)
+{
+    return false;
+}
+
+bool JobProtocol::WriteAll(int, const uint8_t*, size_t)
+{
+    return false;
+}
+#else
+bool JobProtocol::ReadAll(int fd, uint8_t* data, size_t numBytes)
+{
+    while (numBytes > 0)
+    {
+        ssize_t n = read(fd, data, numBytes);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        data += n;
+        numBytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool JobProtocol::WriteAll(int fd, const uint8_t* data, size_t numBytes)
+{
+#if defined(MSG_NOSIGNAL)
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;        // SO_NOSIGPIPE is set on the socket instead.
+#endif
+    while (numBytes > 0)
+    {
+        ssize_t n = send(fd, data, numBytes, flags);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        data += n;
+        numBytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+#endif
+
+bool JobProtocol::ReadFrame(int fd, size_t minSize, std::vector<uint8_t>& frame)
+{
+    uint8_t size[4];
+    if (!ReadAll(fd, size, sizeof (size)))
+    {
+        return false;
+    }
+    uint32_t numBytes = GetUint32(size);
+    if (numBytes < minSize || numBytes > MAX_FRAME_SIZE)
+    {
+        return false;
+    }
+    frame.resize(numBytes);
+    return ReadAll(fd, &frame[0], numBytes);
+}
+
+bool JobProtocol::ReadRequest(int fd, Request& request)
+{
+    std::vector<uint8_t> frame;
+    if (!ReadFrame(fd, REQUEST_HEADER_SIZE, frame))
+    {
+        return false;
+    }
+    uint32_t paramSize = GetUint32(&frame[5]);
+    if (paramSize > frame.size() - REQUEST_HEADER_SIZE)
+    {
+        return false;
+    }
+    request.id = GetUint32(&frame[0]);
+    request.operation = frame[4];
+    const char* params = reinterpret_cast<const char*>(&frame[0] + REQUEST_HEADER_SIZE);
+    request.parameters.assign(params, params + paramSize);
+    request.payload.assign(frame.begin() + REQUEST_HEADER_SIZE + paramSize, frame.end());
+    return true;
+}
+
+bool JobProtocol::ReadResponse(int fd, Response& response)
+{
+    std::vector<uint8_t> frame;
+    if (!ReadFrame(fd, RESPONSE_HEADER_SIZE, frame))
+    {
+        return false;
+    }
+    response.id = GetUint32(&frame[0]);
+    response.status = frame[4];
+    response.serviceNs = GetUint64(&frame[5]);
+    response.payload.assign(frame.begin() + RESPONSE_HEADER_SIZE, frame.end());
+    return true;
+}
+
+bool JobProtocol::WriteRequest(int fd, const Request& request)
+{
+    size_t numBytes = REQUEST_HEADER_SIZE + request.parameters.size() + request.payload.size();
+    if (numBytes > MAX_FRAME_SIZE)
+    {
+        return false;
+    }
+    // The header and parameters go in one write, the payload in place.
+    std::vector<uint8_t> header(4 + REQUEST_HEADER_SIZE + request.parameters.size());
+    PutUint32(&header[0], static_cast<uint32_t>(numBytes));
+    PutUint32(&header[4], request.id);
+    header[8] = request.operation;
+    PutUint32(&header[9], static_cast<uint32_t>(request.parameters.size()));
+    std::copy(request.parameters.begin(), request.parameters.end(), header.begin() + 4 + REQUEST_HEADER_SIZE);
+    return WriteAll(fd, &header[0], header.size())
+        && (request.payload.empty() || WriteAll(fd, &request.payload[0], request.payload.size()));
+}
+
+bool JobProtocol::WriteResponse(int fd, const Response& response)
+{
+    size_t numBytes = RESPONSE_HEADER_SIZE + response.payload.size();
+    if (numBytes > MAX_FRAME_SIZE)
+    {
+        return false;
+    }
+    uint8_t header[4 + RESPONSE_HEADER_SIZE];
+    PutUint32(&header[0], static_cast<uint32_t>(numBytes));
+    PutUint32(&header[4], response.id);
+    header[8] = response.status;
+    PutUint64(&header[9], response.serviceNs);
+    return WriteAll(fd, header, sizeof (header))
+        && (response.payload.empty() || WriteAll(fd, &response.payload[0], response.payload.size()));
+}
+
+void JobProtocol::Test(void)
+{
+#if !defined(_WIN32)
+    int fds[2];
+    int result = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    assert(result == 0);
+    (void)result;
+    bool ok = false;
+
+    // Round trips, with and without parameters and payload.
+    Request request = { 7, OP_CRC, "1 0000 0111", std::vector<uint8_t>(1000, 0xA5) };
+    ok = WriteRequest(fds[0], request);
+    assert(ok);
+    Request empty = { 0xFFFFFFFFu, OP_STATISTICS, "", std::vector<uint8_t>() };
+    ok = WriteRequest(fds[0], empty);
+    assert(ok);
+    Request received;
+    ok = ReadRequest(fds[1], received);
+    assert(ok);
+    assert(received.id == 7 && received.operation == OP_CRC);
+    assert(received.parameters == request.parameters && received.payload == request.payload);
+    ok = ReadRequest(fds[1], received);
+    assert(ok);
+    assert(received.id == 0xFFFFFFFFu && received.operation == OP_STATISTICS);
+    assert(received.parameters.empty() && received.payload.empty());
+
+    Response response = { 7, JS_OK, 0x123456789ULL, std::vector<uint8_t>(3, 1) };
+    ok = WriteResponse(fds[1], response);
+    assert(ok);
+    Response answer;
+    ok = ReadResponse(fds[0], answer);
+    assert(ok);
+    assert(answer.id == 7 && answer.status == JS_OK && answer.serviceNs == 0x123456789ULL);
+    assert(answer.payload == response.payload);
+
+    // A request whose parameters overrun the frame is malformed.
+    uint8_t bad[4 + REQUEST_HEADER_SIZE] = { 0 };
+    PutUint32(&bad[0], REQUEST_HEADER_SIZE);
+    PutUint32(&bad[9], 1);
+    ok = WriteAll(fds[0], bad, sizeof (bad));
+    assert(ok);
+    ok = ReadRequest(fds[1], received);
+    assert(!ok);
+
+    // The end of the stream.
+    close(fds[0]);
+    ok = ReadRequest(fds[1], received);
+    assert(!ok);
+    ok = WriteResponse(fds[1], response);
+    assert(!ok);
+    close(fds[1]);
+    assert(std::strcmp(GetOperationName(OP_HAMMING_DECODE), "hamming-decode") == 0);
+    assert(std::strcmp(GetOperationName(200), "unknown") == 0);
+    (void)ok;
+#endif
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * The frames exchanged by JobServer and JobClient over a stream socket.
+ *
+ * Every integer is little-endian.  A request is
+ *
+ *     uint32 size          the bytes after this field
+ *     uint32 id            chosen by the client, echoed in the response
+ *     uint8  operation     an Operation
+ *     uint32 paramSize
+ *     char   params[paramSize]
+ *     uint8  payload[size - 9 - paramSize]
+ *
+ * and a response is
+ *
+ *     uint32 size
+ *     uint32 id
+ *     uint8  status        a Status
+ *     uint64 serviceNs     from the arrival of the request to its response
+ *     uint8  payload[size - 13]
+ *
+ * A client may send any number of requests before reading responses;
+ * responses come back as the jobs finish, not necessarily in order.
+ *
+ * The parameters are text:
+ *   OP_CRC              the generator as bits, e.g. "1 0000 0111"; the
+ *                       payload is the message, read LSB first; the result
+ *                       is the remainder in hex.
+ *   OP_HAMMING_ENCODE   the message block bits k; the result is the code
+ *                       blocks (see FileCodecs).
+ *   OP_HAMMING_DECODE   k, optionally followed by ",<bytes>", the message
+ *                       length to restore; the result is the number of
+ *                       corrected blocks as a uint64, then the message.
+ *   OP_STATISTICS       none; the result is the server statistics as text.
+ */
+class JobProtocol
+{
+public:
+    enum Operation
+    {
+        OP_CRC = 1,
+        OP_HAMMING_ENCODE,
+        OP_HAMMING_DECODE,
+        OP_STATISTICS,
+        OP_COUNT,
+    };
+
+    enum Status
+    {
+        JS_OK,
+        JS_BAD_REQUEST,         ///< an unknown operation or invalid parameters.
+        JS_BUSY,                ///< the server is stopping or its queue of jobs is full.
+    };
+
+    /// The largest frame accepted, so that a corrupt size cannot exhaust memory.
+    static const uint32_t MAX_FRAME_SIZE = 1u << 30;
+
+    struct Request
+    {
+        uint32_t id;
+        uint8_t operation;
+        std::string parameters;
+        std::vector<uint8_t> payload;
+    };
+
+    struct Response
+    {
+        uint32_t id;
+        uint8_t status;
+        uint64_t serviceNs;
+        std::vector<uint8_t> payload;
+    };
+
+    /**
+     * @return The name of an operation, or "unknown".
+     */
+    static const char* GetOperationName(uint8_t operation);
+
+    /**
+     * Block until a whole frame has been read from \c fd.
+     * @return false at the end of the stream, on an error or on a malformed frame.
+     */
+    static bool ReadRequest(int fd, Request& request);
+    static bool ReadResponse(int fd, Response& response);
+
+    /**
+     * Write a whole frame to \c fd; a peer that has gone raises no signal.
+     * @return false on an error.
+     */
+    static bool WriteRequest(int fd, const Request& request);
+    static bool WriteResponse(int fd, const Response& response);
+
+    /**
+     * Little-endian integers of the frames and payloads.
+     */
+    static void PutUint32(uint8_t* p, uint32_t value);
+    static void PutUint64(uint8_t* p, uint64_t value);
+    static uint32_t GetUint32(const uint8_t* p);
+    static uint64_t GetUint64(const uint8_t* p);
+
+    static void Test(void);
+
+private:
+    static bool ReadAll(int fd, uint8_t* data, size_t numBytes);
+    static bool WriteAll(int fd, const uint8_t* data, size_t numBytes);
+
+    /**
+     * Read a frame size and the frame after it.
+     * @param [in] minSize   the size of the fixed fields.
+     */
+    static bool ReadFrame(int fd, size_t minSize, std::vector<uint8_t>& frame);
+};
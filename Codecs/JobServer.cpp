@@ -0,0 +1,724 @@
+#include "JobServer.h"
+#include "DataIo.h"
+#include "FileCodecs.h"
+#include "HammingCodecs.h"
+#include "LfsrDivider.h"
+#include "PackedBits.h"
+#include <cassert>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#if !defined(_WIN32)
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+struct JobServer::Connection
+{
+    explicit Connection(int f) : fd(f), closed(false) {}
+
+    ~Connection(void)
+    {
+#if !defined(_WIN32)
+        close(fd);
+#endif
+    }
+
+    int fd;
+    std::mutex writeMutex;      ///< responses of concurrent jobs are written whole.
+    std::atomic<bool> closed;   ///< the reader has returned.
+};
+
+namespace
+{
+    uint64_t GetNanoseconds(std::chrono::steady_clock::time_point start)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+void JobServer::Latency::Add(uint64_t ns)
+{
+    size_t b = 0;
+    for (uint64_t n = ns; n && b + 1 < NUM_BUCKETS; n >>= 1)
+    {
+        ++b;
+    }
+    ++count;
+    totalNs += ns;
+    maxNs = std::max(maxNs, ns);
+    ++buckets[b];
+}
+
+uint64_t JobServer::Latency::GetQuantile(double q) const
+{
+    uint64_t seen = 0;
+    for (size_t b = 0; b < NUM_BUCKETS; ++b)
+    {
+        seen += buckets[b];
+        if (seen && seen >= q * count)
+        {
+            return b ? std::min(uint64_t(1) << b, maxNs) : 0;
+        }
+    }
+    return 0;
+}
+
+JobServer::JobServer(size_t numThreads, size_t chunkSize, size_t maxQueuedJobs) :
+    pool_(numThreads),
+    chunkSize_(std::max<size_t>(chunkSize, 1)),
+    maxQueuedJobs_(maxQueuedJobs),
+    listenFd_(-1),
+    stopping_(false),
+    numQueued_(0),
+    numRunning_(0)
+{
+    wakeFds_[0] = wakeFds_[1] = -1;
+    std::memset(&statistics_, 0, sizeof (statistics_));
+}
+
+JobServer::~JobServer(void)
+{
+    Stop();
+#if !defined(_WIN32)
+    for (size_t i = 0; i < 2; ++i)
+    {
+        if (wakeFds_[i] >= 0)
+        {
+            close(wakeFds_[i]);
+        }
+    }
+#endif
+}
+
+#if defined(_WIN32)
+bool JobServer::Listen(const std::string&)
+{
+    return false;
+}
+
+void JobServer::Serve(void)
+{
+}
+
+void JobServer::Stop(void)
+{
+}
+
+void JobServer::ReadRequests(ConnectionPtr)
+{
+}
+
+void JobServer::Respond(const ConnectionPtr&, uint32_t, uint8_t, uint8_t, Clock::time_point, std::vector<uint8_t>&)
+{
+}
+#else
+bool JobServer::Listen(const std::string& path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof (address));
+    if (listenFd_ >= 0 || path.empty() || path.size() >= sizeof (address.sun_path))
+    {
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    // Only a stale socket is replaced, never a file given by mistake.
+    struct stat status;
+    if (lstat(path.c_str(), &status) == 0)
+    {
+        if (!S_ISSOCK(status.st_mode))
+        {
+            return false;
+        }
+        unlink(path.c_str());
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof (address)) != 0
+        || listen(fd, SOMAXCONN) != 0 || pipe(wakeFds_) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    path_ = path;
+    listenFd_ = fd;
+    return true;
+}
+
+void JobServer::Serve(void)
+{
+    if (listenFd_ < 0)
+    {
+        return;
+    }
+    for (;;)
+    {
+        pollfd fds[2] = { { listenFd_, POLLIN, 0 }, { wakeFds_[0], POLLIN, 0 } };
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents)
+        {
+            break;
+        }
+        int fd = accept(listenFd_, nullptr, nullptr);
+        if (fd < 0)
+        {
+            continue;
+        }
+#if defined(SO_NOSIGPIPE)
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof (on));
+#endif
+        ConnectionPtr connection(new Connection(fd));
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_)
+        {
+            break;
+        }
+        connections_.push_back(std::make_pair(connection, std::thread(&JobServer::ReadRequests, this, connection)));
+        Reap();
+    }
+    close(listenFd_);
+    listenFd_ = -1;
+    unlink(path_.c_str());
+}
+
+void JobServer::Stop(void)
+{
+    std::vector<std::pair<ConnectionPtr, std::thread>> connections;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        connections.swap(connections_);
+    }
+    if (wakeFds_[1] >= 0)
+    {
+        char wake = 0;
+        ssize_t n = write(wakeFds_[1], &wake, 1);
+        (void)n;
+    }
+    // The readers see the end of their streams; the responses still due fail to be sent.
+    for (size_t i = 0; i < connections.size(); ++i)
+    {
+        shutdown(connections[i].first->fd, SHUT_RDWR);
+    }
+    for (size_t i = 0; i < connections.size(); ++i)
+    {
+        connections[i].second.join();
+    }
+    pool_.Wait();
+}
+
+void JobServer::ReadRequests(ConnectionPtr connection)
+{
+    for (;;)
+    {
+        std::shared_ptr<JobProtocol::Request> request(new JobProtocol::Request);
+        if (!JobProtocol::ReadRequest(connection->fd, *request))
+        {
+            break;
+        }
+        Clock::time_point arrival = Clock::now();
+        if (request->operation == JobProtocol::OP_STATISTICS)
+        {
+            // Answered at once, not behind the jobs it reports on.
+            std::ostringstream text;
+            WriteStatistics(text);
+            std::string s = text.str();
+            std::vector<uint8_t> payload(s.begin(), s.end());
+            Respond(connection, request->id, request->operation, JobProtocol::JS_OK, arrival, payload);
+            continue;
+        }
+        bool stopping = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping = stopping_;
+        }
+        if (stopping || numQueued_ >= maxQueuedJobs_)
+        {
+            std::vector<uint8_t> none;
+            Respond(connection, request->id, request->operation, JobProtocol::JS_BUSY, arrival, none);
+            continue;
+        }
+        ++numQueued_;
+        RequestPtr job(request);
+        pool_.Submit([this, connection, job, arrival]()
+        {
+            Execute(connection, job, arrival);
+        });
+    }
+    connection->closed = true;
+}
+
+void JobServer::Respond(const ConnectionPtr& connection, uint32_t id, uint8_t operation, uint8_t status,
+                        Clock::time_point arrival, std::vector<uint8_t>& payload)
+{
+    JobProtocol::Response response;
+    response.id = id;
+    response.status = status;
+    response.payload.swap(payload);
+    response.serviceNs = GetNanoseconds(arrival);
+    // Accounted for before the client can see the response.
+    {
+        std::lock_guard<std::mutex> lock(statisticsMutex_);
+        if (status == JobProtocol::JS_BAD_REQUEST)
+        {
+            ++statistics_.numRejected;
+        }
+        else if (status == JobProtocol::JS_BUSY)
+        {
+            ++statistics_.numBusy;
+        }
+        else
+        {
+            statistics_.service[operation < JobProtocol::OP_COUNT ? operation : 0].Add(response.serviceNs);
+        }
+    }
+    if (operation != JobProtocol::OP_STATISTICS && status != JobProtocol::JS_BUSY)
+    {
+        --numRunning_;
+    }
+    std::lock_guard<std::mutex> lock(connection->writeMutex);
+    JobProtocol::WriteResponse(connection->fd, response);
+}
+#endif
+
+void JobServer::Reap(void)
+{
+    for (size_t i = 0; i < connections_.size(); )
+    {
+        if (connections_[i].first->closed)
+        {
+            connections_[i].second.join();
+            if (i + 1 < connections_.size())
+            {
+                connections_[i] = std::move(connections_.back());
+            }
+            connections_.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+std::shared_ptr<const LfsrDivider> JobServer::GetDivider(const std::string& generator)
+{
+    std::vector<bool> bits = DataIo::FromString(generator);
+    bits.erase(bits.begin(), std::find(bits.begin(), bits.end(), true));
+    if (bits.size() < 2 || bits.size() - 1 > MAX_DEGREE)
+    {
+        return std::shared_ptr<const LfsrDivider>();
+    }
+    std::lock_guard<std::mutex> lock(codecsMutex_);
+    std::map<std::vector<bool>, std::shared_ptr<const LfsrDivider>>::iterator it = dividers_.find(bits);
+    if (it != dividers_.end())
+    {
+        return it->second;
+    }
+    // The jobs still using a dropped divider hold their own references.
+    if (dividers_.size() >= MAX_CACHED_DIVIDERS)
+    {
+        dividers_.erase(dividers_.begin());
+    }
+    std::shared_ptr<const LfsrDivider> divider(new LfsrDivider(bits));
+    dividers_[bits] = divider;
+    return divider;
+}
+
+std::shared_ptr<const HammingCodecs> JobServer::GetHamming(size_t numMessageBits)
+{
+    if (numMessageBits == 0 || numMessageBits > MAX_BLOCK_BITS)
+    {
+        return std::shared_ptr<const HammingCodecs>();
+    }
+    std::lock_guard<std::mutex> lock(codecsMutex_);
+    std::shared_ptr<const HammingCodecs>& hamming = hammings_[numMessageBits];
+    if (!hamming)
+    {
+        hamming.reset(new HammingCodecs(numMessageBits));
+    }
+    return hamming;
+}
+
+void JobServer::Execute(ConnectionPtr connection, RequestPtr request, Clock::time_point arrival)
+{
+    --numQueued_;
+    ++numRunning_;
+    {
+        std::lock_guard<std::mutex> lock(statisticsMutex_);
+        statistics_.wait.Add(GetNanoseconds(arrival));
+    }
+    switch (request->operation)
+    {
+    case JobProtocol::OP_CRC:
+        RunCrc(connection, request, arrival);
+        return;
+    case JobProtocol::OP_HAMMING_ENCODE:
+        RunHammingEncode(connection, request, arrival);
+        return;
+    case JobProtocol::OP_HAMMING_DECODE:
+        RunHammingDecode(connection, request, arrival);
+        return;
+    }
+    std::vector<uint8_t> none;
+    Respond(connection, request->id, 0, JobProtocol::JS_BAD_REQUEST, arrival, none);
+}
+
+void JobServer::RunChunks(size_t numChunks, const std::function<void(size_t)>& run,
+                          const std::function<void(void)>& finish)
+{
+    if (numChunks <= 1)
+    {
+        if (numChunks)
+        {
+            run(0);
+        }
+        finish();
+        return;
+    }
+    // Submitted from a worker, the chunks go to its own queue for the others to steal.
+    std::shared_ptr<std::atomic<size_t>> remaining(new std::atomic<size_t>(numChunks));
+    for (size_t c = 0; c < numChunks; ++c)
+    {
+        pool_.Submit([run, finish, remaining, c]()
+        {
+            run(c);
+            if (--*remaining == 0)
+            {
+                finish();
+            }
+        });
+    }
+}
+
+void JobServer::RunCrc(ConnectionPtr connection, RequestPtr request, Clock::time_point arrival)
+{
+    std::shared_ptr<const LfsrDivider> divider = GetDivider(request->parameters);
+    if (!divider)
+    {
+        std::vector<uint8_t> none;
+        Respond(connection, request->id, request->operation, JobProtocol::JS_BAD_REQUEST, arrival, none);
+        return;
+    }
+    // Each chunk is divided on its own; the remainders are then moved to
+    // their place, CRC(A B) = CRC(A) x^|B| + CRC(B).
+    size_t numBytes = request->payload.size();
+    size_t numChunks = (numBytes + chunkSize_ - 1) / chunkSize_;
+    size_t numWords = divider->GetNumberOfWords();
+    size_t chunkSize = chunkSize_;
+    std::shared_ptr<std::vector<uint64_t>> regs(new std::vector<uint64_t>((numChunks + 1) * numWords, 0));
+    RunChunks(numChunks, [divider, request, regs, numWords, numBytes, chunkSize](size_t c)
+    {
+        size_t first = c * chunkSize;
+        divider->Update(&(*regs)[c * numWords], &request->payload[first], 8 * std::min(chunkSize, numBytes - first));
+    },
+    [this, connection, divider, request, regs, numChunks, numWords, numBytes, chunkSize, arrival]()
+    {
+        uint64_t* crc = &(*regs)[numChunks * numWords];
+        for (size_t c = 0; c < numChunks; ++c)
+        {
+            divider->MultiplyByPowerOfX(crc, 8 * std::min(chunkSize, numBytes - c * chunkSize));
+            PackedBits::XorBits(&(*regs)[c * numWords], crc, divider->GetDegree());
+        }
+        std::string hex;
+        DataIo::ToHex(crc, divider->GetDegree(), hex);
+        std::vector<uint8_t> payload(hex.begin(), hex.end());
+        Respond(connection, request->id, request->operation, JobProtocol::JS_OK, arrival, payload);
+    });
+}
+
+void JobServer::RunHammingEncode(ConnectionPtr connection, RequestPtr request, Clock::time_point arrival)
+{
+    std::shared_ptr<const HammingCodecs> hamming = GetHamming(std::strtoull(request->parameters.c_str(), nullptr, 10));
+    if (!hamming)
+    {
+        std::vector<uint8_t> none;
+        Respond(connection, request->id, request->operation, JobProtocol::JS_BAD_REQUEST, arrival, none);
+        return;
+    }
+    // Chunks of whole message blocks: k bytes hold 8 blocks.
+    size_t numBytes = request->payload.size();
+    size_t chunkSize = std::max<size_t>(chunkSize_ / hamming->GetNumberOfMessageBits(), 1)
+                       * hamming->GetNumberOfMessageBits();
+    size_t numChunks = (numBytes + chunkSize - 1) / chunkSize;
+    std::shared_ptr<std::vector<uint8_t>> code(
+        new std::vector<uint8_t>(FileCodecs::GetEncodedSize(*hamming, numBytes) + 1));
+    RunChunks(numChunks, [hamming, request, code, numBytes, chunkSize](size_t c)
+    {
+        size_t first = c * chunkSize;
+        FileCodecs::HammingEncode(*hamming, &request->payload[first], std::min(chunkSize, numBytes - first),
+                                  &(*code)[FileCodecs::GetEncodedSize(*hamming, first)]);
+    },
+    [this, connection, hamming, request, code, numBytes, arrival]()
+    {
+        code->resize(FileCodecs::GetEncodedSize(*hamming, numBytes));
+        Respond(connection, request->id, request->operation, JobProtocol::JS_OK, arrival, *code);
+    });
+}
+
+void JobServer::RunHammingDecode(ConnectionPtr connection, RequestPtr request, Clock::time_point arrival)
+{
+    const char* parameters = request->parameters.c_str();
+    char* end = nullptr;
+    std::shared_ptr<const HammingCodecs> hamming = GetHamming(std::strtoull(parameters, &end, 10));
+    size_t numInputBytes = request->payload.size();
+    size_t numBytes = hamming ? FileCodecs::GetDecodedSize(*hamming, numInputBytes) : 0;
+    if (hamming && *end == ',')
+    {
+        numBytes = std::strtoull(end + 1, &end, 10);
+    }
+    if (!hamming || *end || numBytes > FileCodecs::GetDecodedSize(*hamming, numInputBytes))
+    {
+        std::vector<uint8_t> none;
+        Respond(connection, request->id, request->operation, JobProtocol::JS_BAD_REQUEST, arrival, none);
+        return;
+    }
+    // Chunks of whole code blocks, decoded to their place after the count of corrections.
+    size_t chunkSize = std::max<size_t>(chunkSize_ / hamming->GetNumberOfCodeBits(), 1)
+                       * hamming->GetNumberOfCodeBits();
+    size_t numChunks = (numInputBytes + chunkSize - 1) / chunkSize;
+    std::shared_ptr<std::vector<uint8_t>> message(new std::vector<uint8_t>(8 + numBytes + 1));
+    std::shared_ptr<std::atomic<uint64_t>> numCorrected(new std::atomic<uint64_t>(0));
+    RunChunks(numChunks, [hamming, request, message, numCorrected, numInputBytes, numBytes, chunkSize](size_t c)
+    {
+        size_t first = c * chunkSize;
+        size_t offset = FileCodecs::GetDecodedSize(*hamming, first);
+        if (offset < numBytes)
+        {
+            size_t numChunkBytes = std::min(chunkSize, numInputBytes - first);
+            size_t numOutputBytes = std::min(FileCodecs::GetDecodedSize(*hamming, numChunkBytes), numBytes - offset);
+            *numCorrected += FileCodecs::HammingDecode(*hamming, &request->payload[first], numChunkBytes,
+                                                       &(*message)[8 + offset], numOutputBytes);
+        }
+    },
+    [this, connection, request, message, numCorrected, numBytes, arrival]()
+    {
+        message->resize(8 + numBytes);
+        JobProtocol::PutUint64(&(*message)[0], *numCorrected);
+        Respond(connection, request->id, request->operation, JobProtocol::JS_OK, arrival, *message);
+    });
+}
+
+JobServer::Statistics JobServer::GetStatistics(void) const
+{
+    Statistics statistics;
+    {
+        std::lock_guard<std::mutex> lock(statisticsMutex_);
+        statistics = statistics_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        statistics.numConnections = 0;
+        for (size_t i = 0; i < connections_.size(); ++i)
+        {
+            statistics.numConnections += !connections_[i].first->closed;
+        }
+    }
+    statistics.numQueued = numQueued_;
+    statistics.numRunning = numRunning_;
+    statistics.numQueuedTasks = pool_.GetNumberOfQueuedTasks();
+    return statistics;
+}
+
+void JobServer::WriteStatistics(std::ostream& os) const
+{
+    Statistics statistics = GetStatistics();
+    os << "connections " << statistics.numConnections << '\n'
+       << "queued " << statistics.numQueued << '\n'
+       << "running " << statistics.numRunning << '\n'
+       << "queued-tasks " << statistics.numQueuedTasks << '\n'
+       << "rejected " << statistics.numRejected << '\n'
+       << "busy " << statistics.numBusy << '\n';
+    os << "# latency (us): count mean p50 p99 max\n";
+    const Latency* latencies[JobProtocol::OP_COUNT];
+    const char* names[JobProtocol::OP_COUNT];
+    latencies[0] = &statistics.wait;
+    names[0] = "wait";
+    for (size_t o = 1; o < JobProtocol::OP_COUNT; ++o)
+    {
+        latencies[o] = &statistics.service[o];
+        names[o] = JobProtocol::GetOperationName(static_cast<uint8_t>(o));
+    }
+    for (size_t o = 0; o < JobProtocol::OP_COUNT; ++o)
+    {
+        const Latency& l = *latencies[o];
+        os << names[o] << ' ' << l.count << ' ' << (l.count ? l.totalNs / l.count / 1000 : 0) << ' '
+           << l.GetQuantile(0.5) / 1000 << ' ' << l.GetQuantile(0.99) / 1000 << ' ' << l.maxNs / 1000 << '\n';
+    }
+}
+
+#include "JobClient.h"
+#include <cstdio>
+void JobServer::Test(void)
+{
+#if !defined(_WIN32)
+    // Small chunks, so that the jobs below are split.
+    const char* path = "codecs-test-server.sock";
+    JobServer server(2, 4096);
+    bool ok = server.Listen(path);
+    assert(ok);
+    std::thread serving(&JobServer::Serve, &server);
+    JobClient client;
+    ok = client.Connect(path);
+    assert(ok);
+
+    std::vector<uint8_t> message(100000);
+    for (size_t i = 0; i < message.size(); ++i)
+    {
+        message[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+
+    // A CRC of 25 chunks against one division.
+    const char* generator = "1 0000 0100 1100 0001 0001 1101 1011 0111";
+    JobProtocol::Response response = JobProtocol::Response();
+    ok = client.Call(JobProtocol::OP_CRC, generator, message, response);
+    assert(ok);
+    assert(response.status == JobProtocol::JS_OK);
+    LfsrDivider divider(DataIo::FromString(generator));
+    uint64_t reg = 0;
+    divider.Update(&reg, &message[0], 8 * message.size());
+    std::string hex;
+    DataIo::ToHex(&reg, 32, hex);
+    assert(std::string(response.payload.begin(), response.payload.end()) == hex);
+    assert(server.GetDivider(generator) == server.GetDivider(std::string("0") + generator));
+
+    // Hamming coding against FileCodecs, then decoding with an error.
+    HammingCodecs hamming(57);
+    std::vector<uint8_t> code(FileCodecs::GetEncodedSize(hamming, message.size()));
+    FileCodecs::HammingEncode(hamming, &message[0], message.size(), &code[0]);
+    ok = client.Call(JobProtocol::OP_HAMMING_ENCODE, "57", message, response);
+    assert(ok);
+    assert(response.status == JobProtocol::JS_OK && response.payload == code);
+    code[5000] ^= 0x10;
+    ok = client.Call(JobProtocol::OP_HAMMING_DECODE, "57,100000", code, response);
+    assert(ok);
+    assert(response.status == JobProtocol::JS_OK && response.payload.size() == 8 + message.size());
+    assert(JobProtocol::GetUint64(&response.payload[0]) == 1);
+    assert(std::equal(message.begin(), message.end(), response.payload.begin() + 8));
+
+    // Bad requests.
+    ok = client.Call(JobProtocol::OP_CRC, "0001", message, response);
+    assert(ok);
+    assert(response.status == JobProtocol::JS_BAD_REQUEST);
+    ok = client.Call(JobProtocol::OP_HAMMING_ENCODE, "0", message, response);
+    assert(ok);
+    assert(response.status == JobProtocol::JS_BAD_REQUEST);
+    ok = client.Call(JobProtocol::OP_HAMMING_DECODE, "57,200000", code, response);
+    assert(ok);
+    assert(response.status == JobProtocol::JS_BAD_REQUEST);
+    ok = client.Call(99, "", message, response);
+    assert(ok);
+    assert(response.status == JobProtocol::JS_BAD_REQUEST);
+    std::string wide(MAX_DEGREE + 2, '0');
+    wide[0] = wide[MAX_DEGREE + 1] = '1';
+    ok = client.Call(JobProtocol::OP_CRC, wide, message, response);
+    assert(ok);
+    assert(response.status == JobProtocol::JS_BAD_REQUEST);
+
+    // The cache of dividers is bounded.
+    for (size_t i = 0; i < 2 * MAX_CACHED_DIVIDERS; ++i)
+    {
+        std::string bits(8, '0');
+        for (size_t b = 0; b < 8; ++b)
+        {
+            bits[b] = i >> b & 1 ? '1' : '0';
+        }
+        server.GetDivider("1" + bits);
+    }
+    assert(server.dividers_.size() == MAX_CACHED_DIVIDERS);
+
+    // Pipelined requests of mixed sizes, answered as they finish.
+    std::map<uint32_t, size_t> sizes;
+    for (size_t i = 0; i < 20; ++i)
+    {
+        size_t size = i % 4 == 0 ? message.size() : i * 10;
+        uint32_t id = 0;
+        ok = client.Send(JobProtocol::OP_HAMMING_ENCODE, "11",
+                         std::vector<uint8_t>(message.begin(), message.begin() + size), id);
+        assert(ok);
+        sizes[id] = size;
+    }
+    HammingCodecs hamming11(11);
+    for (size_t i = 0; i < 20; ++i)
+    {
+        ok = client.Receive(response);
+        assert(ok);
+        assert(sizes.count(response.id) == 1);
+        assert(response.payload.size() == FileCodecs::GetEncodedSize(hamming11, sizes[response.id]));
+        sizes.erase(response.id);
+    }
+
+    // Statistics, as the client sees them and from the server.
+    ok = client.Call(JobProtocol::OP_STATISTICS, "", std::vector<uint8_t>(), response);
+    assert(ok);
+    std::string text(response.payload.begin(), response.payload.end());
+    assert(text.find("connections 1\n") != std::string::npos);
+    assert(text.find("hamming-encode 21 ") != std::string::npos);
+    Statistics statistics = server.GetStatistics();
+    assert(statistics.numRejected == 5 && statistics.numBusy == 0);
+    assert(statistics.service[JobProtocol::OP_CRC].count == 1);
+    assert(statistics.wait.count == 28);
+    assert(statistics.numQueued == 0 && statistics.numRunning == 0);
+    (void)statistics;
+
+    // Stopping closes the connections and removes the socket file.
+    server.Stop();
+    serving.join();
+    ok = client.Receive(response);
+    assert(!ok);
+    std::FILE* file = std::fopen(path, "r");
+    assert(file == nullptr);
+
+    // A server without room for jobs answers JS_BUSY, but still reports statistics.
+    JobServer busy(1, 4096, 0);
+    ok = busy.Listen(path);
+    assert(ok);
+    std::thread busyServing(&JobServer::Serve, &busy);
+    JobClient busyClient;
+    ok = busyClient.Connect(path);
+    assert(ok);
+    ok = busyClient.Call(JobProtocol::OP_CRC, generator, message, response);
+    assert(ok);
+    assert(response.status == JobProtocol::JS_BUSY);
+    ok = busyClient.Call(JobProtocol::OP_STATISTICS, "", std::vector<uint8_t>(), response);
+    assert(ok);
+    assert(response.status == JobProtocol::JS_OK);
+    text.assign(response.payload.begin(), response.payload.end());
+    assert(text.find("busy 1\n") != std::string::npos);
+    assert(text.find("running 0\n") != std::string::npos);
+    busy.Stop();
+    busyServing.join();
+
+    // A file that is not a socket is left alone.
+    file = std::fopen(path, "w");
+    assert(file != nullptr);
+    std::fclose(file);
+    JobServer refused(1);
+    ok = refused.Listen(path);
+    assert(!ok);
+    file = std::fopen(path, "r");
+    assert(file != nullptr);
+    std::fclose(file);
+    std::remove(path);
+    (void)ok;
+#endif
+}
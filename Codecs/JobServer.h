@@ -0,0 +1,184 @@
+#pragma once
+#include "JobProtocol.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LfsrDivider;
+class HammingCodecs;
+
+/**
+ * A long-running codec server on a Unix-domain socket (POSIX only).
+ *
+ * Clients send JobProtocol requests; each connection has a thread reading
+ * them, so a client may pipeline many requests, and every job runs on the
+ * work-stealing ThreadPool.  A job larger than the chunk size is split
+ * into chunk tasks submitted from its worker, which idle workers steal:
+ * CRCs of the chunks are combined with LfsrDivider::MultiplyByPowerOfX(),
+ * and Hamming chunks of whole blocks are coded in place.  Responses are
+ * written as jobs finish.  Statistics requests are answered by the reader
+ * at once, so they report the queue depth even when every worker is busy.
+ *
+ * Codecs are built once per generator or block size and shared by all
+ * connections.
+ */
+class JobServer
+{
+public:
+    static const size_t DEFAULT_CHUNK_SIZE = 256 * 1024;
+
+    /// The largest number of jobs waiting for a worker; more are answered JS_BUSY.
+    static const size_t DEFAULT_MAX_QUEUED_JOBS = 1024;
+
+    /// The largest Hamming message block accepted, in bits.
+    static const size_t MAX_BLOCK_BITS = 4096;
+
+    /// The largest CRC generator degree accepted.
+    static const size_t MAX_DEGREE = 1024;
+
+    /// The most dividers kept for reuse; one is dropped to make room for another.
+    static const size_t MAX_CACHED_DIVIDERS = 64;
+
+    /// Bucket b holds latencies of [2^(b-1), 2^b) nanoseconds; bucket 0 holds 0.
+    static const size_t NUM_BUCKETS = 48;
+
+    struct Latency
+    {
+        uint64_t count;
+        uint64_t totalNs;
+        uint64_t maxNs;
+        uint64_t buckets[NUM_BUCKETS];
+
+        void Add(uint64_t ns);
+
+        /**
+         * @param [in] q   0 < q <= 1, e.g. 0.99.
+         * @return The upper bound, in nanoseconds, of the bucket holding quantile \c q, at most maxNs.
+         */
+        uint64_t GetQuantile(double q) const;
+    };
+
+    struct Statistics
+    {
+        uint64_t numConnections;        ///< open connections.
+        uint64_t numQueued;             ///< jobs received and not started.
+        uint64_t numRunning;            ///< jobs started and not answered.
+        uint64_t numQueuedTasks;        ///< tasks of the pool waiting for a worker, chunks included.
+        uint64_t numRejected;           ///< bad requests.
+        uint64_t numBusy;               ///< jobs refused for a full queue or while stopping.
+        Latency wait;                   ///< from the arrival of a job to its start.
+        Latency service[JobProtocol::OP_COUNT];     ///< from the arrival of a job to its response.
+    };
+
+    /**
+     * @param [in] numThreads   the number of workers; 0 for one per hardware thread.
+     * @param [in] chunkSize    the payload bytes of a chunk task of a split job.
+     * @param [in] maxQueuedJobs    the jobs that may wait for a worker before more are answered JS_BUSY.
+     */
+    explicit JobServer(size_t numThreads = 0, size_t chunkSize = DEFAULT_CHUNK_SIZE,
+                       size_t maxQueuedJobs = DEFAULT_MAX_QUEUED_JOBS);
+
+    /**
+     * Stop(); the thread running Serve() must have returned.
+     */
+    ~JobServer(void);
+
+    /**
+     * Bind the socket, replacing a stale socket file at \c path.
+     * @return false if the socket cannot be bound, if \c path exists and is
+     *         not a socket, or on Windows.
+     */
+    bool Listen(const std::string& path);
+
+    /**
+     * Accept connections until Stop(), then remove the socket file.
+     */
+    void Serve(void);
+
+    /**
+     * Make Serve() return, close the connections and wait for the running
+     * jobs.  May be called from any thread.
+     */
+    void Stop(void);
+
+    Statistics GetStatistics(void) const;
+    void WriteStatistics(std::ostream& os) const;
+
+    /**
+     * @return The shared divider of a generator given as bits, or nullptr if
+     *         its degree is 0 or above MAX_DEGREE.
+     */
+    std::shared_ptr<const LfsrDivider> GetDivider(const std::string& generator);
+
+    /**
+     * @return The shared codec of \c numMessageBits-bit blocks, or nullptr if out of range.
+     */
+    std::shared_ptr<const HammingCodecs> GetHamming(size_t numMessageBits);
+
+    static void Test(void);
+
+private:
+    JobServer(const JobServer&);
+    JobServer& operator=(const JobServer&);
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Connection;
+    typedef std::shared_ptr<Connection> ConnectionPtr;
+    typedef std::shared_ptr<const JobProtocol::Request> RequestPtr;
+
+    void ReadRequests(ConnectionPtr connection);
+    void Execute(ConnectionPtr connection, RequestPtr request, Clock::time_point arrival);
+    void RunCrc(ConnectionPtr connection, RequestPtr request, Clock::time_point arrival);
+    void RunHammingEncode(ConnectionPtr connection, RequestPtr request, Clock::time_point arrival);
+    void RunHammingDecode(ConnectionPtr connection, RequestPtr request, Clock::time_point arrival);
+
+    /**
+     * Run \c run(c) for chunks c < numChunks, spread over the pool if more
+     * than one, then \c finish() after the last.
+     */
+    void RunChunks(size_t numChunks, const std::function<void(size_t)>& run, const std::function<void(void)>& finish);
+
+    /**
+     * Account for a response, ending its job unless it answers OP_STATISTICS
+     * or refuses the job with JS_BUSY, and send it; \c operation is 0 for an
+     * unknown operation.
+     */
+    void Respond(const ConnectionPtr& connection, uint32_t id, uint8_t operation, uint8_t status,
+                 Clock::time_point arrival, std::vector<uint8_t>& payload);
+
+    /**
+     * Join the readers of closed connections.
+     */
+    void Reap(void);
+
+private:
+    ThreadPool pool_;
+    size_t chunkSize_;
+    size_t maxQueuedJobs_;
+    std::string path_;
+    int listenFd_;
+    int wakeFds_[2];            ///< a pipe waking Serve() up to stop.
+
+    mutable std::mutex mutex_;
+    bool stopping_;
+    std::vector<std::pair<ConnectionPtr, std::thread>> connections_;
+
+    std::mutex codecsMutex_;
+    std::map<std::vector<bool>, std::shared_ptr<const LfsrDivider>> dividers_;
+    std::map<size_t, std::shared_ptr<const HammingCodecs>> hammings_;
+
+    std::atomic<uint64_t> numQueued_;
+    std::atomic<uint64_t> numRunning_;
+    mutable std::mutex statisticsMutex_;
+    Statistics statistics_;     ///< the latencies and rejections; the counts are taken live.
+};
@@ -0,0 +1,518 @@
+#include "LfsrDivider.h"
+#include "Instrumentation.h"
+#include "PackedBits.h"
+#include "ScratchArena.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+    /// The generator without its leading zero coefficients.
+    std::vector<bool> StripLeadingZeros(const std::vector<bool>& generator)
+    {
+        auto first = generator.begin();
+        while (first != generator.end() && !*first)
+        {
+            ++first;
+        }
+        return std::vector<bool>(first, generator.end());
+    }
+}
+
+LfsrDivider::LfsrDivider(const std::vector<bool>& generator) :
+    generator_(StripLeadingZeros(generator)),
+    degree_(generator_.empty() ? 0 : generator_.size() - 1),
+    numWords_(PackedBits::GetNumberOfWords(degree_))
+{
+    // The generator must not be zero.
+    assert(!generator_.empty());
+    feedback_.assign(numWords_, 0);
+    for (size_t j = 0; j < degree_; ++j)
+    {
+        if (generator_[j + 1])
+        {
+            PackedBits::SetBit(&feedback_[0], j, true);
+        }
+    }
+    // tables_[0][v]: the register after feeding byte v to a zero register.
+    // tables_[k][v]: the same followed by k zero bytes.
+    tables_.assign(8 * 256 * numWords_, 0);
+    if (numWords_)
+    {
+        for (unsigned v = 0; v < 256; ++v)
+        {
+            uint64_t* entry = &tables_[v * numWords_];
+            for (unsigned b = 0; b < 8; ++b)
+            {
+                UpdateBit(entry, (v >> b) & 1);
+            }
+        }
+        for (size_t k = 1; k < 8; ++k)
+        {
+            for (unsigned v = 0; v < 256; ++v)
+            {
+                uint64_t* entry = &tables_[(k * 256 + v) * numWords_];
+                std::memcpy(entry, &tables_[((k - 1) * 256 + v) * numWords_], numWords_ * sizeof (uint64_t));
+                UpdateByte(entry, 0);
+            }
+        }
+        // powers_[0] = x, the register of 1 (the coefficient of x^0 is the last bit) times x.
+        powers_.assign(64 * numWords_, 0);
+        PackedBits::SetBit(&powers_[0], degree_ - 1, true);
+        UpdateBit(&powers_[0], false);
+        for (size_t i = 1; i < 64; ++i)
+        {
+            uint64_t* power = &powers_[i * numWords_];
+            std::memcpy(power, power - numWords_, numWords_ * sizeof (uint64_t));
+            MultiplyMod(power, power - numWords_);
+        }
+    }
+}
+
+const std::vector<bool>& LfsrDivider::GetGenerator(void) const
+{
+    return generator_;
+}
+
+size_t LfsrDivider::GetDegree(void) const
+{
+    return degree_;
+}
+
+size_t LfsrDivider::GetNumberOfWords(void) const
+{
+    return numWords_;
+}
+
+void LfsrDivider::UpdateBit(uint64_t* reg, bool bit) const
+{
+    // Multiply by x: the coefficient of x^(r-1) (bit 0) leaves the register,
+    // and x^r is replaced by the rest of the generator.
+    bool feedback = (reg[0] & 1) != bit;
+    for (size_t w = 0; w + 1 < numWords_; ++w)
+    {
+        reg[w] = (reg[w] >> 1) | (reg[w + 1] << 63);
+    }
+    reg[numWords_ - 1] >>= 1;
+    if (feedback)
+    {
+        for (size_t w = 0; w < numWords_; ++w)
+        {
+            reg[w] ^= feedback_[w];
+        }
+    }
+}
+
+void LfsrDivider::UpdateByte(uint64_t* reg, uint8_t byte) const
+{
+    const uint64_t* entry = &tables_[((reg[0] ^ byte) & 0xFF) * numWords_];
+    for (size_t w = 0; w + 1 < numWords_; ++w)
+    {
+        reg[w] = (reg[w] >> 8) ^ (reg[w + 1] << 56) ^ entry[w];
+    }
+    reg[numWords_ - 1] = (degree_ > 8 ? reg[numWords_ - 1] >> 8 : 0) ^ entry[numWords_ - 1];
+}
+
+template <size_t WORDS>
+size_t LfsrDivider::UpdateWords(uint64_t* reg, const uint8_t* data, size_t numBytes) const
+{
+    // Slicing-by-8 with a multi-word register: the low word meets the data,
+    // the other words shift down by one word.
+    // WORDS is the number of register words, or 0 if only known at run time.
+    const size_t numWords = WORDS ? WORDS : numWords_;
+    const uint64_t* t = &tables_[0];
+    uint64_t r[WORDS ? WORDS : 1];
+    uint64_t* acc = WORDS ? r : reg;
+    if (WORDS)
+    {
+        std::memcpy(r, reg, sizeof (r));
+    }
+    size_t i = 0;
+    for (; i + 8 <= numBytes; i += 8)
+    {
+        // The first byte is the low byte of the register on any host.
+        uint64_t d = PackedBits::LoadLittleEndian(data + i) ^ acc[0];
+        const uint64_t* t7 = t + (7 * 256 + (d & 0xFF)) * numWords;
+        const uint64_t* t6 = t + (6 * 256 + ((d >> 8) & 0xFF)) * numWords;
+        const uint64_t* t5 = t + (5 * 256 + ((d >> 16) & 0xFF)) * numWords;
+        const uint64_t* t4 = t + (4 * 256 + ((d >> 24) & 0xFF)) * numWords;
+        const uint64_t* t3 = t + (3 * 256 + ((d >> 32) & 0xFF)) * numWords;
+        const uint64_t* t2 = t + (2 * 256 + ((d >> 40) & 0xFF)) * numWords;
+        const uint64_t* t1 = t + (1 * 256 + ((d >> 48) & 0xFF)) * numWords;
+        const uint64_t* t0 = t + ((d >> 56) & 0xFF) * numWords;
+        for (size_t w = 0; w < numWords; ++w)
+        {
+            uint64_t next = w + 1 < numWords ? acc[w + 1] : 0;
+            acc[w] = next ^ t0[w] ^ t1[w] ^ t2[w] ^ t3[w] ^ t4[w] ^ t5[w] ^ t6[w] ^ t7[w];
+        }
+    }
+    if (WORDS)
+    {
+        std::memcpy(reg, r, sizeof (r));
+    }
+    return i;
+}
+
+void LfsrDivider::Update(uint64_t* reg, const uint8_t* data, size_t numBits) const
+{
+    CODECS_COUNT(Instrumentation::CT_CRC_BYTES, numBits / 8);
+    if (!numWords_)
+    {
+        return;
+    }
+    size_t numBytes = numBits / 8;
+    size_t i = 0;
+    switch (numWords_)
+    {
+    case 1:
+        i = UpdateWords<1>(reg, data, numBytes);
+        break;
+    case 2:
+        i = UpdateWords<2>(reg, data, numBytes);
+        break;
+    case 3:
+        i = UpdateWords<3>(reg, data, numBytes);
+        break;
+    case 4:
+        i = UpdateWords<4>(reg, data, numBytes);
+        break;
+    default:
+        i = UpdateWords<0>(reg, data, numBytes);
+        break;
+    }
+    for (; i < numBytes; ++i)
+    {
+        UpdateByte(reg, data[i]);
+    }
+    for (size_t b = 0; b < numBits % 8; ++b)
+    {
+        UpdateBit(reg, (data[numBytes] >> b) & 1);
+    }
+}
+
+void LfsrDivider::Update(uint64_t* reg, const uint64_t* data, size_t numBits) const
+{
+    // Packed words are laid out in memory as the byte form on little-endian hosts.
+    Update(reg, reinterpret_cast<const uint8_t*>(data), numBits);
+}
+
+void LfsrDivider::Update(uint64_t* reg, const BitView& data) const
+{
+    if (data.GetBitOrder() == BitView::BO_LSB_FIRST)
+    {
+        Update(reg, data.GetBytes(), data.GetNumberOfBits());
+        return;
+    }
+    // Bring MSB-first bytes into sequence order a chunk at a time.
+    const size_t CHUNK_BITS = 4096;
+    uint64_t chunk[CHUNK_BITS / PackedBits::WORD_BITS];
+    for (size_t first = 0; first < data.GetNumberOfBits(); first += CHUNK_BITS)
+    {
+        size_t n = data.GetNumberOfBits() - first < CHUNK_BITS ? data.GetNumberOfBits() - first : CHUNK_BITS;
+        data.CopyBits(first, n, chunk);
+        Update(reg, chunk, n);
+    }
+}
+
+template <size_t COUNT>
+void LfsrDivider::UpdateInterleaved(const LfsrDivider* const* dividers, const size_t* offsets, size_t count,
+                                    uint64_t* regs, const uint8_t* data, size_t numBytes)
+{
+    // The same slicing-by-8 step as UpdateWords<1>, over independent registers.
+    const size_t n = COUNT ? COUNT : count;
+    const uint64_t* t[MAX_INTERLEAVED];
+    uint64_t r[MAX_INTERLEAVED];
+    for (size_t c = 0; c < n; ++c)
+    {
+        t[c] = &dividers[c]->tables_[0];
+        r[c] = regs[offsets[c]];
+    }
+    for (size_t i = 0; i + 8 <= numBytes; i += 8)
+    {
+        uint64_t d = PackedBits::LoadLittleEndian(data + i);
+        for (size_t c = 0; c < n; ++c)
+        {
+            uint64_t x = d ^ r[c];
+            const uint64_t* tc = t[c];
+            r[c] = tc[7 * 256 + (x & 0xFF)] ^ tc[6 * 256 + ((x >> 8) & 0xFF)]
+                 ^ tc[5 * 256 + ((x >> 16) & 0xFF)] ^ tc[4 * 256 + ((x >> 24) & 0xFF)]
+                 ^ tc[3 * 256 + ((x >> 32) & 0xFF)] ^ tc[2 * 256 + ((x >> 40) & 0xFF)]
+                 ^ tc[1 * 256 + ((x >> 48) & 0xFF)] ^ tc[(x >> 56) & 0xFF];
+        }
+    }
+    for (size_t c = 0; c < n; ++c)
+    {
+        regs[offsets[c]] = r[c];
+    }
+}
+
+void LfsrDivider::UpdateMany(const LfsrDivider* const* dividers, const size_t* offsets, size_t count,
+                             uint64_t* regs, const uint8_t* data, size_t numBits)
+{
+    // Blocks stay in L1 while every divider goes over them.
+    const size_t BLOCK_BYTES = 4096;
+    const size_t numBytes = numBits / 8;
+    const LfsrDivider* singles[MAX_INTERLEAVED];
+    size_t singleOffsets[MAX_INTERLEAVED];
+    for (size_t first = 0; first < numBytes; first += BLOCK_BYTES)
+    {
+        const size_t n = numBytes - first < BLOCK_BYTES ? numBytes - first : BLOCK_BYTES;
+        const size_t whole = n / 8 * 8;
+        for (size_t c = 0; c < count; ++c)
+        {
+            if (dividers[c]->numWords_ != 1)
+            {
+                dividers[c]->Update(regs + offsets[c], data + first, 8 * n);
+            }
+        }
+        // The single-word ones, MAX_INTERLEAVED at a time.
+        for (size_t c = 0; c < count; )
+        {
+            size_t numSingles = 0;
+            for (; c < count && numSingles < MAX_INTERLEAVED; ++c)
+            {
+                if (dividers[c]->numWords_ == 1)
+                {
+                    singles[numSingles] = dividers[c];
+                    singleOffsets[numSingles] = offsets[c];
+                    ++numSingles;
+                }
+            }
+            CODECS_COUNT(Instrumentation::CT_CRC_BYTES, numSingles * whole);
+            switch (numSingles)
+            {
+            case 0:
+                break;
+            case 2:
+                UpdateInterleaved<2>(singles, singleOffsets, numSingles, regs, data + first, whole);
+                break;
+            case 3:
+                UpdateInterleaved<3>(singles, singleOffsets, numSingles, regs, data + first, whole);
+                break;
+            case 4:
+                UpdateInterleaved<4>(singles, singleOffsets, numSingles, regs, data + first, whole);
+                break;
+            default:
+                UpdateInterleaved<0>(singles, singleOffsets, numSingles, regs, data + first, whole);
+                break;
+            }
+            for (size_t k = 0; k < numSingles && whole < n; ++k)
+            {
+                singles[k]->Update(regs + singleOffsets[k], data + first + whole, 8 * (n - whole));
+            }
+        }
+    }
+    for (size_t c = 0; c < count && numBits % 8; ++c)
+    {
+        dividers[c]->Update(regs + offsets[c], data + numBytes, numBits % 8);
+    }
+}
+
+std::vector<bool> LfsrDivider::Remainder(const std::vector<bool>& message) const
+{
+    std::vector<uint64_t> data = PackedBits::FromVector(message);
+    std::vector<uint64_t> reg(numWords_ + 1, 0);
+    Update(&reg[0], data.empty() ? nullptr : &data[0], message.size());
+    return PackedBits::ToVector(&reg[0], degree_);
+}
+
+void LfsrDivider::MultiplyMod(uint64_t* a, const uint64_t* b) const
+{
+    // Horner's rule over the coefficients of b, from x^(r-1) (bit 0) down.
+    if (numWords_ == 1)
+    {
+        uint64_t acc = 0;
+        for (size_t j = 0; j < degree_; ++j)
+        {
+            acc = (acc >> 1) ^ (feedback_[0] & (0 - (acc & 1)));
+            acc ^= a[0] & (0 - ((b[0] >> j) & 1));
+        }
+        a[0] = acc;
+        return;
+    }
+    ScratchArena::Scope scope;
+    uint64_t* acc = static_cast<uint64_t*>(ScratchArena::GetInstance().Allocate(numWords_ * sizeof (uint64_t), 8));
+    std::memset(acc, 0, numWords_ * sizeof (uint64_t));
+    for (size_t j = 0; j < degree_; ++j)
+    {
+        UpdateBit(acc, false);
+        if (PackedBits::GetBit(b, j))
+        {
+            for (size_t w = 0; w < numWords_; ++w)
+            {
+                acc[w] ^= a[w];
+            }
+        }
+    }
+    std::memcpy(a, acc, numWords_ * sizeof (uint64_t));
+    ScratchArena::GetInstance().Deallocate(acc);
+}
+
+void LfsrDivider::MultiplyByPowerOfX(uint64_t* reg, uint64_t k) const
+{
+    for (size_t i = 0; k && numWords_; ++i, k >>= 1)
+    {
+        if (k & 1)
+        {
+            MultiplyMod(reg, &powers_[i * numWords_]);
+        }
+    }
+}
+
+void LfsrDivider::UpdateCrc(uint64_t* crc, size_t totalBits, size_t offset,
+                            const uint64_t* oldBits, const uint64_t* newBits, size_t numBits) const
+{
+    assert(offset + numBits <= totalBits);
+    if (!numWords_)
+    {
+        return;
+    }
+    ScratchArena::Scope scope;
+    ScratchArena& arena = ScratchArena::GetInstance();
+    size_t n = PackedBits::GetNumberOfWords(numBits);
+    uint64_t* delta = static_cast<uint64_t*>(arena.Allocate((n + 1) * sizeof (uint64_t), 8));
+    uint64_t* reg = static_cast<uint64_t*>(arena.Allocate((numWords_ + 1) * sizeof (uint64_t), 8));
+    for (size_t w = 0; w < n; ++w)
+    {
+        delta[w] = oldBits[w] ^ newBits[w];
+    }
+    std::memset(reg, 0, (numWords_ + 1) * sizeof (uint64_t));
+    Update(reg, delta, numBits);
+    MultiplyByPowerOfX(reg, totalBits - offset - numBits);
+    for (size_t w = 0; w < numWords_; ++w)
+    {
+        crc[w] ^= reg[w];
+    }
+    arena.Deallocate(reg);
+    arena.Deallocate(delta);
+}
+
+std::vector<bool> LfsrDivider::UpdateCrc(const std::vector<bool>& oldCrc, size_t totalBits, size_t offset,
+                                         const std::vector<bool>& oldBits, const std::vector<bool>& newBits) const
+{
+    assert(oldCrc.size() == degree_ && oldBits.size() == newBits.size());
+    std::vector<uint64_t> crc(numWords_ + 1, 0);
+    PackedBits::FromVector(oldCrc, &crc[0]);
+    std::vector<uint64_t> before = PackedBits::FromVector(oldBits);
+    std::vector<uint64_t> after = PackedBits::FromVector(newBits);
+    UpdateCrc(&crc[0], totalBits, offset, before.empty() ? nullptr : &before[0],
+              after.empty() ? nullptr : &after[0], oldBits.size());
+    return PackedBits::ToVector(&crc[0], degree_);
+}
+
+#include "DataIo.h"
+#include "PolynomialDivider.h"
+void LfsrDivider::Test(void)
+{
+    // Remainder against PolynomialDivider::Divide, for generators of
+    // various degrees and messages of various lengths.
+    const char* generators[] =
+    {
+        "11",
+        "1011",
+        "1 0001 0000 0010 0001",
+        "1 0000 0100 1100 0001 0001 1101 1011 0111",
+        "1 0100 0010 1111 0000 1110 0001 1110 1010 1110 1001 0011 0010 0100 1001 1011 0110 1010 1011",
+    };
+    uint64_t x = 0x243F6A8885A308D3ULL;
+    for (size_t g = 0; g < sizeof (generators) / sizeof (generators[0]); ++g)
+    {
+        LfsrDivider lfsr(DataIo::FromString(generators[g]));
+        const size_t lengths[] = { 0, 1, 7, 8, 9, 63, 64, 65, 200, 1001 };
+        for (size_t l = 0; l < sizeof (lengths) / sizeof (lengths[0]); ++l)
+        {
+            std::vector<bool> message(lengths[l], false);
+            for (size_t i = 0; i < message.size(); ++i)
+            {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                message[i] = x & 1;
+            }
+            std::vector<bool> dividend = message;
+            dividend.resize(message.size() + lfsr.GetDegree(), false);
+            std::vector<bool> quotient;
+            std::vector<bool> remainder;
+            PolynomialDivider::Divide(dividend, lfsr.GetGenerator(), quotient, remainder);
+            assert(lfsr.Remainder(message) == remainder);
+        }
+    }
+
+    // Leading zeros of the generator are ignored.
+    LfsrDivider crc4(DataIo::FromString("0010011"));
+    assert(crc4.GetDegree() == 4);
+    assert(crc4.Remainder(DataIo::FromString("1100 0101")) == DataIo::FromString("0110"));
+
+    // Byte buffers viewed in both bit orders.
+    LfsrDivider crc32(DataIo::FromString(generators[3]));
+    std::vector<uint8_t> bytes(1000, 0);
+    for (size_t i = 0; i < bytes.size(); ++i)
+    {
+        bytes[i] = static_cast<uint8_t>(i * 7 + (i >> 3));
+    }
+    const size_t numBits = 8 * bytes.size() - 3;
+    for (unsigned order = 0; order < 2; ++order)
+    {
+        BitView view(&bytes[0], numBits, order ? BitView::BO_MSB_FIRST : BitView::BO_LSB_FIRST);
+        std::vector<bool> message(numBits, false);
+        for (size_t i = 0; i < numBits; ++i)
+        {
+            message[i] = view.GetBit(i);
+        }
+        uint64_t reg = 0;
+        crc32.Update(&reg, view);
+        assert(PackedBits::ToVector(&reg, 32) == crc32.Remainder(message));
+    }
+
+    // x^k by powers against feeding k zeros.
+    for (size_t g = 0; g < sizeof (generators) / sizeof (generators[0]); ++g)
+    {
+        LfsrDivider lfsr(DataIo::FromString(generators[g]));
+        const size_t ks[] = { 0, 1, 2, 63, 64, 65, 1000, 4097 };
+        for (size_t i = 0; i < sizeof (ks) / sizeof (ks[0]); ++i)
+        {
+            std::vector<bool> message(37, false);
+            message[0] = message[5] = message[36] = true;
+            std::vector<uint64_t> reg = PackedBits::FromVector(lfsr.Remainder(message));
+            reg.resize(lfsr.GetNumberOfWords() + 1, 0);
+            lfsr.MultiplyByPowerOfX(&reg[0], ks[i]);
+            message.resize(message.size() + ks[i], false);
+            assert(PackedBits::ToVector(&reg[0], lfsr.GetDegree()) == lfsr.Remainder(message));
+        }
+    }
+
+    // Updates of a few bits anywhere, against dividing the whole new message.
+    for (size_t g = 0; g < sizeof (generators) / sizeof (generators[0]); ++g)
+    {
+        LfsrDivider lfsr(DataIo::FromString(generators[g]));
+        std::vector<bool> message(3001, false);
+        for (size_t i = 0; i < message.size(); ++i)
+        {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            message[i] = x & 1;
+        }
+        std::vector<bool> crc = lfsr.Remainder(message);
+        const size_t offsets[] = { 0, 1, 100, 2000, 2990, 3000 };
+        const size_t sizes[] = { 1, 11, 1, 130, 11, 1 };
+        for (size_t i = 0; i < sizeof (offsets) / sizeof (offsets[0]); ++i)
+        {
+            std::vector<bool> before(message.begin() + offsets[i], message.begin() + offsets[i] + sizes[i]);
+            std::vector<bool> after(before);
+            for (size_t j = 0; j < after.size(); j += 2)
+            {
+                after[j] = !after[j];
+            }
+            std::copy(after.begin(), after.end(), message.begin() + offsets[i]);
+            crc = lfsr.UpdateCrc(crc, message.size(), offsets[i], before, after);
+            std::vector<bool> dividend = message;
+            dividend.resize(message.size() + lfsr.GetDegree(), false);
+            std::vector<bool> quotient;
+            std::vector<bool> remainder;
+            PolynomialDivider::Divide(dividend, lfsr.GetGenerator(), quotient, remainder);
+            assert(crc == remainder);
+        }
+    }
+}
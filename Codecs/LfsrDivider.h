@@ -0,0 +1,142 @@
+#pragma once
+#include "BitView.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Table-driven division by a fixed GF(2) polynomial, as done by a CRC engine.
+ *
+ * The register holds the running remainder as a packed bit sequence
+ * (see PackedBits) in big-endian order: bit j is the coefficient of
+ * x^(r - 1 - j), where r is the degree of the generator.  Message bits are
+ * fed in sequence order, eight bytes at a time through slicing-by-8 tables,
+ * so after feeding a message M the register holds M(x) * x^r mod G(x),
+ * i.e. the same remainder as PolynomialDivider::Divide() gives for M
+ * followed by r zeros.
+ *
+ * Generators of any degree are supported; the register spans
+ * (r + 63) / 64 words.
+ */
+class LfsrDivider
+{
+public:
+    /**
+     * @param [in] generator   the divisor in big-endian order; it must not be zero.
+     */
+    explicit LfsrDivider(const std::vector<bool>& generator);
+
+    /**
+     * @return The generator without its leading zeros.
+     */
+    const std::vector<bool>& GetGenerator(void) const;
+
+    /**
+     * @return The degree r of the generator, i.e. the number of remainder bits.
+     */
+    size_t GetDegree(void) const;
+
+    /**
+     * @return The number of words of a register.
+     */
+    size_t GetNumberOfWords(void) const;
+
+    /**
+     * Feed \c numBits message bits.
+     * @param [in,out] reg       GetNumberOfWords() words; zero to start a new division.
+     * @param [in]     data      a packed bit sequence.
+     * @param [in]     numBits   the number of bits of \c data.
+     */
+    void Update(uint64_t* reg, const uint64_t* data, size_t numBits) const;
+
+    /**
+     * Feed \c numBits message bits packed into bytes, the first bit being
+     * the least significant bit of the first byte.
+     */
+    void Update(uint64_t* reg, const uint8_t* data, size_t numBits) const;
+
+    /**
+     * Feed the bits of a byte buffer in place; LSB-first views are not copied.
+     */
+    void Update(uint64_t* reg, const BitView& data) const;
+
+    /**
+     * Feed the same bytes to several dividers, loading the data once.
+     * Dividers with single-word registers advance together eight bytes at a
+     * time, their table lookups interleaved; the others follow a cache-sized
+     * block at a time.
+     * @param [in]     dividers   \c count dividers.
+     * @param [in]     offsets    the first word of the register of each divider in \c regs.
+     * @param [in,out] regs       the registers.
+     */
+    static void UpdateMany(const LfsrDivider* const* dividers, const size_t* offsets, size_t count,
+                           uint64_t* regs, const uint8_t* data, size_t numBits);
+
+    /**
+     * @return The remainder of message(x) * x^r divided by the generator, r bits.
+     */
+    std::vector<bool> Remainder(const std::vector<bool>& message) const;
+
+    /**
+     * Multiply the register by x^k modulo the generator, as feeding k zero
+     * bits would, with O(log k) products of precomputed powers x^(2^i).
+     */
+    void MultiplyByPowerOfX(uint64_t* reg, uint64_t k) const;
+
+    /**
+     * Update the remainder of a message after some of its bits change,
+     * without feeding the unchanged bits.  The remainder is linear in the
+     * message, so it changes by the remainder of the changed bits, moved to
+     * their place by x^(totalBits - offset - numBits).
+     * @param [in,out] crc         GetNumberOfWords() words: the remainder of the old message.
+     * @param [in]     totalBits   the length of the message.
+     * @param [in]     offset      the first changed bit, in sequence order.
+     * @param [in]     oldBits     the \c numBits bits at \c offset before the change.
+     * @param [in]     newBits     the same bits after the change.
+     */
+    void UpdateCrc(uint64_t* crc, size_t totalBits, size_t offset,
+                   const uint64_t* oldBits, const uint64_t* newBits, size_t numBits) const;
+
+    /**
+     * @return The remainder of the message after the bits at \c offset change
+     * from \c oldBits to \c newBits, given its remainder \c oldCrc before.
+     */
+    std::vector<bool> UpdateCrc(const std::vector<bool>& oldCrc, size_t totalBits, size_t offset,
+                                const std::vector<bool>& oldBits, const std::vector<bool>& newBits) const;
+
+    static void Test(void);
+
+private:
+    void UpdateBit(uint64_t* reg, bool bit) const;
+    void UpdateByte(uint64_t* reg, uint8_t byte) const;
+
+    /**
+     * a = a * b mod G, both registers.
+     */
+    void MultiplyMod(uint64_t* a, const uint64_t* b) const;
+
+    /**
+     * Feed whole 8-byte groups of \c numBytes bytes.
+     * @return The number of bytes fed.
+     */
+    template <size_t WORDS>
+    size_t UpdateWords(uint64_t* reg, const uint8_t* data, size_t numBytes) const;
+
+    /**
+     * Feed whole 8-byte groups of \c numBytes bytes to \c count (<= MAX_INTERLEAVED)
+     * dividers with single-word registers; COUNT is \c count, or 0 if only known at run time.
+     */
+    template <size_t COUNT>
+    static void UpdateInterleaved(const LfsrDivider* const* dividers, const size_t* offsets, size_t count,
+                                  uint64_t* regs, const uint8_t* data, size_t numBytes);
+
+    static const size_t MAX_INTERLEAVED = 8;
+
+private:
+    std::vector<bool> generator_;
+    size_t degree_;
+    size_t numWords_;
+    std::vector<uint64_t> feedback_;    ///< the generator without x^r, in register order.
+    std::vector<uint64_t> tables_;      ///< 8 x 256 entries of numWords_ words.
+    std::vector<uint64_t> powers_;      ///< x^(2^i) mod G for i < 64, numWords_ words each.
+};
@@ -1,28 +1,91 @@
 #include <iostream>
+#include <string>
+#include <vector>
 #include "DataIo.h"
 #include "PolynomialDivider.h"
+#include "PackedBits.h"
+#include "BitView.h"
+#include "BitTranspose.h"
 #include "BitMatrix.h"
 #include "HammingCodecs.h"
+#include "BlockInterleaver.h"
+#include "GaloisField256.h"
+#include "ReedSolomon.h"
+#include "LfsrDivider.h"
+#include "BchCodecs.h"
+#include "ConvolutionalCodecs.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "OrderedPipeline.h"
+#include "FileCodecs.h"
+#include "AllocationCounter.h"
+#include "ScratchArena.h"
+#include "Instrumentation.h"
+#include "BerSimulator.h"
+#include "CrcAnalyzer.h"
+#include "CrcManifest.h"
+#include "CrcCorrector.h"
+#include "MultiCrc.h"
+#include "CodecPipeline.h"
+#include "JobProtocol.h"
+#include "JobServer.h"
+#include "JobClient.h"
+#include "CliEngine.h"
 #include "UiEngine.h"
 
 void Test(void);
 
-int main(void)
+int main(int argc, char* argv[])
 {
-    std::cout << "Codecs v1.1 (2017.05.11)" << std::endl;
-    std::cout << "(c) University of Electronic Science and Technology of China (UESTC)." << std::endl;
-    std::cout << "All right reserved." << std::endl;
-    Test();
-//    return 0;
-    UiEngine ui;
-    ui.Loop();
-    return 0;
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (args.size() == 1 && args[0] == "--menu")
+    {
+        std::cout << "Codecs v1.1 (2017.05.11)" << std::endl;
+        std::cout << "(c) University of Electronic Science and Technology of China (UESTC)." << std::endl;
+        std::cout << "All right reserved." << std::endl;
+        UiEngine ui;
+        ui.Loop();
+        return 0;
+    }
+    if (args.size() == 1 && args[0] == "--self-test")
+    {
+        Test();
+        std::cout << "All tests passed." << std::endl;
+        return 0;
+    }
+    CliEngine cli;
+    return cli.Run(args);
 }
 
 void Test(void)
 {
     DataIo::Test();
     PolynomialDivider::Test();
+    PackedBits::Test();
+    ScratchArena::Test();
+    BitView::Test();
+    BitTranspose::Test();
     BitMatrix::Test();
     HammingCodecs::Test();
+    BlockInterleaver::Test();
+    GaloisField256::Test();
+    ReedSolomon::Test();
+    LfsrDivider::Test();
+    BchCodecs::Test();
+    ConvolutionalCodecs::Test();
+    MappedFile::Test();
+    ThreadPool::Test();
+    OrderedPipeline::Test();
+    FileCodecs::Test();
+    AllocationCounter::Test();
+    Instrumentation::Test();
+    BerSimulator::Test();
+    CrcAnalyzer::Test();
+    CrcManifest::Test();
+    CrcCorrector::Test();
+    MultiCrc::Test();
+    CodecPipeline::Test();
+    JobProtocol::Test();
+    JobServer::Test();
+    JobClient::Test();
 }
@@ -0,0 +1,261 @@
+#include "MappedFile.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(void) :
+    data_(nullptr),
+    size_(0),
+    open_(false)
+#if defined(_WIN32)
+    , file_(INVALID_HANDLE_VALUE),
+    mapping_(nullptr)
+#else
+    , fd_(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile(void)
+{
+    Close();
+}
+
+#if defined(_WIN32)
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    LARGE_INTEGER size;
+    if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size))
+    {
+        Close();
+        return false;
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    open_ = true;
+    if (size_)
+    {
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data_ = mapping_ ? static_cast<uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (!data_)
+        {
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MappedFile::Create(const std::string& path, size_t size)
+{
+    Close();
+    file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+    {
+        Close();
+        return false;
+    }
+    size_ = size;
+    open_ = true;
+    if (size_)
+    {
+        uint64_t size64 = size;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE,
+                                      static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), nullptr);
+        data_ = mapping_ ? static_cast<uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, 0)) : nullptr;
+        if (!data_)
+        {
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void MappedFile::Close(void)
+{
+    if (data_)
+    {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_)
+    {
+        CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = nullptr;
+}
+
+bool MappedFile::GetModificationTime(const std::string& path, uint64_t& time)
+{
+    // 100-nanosecond intervals since 1601.
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes))
+    {
+        return false;
+    }
+    time = (uint64_t(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+#else
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+    fd_ = open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd_ < 0 || fstat(fd_, &status) != 0)
+    {
+        Close();
+        return false;
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    open_ = true;
+    if (size_)
+    {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+        if (data == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+        data_ = static_cast<uint8_t*>(data);
+        madvise(data, size_, MADV_SEQUENTIAL);
+    }
+    return true;
+}
+
+bool MappedFile::Create(const std::string& path, size_t size)
+{
+    Close();
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0 || ftruncate(fd_, static_cast<off_t>(size)) != 0)
+    {
+        Close();
+        return false;
+    }
+    size_ = size;
+    open_ = true;
+    if (size_)
+    {
+        void* data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (data == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+        data_ = static_cast<uint8_t*>(data);
+        madvise(data, size_, MADV_SEQUENTIAL);
+    }
+    return true;
+}
+
+void MappedFile::Close(void)
+{
+    if (data_)
+    {
+        munmap(data_, size_);
+    }
+    if (fd_ >= 0)
+    {
+        close(fd_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    fd_ = -1;
+}
+
+bool MappedFile::GetModificationTime(const std::string& path, uint64_t& time)
+{
+    // Nanoseconds since 1970 where the system keeps them, else seconds.
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0)
+    {
+        return false;
+    }
+#if defined(__linux__)
+    time = uint64_t(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+#else
+    time = uint64_t(status.st_mtime);
+#endif
+    return true;
+}
+#endif
+
+bool MappedFile::IsOpen(void) const
+{
+    return open_;
+}
+
+size_t MappedFile::GetSize(void) const
+{
+    return size_;
+}
+
+const uint8_t* MappedFile::GetData(void) const
+{
+    return data_;
+}
+
+uint8_t* MappedFile::GetData(void)
+{
+    return data_;
+}
+
+void MappedFile::Test(void)
+{
+    const char* path = "MappedFile.test.tmp";
+    const char text[] = "memory-mapped";
+    bool ok = false;
+    {
+        MappedFile out;
+        ok = out.Create(path, sizeof (text));
+        assert(ok);
+        std::memcpy(out.GetData(), text, sizeof (text));
+    }
+    MappedFile in;
+    ok = in.Open(path);
+    assert(ok);
+    assert(in.GetSize() == sizeof (text));
+    assert(std::memcmp(in.GetData(), text, sizeof (text)) == 0);
+    in.Close();
+    assert(!in.IsOpen());
+    uint64_t time = 0;
+    ok = GetModificationTime(path, time);
+    assert(ok && time != 0);
+
+    // Empty files map to nothing.
+    MappedFile empty;
+    ok = empty.Create(path, 0);
+    assert(ok);
+    empty.Close();
+    ok = empty.Open(path);
+    assert(ok);
+    assert(empty.GetSize() == 0 && empty.GetData() == nullptr);
+    empty.Close();
+    std::remove(path);
+
+    ok = in.Open("MappedFile.missing.tmp");
+    assert(!ok);
+    ok = GetModificationTime(path, time);
+    assert(!ok);
+    (void)ok;
+}
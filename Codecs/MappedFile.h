@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * A file mapped into memory.
+ *
+ * Files opened for reading are advised for sequential access, so the
+ * kernel reads ahead and drops pages behind; files created for writing
+ * get their final size up front and are written through the mapping.
+ * An empty file maps to a null pointer of size 0.
+ */
+class MappedFile
+{
+public:
+    MappedFile(void);
+    ~MappedFile(void);
+
+    /**
+     * Map an existing file for reading.
+     * @return false if the file cannot be opened or mapped.
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * Create (or truncate) a file of \c size bytes and map it for writing.
+     * @return false if the file cannot be created or mapped.
+     */
+    bool Create(const std::string& path, size_t size);
+
+    /**
+     * Unmap and close the file; written pages are left to the kernel to flush.
+     */
+    void Close(void);
+
+    bool IsOpen(void) const;
+    size_t GetSize(void) const;
+    const uint8_t* GetData(void) const;
+    uint8_t* GetData(void);
+
+    /**
+     * @param [out] time   the last modification time, in units that depend on
+     *                     the system; it changes when the file is written.
+     * @return false if the file does not exist.
+     */
+    static bool GetModificationTime(const std::string& path, uint64_t& time);
+
+    static void Test(void);
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+private:
+    uint8_t* data_;
+    size_t size_;
+    bool open_;
+#if defined(_WIN32)
+    void* file_;        ///< HANDLE of the file.
+    void* mapping_;     ///< HANDLE of the file mapping.
+#else
+    int fd_;
+#endif
+};
@@ -0,0 +1,124 @@
+#include "MultiCrc.h"
+#include "PackedBits.h"
+#include <cassert>
+
+MultiCrc::MultiCrc(const std::vector<std::vector<bool>>& generators) :
+    offsets_(1, 0)
+{
+    for (size_t i = 0; i < generators.size(); ++i)
+    {
+        dividers_.push_back(LfsrDivider(generators[i]));
+        offsets_.push_back(offsets_.back() + dividers_.back().GetNumberOfWords());
+    }
+    for (size_t i = 0; i < dividers_.size(); ++i)
+    {
+        pointers_.push_back(&dividers_[i]);
+    }
+}
+
+size_t MultiCrc::GetNumberOfCrcs(void) const
+{
+    return dividers_.size();
+}
+
+const LfsrDivider& MultiCrc::GetDivider(size_t i) const
+{
+    return dividers_[i];
+}
+
+size_t MultiCrc::GetOffset(size_t i) const
+{
+    return offsets_[i];
+}
+
+size_t MultiCrc::GetNumberOfWords(void) const
+{
+    return offsets_.back();
+}
+
+void MultiCrc::Update(uint64_t* regs, const uint8_t* data, size_t numBits) const
+{
+    if (!dividers_.empty())
+    {
+        LfsrDivider::UpdateMany(&pointers_[0], &offsets_[0], dividers_.size(), regs, data, numBits);
+    }
+}
+
+void MultiCrc::Update(uint64_t* regs, const uint64_t* data, size_t numBits) const
+{
+    // Packed words are laid out in memory as the byte form on little-endian hosts.
+    Update(regs, reinterpret_cast<const uint8_t*>(data), numBits);
+}
+
+std::vector<std::vector<bool>> MultiCrc::Remainders(const std::vector<bool>& message) const
+{
+    std::vector<uint64_t> data = PackedBits::FromVector(message);
+    std::vector<uint64_t> regs(GetNumberOfWords() + 1, 0);
+    Update(&regs[0], data.empty() ? nullptr : &data[0], message.size());
+    std::vector<std::vector<bool>> remainders;
+    for (size_t i = 0; i < dividers_.size(); ++i)
+    {
+        remainders.push_back(PackedBits::ToVector(&regs[offsets_[i]], dividers_[i].GetDegree()));
+    }
+    return remainders;
+}
+
+#include "DataIo.h"
+#include "PolynomialDivider.h"
+void MultiCrc::Test(void)
+{
+    // Single-word CRCs interleaved, beyond MAX_INTERLEAVED, mixed with multi-word ones.
+    const char* generators[] =
+    {
+        "1 0000 0111",
+        "1 0001 0000 0010 0001",
+        "1 0000 0100 1100 0001 0001 1101 1011 0111",
+        "1 0100 0010 1111 0000 1110 0001 1110 1010 1110 1001 0011 0010 0100 1001 1011 0110 1010 1011",
+        "11",
+        "1011",
+        "10011",
+        "100101",
+        "1000011",
+        "10001001",
+        "1 0000 0000 0000 0000 0000 0000 0000 0000 0000 0000 0000 0000 0000 0000 0000 0001 1011",
+    };
+    const size_t numGenerators = sizeof (generators) / sizeof (generators[0]);
+    uint64_t x = 0x13198A2E03707344ULL;
+    const size_t lengths[] = { 0, 1, 7, 8, 9, 63, 64, 65, 4096 * 8, 4096 * 8 + 8 * 13 + 5, 70001 };
+    const size_t counts[] = { 0, 1, 2, 3, 4, 5, numGenerators };
+    for (size_t n = 0; n < sizeof (counts) / sizeof (counts[0]); ++n)
+    {
+        std::vector<std::vector<bool>> set;
+        for (size_t g = 0; g < counts[n]; ++g)
+        {
+            set.push_back(DataIo::FromString(generators[g]));
+        }
+        MultiCrc crcs(set);
+        assert(crcs.GetNumberOfCrcs() == set.size());
+        for (size_t l = 0; l < sizeof (lengths) / sizeof (lengths[0]); ++l)
+        {
+            std::vector<bool> message(lengths[l], false);
+            for (size_t i = 0; i < message.size(); ++i)
+            {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                message[i] = x & 1;
+            }
+            std::vector<std::vector<bool>> remainders = crcs.Remainders(message);
+            for (size_t i = 0; i < set.size(); ++i)
+            {
+                assert(remainders[i] == crcs.GetDivider(i).Remainder(message));
+            }
+            if (lengths[l] == 65 && !set.empty())
+            {
+                std::vector<bool> dividend = message;
+                dividend.resize(message.size() + crcs.GetDivider(0).GetDegree(), false);
+                std::vector<bool> quotient;
+                std::vector<bool> remainder;
+                PolynomialDivider::Divide(dividend, set[0], quotient, remainder);
+                assert(remainders[0] == remainder);
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "LfsrDivider.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Several CRCs of the same data in a single pass.
+ *
+ * The registers of the CRCs are kept back to back, GetOffset(i) being the
+ * first word of the i-th; the data is loaded once for all of them (see
+ * LfsrDivider::UpdateMany()), so memory traffic does not grow with the
+ * number of CRCs.
+ */
+class MultiCrc
+{
+public:
+    /**
+     * @param [in] generators   the divisors in big-endian order; none may be zero.
+     */
+    explicit MultiCrc(const std::vector<std::vector<bool>>& generators);
+
+    size_t GetNumberOfCrcs(void) const;
+    const LfsrDivider& GetDivider(size_t i) const;
+
+    /**
+     * @return The first word of the register of the i-th CRC.
+     */
+    size_t GetOffset(size_t i) const;
+
+    /**
+     * @return The number of words of all the registers.
+     */
+    size_t GetNumberOfWords(void) const;
+
+    /**
+     * Feed \c numBits message bits to every CRC.
+     * @param [in,out] regs   GetNumberOfWords() words; zero to start new divisions.
+     * @param [in]     data   bytes, the first bit being the least significant bit of the first byte.
+     */
+    void Update(uint64_t* regs, const uint8_t* data, size_t numBits) const;
+
+    /**
+     * Feed a packed bit sequence, see PackedBits.
+     */
+    void Update(uint64_t* regs, const uint64_t* data, size_t numBits) const;
+
+    /**
+     * @return The remainder of each CRC, as LfsrDivider::Remainder().
+     */
+    std::vector<std::vector<bool>> Remainders(const std::vector<bool>& message) const;
+
+    static void Test(void);
+
+private:
+    MultiCrc(const MultiCrc&);
+    MultiCrc& operator=(const MultiCrc&);
+
+private:
+    std::vector<LfsrDivider> dividers_;
+    std::vector<const LfsrDivider*> pointers_;  ///< to dividers_, for LfsrDivider::UpdateMany().
+    std::vector<size_t> offsets_;               ///< one more than the dividers: the total words.
+};
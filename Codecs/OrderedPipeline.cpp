@@ -0,0 +1,197 @@
+#include "OrderedPipeline.h"
+#include <cassert>
+#include <cstring>
+#include <thread>
+
+OrderedPipeline::OrderedPipeline(ThreadPool& pool, size_t chunkSize, size_t outputCapacity, size_t numSlots) :
+    pool_(pool),
+    chunkSize_(chunkSize),
+    slots_(numSlots ? numSlots : 3 * pool.GetNumberOfThreads()),
+    numRead_(0),
+    numWritten_(0),
+    numTransforming_(0),
+    endOfInput_(false),
+    stopped_(false)
+{
+    assert(chunkSize > 0);
+    for (size_t i = 0; i < slots_.size(); ++i)
+    {
+        slots_[i].input.resize(chunkSize);
+        slots_[i].output.resize(outputCapacity + 1);
+        slots_[i].ready = false;
+    }
+}
+
+bool OrderedPipeline::Run(const Reader& reader, const Transform& transform, const Writer& writer)
+{
+    numRead_ = 0;
+    numWritten_ = 0;
+    endOfInput_ = false;
+    stopped_ = false;
+    std::thread writerThread(&OrderedPipeline::Write, this, std::cref(writer));
+    bool isLast = false;
+    while (!isLast)
+    {
+        // Chunk i lives in slot i % numSlots, free once chunk i - numSlots is written.
+        Slot* slot = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stopped_ && numRead_ - numWritten_ == slots_.size())
+            {
+                changed_.wait(lock);
+            }
+            if (stopped_)
+            {
+                break;
+            }
+            slot = &slots_[numRead_ % slots_.size()];
+        }
+        slot->inputSize = reader(&slot->input[0], chunkSize_);
+        // A full chunk at the end of the input is followed by an empty last chunk.
+        isLast = slot->inputSize < chunkSize_;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++numRead_;
+            ++numTransforming_;
+        }
+        pool_.Submit([this, slot, &transform, isLast]()
+        {
+            size_t outputSize = transform(&slot->input[0], slot->inputSize, isLast, &slot->output[0]);
+            assert(outputSize < slot->output.size());
+            // Notified under the lock, as Run() may return as soon as the count drops.
+            std::lock_guard<std::mutex> lock(mutex_);
+            slot->outputSize = outputSize;
+            slot->ready = true;
+            --numTransforming_;
+            changed_.notify_all();
+        });
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        endOfInput_ = true;
+    }
+    changed_.notify_all();
+    writerThread.join();
+    // Workers may still hold slots of chunks the writer skipped after a stop.
+    // Only this pipeline's chunks are waited for, not the whole pool, so that
+    // Run() may be called from a task of the pool.
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (numTransforming_)
+    {
+        changed_.wait(lock);
+    }
+    return !stopped_;
+}
+
+void OrderedPipeline::Write(const Writer& writer)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        Slot& slot = slots_[numWritten_ % slots_.size()];
+        while (!(numWritten_ < numRead_ && slot.ready) && !(endOfInput_ && numWritten_ == numRead_))
+        {
+            changed_.wait(lock);
+        }
+        if (numWritten_ == numRead_)
+        {
+            return;
+        }
+        lock.unlock();
+        bool ok = writer(&slot.output[0], slot.outputSize);
+        lock.lock();
+        slot.ready = false;
+        ++numWritten_;
+        if (!ok)
+        {
+            stopped_ = true;
+        }
+        changed_.notify_all();
+        if (stopped_)
+        {
+            return;
+        }
+    }
+}
+
+void OrderedPipeline::Test(void)
+{
+    // Reverse the bytes of each chunk; the output must keep the chunk order
+    // whatever the order the workers finish in.
+    std::vector<uint8_t> input(100003, 0);
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        input[i] = static_cast<uint8_t>(i * 17 + (i >> 8));
+    }
+    const size_t chunkSize = 1000;
+    ThreadPool pool(4);
+    for (size_t numSlots = 1; numSlots <= 12; numSlots += 11)
+    {
+        OrderedPipeline pipeline(pool, chunkSize, chunkSize, numSlots);
+        size_t position = 0;
+        std::vector<uint8_t> output;
+        size_t numLast = 0;
+        bool ok = pipeline.Run(
+            [&](uint8_t* buffer, size_t capacity) -> size_t
+            {
+                size_t n = input.size() - position < capacity ? input.size() - position : capacity;
+                std::memcpy(buffer, &input[position], n);
+                position += n;
+                return n;
+            },
+            [&](const uint8_t* in, size_t numBytes, bool isLast, uint8_t* out) -> size_t
+            {
+                for (size_t i = 0; i < numBytes; ++i)
+                {
+                    out[i] = in[numBytes - 1 - i];
+                }
+                if (isLast)
+                {
+                    ++numLast;
+                }
+                return numBytes;
+            },
+            [&](const uint8_t* out, size_t numBytes) -> bool
+            {
+                output.insert(output.end(), out, out + numBytes);
+                return true;
+            });
+        assert(ok);
+        (void)ok;
+        assert(numLast == 1);
+        assert(output.size() == input.size());
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            size_t chunk = i / chunkSize;
+            size_t length = std::min(chunkSize, input.size() - chunk * chunkSize);
+            assert(output[i] == input[chunk * chunkSize + length - 1 - i % chunkSize]);
+            (void)length;
+        }
+    }
+
+    // A writer can stop the pipeline early.
+    OrderedPipeline pipeline(pool, 10, 10);
+    size_t numWritten = 0;
+    bool ok = pipeline.Run(
+        [](uint8_t*, size_t capacity) -> size_t { return capacity; },
+        [](const uint8_t*, size_t numBytes, bool, uint8_t*) -> size_t { return numBytes; },
+        [&](const uint8_t*, size_t) -> bool { return ++numWritten < 5; });
+    assert(!ok);
+    assert(numWritten == 5);
+
+    // A task of the pool may run a pipeline on the same pool.
+    size_t numBytes = 0;
+    pool.Submit([&]()
+    {
+        OrderedPipeline inner(pool, 10, 10);
+        size_t numChunks = 0;
+        ok = inner.Run(
+            [&](uint8_t*, size_t capacity) -> size_t { return ++numChunks < 100 ? capacity : 0; },
+            [](const uint8_t*, size_t n, bool, uint8_t*) -> size_t { return n; },
+            [&](const uint8_t*, size_t n) -> bool { numBytes += n; return true; });
+    });
+    pool.Wait();
+    assert(ok);
+    assert(numBytes == 990);
+    (void)ok;
+}
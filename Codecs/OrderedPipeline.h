@@ -0,0 +1,81 @@
+#pragma once
+#include "ThreadPool.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * Chunk-parallel processing of a byte stream with ordered output.
+ *
+ * The calling thread reads the input in fixed-size chunks into a ring of
+ * slots, workers transform the slots concurrently, and a writer thread
+ * emits them in input order.  The number of slots bounds both the memory
+ * and how far the workers may run ahead of the writer; with at least two
+ * slots per worker, reading, transforming and writing overlap.
+ */
+class OrderedPipeline
+{
+public:
+    /**
+     * Fill \c buffer with up to \c capacity bytes.
+     * @return The number of bytes read; less than \c capacity only at the end of the input.
+     */
+    typedef std::function<size_t(uint8_t* buffer, size_t capacity)> Reader;
+
+    /**
+     * Transform a chunk; called concurrently on different chunks.
+     * @param [in] isLast   whether the chunk is the last one of the input.
+     * @return The number of bytes written to \c output.
+     */
+    typedef std::function<size_t(const uint8_t* input, size_t numBytes, bool isLast, uint8_t* output)> Transform;
+
+    /**
+     * Consume a transformed chunk, in input order.
+     * @return false to stop the pipeline.
+     */
+    typedef std::function<bool(const uint8_t* output, size_t numBytes)> Writer;
+
+public:
+    /**
+     * @param [in] pool             the workers.
+     * @param [in] chunkSize        the number of input bytes per chunk.
+     * @param [in] outputCapacity   the maximum number of output bytes per chunk.
+     * @param [in] numSlots         the number of chunks in flight; 0 for three per worker.
+     */
+    OrderedPipeline(ThreadPool& pool, size_t chunkSize, size_t outputCapacity, size_t numSlots = 0);
+
+    /**
+     * Process the whole input.
+     * @return false if the writer stopped the pipeline.
+     */
+    bool Run(const Reader& reader, const Transform& transform, const Writer& writer);
+
+    static void Test(void);
+
+private:
+    struct Slot
+    {
+        std::vector<uint8_t> input;
+        std::vector<uint8_t> output;
+        size_t inputSize;
+        size_t outputSize;
+        bool ready;
+    };
+
+    void Write(const Writer& writer);
+
+private:
+    ThreadPool& pool_;
+    size_t chunkSize_;
+    std::vector<Slot> slots_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    size_t numRead_;        ///< chunks read so far.
+    size_t numWritten_;     ///< chunks written so far.
+    size_t numTransforming_;    ///< chunks submitted to the pool and not transformed yet.
+    bool endOfInput_;
+    bool stopped_;
+};
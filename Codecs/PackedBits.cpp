@@ -0,0 +1,119 @@
+#include "PackedBits.h"
+#include <algorithm>
+#include <cassert>
+
+void PackedBits::CopyBits(const uint64_t* src, size_t srcFirst,
+                          uint64_t* dst, size_t dstFirst, size_t n)
+{
+    while (n > 0)
+    {
+        // Fill up to the end of the current destination word.
+        size_t d = dstFirst % WORD_BITS;
+        size_t chunk = WORD_BITS - d;
+        if (chunk > n)
+        {
+            chunk = n;
+        }
+        uint64_t value = ExtractBits(src, srcFirst, chunk);
+        uint64_t mask = GetLowMask(chunk) << d;
+        uint64_t& word = dst[dstFirst / WORD_BITS];
+        word = (word & ~mask) | (value << d);
+        srcFirst += chunk;
+        dstFirst += chunk;
+        n -= chunk;
+    }
+}
+
+void PackedBits::XorBits(const uint64_t* src, uint64_t* dst, size_t n)
+{
+    size_t numFullWords = n / WORD_BITS;
+    for (size_t i = 0; i < numFullWords; ++i)
+    {
+        dst[i] ^= src[i];
+    }
+    if (n % WORD_BITS)
+    {
+        dst[numFullWords] ^= src[numFullWords] & GetLowMask(n % WORD_BITS);
+    }
+}
+
+bool PackedBits::IsZero(const uint64_t* words, size_t numBits)
+{
+    size_t numFullWords = numBits / WORD_BITS;
+    for (size_t i = 0; i < numFullWords; ++i)
+    {
+        if (words[i])
+        {
+            return false;
+        }
+    }
+    return !(numBits % WORD_BITS) || !(words[numFullWords] & GetLowMask(numBits % WORD_BITS));
+}
+
+std::vector<uint64_t> PackedBits::FromVector(const std::vector<bool>& bits)
+{
+    std::vector<uint64_t> words(GetNumberOfWords(bits.size()), 0);
+    if (!words.empty())
+    {
+        FromVector(bits, &words[0]);
+    }
+    return words;
+}
+
+void PackedBits::FromVector(const std::vector<bool>& bits, uint64_t* words)
+{
+    std::fill(words, words + GetNumberOfWords(bits.size()), 0);
+    for (size_t i = 0; i < bits.size(); ++i)
+    {
+        if (bits[i])
+        {
+            words[i / WORD_BITS] |= uint64_t(1) << (i % WORD_BITS);
+        }
+    }
+}
+
+std::vector<bool> PackedBits::ToVector(const uint64_t* words, size_t numBits)
+{
+    std::vector<bool> bits(numBits, false);
+    for (size_t i = 0; i < numBits; ++i)
+    {
+        bits[i] = GetBit(words, i);
+    }
+    return bits;
+}
+
+#include "DataIo.h"
+void PackedBits::Test(void)
+{
+    // FromVector, ToVector
+    std::vector<bool> bits = DataIo::FromString("1100 1010 0000 0000 0000 0000 0000 0000 "
+                                                "0000 0000 0000 0000 0000 0000 0000 0000 "
+                                                "1011");
+    std::vector<uint64_t> words = FromVector(bits);
+    assert(words.size() == 2);
+    assert(words[0] == 0x53);
+    assert(words[1] == 0xD);
+    assert(ToVector(&words[0], bits.size()) == bits);
+
+    // ExtractBits across a word boundary.
+    assert(ExtractBits(&words[0], 62, 4) == 0x4);
+    assert(ExtractBits(&words[0], 64, 4) == 0xD);
+
+    // LoadLittleEndian, StoreLittleEndian
+    uint8_t bytes[8];
+    StoreLittleEndian(bytes, 0x0123456789ABCDEFULL);
+    assert(bytes[0] == 0xEF && bytes[7] == 0x01);
+    assert(LoadLittleEndian(bytes) == 0x0123456789ABCDEFULL);
+
+    // CopyBits
+    std::vector<uint64_t> dst(2, ~uint64_t(0));
+    CopyBits(&words[0], 0, &dst[0], 60, 8);
+    assert(dst[0] == (0x3ULL << 60 | GetLowMask(60)));
+    assert(dst[1] == (~uint64_t(0) << 4 | 0x5));
+
+    // PopCount, CountTrailingZeros
+    assert(PopCount(0xF0F0) == 8);
+    assert(CountTrailingZeros(0x100000000ULL) == 32);
+    assert(Parity(0x7));
+    assert(IsZero(&dst[0], 0));
+}
@@ -0,0 +1,203 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Hosts known to be little-endian load and store words of bytes directly;
+// the others assemble them byte by byte.
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_MSC_VER)
+#define CODECS_LITTLE_ENDIAN 1
+#endif
+
+/**
+ * Helpers on bit sequences packed into 64-bit words.
+ *
+ * The i-th bit of a sequence is bit (i % 64) of word (i / 64), i.e. the
+ * first bit of a big-endian sequence (as read by DataIo) is the least
+ * significant bit of the first word.
+ * Unused bits of the last word are kept zero by every routine that writes
+ * a packed sequence.
+ */
+class PackedBits
+{
+public:
+    static const size_t WORD_BITS = 64;
+
+    static size_t GetNumberOfWords(size_t numBits)
+    {
+        return (numBits + WORD_BITS - 1) / WORD_BITS;
+    }
+
+    /**
+     * @return A word whose lowest \c n bits are set, 0 <= n <= 64.
+     */
+    static uint64_t GetLowMask(size_t n)
+    {
+        return n >= WORD_BITS ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+    }
+
+    static bool GetBit(const uint64_t* words, size_t i)
+    {
+        return (words[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+    }
+
+    static void SetBit(uint64_t* words, size_t i, bool value)
+    {
+        uint64_t mask = uint64_t(1) << (i % WORD_BITS);
+        if (value)
+        {
+            words[i / WORD_BITS] |= mask;
+        }
+        else
+        {
+            words[i / WORD_BITS] &= ~mask;
+        }
+    }
+
+    static void FlipBit(uint64_t* words, size_t i)
+    {
+        words[i / WORD_BITS] ^= uint64_t(1) << (i % WORD_BITS);
+    }
+
+    static unsigned PopCount(uint64_t w)
+    {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_popcountll(w));
+#else
+        w = w - ((w >> 1) & 0x5555555555555555ULL);
+        w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+        w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast<unsigned>((w * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    static bool Parity(uint64_t w)
+    {
+        return PopCount(w) & 1;
+    }
+
+    /**
+     * @param [in] w   w must not be zero.
+     */
+    static unsigned CountTrailingZeros(uint64_t w)
+    {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_ctzll(w));
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, w);
+        return static_cast<unsigned>(index);
+#elif defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanForward(&index, static_cast<unsigned long>(w)))
+        {
+            return static_cast<unsigned>(index);
+        }
+        _BitScanForward(&index, static_cast<unsigned long>(w >> 32));
+        return static_cast<unsigned>(index + 32);
+#else
+        unsigned n = 0;
+        while (!(w & 1))
+        {
+            w >>= 1;
+            ++n;
+        }
+        return n;
+#endif
+    }
+
+    /**
+     * @return The word of the 8 bytes at \c p, the first the least significant, whatever the host order.
+     */
+    static uint64_t LoadLittleEndian(const uint8_t* p)
+    {
+        uint64_t w = 0;
+#if defined(CODECS_LITTLE_ENDIAN)
+        std::memcpy(&w, p, sizeof (w));
+#else
+        for (size_t i = 8; i-- > 0; )
+        {
+            w = (w << 8) | p[i];
+        }
+#endif
+        return w;
+    }
+
+    /**
+     * Store \c w as 8 bytes at \c p, the least significant first, whatever the host order.
+     */
+    static void StoreLittleEndian(uint8_t* p, uint64_t w)
+    {
+#if defined(CODECS_LITTLE_ENDIAN)
+        std::memcpy(p, &w, sizeof (w));
+#else
+        for (size_t i = 0; i < 8; ++i)
+        {
+            p[i] = static_cast<uint8_t>(w >> (8 * i));
+        }
+#endif
+    }
+
+    /**
+     * Read \c n (<= 64) bits starting at bit \c first.
+     * The words must be readable up to the word holding bit (first + n - 1).
+     */
+    static uint64_t ExtractBits(const uint64_t* words, size_t first, size_t n)
+    {
+        size_t w = first / WORD_BITS;
+        size_t s = first % WORD_BITS;
+        uint64_t value = words[w] >> s;
+        if (s && s + n > WORD_BITS)
+        {
+            value |= words[w + 1] << (WORD_BITS - s);
+        }
+        return value & GetLowMask(n);
+    }
+
+    /**
+     * Write the low \c n (<= 64) bits of \c value starting at bit \c first.
+     * Bits of \c words outside the destination range are preserved.
+     */
+    static void InsertBits(uint64_t* words, size_t first, uint64_t value, size_t n)
+    {
+        size_t w = first / WORD_BITS;
+        size_t s = first % WORD_BITS;
+        uint64_t mask = GetLowMask(n);
+        value &= mask;
+        words[w] = (words[w] & ~(mask << s)) | (value << s);
+        if (s && s + n > WORD_BITS)
+        {
+            words[w + 1] = (words[w + 1] & ~(mask >> (WORD_BITS - s))) | (value >> (WORD_BITS - s));
+        }
+    }
+
+    /**
+     * Copy \c n bits from \c src starting at bit \c srcFirst
+     * to \c dst starting at bit \c dstFirst.
+     * Bits of \c dst outside the destination range are preserved.
+     */
+    static void CopyBits(const uint64_t* src, size_t srcFirst,
+                         uint64_t* dst, size_t dstFirst, size_t n);
+
+    /**
+     * XOR \c n bits of \c src into \c dst, both starting at bit 0.
+     */
+    static void XorBits(const uint64_t* src, uint64_t* dst, size_t n);
+
+    static bool IsZero(const uint64_t* words, size_t numBits);
+
+    static std::vector<uint64_t> FromVector(const std::vector<bool>& bits);
+
+    /**
+     * @param [out] words   (bits.size() + 63) / 64 words.
+     */
+    static void FromVector(const std::vector<bool>& bits, uint64_t* words);
+
+    static std::vector<bool> ToVector(const uint64_t* words, size_t numBits);
+
+    static void Test(void);
+};
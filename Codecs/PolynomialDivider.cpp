@@ -1,50 +1,95 @@
 #include "PolynomialDivider.h"
+#include "Instrumentation.h"
+#include "PackedBits.h"
+#include "ScratchArena.h"
 #include <cassert>
 #include <algorithm>
 
 void PolynomialDivider::Divide(const std::vector<bool>& dividend, const std::vector<bool>& divisor,
                                std::vector<bool>& quotient, std::vector<bool>& remainder)
 {
-    std::vector<bool> middle(dividend);
-    auto af = middle.begin();
-    auto al = middle.end();
-
-    auto bf = divisor.begin();
-    auto bl = divisor.end();
-
-    while (bf != bl && !*bf)
-    {
-        ++bf;
-    }
+    // The packed operands are temporaries of the scratch arena.
+    ScratchArena::Scope scope;
+    ScratchArena& arena = ScratchArena::GetInstance();
+    uint64_t* a = static_cast<uint64_t*>(arena.Allocate((PackedBits::GetNumberOfWords(dividend.size()) + 1) * sizeof (uint64_t), 8));
+    uint64_t* b = static_cast<uint64_t*>(arena.Allocate((PackedBits::GetNumberOfWords(divisor.size()) + 1) * sizeof (uint64_t), 8));
+    PackedBits::FromVector(dividend, a);
+    PackedBits::FromVector(divisor, b);
+    size_t length = GetDivisorLength(b, divisor.size());
     // The divisor must not be zero.
-    assert(bf != bl);
-
-    quotient.clear();
-    remainder.clear();
+    assert(length > 0);
+    size_t numQuotientBits = dividend.size() >= length ? dividend.size() - length + 1 : 1;
+    uint64_t* q = static_cast<uint64_t*>(arena.Allocate(PackedBits::GetNumberOfWords(numQuotientBits) * sizeof (uint64_t), 8));
+    uint64_t* r = static_cast<uint64_t*>(arena.Allocate((PackedBits::GetNumberOfWords(length - 1) + 1) * sizeof (uint64_t), 8));
+    Divide(a, dividend.size(), b, divisor.size(), q, r);
+    quotient = PackedBits::ToVector(q, numQuotientBits);
+    remainder = PackedBits::ToVector(r, length - 1);
+    arena.Deallocate(r);
+    arena.Deallocate(q);
+    arena.Deallocate(b);
+    arena.Deallocate(a);
+}
 
-    while (al - af >= bl - bf)
+size_t PolynomialDivider::GetDivisorLength(const uint64_t* divisor, size_t numDivisorBits)
+{
+    for (size_t w = 0; w < PackedBits::GetNumberOfWords(numDivisorBits); ++w)
     {
-        quotient.push_back(*af);
-        if (*af)
+        if (divisor[w])
         {
-            std::transform(bf, bl, af, af, [] (bool a, bool b) -> bool { return a^b; });
+            return numDivisorBits - (w * PackedBits::WORD_BITS + PackedBits::CountTrailingZeros(divisor[w]));
         }
-        ++af;
     }
-    if (quotient.empty())
-    {
-        quotient.push_back(false);
-    }
-    size_t numPrependingZeros = (bl - bf) - (al - af) - 1;
-    while (numPrependingZeros > 0)
-    {
-        remainder.push_back(false);
-        --numPrependingZeros;
-    }
-    while (af != al)
+    return 0;
+}
+
+void PolynomialDivider::Divide(const uint64_t* dividend, size_t numDividendBits,
+                               const uint64_t* divisor, size_t numDivisorBits,
+                               uint64_t* quotient, uint64_t* remainder)
+{
+    CODECS_TIME(Instrumentation::OP_POLYNOMIAL_DIVIDE);
+    size_t length = GetDivisorLength(divisor, numDivisorBits);
+    // The divisor must not be zero.
+    assert(length > 0);
+    size_t lead = numDivisorBits - length;              // the position of the leading one of divisor.
+    size_t numRemainderBits = length - 1;
+    size_t numRemainderWords = PackedBits::GetNumberOfWords(numRemainderBits);
+    size_t numQuotientBits = numDividendBits >= length ? numDividendBits - length + 1 : 1;
+    std::fill(quotient, quotient + PackedBits::GetNumberOfWords(numQuotientBits), 0);
+    std::fill(remainder, remainder + numRemainderWords, 0);
+    for (size_t i = 0; i < numDividendBits; ++i)
     {
-        remainder.push_back(*af);
-        ++af;
+        bool bit = PackedBits::GetBit(dividend, i);
+        if (numRemainderBits == 0)
+        {
+            // Division by 1.
+            PackedBits::SetBit(quotient, i, bit);
+            continue;
+        }
+        // The quotient bit is the top bit of the window made of the
+        // register followed by the next dividend bit.
+        bool q = remainder[0] & 1;
+        for (size_t w = 0; w < numRemainderWords; ++w)
+        {
+            uint64_t next = w + 1 < numRemainderWords ? remainder[w + 1] : 0;
+            remainder[w] = (remainder[w] >> 1) | (next << (PackedBits::WORD_BITS - 1));
+        }
+        if (bit)
+        {
+            PackedBits::FlipBit(remainder, numRemainderBits - 1);
+        }
+        if (i >= numRemainderBits)
+        {
+            if (q)
+            {
+                PackedBits::SetBit(quotient, i - numRemainderBits, true);
+                for (size_t w = 0; w < numRemainderWords; ++w)
+                {
+                    size_t n = numRemainderBits - w * PackedBits::WORD_BITS;
+                    remainder[w] ^= PackedBits::ExtractBits(divisor, lead + 1 + w * PackedBits::WORD_BITS,
+                                                            n < PackedBits::WORD_BITS ? n : PackedBits::WORD_BITS);
+                }
+            }
+        }
     }
 }
 
@@ -73,4 +118,54 @@ void PolynomialDivider::Test(void)
     Divide(dividend, divisor, quotient, remainder);
     assert(DataIo::IsEqual(quotient, DataIo::FromString("11001011")));
     assert(DataIo::IsEqual(remainder, DataIo::FromString("1")));
+
+    // Packed division against schoolbook division, divisors with leading zeros.
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    const size_t divisorLengths[] = { 1, 2, 5, 64, 65, 70, 130 };
+    for (size_t d = 0; d < sizeof (divisorLengths) / sizeof (divisorLengths[0]); ++d)
+    {
+        for (size_t n = 0; n < 300; n += 29)
+        {
+            std::vector<bool> a(n, false);
+            std::vector<bool> b(divisorLengths[d] + 2, false);
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                a[i] = x & 1;
+            }
+            for (size_t i = 3; i < b.size(); ++i)
+            {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                b[i] = x & 1;
+            }
+            b[2] = true;
+            // Schoolbook long division.
+            std::vector<bool> work = a;
+            size_t length = divisorLengths[d];
+            std::vector<bool> q(n >= length ? n - length + 1 : 1, false);
+            for (size_t i = 0; i + length <= n; ++i)
+            {
+                if (work[i])
+                {
+                    q[i] = true;
+                    for (size_t j = 0; j < length; ++j)
+                    {
+                        work[i + j] = work[i + j] != b[2 + j];
+                    }
+                }
+            }
+            std::vector<bool> r(length - 1, false);
+            for (size_t j = 0; j < length - 1 && j < n; ++j)
+            {
+                r[length - 2 - j] = work[n - 1 - j];
+            }
+            Divide(a, b, quotient, remainder);
+            assert(quotient == q);
+            assert(remainder == r);
+        }
+    }
 }
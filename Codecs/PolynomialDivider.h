@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 class PolynomialDivider
@@ -13,5 +15,25 @@ public:
     static void Divide(const std::vector<bool>& dividend, const std::vector<bool>& divisor,
                        std::vector<bool>& quotient, std::vector<bool>& remainder);
 
+    /**
+     * Divide packed bit sequences (see PackedBits) in big-endian order,
+     * without allocation.  The remainder is kept in a register of L - 1 bits
+     * that the dividend is shifted through, L being the length of the
+     * divisor without its leading zeros.
+     *
+     * @param [in]  dividend          numDividendBits bits.
+     * @param [in]  divisor           numDivisorBits bits; it must not be zero.
+     * @param [out] quotient          max(numDividendBits - L + 1, 1) bits.
+     * @param [out] remainder         L - 1 bits.
+     */
+    static void Divide(const uint64_t* dividend, size_t numDividendBits,
+                       const uint64_t* divisor, size_t numDivisorBits,
+                       uint64_t* quotient, uint64_t* remainder);
+
+    /**
+     * @return The length L of \c divisor without its leading zeros.
+     */
+    static size_t GetDivisorLength(const uint64_t* divisor, size_t numDivisorBits);
+
     static void Test(void);
 };
@@ -0,0 +1,199 @@
+#include "ReedSolomon.h"
+#include "GaloisField256.h"
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+    // The number of bytes of each shard processed at once.
+    const size_t CHUNK_SIZE = 4096;
+}
+
+ReedSolomon::ReedSolomon(size_t numDataShards, size_t numParityShards) :
+    k_(numDataShards),
+    m_(numParityShards),
+    cauchy_(numParityShards * numDataShards, 0)
+{
+    assert(k_ > 0);
+    assert(k_ + m_ <= 256);
+    // C[i][j] = 1 / (x_i + y_j) with x_i = k + i and y_j = j, all distinct.
+    for (size_t i = 0; i < m_; ++i)
+    {
+        for (size_t j = 0; j < k_; ++j)
+        {
+            cauchy_[i * k_ + j] = GaloisField256::Inverse(static_cast<uint8_t>((k_ + i) ^ j));
+        }
+    }
+}
+
+size_t ReedSolomon::GetNumberOfDataShards(void) const
+{
+    return k_;
+}
+
+size_t ReedSolomon::GetNumberOfParityShards(void) const
+{
+    return m_;
+}
+
+uint8_t ReedSolomon::GetCoefficient(size_t i, size_t j) const
+{
+    assert(i < m_);
+    assert(j < k_);
+    return cauchy_[i * k_ + j];
+}
+
+void ReedSolomon::MultiplyShards(const uint8_t* matrix, size_t numOutputs, size_t numInputs,
+                                 const uint8_t* const* inputs, uint8_t* const* outputs, size_t length)
+{
+    for (size_t offset = 0; offset < length; offset += CHUNK_SIZE)
+    {
+        size_t n = length - offset < CHUNK_SIZE ? length - offset : CHUNK_SIZE;
+        for (size_t i = 0; i < numOutputs; ++i)
+        {
+            const uint8_t* row = matrix + i * numInputs;
+            GaloisField256::MultiplyRegion(row[0], inputs[0] + offset, outputs[i] + offset, n);
+            for (size_t j = 1; j < numInputs; ++j)
+            {
+                GaloisField256::MultiplyAddRegion(row[j], inputs[j] + offset, outputs[i] + offset, n);
+            }
+        }
+    }
+}
+
+void ReedSolomon::Encode(const uint8_t* const* data, uint8_t* const* parity, size_t length) const
+{
+    if (m_)
+    {
+        MultiplyShards(&cauchy_[0], m_, k_, data, parity, length);
+    }
+}
+
+bool ReedSolomon::Decode(uint8_t* const* shards, const bool* present, size_t length) const
+{
+    // Choose k present shards, and the rows of the encoding matrix producing them.
+    std::vector<size_t> rows;
+    for (size_t s = 0; s < k_ + m_ && rows.size() < k_; ++s)
+    {
+        if (present[s])
+        {
+            rows.push_back(s);
+        }
+    }
+    if (rows.size() < k_)
+    {
+        return false;
+    }
+    std::vector<size_t> missingData;
+    for (size_t j = 0; j < k_; ++j)
+    {
+        if (!present[j])
+        {
+            missingData.push_back(j);
+        }
+    }
+    if (!missingData.empty())
+    {
+        std::vector<uint8_t> matrix(k_ * k_, 0);
+        std::vector<const uint8_t*> inputs(k_, nullptr);
+        for (size_t r = 0; r < k_; ++r)
+        {
+            if (rows[r] < k_)
+            {
+                matrix[r * k_ + rows[r]] = 1;
+            }
+            else
+            {
+                std::memcpy(&matrix[r * k_], &cauchy_[(rows[r] - k_) * k_], k_);
+            }
+            inputs[r] = shards[rows[r]];
+        }
+        bool invertible = GaloisField256::InvertMatrix(&matrix[0], k_);
+        assert(invertible);
+        (void)invertible;
+        // Row j of the inverse rebuilds data shard j from the chosen shards.
+        std::vector<uint8_t> decoder(missingData.size() * k_, 0);
+        std::vector<uint8_t*> outputs(missingData.size(), nullptr);
+        for (size_t i = 0; i < missingData.size(); ++i)
+        {
+            std::memcpy(&decoder[i * k_], &matrix[missingData[i] * k_], k_);
+            outputs[i] = shards[missingData[i]];
+        }
+        MultiplyShards(&decoder[0], missingData.size(), k_, &inputs[0], &outputs[0], length);
+    }
+    // Recompute the missing parity shards from the (now complete) data shards.
+    std::vector<uint8_t> encoder;
+    std::vector<uint8_t*> outputs;
+    for (size_t i = 0; i < m_; ++i)
+    {
+        if (!present[k_ + i])
+        {
+            encoder.insert(encoder.end(), cauchy_.begin() + i * k_, cauchy_.begin() + (i + 1) * k_);
+            outputs.push_back(shards[k_ + i]);
+        }
+    }
+    if (!outputs.empty())
+    {
+        MultiplyShards(&encoder[0], outputs.size(), k_, shards, &outputs[0], length);
+    }
+    return true;
+}
+
+void ReedSolomon::Test(void)
+{
+    // 4 + 2, lose 2 shards of various kinds.
+    const size_t k = 4;
+    const size_t m = 2;
+    const size_t length = 5000;
+    ReedSolomon rs(k, m);
+    std::vector<std::vector<uint8_t> > stripe(k + m, std::vector<uint8_t>(length, 0));
+    for (size_t j = 0; j < k; ++j)
+    {
+        for (size_t i = 0; i < length; ++i)
+        {
+            stripe[j][i] = static_cast<uint8_t>(i * (j + 3) + (i >> 8));
+        }
+    }
+    std::vector<const uint8_t*> data(k, nullptr);
+    std::vector<uint8_t*> shards(k + m, nullptr);
+    for (size_t s = 0; s < k + m; ++s)
+    {
+        shards[s] = &stripe[s][0];
+    }
+    for (size_t j = 0; j < k; ++j)
+    {
+        data[j] = shards[j];
+    }
+    rs.Encode(&data[0], &shards[k], length);
+    for (size_t i = 0; i < length; ++i)
+    {
+        uint8_t p = 0;
+        for (size_t j = 0; j < k; ++j)
+        {
+            p ^= GaloisField256::Multiply(rs.GetCoefficient(0, j), stripe[j][i]);
+        }
+        assert(stripe[k][i] == p);
+    }
+    const std::vector<std::vector<uint8_t> > original = stripe;
+
+    const size_t losses[3][2] = { { 0, 3 }, { 1, 5 }, { 4, 5 } };
+    for (size_t t = 0; t < 3; ++t)
+    {
+        bool present[k + m] = { true, true, true, true, true, true };
+        for (size_t l = 0; l < 2; ++l)
+        {
+            present[losses[t][l]] = false;
+            std::memset(shards[losses[t][l]], 0xEE, length);
+        }
+        bool decoded = rs.Decode(&shards[0], present, length);
+        assert(decoded);
+        assert(stripe == original);
+        (void)decoded;
+    }
+
+    // Too many losses.
+    bool present[k + m] = { false, true, false, true, false, true };
+    bool decoded = rs.Decode(&shards[0], present, length);
+    assert(!decoded);
+    (void)decoded;
+}
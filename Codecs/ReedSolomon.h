@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Systematic Reed-Solomon erasure codec over GF(2^8).
+ *
+ * A stripe is made of k data shards followed by m parity shards, all of the
+ * same length.  Any k of the k + m shards recover the others.
+ * The encoding matrix is the identity on top of an m x k Cauchy matrix,
+ * so every k x k submatrix is invertible.
+ * Shards are processed in chunks that stay in cache while all products
+ * of a chunk are accumulated, and each product is vectorized across bytes
+ * by GaloisField256.
+ */
+class ReedSolomon
+{
+public:
+    /**
+     * @param [in] numDataShards     k > 0
+     * @param [in] numParityShards   m, with k + m <= 256.
+     */
+    ReedSolomon(size_t numDataShards, size_t numParityShards);
+
+    size_t GetNumberOfDataShards(void) const;
+    size_t GetNumberOfParityShards(void) const;
+
+    /**
+     * @return The coefficient of data shard \c j in parity shard \c i.
+     */
+    uint8_t GetCoefficient(size_t i, size_t j) const;
+
+    /**
+     * @param [in]  data     k shards of \c length bytes.
+     * @param [out] parity   m shards of \c length bytes.
+     */
+    void Encode(const uint8_t* const* data, uint8_t* const* parity, size_t length) const;
+
+    /**
+     * Reconstruct the missing shards in place.
+     *
+     * @param [in,out] shards    k + m shards of \c length bytes, data shards first.
+     *                           The buffers of missing shards are overwritten.
+     * @param [in]     present   k + m flags telling which shards are intact.
+     * @param [in]     length    the number of bytes per shard.
+     *
+     * @return false if fewer than k shards are present.
+     */
+    bool Decode(uint8_t* const* shards, const bool* present, size_t length) const;
+
+private:
+    /**
+     * outputs[i] = sum_j matrix[i * numInputs + j] * inputs[j].
+     */
+    static void MultiplyShards(const uint8_t* matrix, size_t numOutputs, size_t numInputs,
+                               const uint8_t* const* inputs, uint8_t* const* outputs, size_t length);
+
+public:
+    static void Test(void);
+
+private:
+    size_t k_;
+    size_t m_;
+    std::vector<uint8_t> cauchy_;   ///< m x k, row-major.
+};
@@ -0,0 +1,153 @@
+#include "ScratchArena.h"
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+ScratchArena::Scope::Scope(void)
+    : arena_(ScratchArena::GetInstance()),
+      mark_(arena_.used_)
+{
+}
+
+ScratchArena::Scope::~Scope(void)
+{
+    assert(arena_.used_ >= mark_);
+    arena_.used_ = mark_;
+}
+
+ScratchArena& ScratchArena::GetInstance(void)
+{
+    static thread_local ScratchArena arena;
+    return arena;
+}
+
+ScratchArena::ScratchArena(void)
+    : buffer_(nullptr),
+      capacity_(DEFAULT_CAPACITY),
+      used_(0),
+      numFallbacks_(0)
+{
+}
+
+ScratchArena::~ScratchArena(void)
+{
+    ::operator delete(buffer_);
+}
+
+void ScratchArena::SetCapacity(size_t capacity)
+{
+    assert(used_ == 0);
+    ::operator delete(buffer_);
+    buffer_ = nullptr;
+    capacity_ = capacity;
+}
+
+size_t ScratchArena::GetCapacity(void) const
+{
+    return capacity_;
+}
+
+size_t ScratchArena::GetUsed(void) const
+{
+    return used_;
+}
+
+size_t ScratchArena::GetNumberOfFallbacks(void) const
+{
+    return numFallbacks_;
+}
+
+void* ScratchArena::Allocate(size_t size, size_t alignment)
+{
+    assert(alignment && !(alignment & (alignment - 1)) && alignment <= 64);
+    // The buffer is made on first use, so idle threads cost nothing.
+    if (!buffer_ && capacity_)
+    {
+        buffer_ = static_cast<uint8_t*>(::operator new(capacity_ + 64));
+    }
+    if (buffer_)
+    {
+        uintptr_t base = reinterpret_cast<uintptr_t>(buffer_);
+        size_t first = ((base + used_ + alignment - 1) & ~uintptr_t(alignment - 1)) - base;
+        if (first <= capacity_ && size <= capacity_ - first)
+        {
+            used_ = first + size;
+            return buffer_ + first;
+        }
+    }
+    // The heap only aligns to 16: over-allocate, and keep the block from
+    // the heap just before the aligned one for Deallocate().
+    ++numFallbacks_;
+    uint8_t* block = static_cast<uint8_t*>(::operator new(size + sizeof (void*) + alignment - 1));
+    uintptr_t start = reinterpret_cast<uintptr_t>(block) + sizeof (void*);
+    void** aligned = reinterpret_cast<void**>((start + alignment - 1) & ~uintptr_t(alignment - 1));
+    aligned[-1] = block;
+    return aligned;
+}
+
+void ScratchArena::Deallocate(void* p)
+{
+    if (p && !Owns(p))
+    {
+        ::operator delete(static_cast<void**>(p)[-1]);
+    }
+}
+
+bool ScratchArena::Owns(const void* p) const
+{
+    const uint8_t* b = static_cast<const uint8_t*>(p);
+    return buffer_ && b >= buffer_ && b < buffer_ + capacity_ + 64;
+}
+
+#include <thread>
+#include <vector>
+void ScratchArena::Test(void)
+{
+    ScratchArena& arena = GetInstance();
+    size_t capacity = arena.GetCapacity();
+    assert(arena.GetUsed() == 0);
+
+    // Scopes give back everything taken inside them, and nest.
+    {
+        Scope outer;
+        uint64_t* a = static_cast<uint64_t*>(arena.Allocate(24, 8));
+        assert(reinterpret_cast<uintptr_t>(a) % 8 == 0);
+        size_t used = arena.GetUsed();
+        {
+            Scope inner;
+            void* b = arena.Allocate(10, 64);
+            assert(reinterpret_cast<uintptr_t>(b) % 64 == 0);
+            assert(arena.GetUsed() > used);
+            (void)b;
+        }
+        assert(arena.GetUsed() == used);
+        (void)a;
+        (void)used;
+        std::vector<uint64_t, ScratchAllocator<uint64_t> > v(100, 7);
+        assert(v[99] == 7);
+        assert(arena.Owns(&v[0]));
+    }
+    assert(arena.GetUsed() == 0);
+
+    // Requests beyond the capacity go to the heap.
+    arena.SetCapacity(1024);
+    {
+        Scope scope;
+        size_t numFallbacks = arena.GetNumberOfFallbacks();
+        void* a = arena.Allocate(1000, 8);
+        void* b = arena.Allocate(100, 64);
+        assert(arena.Owns(a) && !arena.Owns(b));
+        assert(reinterpret_cast<uintptr_t>(b) % 64 == 0);
+        assert(arena.GetNumberOfFallbacks() == numFallbacks + 1);
+        (void)numFallbacks;
+        arena.Deallocate(b);
+        arena.Deallocate(a);
+    }
+    arena.SetCapacity(capacity);
+
+    // Each thread has its own arena.
+    ScratchArena* other = nullptr;
+    std::thread t([&other](void) { other = &GetInstance(); });
+    t.join();
+    assert(other != &arena);
+}
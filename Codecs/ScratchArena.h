@@ -0,0 +1,130 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A per-thread bump allocator for the temporaries of codec operations.
+ *
+ * An operation opens a Scope, takes memory from the arena of its thread,
+ * and gives all of it back when the scope closes; nothing is freed one
+ * block at a time.  Requests that do not fit the remaining capacity fall
+ * back to the heap.  Each thread has its own arena, so threads running
+ * codecs at once never contend for a lock in the allocator.
+ */
+class ScratchArena
+{
+public:
+    static const size_t DEFAULT_CAPACITY = 256 * 1024;
+
+    /**
+     * Release the memory of the arena when its scope closes.
+     * Scopes nest; they must close in the reverse order they open.
+     */
+    class Scope
+    {
+    public:
+        Scope(void);
+        ~Scope(void);
+
+    private:
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+
+    private:
+        ScratchArena& arena_;
+        size_t mark_;
+    };
+
+    /**
+     * @return The arena of the calling thread.
+     */
+    static ScratchArena& GetInstance(void);
+
+    ~ScratchArena(void);
+
+    /**
+     * Set the capacity of the arena of the calling thread.
+     * Must not be called while a scope is open.
+     * @param [in] capacity   in bytes; 0 sends every request to the heap.
+     */
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity(void) const;
+
+    /**
+     * @return The number of bytes in use.
+     */
+    size_t GetUsed(void) const;
+
+    /**
+     * @return The number of requests served by the heap.
+     */
+    size_t GetNumberOfFallbacks(void) const;
+
+    /**
+     * @param [in] size        in bytes.
+     * @param [in] alignment   a power of 2 no greater than 64.
+     */
+    void* Allocate(size_t size, size_t alignment);
+
+    /**
+     * Give back a block; only blocks served by the heap are freed at once.
+     */
+    void Deallocate(void* p);
+
+    static void Test(void);
+
+private:
+    ScratchArena(void);
+    ScratchArena(const ScratchArena&);
+    ScratchArena& operator=(const ScratchArena&);
+
+    bool Owns(const void* p) const;
+
+private:
+    uint8_t* buffer_;
+    size_t capacity_;
+    size_t used_;
+    size_t numFallbacks_;
+};
+
+/**
+ * A standard allocator drawing from the arena of the calling thread,
+ * for containers that live inside a ScratchArena::Scope.
+ */
+template <typename T>
+class ScratchAllocator
+{
+public:
+    typedef T value_type;
+
+    ScratchAllocator(void)
+    {
+    }
+
+    template <typename U>
+    ScratchAllocator(const ScratchAllocator<U>&)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(ScratchArena::GetInstance().Allocate(n * sizeof (T), alignof (T)));
+    }
+
+    void deallocate(T* p, size_t)
+    {
+        ScratchArena::GetInstance().Deallocate(p);
+    }
+
+    template <typename U>
+    bool operator==(const ScratchAllocator<U>&) const
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const ScratchAllocator<U>&) const
+    {
+        return false;
+    }
+};
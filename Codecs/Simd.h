@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+ * Compile-time detection of the SIMD instruction sets the kernels may use.
+ * Each kernel keeps a portable scalar path, so none of these is required.
+ *
+ * CODECS_HAS_SSE2    128-bit integer operations.
+ * CODECS_HAS_SSSE3   byte shuffles (PSHUFB).
+ * CODECS_HAS_AVX2    256-bit integer operations.
+ * CODECS_HAS_GFNI    GF(2^8) multiplication (GF2P8MULB).
+ * CODECS_HAS_PCLMUL  carry-less multiplication (PCLMULQDQ).
+ * CODECS_HAS_BMI2    parallel bit extract (PEXT).
+ *
+ * Define CODECS_NO_SIMD to force the scalar paths.
+ */
+
+#if !defined(CODECS_NO_SIMD)
+
+#if defined(__AVX2__)
+#define CODECS_HAS_AVX2 1
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__) || defined(CODECS_HAS_AVX2)
+#define CODECS_HAS_SSSE3 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(CODECS_HAS_SSSE3)
+#define CODECS_HAS_SSE2 1
+#endif
+
+#if defined(__GFNI__) && defined(CODECS_HAS_SSSE3)
+#define CODECS_HAS_GFNI 1
+#endif
+
+#if defined(__PCLMUL__) && defined(CODECS_HAS_SSE2)
+#define CODECS_HAS_PCLMUL 1
+#endif
+
+#if defined(__BMI2__)
+#define CODECS_HAS_BMI2 1
+#endif
+
+#endif // !CODECS_NO_SIMD
+
+#if defined(CODECS_HAS_SSE2) || defined(CODECS_HAS_SSSE3) || defined(CODECS_HAS_AVX2) || defined(CODECS_HAS_BMI2)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#endif
@@ -0,0 +1,234 @@
+#include "ThreadPool.h"
+#include <atomic>
+#include <cassert>
+
+namespace
+{
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local size_t currentIndex = 0;
+}
+
+ThreadPool::ThreadPool(size_t numThreads) :
+    numQueued_(0),
+    numPending_(0),
+    stopping_(false)
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::thread::hardware_concurrency();
+        numThreads = numThreads ? numThreads : 1;
+    }
+    for (size_t i = 0; i <= numThreads; ++i)
+    {
+        queues_.push_back(std::unique_ptr<Queue>(new Queue));
+    }
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        threads_.push_back(std::thread(&ThreadPool::Work, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    taskReady_.notify_all();
+    for (size_t i = 0; i < threads_.size(); ++i)
+    {
+        threads_[i].join();
+    }
+}
+
+size_t ThreadPool::GetNumberOfThreads(void) const
+{
+    return threads_.size();
+}
+
+size_t ThreadPool::GetWorkerIndex(void) const
+{
+    // The queues are complete before the first worker starts; threads_ may not be.
+    return currentPool == this ? currentIndex : queues_.size() - 1;
+}
+
+void ThreadPool::Submit(const Task& task)
+{
+    {
+        // Counted before queueing: a worker may take and finish the task
+        // before this thread returns, and must not bring the count to zero.
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++numQueued_;
+        ++numPending_;
+    }
+    Queue& queue = *queues_[GetWorkerIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+    taskReady_.notify_one();
+}
+
+size_t ThreadPool::GetNumberOfQueuedTasks(void) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return numQueued_;
+}
+
+void ThreadPool::Wait(void)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (numPending_)
+    {
+        allDone_.wait(lock);
+    }
+}
+
+bool ThreadPool::Take(size_t index, Task& task)
+{
+    {
+        Queue& own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task.swap(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    // The outside queue first, then the other workers from the next one on.
+    const size_t numThreads = queues_.size() - 1;
+    for (size_t k = 0; k < numThreads; ++k)
+    {
+        Queue& other = *queues_[k ? (index + k) % numThreads : numThreads];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty())
+        {
+            task.swap(other.tasks.front());
+            other.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Work(size_t index)
+{
+    currentPool = this;
+    currentIndex = index;
+    for (;;)
+    {
+        Task task;
+        if (Take(index, task))
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --numQueued_;
+            }
+            task();
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--numPending_ == 0)
+            {
+                allDone_.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!numQueued_ && !stopping_)
+        {
+            taskReady_.wait(lock);
+        }
+        if (!numQueued_)
+        {
+            return;
+        }
+    }
+}
+
+namespace
+{
+    /**
+     * Sum [first, last) by splitting the range and submitting the upper halves.
+     */
+    void SplitSum(ThreadPool& pool, uint64_t first, uint64_t last, std::atomic<uint64_t>& sum,
+                  std::vector<std::atomic<size_t>>& numRun)
+    {
+        while (last - first > 16)
+        {
+            uint64_t middle = first + (last - first) / 2;
+            pool.Submit([&pool, middle, last, &sum, &numRun]() { SplitSum(pool, middle, last, sum, numRun); });
+            last = middle;
+        }
+        uint64_t s = 0;
+        for (uint64_t i = first; i < last; ++i)
+        {
+            s += i;
+        }
+        sum += s;
+        ++numRun[pool.GetWorkerIndex()];
+    }
+}
+
+void ThreadPool::Test(void)
+{
+    ThreadPool pool(4);
+    assert(pool.GetNumberOfThreads() == 4);
+    assert(pool.GetWorkerIndex() == 4);
+    std::atomic<size_t> sum(0);
+    for (size_t i = 1; i <= 1000; ++i)
+    {
+        pool.Submit([&sum, i]() { sum += i; });
+    }
+    pool.Wait();
+    assert(sum == 500500);
+
+    // The pool can be reused after Wait().
+    pool.Submit([&sum]() { sum = 0; });
+    pool.Wait();
+    assert(sum == 0);
+
+    // Tasks submitted by tasks are waited for too, and run on workers only.
+    std::atomic<uint64_t> total(0);
+    std::vector<std::atomic<size_t>> numRun(5);
+    pool.Submit([&pool, &total, &numRun]() { SplitSum(pool, 0, 100000, total, numRun); });
+    pool.Wait();
+    assert(total == 100000ULL * 99999 / 2);
+    assert(numRun[4] == 0);
+
+    // Outside tasks start in submission order on a single worker.
+    ThreadPool one(1);
+    std::vector<size_t> order;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        one.Submit([&order, i]() { order.push_back(i); });
+    }
+    one.Wait();
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        assert(order[i] == i);
+    }
+
+    // Tasks behind a busy worker are counted as queued.
+    std::atomic<bool> started(false);
+    std::atomic<bool> release(false);
+    one.Submit([&started, &release]()
+    {
+        started = true;
+        while (!release)
+        {
+            std::this_thread::yield();
+        }
+    });
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+    for (size_t i = 0; i < 3; ++i)
+    {
+        one.Submit([]() {});
+    }
+    assert(one.GetNumberOfQueuedTasks() == 3);
+    release = true;
+    one.Wait();
+    assert(one.GetNumberOfQueuedTasks() == 0);
+}
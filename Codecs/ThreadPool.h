@@ -0,0 +1,84 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads running submitted tasks.
+ *
+ * Tasks submitted from outside the pool are queued in order.  Tasks
+ * submitted by a running task go to its worker's own queue, which the
+ * worker runs newest first, and idle workers steal the oldest tasks from
+ * the others: a task can split its work and submit the halves, and an
+ * unbalanced search spreads over the workers by itself.
+ */
+class ThreadPool
+{
+public:
+    typedef std::function<void(void)> Task;
+
+    /**
+     * @param [in] numThreads   the number of workers; 0 for one per hardware thread.
+     */
+    explicit ThreadPool(size_t numThreads = 0);
+
+    /**
+     * Run the remaining tasks, then stop the workers.
+     */
+    ~ThreadPool(void);
+
+    size_t GetNumberOfThreads(void) const;
+
+    /**
+     * @return The index of the calling worker, or GetNumberOfThreads() if
+     * the caller is not a worker of this pool.
+     */
+    size_t GetWorkerIndex(void) const;
+
+    void Submit(const Task& task);
+
+    /**
+     * @return The number of tasks waiting for a worker, a snapshot.
+     */
+    size_t GetNumberOfQueuedTasks(void) const;
+
+    /**
+     * Block until every submitted task, including those submitted by tasks, has finished.
+     */
+    void Wait(void);
+
+    static void Test(void);
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Work(size_t index);
+
+    /**
+     * Take a task for worker \c index: its own newest, the oldest submitted
+     * from outside, or the oldest of another worker.
+     */
+    bool Take(size_t index, Task& task);
+
+private:
+    std::vector<std::thread> threads_;
+    std::vector<std::unique_ptr<Queue>> queues_;    ///< one per worker, then the one for outside tasks.
+    mutable std::mutex mutex_;
+    std::condition_variable taskReady_;
+    std::condition_variable allDone_;
+    size_t numQueued_;      ///< tasks in the queues.
+    size_t numPending_;     ///< tasks queued or running.
+    bool stopping_;
+};
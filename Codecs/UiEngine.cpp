@@ -1,8 +1,17 @@
 #include "UiEngine.h"
+#include "CrcCorrector.h"
+#include "Instrumentation.h"
+#include "PackedBits.h"
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
 #include <cctype>
+#include <cstdlib>
+#if defined(_WIN32)
 #include <conio.h>
+#endif
 
 enum ChoiceValues
 {
@@ -10,6 +19,7 @@ enum ChoiceValues
     CV_INPUT_CRC,
     CV_CRC_ENCODE,
     CV_CRC_CHECK,
+    CV_CRC_CORRECT,
     CV_INPUT_HAMMING_CODE,
     CV_HAMMING_ENCODE,
     CV_HAMMING_DECODE,
@@ -38,6 +48,9 @@ void UiEngine::Loop(void)
         case CV_CRC_CHECK:
             CrcCheck();
             break;
+        case CV_CRC_CORRECT:
+            CrcCorrect();
+            break;
         case CV_INPUT_HAMMING_CODE:
             InputHammingMessageBlockSize();
             break;
@@ -57,8 +70,14 @@ void UiEngine::Loop(void)
         }
         if (wait)
         {
+#if defined(_WIN32)
             std::cout << "Press any key to continue.";
             _getch();
+#else
+            std::cout << "Press Enter to continue.";
+            std::string line;
+            std::getline(std::cin, line);
+#endif
             std::cout << std::endl;
         }
     }
@@ -74,10 +93,11 @@ int UiEngine::OfferChoices(void)
               << "2. Set CRC generator." << std::endl
               << "3. CRC encode." << std::endl
               << "4. CRC check." << std::endl
-              << "5. Set Hamming code" << std::endl
-              << "6. Hamming encode." << std::endl
-              << "7. Hamming decode." << std::endl
-              << "8. Exit." << std::endl
+              << "5. CRC check and correct a single-bit error." << std::endl
+              << "6. Set Hamming code" << std::endl
+              << "7. Hamming encode." << std::endl
+              << "8. Hamming decode." << std::endl
+              << "9. Exit." << std::endl
               << "Your choice: ";
     std::string line;
     std::getline(std::cin, line);
@@ -96,13 +116,58 @@ int UiEngine::OfferChoices(void)
     return result;
 }
 
+bool UiEngine::ParseBits(const std::string& line, std::vector<bool>& bits)
+{
+    std::vector<uint8_t> bytes;
+    if (line.compare(0, 2, "0x") == 0 || line.compare(0, 2, "0X") == 0)
+    {
+        std::vector<uint64_t> words;
+        size_t numBits = DataIo::FromHex(line.data(), line.length(), words);
+        bits = PackedBits::ToVector(words.empty() ? nullptr : &words[0], numBits);
+        return true;
+    }
+    else if (line.compare(0, 7, "base64:") == 0)
+    {
+        if (!DataIo::FromBase64(line.data() + 7, line.length() - 7, bytes))
+        {
+            std::cout << "Error: Invalid base64 input!" << std::endl;
+            return false;
+        }
+    }
+    else if (line.compare(0, 1, "@") == 0)
+    {
+        std::ifstream file(line.substr(1).c_str(), std::ios::binary);
+        if (!file)
+        {
+            std::cout << "Error: Cannot open " << line.substr(1) << "!" << std::endl;
+            return false;
+        }
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    else
+    {
+        bits = DataIo::FromString(line);
+        return true;
+    }
+    BitView view(bytes.empty() ? nullptr : &bytes[0], 8 * bytes.size(), BitView::BO_MSB_FIRST);
+    bits.assign(view.GetNumberOfBits(), false);
+    for (size_t i = 0; i < bits.size(); ++i)
+    {
+        bits[i] = view.GetBit(i);
+    }
+    return true;
+}
+
 void UiEngine::InputMessage(void)
 {
-    std::cout << "Input a bit sequence (0, 1 or space) in big-endian order:" << std::endl;
+    std::cout << "Input a bit sequence (0, 1 or space) in big-endian order," << std::endl
+              << "or 0x<hex>, base64:<base64> or @<binary file>:" << std::endl;
     std::string line;
     std::getline(std::cin, line);
-    bitSeq_ = DataIo::FromString(line);
-    ShowMessage();
+    if (ParseBits(line, bitSeq_))
+    {
+        ShowMessage();
+    }
 }
 
 void UiEngine::ShowMessage(void) const
@@ -113,16 +178,20 @@ void UiEngine::ShowMessage(void) const
 
 void UiEngine::InputCrcGenerator(void)
 {
-    std::cout << "Input CRC generator (0, 1 or space) in big-endian order:" << std::endl;
+    std::cout << "Input CRC generator (0, 1 or space) in big-endian order, or 0x<hex>:" << std::endl;
     std::string line;
     std::getline(std::cin, line);
-    crcGen_ = DataIo::FromString(line);
-    ShowCrcGenerator();
+    if (ParseBits(line, crcGen_))
+    {
+        // Hex digits may bring leading zeros, which would lengthen the CRC.
+        crcGen_.erase(crcGen_.begin(), std::find(crcGen_.begin(), crcGen_.end(), true));
+        ShowCrcGenerator();
+    }
 }
 
 void UiEngine::ShowCrcGenerator(void) const
 {
-    std::cout << "The current CRC generator (" << bitSeq_.size() <<  " bits):" << std::endl
+    std::cout << "The current CRC generator (" << crcGen_.size() <<  " bits):" << std::endl
               << DataIo::ToString(crcGen_) << std::endl;
 }
 
@@ -164,6 +233,7 @@ void UiEngine::CrcCheck(void)
         return;
     }
     PolynomialDivider::Divide(bitSeq_, crcGen_, quotient, remainder);
+    CODECS_COUNT(Instrumentation::CT_CRC_CHECKS, 1);
     std::cout << "The quotient (" << quotient.size() << " bits):" << std::endl
               << DataIo::ToString(quotient) << std::endl;
     std::cout << "The remainder (" << remainder.size() << " bits):" << std::endl
@@ -174,12 +244,55 @@ void UiEngine::CrcCheck(void)
     }
     else
     {
+        CODECS_COUNT(Instrumentation::CT_CRC_MISMATCHES, 1);
         std::cout << "There is error." << std::endl;
     }
     bitSeq_.resize(bitSeq_.size() - (crcGen_.size() - 1));
     ShowMessage();
 }
 
+void UiEngine::CrcCorrect(void)
+{
+    if (DataIo::IsZero(crcGen_))
+    {
+        std::cout << "Error: CRC generator has not been set!" << std::endl;
+        return;
+    }
+    if (bitSeq_.size() < crcGen_.size())
+    {
+        std::cout << "Error: The current bit sequence doesn't contain CRC code!" << std::endl;
+        return;
+    }
+    size_t degree = crcGen_.end() - std::find(crcGen_.begin(), crcGen_.end(), true) - 1;
+    if (degree == 0 || degree > 64)
+    {
+        std::cout << "Error: Correction needs a CRC generator of degree 1 to 64!" << std::endl;
+        return;
+    }
+    // The table of a generator and length is built on first use and kept.
+    std::shared_ptr<const CrcCorrector> corrector = CrcCorrector::Get(crcGen_, bitSeq_.size() - degree);
+    if (!corrector->IsCorrectable())
+    {
+        std::cout << "Warning: Some single-bit errors share a remainder at this length;" << std::endl
+                  << "they are reported as uncorrectable." << std::endl;
+    }
+    size_t position = CrcCorrector::NOT_FOUND;
+    switch (corrector->Correct(bitSeq_, position))
+    {
+    case CrcCorrector::CR_NO_ERROR:
+        std::cout << "No error is found." << std::endl;
+        break;
+    case CrcCorrector::CR_CORRECTED:
+        std::cout << "An error is corrected at the " << position + 1 << "-th bit." << std::endl;
+        break;
+    default:
+        std::cout << "There is an uncorrectable error." << std::endl;
+        break;
+    }
+    bitSeq_.resize(bitSeq_.size() - degree);
+    ShowMessage();
+}
+
 void UiEngine::InputHammingMessageBlockSize(void)
 {
     std::cout << "Input Hamming message block size:" << std::endl;
@@ -201,8 +314,17 @@ void UiEngine::InputHammingMessageBlockSize(void)
 void UiEngine::ShowHammingCodecs(void) const
 {
     const BitMatrix& g = hamming_->GetEncoderMatrix();
-    std::cout << "The current Hamming generator (" << g.GetSize(0) <<  "x" << g.GetSize(1) << " matrix):" << std::endl
-              << g.ToString() << std::endl;
+    std::cout << "The current Hamming generator (" << g.GetSize(0) <<  "x" << g.GetSize(1) << " matrix)";
+    // Large generators are shown a row of hexadecimal digits at a time.
+    if (g.GetSize(1) > 64)
+    {
+        std::cout << ", in hexadecimal rows:" << std::endl;
+        g.Write(std::cout, BitMatrix::OF_HEX);
+    }
+    else
+    {
+        std::cout << ":" << std::endl << g << std::endl;
+    }
 }
 
 void UiEngine::HammingEncode(void)
@@ -214,8 +336,11 @@ void UiEngine::HammingEncode(void)
     }
     if (hamming_->GetNumberOfMessageBits() != bitSeq_.size())
     {
-        std::cout << "Error: The size of current bit sequence (" << bitSeq_.size() << " bits) "
-                  << "mismatches the Hamming message block size (" << hamming_->GetNumberOfMessageBits() << ")!" << std::endl;
+        // Any other length is sent as a frame of blocks ending with the length.
+        std::cout << "The current bit sequence (" << bitSeq_.size() << " bits) is encoded as a frame of "
+                  << hamming_->GetFrameLength(bitSeq_.size()) / hamming_->GetNumberOfCodeBits() << " blocks." << std::endl;
+        bitSeq_ = hamming_->EncodeFrame(bitSeq_);
+        ShowMessage();
         return;
     }
     std::vector<bool> code = hamming_->Encode(bitSeq_);
@@ -232,8 +357,24 @@ void UiEngine::HammingDecode(void)
     }
     if (hamming_->GetNumberOfCodeBits() != bitSeq_.size())
     {
-        std::cout << "Error: The size of current bit sequence (" << bitSeq_.size() << " bits) "
-                  << "mismatches the Hamming code block size (" << hamming_->GetNumberOfCodeBits() << ")!" << std::endl;
+        std::vector<bool> message;
+        std::vector<uint8_t> corrections;
+        if (!hamming_->DecodeFrame(bitSeq_, message, corrections))
+        {
+            std::cout << "Error: The current bit sequence (" << bitSeq_.size() << " bits) "
+                      << "is neither a Hamming code block (" << hamming_->GetNumberOfCodeBits() << " bits) "
+                      << "nor a frame of blocks!" << std::endl;
+            return;
+        }
+        for (size_t b = 0; b < corrections.size(); ++b)
+        {
+            if (corrections[b])
+            {
+                std::cout << "An error is corrected in the " << b + 1 << "-th block." << std::endl;
+            }
+        }
+        bitSeq_ = message;
+        ShowMessage();
         return;
     }
     size_t error = hamming_->CheckError(bitSeq_);
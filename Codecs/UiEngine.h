@@ -3,6 +3,7 @@
 #include "BitMatrix.h"
 #include "PolynomialDivider.h"
 #include "HammingCodecs.h"
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -14,6 +15,14 @@ public:
 private:
     int OfferChoices(void);
 
+    /**
+     * Parse a bit sequence typed as bits, as hex digits after "0x",
+     * as base64 after "base64:", or as the bytes of the file after "@".
+     * Bytes are read most significant bit first.
+     * @return false if the input cannot be read.
+     */
+    static bool ParseBits(const std::string& line, std::vector<bool>& bits);
+
     void InputMessage(void);
     void ShowMessage(void) const;
 
@@ -22,6 +31,12 @@ private:
     void CrcEncode(void);
     void CrcCheck(void);
 
+    /**
+     * Check the current bit sequence and correct a single-bit error, if the
+     * generator tells the positions apart at this length (see CrcCorrector).
+     */
+    void CrcCorrect(void);
+
     void InputHammingMessageBlockSize(void);
     void ShowHammingCodecs(void) const;
     void HammingEncode(void);
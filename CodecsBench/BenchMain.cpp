@@ -0,0 +1,108 @@
+#include "Benchmark.h"
+#include "CodecBenchmarks.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    void ShowUsage(void)
+    {
+        std::cerr << "Usage:" << std::endl
+                  << "  codecs-bench [--filter <text>] [--min-time <seconds>] [--json <file>]" << std::endl
+                  << "  codecs-bench --compare <baseline.json> <current.json> [--threshold <percent>]" << std::endl
+                  << "  codecs-bench --self-test" << std::endl
+                  << "Run cases whose name contains the filter text, report ns/op, MB/s and allocs/op" << std::endl
+                  << "(counted only if built with CODECS_ALLOCATION_COUNTER, e.g. make ALLOCATIONS=1)," << std::endl
+                  << "and optionally save the results as JSON.  --compare reports the cases of the current" << std::endl
+                  << "results slower than the baseline by more than the threshold (default 10%) or" << std::endl
+                  << "allocating more, and exits with 1 if there is any." << std::endl;
+    }
+
+    bool Load(const std::string& path, std::vector<Benchmark::Result>& results)
+    {
+        std::ifstream file(path.c_str());
+        if (!file || !Benchmark::ReadJson(file, results))
+        {
+            std::cerr << "Error: Cannot read results from " << path << "!" << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    std::string filter;
+    std::string jsonPath;
+    double minSeconds = 0.05;
+    double threshold = 10;
+    std::vector<std::string> compare;
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        bool hasValue = i + 1 < args.size();
+        if (args[i] == "--self-test")
+        {
+            Benchmark::Test();
+            std::cout << "All tests passed." << std::endl;
+            return 0;
+        }
+        else if (args[i] == "--filter" && hasValue)
+        {
+            filter = args[++i];
+        }
+        else if (args[i] == "--min-time" && hasValue)
+        {
+            minSeconds = std::atof(args[++i].c_str());
+        }
+        else if (args[i] == "--json" && hasValue)
+        {
+            jsonPath = args[++i];
+        }
+        else if (args[i] == "--threshold" && hasValue)
+        {
+            threshold = std::atof(args[++i].c_str());
+        }
+        else if (args[i] == "--compare" && i + 2 < args.size())
+        {
+            compare.push_back(args[++i]);
+            compare.push_back(args[++i]);
+        }
+        else
+        {
+            ShowUsage();
+            return 2;
+        }
+    }
+
+    if (!compare.empty())
+    {
+        std::vector<Benchmark::Result> baseline;
+        std::vector<Benchmark::Result> current;
+        if (!Load(compare[0], baseline) || !Load(compare[1], current))
+        {
+            return 2;
+        }
+        size_t numRegressions = Benchmark::Compare(baseline, current, threshold / 100, std::cout);
+        std::cout << numRegressions << " regression(s)." << std::endl;
+        return numRegressions ? 1 : 0;
+    }
+
+    Benchmark bench(minSeconds);
+    CodecBenchmarks::Register(bench);
+    std::vector<Benchmark::Result> results = bench.Run(filter, std::cout);
+    if (!jsonPath.empty())
+    {
+        std::ofstream file(jsonPath.c_str());
+        Benchmark::WriteJson(results, file);
+        if (!file)
+        {
+            std::cerr << "Error: Cannot write " << jsonPath << "!" << std::endl;
+            return 2;
+        }
+    }
+    return 0;
+}
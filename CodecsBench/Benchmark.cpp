@@ -0,0 +1,390 @@
+#include "Benchmark.h"
+#include "AllocationCounter.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <sstream>
+
+namespace
+{
+    volatile uint64_t sink = 0;
+
+    double Seconds(std::chrono::steady_clock::time_point first, std::chrono::steady_clock::time_point last)
+    {
+        return std::chrono::duration<double>(last - first).count();
+    }
+
+    /// Reads the small JSON subset written by Benchmark::WriteJson().
+    class JsonReader
+    {
+    public:
+        explicit JsonReader(const std::string& text) : text_(text), i_(0) {}
+
+        bool Expect(char c)
+        {
+            SkipSpace();
+            if (i_ < text_.size() && text_[i_] == c)
+            {
+                ++i_;
+                return true;
+            }
+            return false;
+        }
+
+        bool Peek(char c)
+        {
+            SkipSpace();
+            return i_ < text_.size() && text_[i_] == c;
+        }
+
+        bool ReadString(std::string& value)
+        {
+            if (!Expect('"'))
+            {
+                return false;
+            }
+            value.clear();
+            while (i_ < text_.size() && text_[i_] != '"')
+            {
+                if (text_[i_] == '\\' && i_ + 1 < text_.size())
+                {
+                    ++i_;
+                }
+                value.push_back(text_[i_++]);
+            }
+            return Expect('"');
+        }
+
+        bool ReadNumber(double& value)
+        {
+            SkipSpace();
+            const char* first = text_.c_str() + i_;
+            char* last = nullptr;
+            value = std::strtod(first, &last);
+            if (last == first)
+            {
+                return false;
+            }
+            i_ += last - first;
+            return true;
+        }
+
+    private:
+        void SkipSpace(void)
+        {
+            while (i_ < text_.size() && (text_[i_] == ' ' || text_[i_] == '\t' || text_[i_] == '\r' || text_[i_] == '\n'))
+            {
+                ++i_;
+            }
+        }
+
+    private:
+        const std::string& text_;
+        size_t i_;
+    };
+}
+
+Benchmark::Benchmark(double minSeconds, size_t numRuns) :
+    minSeconds_(minSeconds),
+    numRuns_(numRuns)
+{
+    assert(numRuns > 0);
+}
+
+void Benchmark::Add(const std::string& name, size_t bytesPerOp, const Body& body)
+{
+    Case c;
+    c.name = name;
+    c.bytesPerOp = bytesPerOp;
+    c.body = body;
+    cases_.push_back(c);
+}
+
+void Benchmark::Consume(uint64_t value)
+{
+    sink = sink ^ value;
+}
+
+Benchmark::Result Benchmark::Measure(const Case& c) const
+{
+    // Grow the count until a run lasts long enough to time.
+    size_t numOps = 1;
+    for (;;)
+    {
+        std::chrono::steady_clock::time_point first = std::chrono::steady_clock::now();
+        c.body(numOps);
+        double seconds = Seconds(first, std::chrono::steady_clock::now());
+        if (seconds >= minSeconds_)
+        {
+            break;
+        }
+        // Aim a little past the target from the rate seen so far.
+        double scale = seconds > 0 ? 1.2 * minSeconds_ / seconds : 100;
+        numOps = static_cast<size_t>(numOps * (scale < 2 ? 2 : scale > 100 ? 100 : scale));
+    }
+    Result result;
+    result.name = c.name;
+    result.numOps = numOps;
+    result.nsPerOp = 0;
+    result.allocsPerOp = 0;
+    for (size_t r = 0; r < numRuns_; ++r)
+    {
+        std::chrono::steady_clock::time_point first = std::chrono::steady_clock::now();
+        c.body(numOps);
+        double ns = 1e9 * Seconds(first, std::chrono::steady_clock::now()) / numOps;
+        if (r == 0 || ns < result.nsPerOp)
+        {
+            result.nsPerOp = ns;
+        }
+    }
+    // A run of two operations less a run of one leaves out what the body
+    // allocates once per run, such as its output buffers.
+    result.allocsPerOp = -1;
+    if (AllocationCounter::IsEnabled())
+    {
+        size_t numAllocs = AllocationCounter::GetCount();
+        c.body(1);
+        size_t numAllocsOfOne = AllocationCounter::GetCount() - numAllocs;
+        numAllocs = AllocationCounter::GetCount();
+        c.body(2);
+        numAllocs = AllocationCounter::GetCount() - numAllocs;
+        result.allocsPerOp = numAllocs > numAllocsOfOne ? static_cast<double>(numAllocs - numAllocsOfOne) : 0;
+    }
+    result.bytesPerSecond = c.bytesPerOp && result.nsPerOp > 0 ? c.bytesPerOp * 1e9 / result.nsPerOp : 0;
+    return result;
+}
+
+std::vector<Benchmark::Result> Benchmark::Run(const std::string& filter, std::ostream& log) const
+{
+    std::vector<Result> results;
+    log << std::left << std::setw(44) << "benchmark" << std::right
+        << std::setw(14) << "ns/op" << std::setw(14) << "MB/s" << std::setw(12) << "allocs/op" << std::endl;
+    for (size_t i = 0; i < cases_.size(); ++i)
+    {
+        if (cases_[i].name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        Result result = Measure(cases_[i]);
+        log << std::left << std::setw(44) << result.name << std::right << std::fixed
+            << std::setprecision(1) << std::setw(14) << result.nsPerOp
+            << std::setw(14) << result.bytesPerSecond / 1e6
+            << std::setprecision(2) << std::setw(12);
+        if (result.allocsPerOp < 0)
+        {
+            log << "-" << std::endl;
+        }
+        else
+        {
+            log << result.allocsPerOp << std::endl;
+        }
+        results.push_back(result);
+    }
+    return results;
+}
+
+void Benchmark::WriteJson(const std::vector<Result>& results, std::ostream& os)
+{
+    os << "{\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& r = results[i];
+        os << (i ? ",\n" : "\n")
+           << "    {\"name\": \"" << r.name << "\", \"ops\": " << r.numOps
+           << std::setprecision(6) << std::defaultfloat
+           << ", \"ns_per_op\": " << r.nsPerOp
+           << ", \"bytes_per_second\": " << r.bytesPerSecond
+           << ", \"allocs_per_op\": " << r.allocsPerOp << "}";
+    }
+    os << "\n  ]\n}\n";
+}
+
+bool Benchmark::ReadJson(std::istream& is, std::vector<Result>& results)
+{
+    std::ostringstream oss;
+    oss << is.rdbuf();
+    std::string text = oss.str();
+    JsonReader reader(text);
+    std::string key;
+    results.clear();
+    if (!reader.Expect('{') || !reader.ReadString(key) || key != "benchmarks" ||
+        !reader.Expect(':') || !reader.Expect('['))
+    {
+        return false;
+    }
+    while (!reader.Expect(']'))
+    {
+        if (!results.empty() && !reader.Expect(','))
+        {
+            return false;
+        }
+        if (!reader.Expect('{'))
+        {
+            return false;
+        }
+        Result r;
+        r.numOps = 0;
+        r.nsPerOp = 0;
+        r.bytesPerSecond = 0;
+        r.allocsPerOp = -1;
+        while (!reader.Expect('}'))
+        {
+            // Members after the first follow a comma.
+            if (!reader.Peek('"') && !reader.Expect(','))
+            {
+                return false;
+            }
+            if (!reader.ReadString(key) || !reader.Expect(':'))
+            {
+                return false;
+            }
+            double value = 0;
+            if (key == "name")
+            {
+                if (!reader.ReadString(r.name))
+                {
+                    return false;
+                }
+            }
+            else if (!reader.ReadNumber(value))
+            {
+                return false;
+            }
+            else if (key == "ops")
+            {
+                r.numOps = static_cast<size_t>(value);
+            }
+            else if (key == "ns_per_op")
+            {
+                r.nsPerOp = value;
+            }
+            else if (key == "bytes_per_second")
+            {
+                r.bytesPerSecond = value;
+            }
+            else if (key == "allocs_per_op")
+            {
+                r.allocsPerOp = value;
+            }
+        }
+        results.push_back(r);
+    }
+    return reader.Expect('}');
+}
+
+size_t Benchmark::Compare(const std::vector<Result>& baseline, const std::vector<Result>& current,
+                          double threshold, std::ostream& report)
+{
+    std::map<std::string, const Result*> base;
+    for (size_t i = 0; i < baseline.size(); ++i)
+    {
+        base[baseline[i].name] = &baseline[i];
+    }
+    size_t numRegressions = 0;
+    report << std::left << std::setw(44) << "benchmark" << std::right
+           << std::setw(14) << "base ns/op" << std::setw(14) << "ns/op" << std::setw(10) << "change" << std::endl;
+    for (size_t i = 0; i < current.size(); ++i)
+    {
+        const Result& r = current[i];
+        std::map<std::string, const Result*>::const_iterator it = base.find(r.name);
+        if (it == base.end())
+        {
+            report << std::left << std::setw(44) << r.name << std::right << std::setw(14) << "-" << std::fixed
+                   << std::setprecision(1) << std::setw(14) << r.nsPerOp << "    new" << std::endl;
+            continue;
+        }
+        const Result& b = *it->second;
+        double change = b.nsPerOp > 0 ? r.nsPerOp / b.nsPerOp - 1 : 0;
+        report << std::left << std::setw(44) << r.name << std::right << std::fixed << std::setprecision(1)
+               << std::setw(14) << b.nsPerOp << std::setw(14) << r.nsPerOp
+               << std::showpos << std::setw(9) << 100 * change << "%" << std::noshowpos;
+        if (change > threshold)
+        {
+            report << "  REGRESSION";
+            ++numRegressions;
+        }
+        else if (b.allocsPerOp >= 0 && r.allocsPerOp > b.allocsPerOp)
+        {
+            report << "  REGRESSION (allocs/op " << std::setprecision(2) << b.allocsPerOp
+                   << " -> " << r.allocsPerOp << ")";
+            ++numRegressions;
+        }
+        else if (change < -threshold)
+        {
+            report << "  improved";
+        }
+        report << std::endl;
+    }
+    return numRegressions;
+}
+
+void Benchmark::Test(void)
+{
+    // Results survive a JSON round trip.
+    Benchmark bench(0.001, 2);
+    std::vector<uint64_t> data(1000, 3);
+    bench.Add("sum", data.size() * sizeof (uint64_t), [&data](size_t numOps)
+    {
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < data.size(); ++i)
+            {
+                sum += data[i];
+            }
+            Consume(sum);
+        }
+    });
+    bench.Add("allocate", 0, [](size_t numOps)
+    {
+        std::vector<uint64_t> once(1, 0);
+        Consume(once[0]);
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            std::vector<uint64_t> v(8, n);
+            Consume(v[7]);
+        }
+    });
+    std::ostringstream log;
+    std::vector<Result> results = bench.Run("", log);
+    assert(results.size() == 2);
+    assert(results[0].nsPerOp > 0 && results[0].bytesPerSecond > 0);
+    assert(AllocationCounter::IsEnabled() ? results[0].allocsPerOp == 0 : results[0].allocsPerOp == -1);
+    assert(!AllocationCounter::IsEnabled() || results[1].allocsPerOp == 1);
+    std::vector<Result> filtered = bench.Run("sum", log);
+    assert(filtered.size() == 1);
+    (void)filtered;
+
+    std::stringstream json;
+    WriteJson(results, json);
+    std::vector<Result> read;
+    bool ok = ReadJson(json, read);
+    assert(ok && read.size() == 2 && read[1].name == "allocate" && read[1].allocsPerOp == results[1].allocsPerOp);
+
+    // Only slowdowns beyond the threshold and extra allocations are regressions;
+    // results without allocation counts are compared on time only.
+    read[1].allocsPerOp = 1;
+    std::vector<Result> slower = read;
+    slower[0].nsPerOp = read[0].nsPerOp * 1.05;
+    std::ostringstream report;
+    size_t numRegressions = Compare(read, slower, 0.1, report);
+    assert(numRegressions == 0);
+    slower[0].nsPerOp = read[0].nsPerOp * 1.5;
+    slower[1].allocsPerOp = 2;
+    numRegressions = Compare(read, slower, 0.1, report);
+    assert(numRegressions == 2);
+    read[1].allocsPerOp = -1;
+    numRegressions = Compare(read, slower, 0.1, report);
+    assert(numRegressions == 1);
+
+    std::istringstream bad("{\"benchmarks\": [{\"name\": \"x\", \"ns_per_op\": }]}");
+    ok = ReadJson(bad, read);
+    assert(!ok);
+    (void)ok;
+    (void)numRegressions;
+}
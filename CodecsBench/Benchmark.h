@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * A microbenchmark runner.
+ *
+ * Each case is a body that runs its operation a given number of times.
+ * The runner grows the count until a run lasts long enough to time, then
+ * keeps the fastest of several runs.  In builds with the allocation
+ * counter (see AllocationCounter), heap allocations made by the calling
+ * thread are counted per operation, leaving out those the body makes once
+ * per run.
+ */
+class Benchmark
+{
+public:
+    /**
+     * @param [in] numOps   the number of times to run the operation.
+     */
+    typedef std::function<void(size_t numOps)> Body;
+
+    struct Result
+    {
+        std::string name;
+        size_t numOps;              ///< operations per timed run.
+        double nsPerOp;
+        double bytesPerSecond;      ///< 0 if the case has no byte count.
+        double allocsPerOp;         ///< -1 if the build does not count allocations.
+    };
+
+    /**
+     * @param [in] minSeconds   the minimum duration of a timed run.
+     * @param [in] numRuns      the number of timed runs, of which the fastest is kept.
+     */
+    explicit Benchmark(double minSeconds = 0.05, size_t numRuns = 3);
+
+    /**
+     * @param [in] bytesPerOp   the bytes one operation processes, or 0.
+     */
+    void Add(const std::string& name, size_t bytesPerOp, const Body& body);
+
+    /**
+     * Run the cases whose name contains \c filter, reporting each on \c log.
+     */
+    std::vector<Result> Run(const std::string& filter, std::ostream& log) const;
+
+    /**
+     * Keep a value alive, so the compiler cannot drop the work behind it.
+     */
+    static void Consume(uint64_t value);
+
+    static void WriteJson(const std::vector<Result>& results, std::ostream& os);
+
+    /**
+     * Read results written by WriteJson().
+     * @return false if the text is malformed.
+     */
+    static bool ReadJson(std::istream& is, std::vector<Result>& results);
+
+    /**
+     * Report the cases of \c current that are slower than \c baseline by more
+     * than \c threshold (e.g. 0.1 for 10%), or allocate more.
+     * @return The number of regressions.
+     */
+    static size_t Compare(const std::vector<Result>& baseline, const std::vector<Result>& current,
+                          double threshold, std::ostream& report);
+
+    static void Test(void);
+
+private:
+    struct Case
+    {
+        std::string name;
+        size_t bytesPerOp;
+        Body body;
+    };
+
+    Result Measure(const Case& c) const;
+
+private:
+    std::vector<Case> cases_;
+    double minSeconds_;
+    size_t numRuns_;
+};
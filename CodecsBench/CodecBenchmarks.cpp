@@ -0,0 +1,500 @@
+#include "CodecBenchmarks.h"
+#include "BitMatrix.h"
+#include "BitView.h"
+#include "BlockInterleaver.h"
+#include "CodecPipeline.h"
+#include "DataIo.h"
+#include "HammingCodecs.h"
+#include "LfsrDivider.h"
+#include "MultiCrc.h"
+#include "PackedBits.h"
+#include "PolynomialDivider.h"
+#include <memory>
+#include <sstream>
+
+namespace
+{
+    /// Reproducible pseudo-random words for the inputs.
+    class Random
+    {
+    public:
+        explicit Random(uint64_t seed = 0x9E3779B97F4A7C15ULL) : x_(seed) {}
+
+        uint64_t Next(void)
+        {
+            x_ ^= x_ << 13;
+            x_ ^= x_ >> 7;
+            x_ ^= x_ << 17;
+            return x_;
+        }
+
+        std::vector<uint64_t> Words(size_t numBits)
+        {
+            std::vector<uint64_t> words(PackedBits::GetNumberOfWords(numBits), 0);
+            for (size_t i = 0; i < words.size(); ++i)
+            {
+                words[i] = Next();
+            }
+            if (numBits % PackedBits::WORD_BITS)
+            {
+                words.back() &= PackedBits::GetLowMask(numBits % PackedBits::WORD_BITS);
+            }
+            return words;
+        }
+
+        /**
+         * @return A generator of degree \c degree with both end terms.
+         */
+        std::vector<bool> Generator(size_t degree)
+        {
+            std::vector<bool> generator(degree + 1, false);
+            for (size_t i = 1; i < degree; ++i)
+            {
+                generator[i] = Next() & 1;
+            }
+            generator.front() = true;
+            generator.back() = true;
+            return generator;
+        }
+
+    private:
+        uint64_t x_;
+    };
+
+    std::string Name(const char* prefix, size_t a)
+    {
+        std::ostringstream oss;
+        oss << prefix << a;
+        return oss.str();
+    }
+
+    std::string Name(const char* prefix, size_t a, const char* middle, size_t b)
+    {
+        std::ostringstream oss;
+        oss << prefix << a << middle << b;
+        return oss.str();
+    }
+}
+
+void CodecBenchmarks::Register(Benchmark& bench)
+{
+    RegisterCrc(bench);
+    RegisterDivide(bench);
+    RegisterBitMatrix(bench);
+    RegisterHamming(bench);
+    RegisterDataIo(bench);
+    RegisterPipeline(bench);
+}
+
+void CodecBenchmarks::RegisterCrc(Benchmark& bench)
+{
+    // Register widths of one to five words reach every LfsrDivider kernel.
+    const size_t degrees[] = { 8, 16, 32, 64, 128, 192, 256, 300 };
+    const size_t sizes[] = { 64, 4096, 1 << 20 };
+    Random random;
+    for (size_t d = 0; d < sizeof (degrees) / sizeof (degrees[0]); ++d)
+    {
+        std::shared_ptr<LfsrDivider> divider(new LfsrDivider(random.Generator(degrees[d])));
+        for (size_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); ++s)
+        {
+            std::shared_ptr<std::vector<uint64_t> > data(new std::vector<uint64_t>(random.Words(8 * sizes[s])));
+            size_t numBits = 8 * sizes[s];
+            bench.Add(Name("crc/lfsr/degree", degrees[d], "/bytes", sizes[s]), sizes[s],
+                      [divider, data, numBits](size_t numOps)
+            {
+                uint64_t reg[8] = { 0 };
+                for (size_t n = 0; n < numOps; ++n)
+                {
+                    divider->Update(reg, &(*data)[0], numBits);
+                }
+                Benchmark::Consume(reg[0]);
+            });
+        }
+    }
+    // Most significant bit first bytes go through the bit-reversing path.
+    std::shared_ptr<LfsrDivider> crc32(new LfsrDivider(DataIo::FromString("1 0000 0100 1100 0001 0001 1101 1011 0111")));
+    for (size_t s = 1; s < sizeof (sizes) / sizeof (sizes[0]); ++s)
+    {
+        std::shared_ptr<std::vector<uint64_t> > data(new std::vector<uint64_t>(random.Words(8 * sizes[s])));
+        size_t numBytes = sizes[s];
+        bench.Add(Name("crc/lfsr-msb-first/degree", 32, "/bytes", numBytes), numBytes,
+                  [crc32, data, numBytes](size_t numOps)
+        {
+            BitView view(reinterpret_cast<const uint8_t*>(&(*data)[0]), 8 * numBytes, BitView::BO_MSB_FIRST);
+            uint64_t reg = 0;
+            for (size_t n = 0; n < numOps; ++n)
+            {
+                crc32->Update(&reg, view);
+            }
+            Benchmark::Consume(reg);
+        });
+    }
+    // Changing 64 bits of a 1 MB message, against feeding it all again.
+    std::shared_ptr<std::vector<uint64_t> > patch(new std::vector<uint64_t>(random.Words(3 * 64)));
+    bench.Add("crc/update/degree32/bytes1048576", 8, [crc32, patch](size_t numOps)
+    {
+        uint64_t reg = 0;
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            crc32->UpdateCrc(&reg, 8 << 20, (n * 4099) % (8 << 19), &(*patch)[n % 2], &(*patch)[2], 64);
+        }
+        Benchmark::Consume(reg);
+    });
+    // A 16-, a 32- and a 64-bit CRC of 1 MB, in one pass and in three.
+    std::vector<std::vector<bool> > generators;
+    generators.push_back(random.Generator(16));
+    generators.push_back(random.Generator(32));
+    generators.push_back(random.Generator(64));
+    std::shared_ptr<MultiCrc> multi(new MultiCrc(generators));
+    std::shared_ptr<std::vector<uint64_t> > megabyte(new std::vector<uint64_t>(random.Words(8 << 20)));
+    bench.Add("crc/multi/3crcs/bytes1048576", 1 << 20, [multi, megabyte](size_t numOps)
+    {
+        uint64_t regs[3] = { 0 };
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            multi->Update(regs, &(*megabyte)[0], 8 << 20);
+        }
+        Benchmark::Consume(regs[0] ^ regs[1] ^ regs[2]);
+    });
+    bench.Add("crc/separate/3crcs/bytes1048576", 1 << 20, [multi, megabyte](size_t numOps)
+    {
+        uint64_t regs[3] = { 0 };
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            for (size_t i = 0; i < 3; ++i)
+            {
+                multi->GetDivider(i).Update(&regs[i], &(*megabyte)[0], 8 << 20);
+            }
+        }
+        Benchmark::Consume(regs[0] ^ regs[1] ^ regs[2]);
+    });
+}
+
+void CodecBenchmarks::RegisterDivide(Benchmark& bench)
+{
+    const size_t degrees[] = { 16, 32, 64, 130 };
+    const size_t sizes[] = { 1024, 65536 };
+    Random random;
+    for (size_t d = 0; d < sizeof (degrees) / sizeof (degrees[0]); ++d)
+    {
+        std::shared_ptr<std::vector<uint64_t> > divisor(
+            new std::vector<uint64_t>(PackedBits::FromVector(random.Generator(degrees[d]))));
+        size_t numDivisorBits = degrees[d] + 1;
+        for (size_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); ++s)
+        {
+            size_t numBits = sizes[s];
+            std::shared_ptr<std::vector<uint64_t> > dividend(new std::vector<uint64_t>(random.Words(numBits)));
+            std::shared_ptr<std::vector<uint64_t> > quotient(new std::vector<uint64_t>(dividend->size(), 0));
+            std::shared_ptr<std::vector<uint64_t> > remainder(new std::vector<uint64_t>(divisor->size() + 1, 0));
+            bench.Add(Name("divide/packed/degree", degrees[d], "/bits", numBits), numBits / 8,
+                      [=](size_t numOps)
+            {
+                for (size_t n = 0; n < numOps; ++n)
+                {
+                    PolynomialDivider::Divide(&(*dividend)[0], numBits, &(*divisor)[0], numDivisorBits,
+                                              &(*quotient)[0], &(*remainder)[0]);
+                }
+                Benchmark::Consume((*remainder)[0]);
+            });
+        }
+    }
+    std::shared_ptr<std::vector<bool> > dividend(new std::vector<bool>(PackedBits::ToVector(&random.Words(1024)[0], 1024)));
+    std::shared_ptr<std::vector<bool> > divisor(new std::vector<bool>(random.Generator(32)));
+    bench.Add(Name("divide/vector/degree", 32, "/bits", 1024), 1024 / 8, [dividend, divisor](size_t numOps)
+    {
+        std::vector<bool> quotient;
+        std::vector<bool> remainder;
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            PolynomialDivider::Divide(*dividend, *divisor, quotient, remainder);
+        }
+        Benchmark::Consume(remainder[0]);
+    });
+}
+
+void CodecBenchmarks::RegisterBitMatrix(Benchmark& bench)
+{
+    const size_t sizes[] = { 64, 256, 1024 };
+    Random random;
+    for (size_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); ++s)
+    {
+        size_t n = sizes[s];
+        for (int order = 0; order < 2; ++order)
+        {
+            std::shared_ptr<BitMatrix> matrix(new BitMatrix(n, n, order ? BitMatrix::SO_ROW_MAJOR : BitMatrix::SO_COLUMN_MAJOR));
+            for (size_t i = 0; i < matrix->GetNumberOfLines(); ++i)
+            {
+                std::vector<uint64_t> line = random.Words(n);
+                std::copy(line.begin(), line.end(), matrix->GetLine(i));
+            }
+            std::shared_ptr<std::vector<uint64_t> > vec(new std::vector<uint64_t>(random.Words(n)));
+            std::shared_ptr<std::vector<uint64_t> > result(new std::vector<uint64_t>(vec->size(), 0));
+            bench.Add(Name(order ? "matrix/multiply-row-major/" : "matrix/multiply-column-major/", n, "x", n), n / 8,
+                      [matrix, vec, result](size_t numOps)
+            {
+                for (size_t k = 0; k < numOps; ++k)
+                {
+                    matrix->Multiply(&(*vec)[0], &(*result)[0]);
+                }
+                Benchmark::Consume((*result)[0]);
+            });
+            if (order)
+            {
+                std::shared_ptr<std::string> text(new std::string(matrix->ToString()));
+                bench.Add(Name("matrix/from-string/", n, "x", n), text->size(), [text](size_t numOps)
+                {
+                    for (size_t k = 0; k < numOps; ++k)
+                    {
+                        BitMatrix parsed = BitMatrix::FromString(*text);
+                        Benchmark::Consume(parsed.GetSize(0));
+                    }
+                });
+                bench.Add(Name("matrix/write-text/", n, "x", n), text->size(), [matrix](size_t numOps)
+                {
+                    for (size_t k = 0; k < numOps; ++k)
+                    {
+                        std::ostringstream oss;
+                        matrix->Write(oss);
+                        Benchmark::Consume(oss.tellp());
+                    }
+                });
+            }
+        }
+    }
+}
+
+void CodecBenchmarks::RegisterHamming(Benchmark& bench)
+{
+    const size_t sizes[] = { 4, 26, 57, 247, 1013 };
+    Random random;
+    for (size_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); ++s)
+    {
+        size_t k = sizes[s];
+        bench.Add(Name("hamming/construct/k", k), 0,
+                  [k](size_t numOps)
+        {
+            for (size_t n = 0; n < numOps; ++n)
+            {
+                HammingCodecs hc(k);
+                Benchmark::Consume(hc.GetNumberOfCodeBits());
+            }
+        });
+        std::shared_ptr<HammingCodecs> hc(new HammingCodecs(k));
+        size_t numCodeBits = hc->GetNumberOfCodeBits();
+        std::shared_ptr<std::vector<uint64_t> > message(new std::vector<uint64_t>(random.Words(k)));
+        std::shared_ptr<std::vector<uint64_t> > code(new std::vector<uint64_t>(PackedBits::GetNumberOfWords(numCodeBits), 0));
+        std::shared_ptr<std::vector<uint64_t> > decoded(new std::vector<uint64_t>(message->size(), 0));
+        hc->Encode(&(*message)[0], &(*code)[0]);
+        PackedBits::FlipBit(&(*code)[0], numCodeBits / 2);
+        size_t bytes = (k + 7) / 8;
+        bench.Add(Name("hamming/encode/k", k), bytes,
+                  [hc, message](size_t numOps)
+        {
+            std::vector<uint64_t> out(PackedBits::GetNumberOfWords(hc->GetNumberOfCodeBits()), 0);
+            for (size_t n = 0; n < numOps; ++n)
+            {
+                hc->Encode(&(*message)[0], &out[0]);
+            }
+            Benchmark::Consume(out[0]);
+        });
+        bench.Add(Name("hamming/check-error/k", k), bytes,
+                  [hc, code](size_t numOps)
+        {
+            size_t sum = 0;
+            for (size_t n = 0; n < numOps; ++n)
+            {
+                sum += hc->CheckError(&(*code)[0]);
+            }
+            Benchmark::Consume(sum);
+        });
+        bench.Add(Name("hamming/decode/k", k), bytes,
+                  [hc, code, decoded](size_t numOps)
+        {
+            for (size_t n = 0; n < numOps; ++n)
+            {
+                hc->Decode(&(*code)[0], &(*decoded)[0]);
+            }
+            Benchmark::Consume((*decoded)[0]);
+        });
+
+        // 256 blocks at a time through the bit-sliced kernels.
+        const size_t numBlocks = 256;
+        std::shared_ptr<std::vector<uint64_t> > messages(new std::vector<uint64_t>(random.Words(numBlocks * k)));
+        std::shared_ptr<std::vector<uint64_t> > codes(new std::vector<uint64_t>(PackedBits::GetNumberOfWords(numBlocks * numCodeBits), 0));
+        std::shared_ptr<std::vector<uint64_t> > scratch(new std::vector<uint64_t>(hc->GetScratchSize(), 0));
+        hc->EncodeBlocks(&(*messages)[0], numBlocks, &(*codes)[0], &(*scratch)[0]);
+        bench.Add(Name("hamming/encode-blocks/k", k, "/blocks", numBlocks), numBlocks * k / 8,
+                  [hc, messages, scratch](size_t numOps)
+        {
+            std::vector<uint64_t> out(PackedBits::GetNumberOfWords(numBlocks * hc->GetNumberOfCodeBits()), 0);
+            for (size_t n = 0; n < numOps; ++n)
+            {
+                hc->EncodeBlocks(&(*messages)[0], numBlocks, &out[0], &(*scratch)[0]);
+            }
+            Benchmark::Consume(out[0]);
+        });
+        bench.Add(Name("hamming/decode-blocks/k", k, "/blocks", numBlocks), numBlocks * k / 8,
+                  [hc, codes, messages, scratch](size_t numOps)
+        {
+            std::vector<uint64_t> out(messages->size(), 0);
+            size_t sum = 0;
+            for (size_t n = 0; n < numOps; ++n)
+            {
+                sum += hc->DecodeBlocks(&(*codes)[0], numBlocks, &out[0], nullptr, &(*scratch)[0]);
+            }
+            Benchmark::Consume(sum + out[0]);
+        });
+    }
+}
+
+void CodecBenchmarks::RegisterDataIo(Benchmark& bench)
+{
+    const size_t numBits = 8 << 20;
+    Random random;
+    std::shared_ptr<std::vector<uint64_t> > words(new std::vector<uint64_t>(random.Words(numBits)));
+    std::shared_ptr<std::string> text(new std::string());
+    DataIo::ToString(&(*words)[0], numBits, *text);
+    std::shared_ptr<std::string> hex(new std::string());
+    DataIo::ToHex(&(*words)[0], numBits, *hex);
+    std::shared_ptr<std::string> base64(new std::string());
+    DataIo::ToBase64(reinterpret_cast<const uint8_t*>(&(*words)[0]), numBits / 8, *base64);
+
+    bench.Add("dataio/from-string/bits8388608", text->size(), [text](size_t numOps)
+    {
+        std::vector<uint64_t> out;
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            Benchmark::Consume(DataIo::FromString(text->data(), text->size(), out));
+        }
+    });
+    bench.Add("dataio/to-string/bits8388608", numBits / 8, [words](size_t numOps)
+    {
+        std::string out;
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            DataIo::ToString(&(*words)[0], numBits, out);
+        }
+        Benchmark::Consume(out.size());
+    });
+    bench.Add("dataio/from-hex/bits8388608", hex->size(), [hex](size_t numOps)
+    {
+        std::vector<uint64_t> out;
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            Benchmark::Consume(DataIo::FromHex(hex->data(), hex->size(), out));
+        }
+    });
+    bench.Add("dataio/to-hex/bits8388608", numBits / 8, [words](size_t numOps)
+    {
+        std::string out;
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            DataIo::ToHex(&(*words)[0], numBits, out);
+        }
+        Benchmark::Consume(out.size());
+    });
+    bench.Add("dataio/from-base64/bits8388608", base64->size(), [base64](size_t numOps)
+    {
+        std::vector<uint8_t> out;
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            Benchmark::Consume(DataIo::FromBase64(base64->data(), base64->size(), out));
+        }
+    });
+    bench.Add("dataio/to-base64/bits8388608", numBits / 8, [words](size_t numOps)
+    {
+        std::string out;
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            DataIo::ToBase64(reinterpret_cast<const uint8_t*>(&(*words)[0]), numBits / 8, out);
+        }
+        Benchmark::Consume(out.size());
+    });
+    for (int order = 0; order < 2; ++order)
+    {
+        BitView::BitOrder bitOrder = order ? BitView::BO_MSB_FIRST : BitView::BO_LSB_FIRST;
+        bench.Add(order ? "dataio/from-bytes-msb-first/bits8388608" : "dataio/from-bytes-lsb-first/bits8388608",
+                  numBits / 8, [words, bitOrder](size_t numOps)
+        {
+            std::vector<uint64_t> out(words->size(), 0);
+            for (size_t n = 0; n < numOps; ++n)
+            {
+                DataIo::FromBytes(reinterpret_cast<const uint8_t*>(&(*words)[0]), numBits, bitOrder,
+                                  DataIo::BO_BIG_ENDIAN, &out[0]);
+            }
+            Benchmark::Consume(out[0]);
+        });
+    }
+}
+
+void CodecBenchmarks::RegisterPipeline(Benchmark& bench)
+{
+    // CRC-32, Hamming (63, 57) and an 8-deep interleaver over 4 MB, well
+    // beyond the caches: fused tiles against one whole-stream pass per stage.
+    Random random;
+    std::shared_ptr<LfsrDivider> crc(new LfsrDivider(random.Generator(32)));
+    std::shared_ptr<HammingCodecs> hamming(new HammingCodecs(57));
+    std::shared_ptr<BlockInterleaver> interleaver(new BlockInterleaver(hamming->GetNumberOfCodeBits(), 8));
+    std::shared_ptr<CodecPipeline> pipeline(new CodecPipeline);
+    pipeline->AddCrc(*crc).AddHamming(*hamming).AddInterleaver(*interleaver);
+    const size_t numBits = 32 << 20;
+    size_t numCodeBits = pipeline->GetEncodedLength(numBits);
+    std::shared_ptr<std::vector<uint64_t> > message(new std::vector<uint64_t>(random.Words(numBits)));
+    std::shared_ptr<std::vector<uint64_t> > code(new std::vector<uint64_t>(PackedBits::GetNumberOfWords(numCodeBits), 0));
+    pipeline->Encode(&(*message)[0], numBits, &(*code)[0]);
+    bench.Add("pipeline/fused/encode/bytes4194304", numBits / 8, [=](size_t numOps)
+    {
+        std::vector<uint64_t> out(code->size(), 0);
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            pipeline->Encode(&(*message)[0], numBits, &out[0]);
+        }
+        Benchmark::Consume(out[0]);
+    });
+    bench.Add("pipeline/fused/decode/bytes4194304", numBits / 8, [=](size_t numOps)
+    {
+        std::vector<uint64_t> out(message->size(), 0);
+        size_t sum = 0;
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            sum += pipeline->Decode(&(*code)[0], numBits, &out[0]);
+        }
+        Benchmark::Consume(sum + out[0]);
+    });
+
+    size_t numFrameBits = numBits + crc->GetDegree();
+    size_t numBlocks = (numFrameBits + 56) / 57;
+    size_t numFrames = numCodeBits / interleaver->GetFrameLength();
+    bench.Add("pipeline/staged/encode/bytes4194304", numBits / 8, [=](size_t numOps)
+    {
+        std::vector<uint64_t> frame(PackedBits::GetNumberOfWords(numBlocks * 57), 0);
+        std::vector<uint64_t> blocks(code->size(), 0);
+        std::vector<uint64_t> out(code->size(), 0);
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            uint64_t reg = 0;
+            crc->Update(&reg, &(*message)[0], numBits);
+            std::copy(message->begin(), message->end(), frame.begin());
+            PackedBits::InsertBits(&frame[0], numBits, reg, crc->GetDegree());
+            hamming->EncodeBlocks(&frame[0], numBlocks, &blocks[0]);
+            interleaver->Interleave(&blocks[0], numFrames, &out[0]);
+        }
+        Benchmark::Consume(out[0]);
+    });
+    bench.Add("pipeline/staged/decode/bytes4194304", numBits / 8, [=](size_t numOps)
+    {
+        std::vector<uint64_t> blocks(code->size(), 0);
+        std::vector<uint64_t> frame(PackedBits::GetNumberOfWords(numBlocks * 57), 0);
+        std::vector<size_t> errors(numBlocks);
+        size_t sum = 0;
+        for (size_t n = 0; n < numOps; ++n)
+        {
+            interleaver->Deinterleave(&(*code)[0], numFrames, &blocks[0]);
+            sum += hamming->DecodeBlocks(&blocks[0], numBlocks, &frame[0], &errors[0]);
+            uint64_t reg = 0;
+            crc->Update(&reg, &frame[0], numFrameBits);
+            sum += reg;
+        }
+        Benchmark::Consume(sum + frame[0]);
+    });
+}
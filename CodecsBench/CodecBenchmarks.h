@@ -0,0 +1,22 @@
+#pragma once
+#include "Benchmark.h"
+
+/**
+ * The benchmark cases of the codec hot paths.
+ *
+ * Case names are "<module>/<operation>/<parameters>", so a filter such as
+ * "crc/" or "hamming/encode" selects a group.
+ */
+class CodecBenchmarks
+{
+public:
+    static void Register(Benchmark& bench);
+
+private:
+    static void RegisterCrc(Benchmark& bench);
+    static void RegisterDivide(Benchmark& bench);
+    static void RegisterBitMatrix(Benchmark& bench);
+    static void RegisterHamming(Benchmark& bench);
+    static void RegisterDataIo(Benchmark& bench);
+    static void RegisterPipeline(Benchmark& bench);
+};